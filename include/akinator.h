@@ -6,20 +6,30 @@
 #include "akinator_errors.h"
 #include "text_buffer.h"
 #include "tts.h"
+#include "akinator_index.h"
+#include "akinator_trace.h"
+
+struct akinator_epoch_t;
+struct akinator_dump_t;
 
 enum akinator_answer_t {
-    AKINATOR_ANSWER_YES     = 0,
-    AKINATOR_ANSWER_NO      = 1,
-    AKINATOR_ANSWER_UNKNOWN = 2,
+    AKINATOR_ANSWER_YES          = 0,
+    AKINATOR_ANSWER_NO           = 1,
+    AKINATOR_ANSWER_UNKNOWN      = 2,
+    AKINATOR_ANSWER_PROBABLY     = 3,
+    AKINATOR_ANSWER_PROBABLY_NOT = 4,
 };
 
 static const size_t max_nodes_containers_number = 64;
+static const size_t MaxQuestionSize             = 64;
+static const size_t AkinatorContainerSize       = 64;
 
 struct akinator_node_t {
     char            *question;
     akinator_node_t *yes;
     akinator_node_t *no;
     akinator_node_t *parent;
+    size_t           id;
 };
 
 struct akinator_t {
@@ -33,25 +43,54 @@ struct akinator_t {
     size_t            questions_storage_position;
     size_t            old_storage_size;
     const char       *database_name;
-    FILE             *general_dump;
     size_t            dumps_number;
+    akinator_dump_t  *dumper;
+    akinator_trace_t *trace;
     akinator_node_t **leafs_array;
     size_t            leafs_array_capacity;
     size_t            leafs_array_size;
+    size_t           *leafs_positions;
+    size_t            leafs_positions_capacity;
     tts_t             tts;
+    akinator_index_t  index;
+    akinator_epoch_t *epoch;
 };
 
-akinator_error_t akinator_ctor       (akinator_t *akinator,
-                                      const char *database_filename);
+akinator_error_t akinator_ctor            (akinator_t *akinator,
+                                           const char *database_filename);
+
+akinator_error_t akinator_guess           (akinator_t *akinator);
+
+akinator_error_t akinator_fast_guess      (akinator_t *akinator);
+
+akinator_error_t akinator_beam_guess      (akinator_t *akinator);
+
+akinator_error_t akinator_dtor            (akinator_t *akinator);
+
+akinator_error_t akinator_definition      (akinator_t *akinator);
+
+akinator_error_t akinator_difference      (akinator_t *akinator);
 
-akinator_error_t akinator_guess      (akinator_t *akinator);
+akinator_error_t akinator_similar_objects (akinator_t *akinator);
 
-akinator_error_t akinator_dtor       (akinator_t *akinator);
+akinator_error_t akinator_search          (akinator_t *akinator);
 
-akinator_error_t akinator_definition (akinator_t *akinator);
+akinator_error_t akinator_verify          (akinator_t *akinator);
 
-akinator_error_t akinator_difference (akinator_t *akinator);
+akinator_error_t akinator_get_node_by_id  (akinator_t       *akinator,
+                                           size_t            id,
+                                           akinator_node_t **node);
 
-akinator_error_t akinator_verify     (akinator_t *akinator);
+#define AKINATOR_VERIFY(__akinator) {                            \
+    akinator_error_t __error_code = akinator_verify(__akinator); \
+    if(__error_code != AKINATOR_SUCCESS) {                       \
+        akinator_trace_error((__akinator),                       \
+                             __error_code,                       \
+                             __FILE__,                           \
+                             __LINE__,                           \
+                             __PRETTY_FUNCTION__);               \
+        return __error_code;                                     \
+    }                                                            \
+}
 
 #endif
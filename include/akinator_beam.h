@@ -0,0 +1,47 @@
+#ifndef AKINATOR_BEAM_H
+#define AKINATOR_BEAM_H
+
+#include <time.h>
+
+#include "akinator.h"
+#include "akinator_errors.h"
+
+static const size_t BeamDefaultWidth = 32;
+
+struct akinator_beam_entry_t {
+    akinator_node_t *node;
+    double           weight;
+};
+
+struct akinator_beam_t {
+    akinator_beam_entry_t *frontier;
+    akinator_beam_entry_t *scratch;
+    size_t                 frontier_size;
+    size_t                 width;
+    size_t                 current_question;
+    akinator_node_t       *current_guess;
+    size_t                 questions_asked;
+    size_t                 steps_number;
+    clock_t                steps_time;
+};
+
+akinator_error_t akinator_beam_ctor          (akinator_beam_t   *beam,
+                                              size_t             width);
+
+akinator_error_t akinator_beam_reset         (akinator_beam_t   *beam,
+                                              akinator_node_t   *root);
+
+akinator_error_t akinator_beam_next_question (akinator_beam_t   *beam,
+                                              akinator_node_t  **question);
+
+akinator_error_t akinator_beam_answer        (akinator_beam_t   *beam,
+                                              akinator_answer_t  answer);
+
+akinator_error_t akinator_beam_get_guess     (akinator_beam_t   *beam,
+                                              akinator_node_t  **object);
+
+akinator_error_t akinator_beam_reject_guess  (akinator_beam_t   *beam);
+
+akinator_error_t akinator_beam_dtor          (akinator_beam_t   *beam);
+
+#endif
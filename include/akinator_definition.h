@@ -0,0 +1,88 @@
+#ifndef AKINATOR_DEFINITION_H
+#define AKINATOR_DEFINITION_H
+
+#include <stddef.h>
+
+#include "akinator_errors.h"
+#include "akinator_flow.h"
+
+//definitions are built the same way for every tree that can give a way from the root
+//to an object, way_t only has to provide
+//  size_t      akinator_way_size    (const way_t *way)               questions above the object
+//  const char *akinator_way_question(const way_t *way, size_t step)  step 0 is the root
+//  bool        akinator_way_no      (const way_t *way, size_t step)  the way goes on to the no child
+template <typename way_t>
+akinator_error_t akinator_way_element(const way_t           *way,
+                                      size_t                 step,
+                                      akinator_definition_t *definition) {
+    if(akinator_way_no(way, step)) {
+        RETURN_IF_ERROR(akinator_add_definition(definition, "не "));
+    }
+    RETURN_IF_ERROR(akinator_add_definition(definition, "%s", akinator_way_question(way, step)));
+    if(step + 1 != akinator_way_size(way)) {
+        RETURN_IF_ERROR(akinator_add_definition(definition, ",\n"));
+    }
+    return AKINATOR_SUCCESS;
+}
+
+template <typename way_t>
+akinator_error_t akinator_way_define(const way_t           *way,
+                                     const char            *object,
+                                     akinator_definition_t *definition) {
+    size_t size = akinator_way_size(way);
+    if(size == 0) {
+        return AKINATOR_INVALID_NODE_LEVEL;
+    }
+
+    RETURN_IF_ERROR(akinator_add_definition(definition, "%s - это ", object));
+    if(akinator_way_no(way, 0)) {
+        RETURN_IF_ERROR(akinator_add_definition(definition, "не "));
+    }
+    RETURN_IF_ERROR(akinator_add_definition(definition, "%s, который ", akinator_way_question(way, 0)));
+    for(size_t step = 1; step < size; step++) {
+        RETURN_IF_ERROR(akinator_way_element(way, step, definition));
+    }
+    return AKINATOR_SUCCESS;
+}
+
+//both ways start at the same root, so the same turns lead through the same questions
+template <typename way_t>
+akinator_error_t akinator_way_differ(const way_t           *first_way,
+                                     const char            *first,
+                                     const way_t           *second_way,
+                                     const char            *second,
+                                     akinator_definition_t *definition) {
+    size_t first_size  = akinator_way_size(first_way);
+    size_t second_size = akinator_way_size(second_way);
+    if(first_size == 0 || second_size == 0) {
+        return AKINATOR_INVALID_NODE_LEVEL;
+    }
+
+    size_t common = 0;
+    while(common < first_size && common < second_size &&
+          akinator_way_no(first_way, common) == akinator_way_no(second_way, common)) {
+        common++;
+    }
+
+    if(common != 0) {
+        RETURN_IF_ERROR(akinator_add_definition(definition, "Они оба "));
+    }
+    for(size_t step = 0; step < common; step++) {
+        RETURN_IF_ERROR(akinator_way_element(first_way, step, definition));
+    }
+    if(common != 0) {
+        RETURN_IF_ERROR(akinator_add_definition(definition, "но "));
+    }
+
+    RETURN_IF_ERROR(akinator_add_definition(definition, "%s ", first));
+    for(size_t step = common; step < first_size; step++) {
+        RETURN_IF_ERROR(akinator_way_element(first_way, step, definition));
+    }
+    RETURN_IF_ERROR(akinator_add_definition(definition, ", а %s ", second));
+    for(size_t step = common; step < second_size; step++) {
+        RETURN_IF_ERROR(akinator_way_element(second_way, step, definition));
+    }
+    return AKINATOR_SUCCESS;
+}
+
+#endif
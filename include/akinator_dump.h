@@ -1,8 +1,12 @@
 #ifndef AKINATOR_DUMP_H
 #define AKINATOR_DUMP_H
 
+#include <stdint.h>
+#include <pthread.h>
+
 #include "akinator.h"
 #include "akinator_errors.h"
+#include "akinator_histogram.h"
 
 #define AKINATOR_DUMP(__akinator_pointer)\
     akinator_dump((__akinator_pointer),  \
@@ -10,6 +14,112 @@
                   __LINE__,              \
                   __PRETTY_FUNCTION__);  \
 
+//  trace   dumps are only recorded in the trace, akin_trace draws them afterwards
+//  report  dumps are also drawn while the game runs
+enum akinator_dump_mode_t {
+    DUMP_MODE_TRACE  = 0,
+    DUMP_MODE_REPORT = 1,
+};
+
+static const akinator_dump_mode_t DumpDefaultMode = DUMP_MODE_TRACE;
+
+enum akinator_dump_renderer_t {
+    DUMP_RENDERER_NATIVE   = 0,
+    DUMP_RENDERER_GRAPHVIZ = 1,
+};
+
+static const akinator_dump_renderer_t DumpDefaultRenderer = DUMP_RENDERER_NATIVE;
+
+static const size_t DumpQueueCapacity = 64;
+static const size_t DumpBatchCapacity = 16;
+static const size_t DumpNoChild       = 0;
+
+//a page is closed once it has DumpPageMaxDumps dumps or its html and images take
+//DumpPageMaxBytes, the oldest pages are removed while there are more than DumpMaxPages
+//of them or all of them take more than DumpMaxDiskBytes
+static const size_t DumpPageMaxDumps  = 64;
+static const size_t DumpPageMaxBytes  = 8  << 20;
+static const size_t DumpMaxPages      = 32;
+static const size_t DumpMaxDiskBytes  = 64 << 20;
+
+//questions are not copied, their storage lives until the tree is destroyed and a
+//published question never changes, children are indices, the root is entry 0 so
+//DumpNoChild marks a leaf
+struct akinator_dump_entry_t {
+    const char *question;
+    size_t      yes;
+    size_t      no;
+    size_t      level;
+};
+
+//bytes are the page and every image and dot file of its dumps
+struct akinator_dump_page_t {
+    size_t number;
+    size_t first_dump;
+    size_t last_dump;
+    size_t dumps_number;
+    size_t bytes;
+};
+
+//caller strings are __FILE__ and __PRETTY_FUNCTION__ literals, hashes are filled in by
+//the worker, a subtree hash covers its question pointers and shape
+struct akinator_dump_job_t {
+    akinator_dump_entry_t *entries;
+    size_t                 entries_number;
+    size_t                 number;
+    uint64_t              *hashes;
+    const char            *caller_file;
+    size_t                 caller_line;
+    const char            *caller_func;
+};
+
+//akinator_dump only snapshots the tree breadth first and queues it, a full queue
+//makes the caller wait for the worker, the page is written by the worker alone
+//every dump is compared with the one before it, an unchanged tree only points to the
+//image already shown, a change below one subtree smaller than half of the tree
+//renders that subtree and links the last full image, anything else is drawn whole
+//the first dump of every page is drawn whole, so a page only links images of its own
+//dumps and can be removed with them, akin.html is an index of the pages still on disk
+//  native    worker lays the tree out itself and writes the svg, no tools needed
+//  graphviz  worker writes dot files and renders a whole batch with one dot process
+struct akinator_dump_t {
+    akinator_dump_renderer_t   renderer;
+    pthread_t                  worker;
+    pthread_mutex_t            lock;
+    pthread_cond_t             changed;
+    akinator_dump_job_t        queue[DumpQueueCapacity];
+    size_t                     queue_head;
+    size_t                     queue_size;
+    akinator_node_t          **pending;
+    size_t                     pending_capacity;
+    FILE                      *page;
+    akinator_dump_page_t       pages[DumpMaxPages];
+    size_t                     pages_head;
+    size_t                     pages_number;
+    size_t                     planned_pages;
+    size_t                     page_dumps;
+    size_t                     page_bytes;
+    size_t                     disk_bytes;
+    size_t                     removed_pages;
+    akinator_dump_job_t        previous;
+    size_t                     shown_image;
+    size_t                     full_image;
+    bool                       started;
+    bool                       busy;
+    int                        stop;
+    akinator_error_t           error;
+    size_t                     rendered_number;
+    size_t                     failed_number;
+    size_t                     full_number;
+    size_t                     partial_number;
+    size_t                     unchanged_number;
+    size_t                     rendered_nodes;
+    size_t                     batches_number;
+    size_t                     waits_number;
+    uint64_t                   render_ns;
+    akinator_histogram_t       caller_time;
+};
+
 akinator_error_t akinator_dump      (akinator_t *akinator,
                                      const char *caller_file,
                                      size_t      caller_line,
@@ -17,4 +127,6 @@ akinator_error_t akinator_dump      (akinator_t *akinator,
 
 akinator_error_t akinator_dump_init (akinator_t *akinator);
 
+akinator_error_t akinator_dump_dtor (akinator_t *akinator);
+
 #endif
@@ -0,0 +1,34 @@
+#ifndef AKINATOR_ENCODING_H
+#define AKINATOR_ENCODING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "akinator_errors.h"
+
+static const size_t EncodingMaxUtf8Ratio = 3;
+
+//database, console and sources are cp1251, graphviz wants utf-8 and sapi utf-16
+//sizes are in bytes for char strings and in units for utf-16, nothing is terminated,
+//output_capacity of EncodingMaxUtf8Ratio * input_size is always enough for utf-8
+//runs of ascii are copied 16 bytes at a time with sse2, 8 bytes without it
+//characters cp1251 does not have become '?', so does broken utf-8
+akinator_error_t akinator_cp1251_to_utf8  (const char     *input,
+                                           size_t          input_size,
+                                           char           *output,
+                                           size_t          output_capacity,
+                                           size_t         *output_size);
+
+akinator_error_t akinator_cp1251_to_utf16 (const char     *input,
+                                           size_t          input_size,
+                                           uint16_t       *output,
+                                           size_t          output_capacity,
+                                           size_t         *output_size);
+
+akinator_error_t akinator_utf8_to_cp1251  (const char     *input,
+                                           size_t          input_size,
+                                           char           *output,
+                                           size_t          output_capacity,
+                                           size_t         *output_size);
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef AKINATOR_EPOCH_H
+#define AKINATOR_EPOCH_H
+
+#include <stddef.h>
+
+#include "akinator_errors.h"
+
+static const size_t EpochMaxReaders = 128;
+static const size_t EpochQuiescent  = 0;
+
+struct akinator_epoch_retired_t {
+    void   *pointer;
+    size_t  epoch;
+};
+
+//readers publish the epoch they entered with, memory retired in epoch E
+//is freed once every active reader has entered after E
+struct akinator_epoch_t {
+    size_t                    global;
+    size_t                    readers[EpochMaxReaders];
+    size_t                    readers_number;
+    akinator_epoch_retired_t *retired;
+    size_t                    retired_size;
+    size_t                    retired_capacity;
+};
+
+akinator_error_t akinator_epoch_ctor        (akinator_epoch_t *epoch);
+
+akinator_error_t akinator_epoch_register    (akinator_epoch_t *epoch,
+                                             size_t           *reader);
+
+akinator_error_t akinator_epoch_enter       (akinator_epoch_t *epoch,
+                                             size_t            reader);
+
+akinator_error_t akinator_epoch_exit        (akinator_epoch_t *epoch,
+                                             size_t            reader);
+
+akinator_error_t akinator_epoch_retire      (akinator_epoch_t *epoch,
+                                             void             *pointer);
+
+akinator_error_t akinator_epoch_collect     (akinator_epoch_t *epoch);
+
+akinator_error_t akinator_epoch_synchronize (akinator_epoch_t *epoch);
+
+akinator_error_t akinator_epoch_dtor        (akinator_epoch_t *epoch);
+
+#endif
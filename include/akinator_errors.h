@@ -34,7 +34,38 @@ enum akinator_error_t {
     AKINATOR_MESSAGE_SIZE_ERROR             = 29,
     AKINATOR_IMAGE_LOADING_ERROR            = 30,
     AKINATOR_UI_ENVIRONMENT_ERROR           = 31,
-    AKINATOR_NULL_FUNCTION_PARAMETER        = 32
+    AKINATOR_NULL_FUNCTION_PARAMETER        = 32,
+    AKINATOR_MATRIX_ALLOCATION_ERROR        = 33,
+    AKINATOR_BEAM_ALLOCATION_ERROR          = 34,
+    AKINATOR_SIMILAR_ALLOCATION_ERROR       = 35,
+    AKINATOR_INDEX_ALLOCATION_ERROR         = 36,
+    AKINATOR_NODE_NOT_LEAF                  = 37,
+    AKINATOR_SESSION_STATE_ERROR            = 38,
+    AKINATOR_SERVER_SOCKET_ERROR            = 39,
+    AKINATOR_SERVER_THREAD_ERROR            = 40,
+    AKINATOR_SERVER_ALLOCATION_ERROR        = 41,
+    AKINATOR_EPOCH_ERROR                    = 42,
+    AKINATOR_FLOW_ERROR                     = 43,
+    AKINATOR_TREE_REPLACED                  = 44,
+    AKINATOR_RELOAD_ERROR                   = 45,
+    AKINATOR_SHARED_ERROR                   = 46,
+    AKINATOR_ROUTER_ERROR                   = 47,
+    AKINATOR_REPLICATION_ERROR              = 48,
+    AKINATOR_REPLICA_READ_ONLY              = 49,
+    AKINATOR_PATCH_ERROR                    = 50,
+    AKINATOR_ENCODING_ERROR                 = 51,
+    AKINATOR_DUMP_WORKER_ERROR              = 52,
+    AKINATOR_TRACE_ERROR                    = 53,
+    AKINATOR_EXPORT_ERROR                   = 54,
+    AKINATOR_UI_ERROR                       = 55,
+    AKINATOR_JOURNAL_ERROR                  = 56,
 };
 
+#define RETURN_IF_ERROR(...) {   /*FUNCTION CALL ONLY*/          \
+    akinator_error_t __error_code = __VA_ARGS__;                 \
+    if(__error_code != AKINATOR_SUCCESS) {                       \
+        return __error_code;                                     \
+    }                                                            \
+}
+
 #endif
@@ -0,0 +1,44 @@
+#ifndef AKINATOR_EXPORT_H
+#define AKINATOR_EXPORT_H
+
+#include <stddef.h>
+
+#include "akinator_errors.h"
+
+struct akinator_t;
+
+static const char   ExportDefaultFolder[]  = "logs/export";
+static const size_t ExportDefaultDepth     = 6;
+static const size_t ExportDefaultCollapse  = 8;
+static const size_t ExportDefaultRadius    = 2;
+
+//a view is drawn depth levels down from its root, below that and in place of any
+//subtree with less than collapse objects there is one summary node with the numbers
+//of objects and questions, a view with less than collapse objects is drawn whole
+//focus is an object, its view is the path from the root to it, every other child of
+//the path is drawn radius levels down, without focus the view starts at the root
+//paginate gives every summary node a page of its own with the summary as its root,
+//summaries link to their pages and pages link back to the one they were opened from
+struct akinator_export_options_t {
+    size_t      depth;
+    size_t      collapse;
+    const char *focus;
+    size_t      radius;
+    bool        paginate;
+};
+
+//pages are <folder>/tree_<node id>.dot and <folder>/focus.dot, links point to the
+//.svg graphviz makes of them
+struct akinator_export_stats_t {
+    size_t pages_number;
+    size_t nodes_number;
+    size_t summaries_number;
+    size_t largest_page;
+};
+
+akinator_error_t akinator_export (akinator_t                      *akinator,
+                                  const akinator_export_options_t *options,
+                                  const char                      *folder,
+                                  akinator_export_stats_t         *stats);
+
+#endif
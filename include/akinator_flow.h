@@ -0,0 +1,114 @@
+#ifndef AKINATOR_FLOW_H
+#define AKINATOR_FLOW_H
+
+#include <stddef.h>
+#include <coroutine>
+
+#include "akinator.h"
+#include "akinator_errors.h"
+
+static const size_t MaxDefinitionSize = 512;
+static const size_t SearchShownNumber = 5;
+
+enum akinator_flow_input_t {
+    AKINATOR_FLOW_INPUT_NONE   = 0,
+    AKINATOR_FLOW_INPUT_ANSWER = 1,
+    AKINATOR_FLOW_INPUT_TEXT   = 2,
+};
+
+//filled by the flow on every suspension, buffer belongs to the driver and is
+//shared by all of its flows, text has to stay alive until the next suspension
+//asked is the node whose question is in buffer, drivers may look ahead at its children
+struct akinator_flow_io_t {
+    std::coroutine_handle<>  resume_point;
+    char                    *buffer;
+    size_t                   buffer_size;
+    akinator_flow_input_t    input;
+    akinator_answer_t        answer;
+    const char              *text;
+    akinator_node_t         *asked;
+};
+
+struct akinator_definition_t {
+    char   *definition;
+    size_t  index;
+    size_t  capacity;
+};
+
+//flow frame is a plain handle, top level flows are destroyed with akinator_flow_dtor
+//together with the awaited flow they are suspended in, finished awaited flows are
+//destroyed by the awaiting flow
+struct akinator_flow_t {
+    struct promise_type;
+    using handle_t = std::coroutine_handle<promise_type>;
+
+    struct final_awaiter_t {
+        bool                    await_ready  (void) noexcept { return false; }
+        std::coroutine_handle<> await_suspend(handle_t handle) noexcept;
+        void                    await_resume (void) noexcept {}
+    };
+
+    struct promise_type {
+        akinator_error_t result       = AKINATOR_SUCCESS;
+        handle_t         continuation = nullptr;
+        handle_t         child        = nullptr;
+
+        static void    *operator new                          (size_t size) noexcept;
+        static void     operator delete                       (void *frame, size_t size) noexcept;
+        static akinator_flow_t get_return_object_on_allocation_failure(void) noexcept { return {}; }
+
+        akinator_flow_t     get_return_object  (void) noexcept { return {handle_t::from_promise(*this)}; }
+        std::suspend_always initial_suspend    (void) noexcept { return {}; }
+        final_awaiter_t     final_suspend      (void) noexcept { return {}; }
+        void                return_value       (akinator_error_t error_code) noexcept { result = error_code; }
+        void                unhandled_exception(void) noexcept { result = AKINATOR_FLOW_ERROR; }
+    };
+
+    handle_t handle;
+
+    bool                    await_ready  (void) noexcept { return !handle; }
+    std::coroutine_handle<> await_suspend(handle_t awaiting) noexcept;
+    akinator_error_t        await_resume (void) noexcept;
+};
+
+#define CO_RETURN_IF_ERROR(...) {   /*FUNCTION CALL OR CO_AWAIT ONLY*/ \
+    akinator_error_t __error_code = __VA_ARGS__;                       \
+    if(__error_code != AKINATOR_SUCCESS) {                             \
+        co_return __error_code;                                        \
+    }                                                                  \
+}
+
+akinator_flow_t  akinator_flow_guess           (akinator_t            *akinator,
+                                                akinator_flow_io_t    *io);
+
+akinator_flow_t  akinator_flow_learn           (akinator_t            *akinator,
+                                                akinator_flow_io_t    *io,
+                                                akinator_node_t       *leaf);
+
+akinator_flow_t  akinator_flow_definition      (akinator_t            *akinator,
+                                                akinator_flow_io_t    *io);
+
+akinator_flow_t  akinator_flow_difference      (akinator_t            *akinator,
+                                                akinator_flow_io_t    *io);
+
+akinator_flow_t  akinator_flow_similar         (akinator_t            *akinator,
+                                                akinator_flow_io_t    *io);
+
+akinator_flow_t  akinator_flow_search          (akinator_t            *akinator,
+                                                akinator_flow_io_t    *io);
+
+akinator_error_t akinator_flow_resume          (akinator_flow_t       *flow,
+                                                akinator_flow_io_t    *io);
+
+bool             akinator_flow_done            (akinator_flow_t       *flow);
+
+akinator_error_t akinator_flow_result          (akinator_flow_t       *flow);
+
+akinator_error_t akinator_flow_dtor            (akinator_flow_t       *flow);
+
+size_t           akinator_flow_allocated_bytes (void);
+
+akinator_error_t akinator_add_definition       (akinator_definition_t *definition,
+                                                const char            *format, ...);
+
+#endif
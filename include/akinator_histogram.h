@@ -0,0 +1,31 @@
+#ifndef AKINATOR_HISTOGRAM_H
+#define AKINATOR_HISTOGRAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "akinator_errors.h"
+
+static const size_t HistogramSubBits       = 6;
+static const size_t HistogramSubBuckets    = 1 << HistogramSubBits;
+static const size_t HistogramBucketsNumber = (64 - HistogramSubBits + 1) * HistogramSubBuckets;
+
+//values below HistogramSubBuckets are exact, bigger ones keep 6 significant bits
+struct akinator_histogram_t {
+    size_t   buckets[HistogramBucketsNumber];
+    size_t   count;
+    uint64_t max;
+    uint64_t sum;
+};
+
+akinator_error_t akinator_histogram_add        (akinator_histogram_t       *histogram,
+                                                uint64_t                    value);
+
+akinator_error_t akinator_histogram_merge      (akinator_histogram_t       *destination,
+                                                const akinator_histogram_t *source);
+
+akinator_error_t akinator_histogram_percentile (const akinator_histogram_t *histogram,
+                                                double                      percentile,
+                                                uint64_t                   *value);
+
+#endif
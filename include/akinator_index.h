@@ -0,0 +1,66 @@
+#ifndef AKINATOR_INDEX_H
+#define AKINATOR_INDEX_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "akinator_errors.h"
+
+struct akinator_t;
+struct akinator_node_t;
+
+enum akinator_index_mode_t {
+    AKINATOR_INDEX_AND = 0,
+    AKINATOR_INDEX_OR  = 1,
+};
+
+struct akinator_index_posting_t {
+    char    *word;
+    uint8_t *data;
+    size_t   size;
+    size_t   capacity;
+    size_t   count;
+    size_t   last_id;
+};
+
+struct akinator_index_t {
+    akinator_index_posting_t *table;
+    size_t                    table_capacity;
+    size_t                    words_number;
+    size_t                   *subtree_sizes;
+    size_t                    subtree_capacity;
+};
+
+struct akinator_index_result_t {
+    akinator_node_t **nodes;
+    size_t           *subtree_sizes;
+    size_t           *scratch;
+    size_t            size;
+    size_t            capacity;
+};
+
+akinator_error_t akinator_index_build        (akinator_index_t        *index,
+                                              akinator_t              *akinator);
+
+akinator_error_t akinator_index_add_question (akinator_index_t        *index,
+                                              akinator_node_t         *node);
+
+akinator_error_t akinator_index_rename       (akinator_index_t        *index,
+                                              akinator_node_t         *node,
+                                              const char              *old_text);
+
+akinator_error_t akinator_index_lift         (akinator_index_t        *index,
+                                              akinator_node_t         *node,
+                                              akinator_node_t         *dropped);
+
+akinator_error_t akinator_index_query        (akinator_index_t        *index,
+                                              akinator_t              *akinator,
+                                              const char              *query,
+                                              akinator_index_mode_t    mode,
+                                              akinator_index_result_t *result);
+
+akinator_error_t akinator_index_result_dtor  (akinator_index_result_t *result);
+
+akinator_error_t akinator_index_dtor         (akinator_index_t        *index);
+
+#endif
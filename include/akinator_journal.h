@@ -0,0 +1,49 @@
+#ifndef AKINATOR_JOURNAL_H
+#define AKINATOR_JOURNAL_H
+
+#include <stdio.h>
+#include <time.h>
+#include <limits.h>
+#include <sys/types.h>
+
+#include "akinator.h"
+#include "akinator_errors.h"
+
+static const size_t JournalCompactRecords = 4096;
+static const size_t JournalMaxWay         = 256;
+
+//learned objects are appended to <database>.journal and synced once per batch, the
+//database itself is rewritten only when the journal holds JournalCompactRecords
+//records, then the journal starts again
+//  akinator journal <inode> <seconds> <nanoseconds>
+//  <way>\t<object>\t<question>
+//the first line names the database file the records go on top of, a journal found
+//next to any other file is stale and dropped, so a rewrite that dies before the
+//journal is started again loses nothing
+//way has + or - for every answer from the root down to the leaf the object split,
+//a last line without its newline is a write cut by a crash and is dropped
+struct akinator_journal_t {
+    FILE   *file;
+    char    name[PATH_MAX];
+    size_t  records_number;
+};
+
+akinator_error_t akinator_journal_ctor   (akinator_journal_t       *journal,
+                                          akinator_t               *akinator,
+                                          ino_t                     inode,
+                                          const struct timespec    *modified);
+
+akinator_error_t akinator_journal_append (akinator_journal_t       *journal,
+                                          akinator_node_t          *question_node,
+                                          const char               *object,
+                                          const char               *question);
+
+akinator_error_t akinator_journal_sync   (akinator_journal_t       *journal);
+
+akinator_error_t akinator_journal_reset  (akinator_journal_t       *journal,
+                                          ino_t                     inode,
+                                          const struct timespec    *modified);
+
+akinator_error_t akinator_journal_dtor   (akinator_journal_t       *journal);
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef AKINATOR_LAYOUT_H
+#define AKINATOR_LAYOUT_H
+
+#include <stdint.h>
+
+#include "akinator_errors.h"
+#include "akinator_dump.h"
+
+static const int32_t LayoutMinSeparation = 2;
+
+//x is in half separations, siblings are LayoutMinSeparation apart at least and so are
+//any two nodes of one level, parents are centered over their children, x of the
+//leftmost node is 0
+struct akinator_layout_t {
+    int32_t *x;
+    size_t   nodes_number;
+    int32_t  width;
+    size_t   depth;
+};
+
+akinator_error_t akinator_layout_ctor (akinator_layout_t         *layout,
+                                       const akinator_dump_job_t *job);
+
+akinator_error_t akinator_layout_dtor (akinator_layout_t         *layout);
+
+#endif
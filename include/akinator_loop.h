@@ -0,0 +1,62 @@
+#ifndef AKINATOR_LOOP_H
+#define AKINATOR_LOOP_H
+
+#include <stdint.h>
+#include <time.h>
+
+#include "akinator.h"
+#include "akinator_errors.h"
+#include "akinator_flow.h"
+
+static const char   LoopDefaultSocket[] = "/tmp/akinator_loop.sock";
+static const size_t LoopMaxEvents       = 256;
+static const size_t LoopMaxLine         = 2 * MaxQuestionSize + 16;
+static const int    LoopPollTimeout     = 100;
+static const int    LoopListenBacklog   = 1024;
+
+//every connection runs one flow at a time on the loop thread:
+//  guess | definition | difference | similar | search -> flow lines until done <code>
+//  answer <0..4>                                       -> continues a flow that asked
+//  text <string>                                       -> continues a flow that reads
+//  quit
+//flow lines are say <message> | ask <message> | read <message>, newlines are sent as spaces
+//idle connection keeps only this struct and the suspended flow frame, partial input
+//lines are the only thing allocated on top of it
+struct akinator_loop_connection_t {
+    akinator_flow_t     flow;
+    akinator_flow_io_t  io;
+    char               *pending;
+    uint32_t            pending_size;
+    int                 socket;
+};
+
+struct akinator_loop_t {
+    akinator_t      *akinator;
+    const char      *socket_path;
+    int              listen_socket;
+    int              epoll;
+    char             message[MaxDefinitionSize];
+    char             line   [LoopMaxLine];
+    size_t           connections_number;
+    size_t           flows_started;
+    size_t           flows_finished;
+    size_t           resumes_number;
+    volatile int     stop;
+    struct timespec  start_time;
+};
+
+akinator_error_t akinator_loop_ctor         (akinator_loop_t            *loop,
+                                             akinator_t                 *akinator,
+                                             const char                 *socket_path);
+
+akinator_error_t akinator_loop_run          (akinator_loop_t            *loop);
+
+akinator_error_t akinator_loop_start_flow   (akinator_loop_t            *loop,
+                                             akinator_loop_connection_t *connection,
+                                             const char                 *name);
+
+akinator_error_t akinator_loop_print_stats  (akinator_loop_t            *loop);
+
+akinator_error_t akinator_loop_dtor         (akinator_loop_t            *loop);
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef AKINATOR_MATRIX_H
+#define AKINATOR_MATRIX_H
+
+#include <stdint.h>
+
+#include "akinator.h"
+#include "akinator_errors.h"
+
+static const size_t MatrixNoIndex = (size_t)-1;
+
+/*
+ * Column of the object x question matrix. Objects are numbered in DFS order
+ * (yes before no), so objects answering "yes" form the run [yes_begin, no_begin)
+ * and objects answering "no" form the run [no_begin, end). Objects outside
+ * of [yes_begin, end) never reach the question, their answer is unknown.
+ */
+struct akinator_matrix_question_t {
+    akinator_node_t *node;
+    size_t           yes_begin;
+    size_t           no_begin;
+    size_t           end;
+    size_t           yes_question;
+    size_t           no_question;
+};
+
+struct akinator_matrix_t {
+    akinator_node_t            **objects;
+    size_t                       objects_number;
+    akinator_matrix_question_t  *questions;
+    size_t                       questions_number;
+    uint64_t                    *candidates;
+    uint64_t                    *asked;
+    size_t                      *words_prefix;
+    size_t                       words_number;
+    size_t                       candidates_number;
+    size_t                      *search_stack;
+    size_t                       current_question;
+    size_t                       current_guess;
+};
+
+akinator_error_t akinator_matrix_ctor          (akinator_matrix_t *matrix,
+                                                akinator_t        *akinator);
+
+akinator_error_t akinator_matrix_reset         (akinator_matrix_t *matrix);
+
+akinator_error_t akinator_matrix_next_question (akinator_matrix_t *matrix,
+                                                akinator_node_t  **question);
+
+akinator_error_t akinator_matrix_answer        (akinator_matrix_t *matrix,
+                                                akinator_answer_t  answer);
+
+akinator_error_t akinator_matrix_get_guess     (akinator_matrix_t *matrix,
+                                                akinator_node_t  **object);
+
+akinator_error_t akinator_matrix_reject_guess  (akinator_matrix_t *matrix);
+
+akinator_error_t akinator_matrix_dtor          (akinator_matrix_t *matrix);
+
+#endif
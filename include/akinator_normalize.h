@@ -0,0 +1,22 @@
+#ifndef AKINATOR_NORMALIZE_H
+#define AKINATOR_NORMALIZE_H
+
+#include "akinator.h"
+#include "akinator_errors.h"
+
+struct akinator_normalize_stats_t {
+    size_t nodes_before;
+    size_t nodes_after;
+    double depth_before;
+    double depth_after;
+    size_t removed_questions;
+    size_t merged_leafs;
+    size_t duplicate_leafs;
+};
+
+akinator_error_t akinator_normalize       (akinator_t                 *akinator,
+                                           akinator_normalize_stats_t *stats);
+
+akinator_error_t akinator_normalize_print (akinator_normalize_stats_t *stats);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef AKINATOR_PATCH_H
+#define AKINATOR_PATCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "akinator.h"
+#include "akinator_errors.h"
+
+static const char   PatchMagic[]  = "AKPATCH1";
+static const size_t PatchMaxDepth = 4096;
+
+enum akinator_patch_operation_t {
+    AKINATOR_PATCH_END    = 'E',
+    AKINATOR_PATCH_SPLIT  = 'S',
+    AKINATOR_PATCH_RENAME = 'R',
+    AKINATOR_PATCH_LIFT   = 'L',
+};
+
+//a patch is the magic followed by operations, each one is
+//  kind | depth (uint16) | way, (depth + 7) / 8 bytes, bit i set when step i is no |
+//  guard | arguments
+//strings are a length byte and the bytes, guard is the text the node at way has to have
+//  split  <question> <object>  leaf at way becomes question, object is its yes, the
+//                              leaf stays as no
+//  rename <text>               node at way gets text
+//  lift   <kept>               question at way is replaced by its yes (0) or no (1) child,
+//                              the other branch is dropped
+//operations refer to the tree as the previous ones left it, so they are applied in order
+//and each costs a walk from the root, nothing else in the tree is read
+struct akinator_patch_stats_t {
+    size_t splits;
+    size_t renames;
+    size_t lifts;
+    size_t size;
+};
+
+akinator_error_t akinator_patch_diff  (akinator_t             *old_tree,
+                                       akinator_t             *new_tree,
+                                       FILE                   *patch,
+                                       akinator_patch_stats_t *stats);
+
+akinator_error_t akinator_patch_apply (akinator_t             *akinator,
+                                       FILE                   *patch,
+                                       akinator_patch_stats_t *stats);
+
+akinator_error_t akinator_patch_print (akinator_patch_stats_t *stats);
+
+#endif
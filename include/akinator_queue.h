@@ -0,0 +1,31 @@
+#ifndef AKINATOR_QUEUE_H
+#define AKINATOR_QUEUE_H
+
+#include <stddef.h>
+
+#include "akinator_errors.h"
+
+struct akinator_queue_node_t {
+    akinator_queue_node_t *next;
+};
+
+//intrusive multi-producer single-consumer list, producers swap head and link the
+//previous node, consumer walks from tail, stub keeps the list non-empty, so the
+//queue must not be moved after ctor
+struct akinator_queue_t {
+    akinator_queue_node_t *head;
+    akinator_queue_node_t *tail;
+    akinator_queue_node_t  stub;
+    size_t                 depth;
+};
+
+akinator_error_t       akinator_queue_ctor  (akinator_queue_t      *queue);
+
+akinator_error_t       akinator_queue_push  (akinator_queue_t      *queue,
+                                             akinator_queue_node_t *node);
+
+akinator_queue_node_t *akinator_queue_pop   (akinator_queue_t      *queue);
+
+size_t                 akinator_queue_depth (akinator_queue_t      *queue);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef AKINATOR_RELOAD_H
+#define AKINATOR_RELOAD_H
+
+#include <pthread.h>
+#include <limits.h>
+
+#include "akinator_errors.h"
+#include "akinator_server.h"
+
+//database file is watched through its directory, editors and akinator_save_database
+//replace it with a rename, so a watch on the file itself would go stale
+//a changed file is read and verified on the reload thread, the writer switches to it
+//between batches and the old tree waits in draining until its last session is gone
+struct akinator_reload_t {
+    akinator_server_t     *server;
+    pthread_t              thread;
+    int                    notify;
+    int                    watch;
+    char                   directory[PATH_MAX];
+    const char            *file_name;
+    akinator_generation_t *draining;
+    size_t                 reloads_number;
+    size_t                 rejected_number;
+    size_t                 freed_number;
+    volatile int           stop;
+};
+
+akinator_error_t akinator_reload_ctor        (akinator_reload_t *reload,
+                                              akinator_server_t *server);
+
+akinator_error_t akinator_reload_print_stats (akinator_reload_t *reload);
+
+akinator_error_t akinator_reload_dtor        (akinator_reload_t *reload);
+
+#endif
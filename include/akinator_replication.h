@@ -0,0 +1,111 @@
+#ifndef AKINATOR_REPLICATION_H
+#define AKINATOR_REPLICATION_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <limits.h>
+
+#include "akinator.h"
+#include "akinator_errors.h"
+#include "akinator_server.h"
+#include "akinator_histogram.h"
+
+static const size_t ReplicationLogCapacity = 1 << 16;
+static const size_t ReplicationPathSize    = ServerMaxWay / 8;
+static const int    ReplicationSaveMs      = 200;
+
+//a record says which leaf was replaced by question with object as its yes answer,
+//the leaf is named by its way from the root, bit i set when answer i was no, so the
+//record means the same in any process holding the same tree however it was loaded
+//on the wire the header is followed by (depth + 7) / 8 bytes of the way, object and
+//question, sizes are in the header and strings carry no terminator
+struct akinator_replication_header_t {
+    uint64_t sequence;
+    uint64_t committed_ns;
+    uint16_t depth;
+    uint16_t object_size;
+    uint16_t question_size;
+    uint16_t padding;
+};
+
+struct akinator_replication_record_t {
+    akinator_replication_header_t header;
+    uint8_t                       way     [ReplicationPathSize];
+    char                          object  [MaxQuestionSize + 1];
+    char                          question[MaxQuestionSize + 1];
+};
+
+//primary keeps the last ReplicationLogCapacity records, a replica sends
+//  replicate <sequence>
+//and gets "ok <first>" followed by every record after sequence, or "gone <first>"
+//when records it needs are no longer kept, then it has to be seeded from a copy of
+//the primary database with its .journal and .seq files
+//sequence of the last staged record is stored in <database>.seq before the batch is
+//synced and records are streamed only after that
+struct akinator_replication_t {
+    akinator_server_t             *server;
+    const char                    *socket_path;
+    int                            listen_socket;
+    pthread_t                      listener;
+    pthread_mutex_t                lock;
+    pthread_cond_t                 published_signal;
+    akinator_replication_record_t *records;
+    uint64_t                       first;
+    uint64_t                       staged;
+    uint64_t                       published;
+    char                           sequence_name[PATH_MAX];
+    size_t                         replicas_number;
+    size_t                         senders_number;
+    volatile int                   stop;
+};
+
+//replica applies records on its own thread, it is the only one changing the tree,
+//players are served read only, lag is measured from the primary commit to the moment
+//the object can be guessed here, it is sub-millisecond at p50, the tail is the
+//scheduler's when primary, replica and players share one core, not the replica's work
+//the tree is saved every ReplicationSaveMs by a saver thread reading it like a session
+//does, so the disk never holds up the stream, records the saved file already has are
+//skipped after a restart
+struct akinator_replica_t {
+    akinator_server_t             *server;
+    const char                    *primary_path;
+    pthread_t                      thread;
+    pthread_t                      saver;
+    int                            socket;
+    uint64_t                       applied;
+    uint64_t                       saved;
+    char                           sequence_name[PATH_MAX];
+    akinator_replication_record_t  record;
+    akinator_histogram_t          *lag;
+    size_t                         skipped_number;
+    size_t                         connects_number;
+    akinator_error_t               error;
+    volatile int                   stop;
+};
+
+akinator_error_t akinator_replication_ctor        (akinator_replication_t *replication,
+                                                   akinator_server_t      *server,
+                                                   const char             *socket_path);
+
+akinator_error_t akinator_replication_stage       (akinator_replication_t *replication,
+                                                   akinator_node_t        *leaf,
+                                                   const char             *object,
+                                                   const char             *question);
+
+akinator_error_t akinator_replication_reserve     (akinator_replication_t *replication);
+
+akinator_error_t akinator_replication_publish     (akinator_replication_t *replication);
+
+akinator_error_t akinator_replication_print_stats (akinator_replication_t *replication);
+
+akinator_error_t akinator_replication_dtor        (akinator_replication_t *replication);
+
+akinator_error_t akinator_replica_ctor            (akinator_replica_t     *replica,
+                                                   akinator_server_t      *server,
+                                                   const char             *primary_path);
+
+akinator_error_t akinator_replica_print_stats     (akinator_replica_t     *replica);
+
+akinator_error_t akinator_replica_dtor            (akinator_replica_t     *replica);
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef AKINATOR_ROUTER_H
+#define AKINATOR_ROUTER_H
+
+#include <pthread.h>
+
+#include "akinator.h"
+#include "akinator_errors.h"
+#include "akinator_session.h"
+#include "akinator_server.h"
+
+static const char   RouterDefaultSocket[] = "/tmp/akinator_router.sock";
+static const char   RouterDatabaseName[]  = "router";
+static const char   RouterLinkPrefix[]    = "@shard_";
+static const size_t RouterMaxPath         = 256;
+static const size_t RouterMaxReply        = ServerMaxWay * (MaxQuestionSize + 2) + 16;
+
+//a split directory holds the top levels in router and every subtree cut at the split
+//depth in shard_<n>, each of them is a plain database served by its own akin_server
+//on shard_<n>.sock, the cut subtrees are leafs named @shard_<n> in router
+//
+//clients speak the server protocol to the router and two more requests:
+//  definition <object>         -> definition <text>
+//  difference <first>\t<second> -> difference <text>
+//a session is walked in the router until it reaches a link, from then on its lines are
+//forwarded to the shard until the next start
+struct akinator_router_step_t {
+    char question[MaxQuestionSize + 1];
+    bool no;
+};
+
+struct akinator_router_way_t {
+    akinator_router_step_t steps[ServerMaxWay];
+    size_t                 size;
+};
+
+struct akinator_router_t;
+
+struct akinator_router_connection_t {
+    akinator_router_t     *router;
+    pthread_t              thread;
+    int                    socket;
+    int                   *shard_sockets;
+    long                   shard;
+    akinator_session_t     session;
+    char                   buffer[ServerMaxLine];
+    size_t                 buffer_size;
+    char                   reply [RouterMaxReply];
+    akinator_router_way_t  ways[2];
+};
+
+struct akinator_router_t {
+    akinator_t        akinator;
+    char              database_name[RouterMaxPath];
+    const char       *directory;
+    const char       *socket_path;
+    int               listen_socket;
+    akinator_node_t **links;
+    size_t            shards_number;
+    pthread_mutex_t   learn_lock;
+    size_t            connections_number;
+    size_t            sessions_started;
+    size_t            handoffs_number;
+    size_t            queries_number;
+    volatile int      stop;
+};
+
+akinator_error_t akinator_router_split       (akinator_t        *akinator,
+                                              size_t             depth,
+                                              const char        *directory,
+                                              size_t            *shards_number);
+
+akinator_error_t akinator_router_ctor        (akinator_router_t *router,
+                                              const char        *directory,
+                                              const char        *socket_path);
+
+akinator_error_t akinator_router_run         (akinator_router_t *router);
+
+akinator_error_t akinator_router_print_stats (akinator_router_t *router);
+
+akinator_error_t akinator_router_dtor        (akinator_router_t *router);
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef AKINATOR_SERVER_H
+#define AKINATOR_SERVER_H
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "akinator.h"
+#include "akinator_errors.h"
+#include "akinator_session.h"
+#include "akinator_histogram.h"
+#include "akinator_epoch.h"
+#include "akinator_queue.h"
+#include "akinator_journal.h"
+
+static const char   ServerDefaultSocket[]  = "/tmp/akinator.sock";
+static const size_t ServerDefaultThreads   = 4;
+static const size_t ServerMaxThreads       = 64;
+static const size_t ServerMaxLine          = 2 * MaxQuestionSize + 16;
+static const int    ServerPollTimeout      = 100;
+static const int    ServerListenBacklog    = 128;
+static const size_t ServerDefaultBatch     = 64;
+static const size_t ServerDefaultLatencyUs = 2000;
+static const size_t ServerMaxWay           = 256;
+
+//protocol is line based request/response, one request in flight per connection:
+//  start                      -> ask <question> | guess <object>
+//  answer <0..4>              -> ask <question> | guess <object> | won | learn
+//  learn <object>\t<question> -> learned | error <code>
+//  way <object>               -> way[\t+<question>|\t-<question>]... | none
+//  quit
+//way lists the questions from the root down to the object with the answer given to each
+//sessions pin the tree they started on, a reloaded tree replaces current and the
+//old one is freed once its sessions are gone, inode and modified describe the file
+//the tree was read from
+struct akinator_generation_t {
+    akinator_t            *akinator;
+    size_t                 sessions;
+    int                    retired;
+    int                    owned;
+    ino_t                  inode;
+    struct timespec        modified;
+    akinator_generation_t *next_draining;
+};
+
+//learn replies are sent once the batch holding the object is on disk
+struct akinator_connection_t {
+    int                    socket;
+    akinator_session_t     session;
+    akinator_generation_t *generation;
+    char                   buffer[ServerMaxLine];
+    size_t                 buffer_size;
+    char                   object  [MaxQuestionSize + 1];
+    char                   question[MaxQuestionSize + 1];
+    akinator_queue_node_t  learn_node;
+    akinator_connection_t *next_batch;
+    uint64_t               learn_enqueued;
+    akinator_error_t       learn_result;
+};
+
+struct akinator_server_t;
+struct akinator_replication_t;
+
+struct akinator_server_worker_t {
+    pthread_t             thread;
+    akinator_server_t    *server;
+    akinator_histogram_t *answer_latency;
+    size_t                answers_number;
+    size_t                reader;
+};
+
+struct akinator_server_t {
+    akinator_generation_t     *current;
+    akinator_generation_t     *pending;
+    akinator_generation_t      initial;
+    pthread_mutex_t            save_lock;
+    ino_t                      saved_inode;
+    struct timespec            saved_time;
+    akinator_journal_t         journal;
+    const char                *socket_path;
+    int                        listen_socket;
+    int                        epoll;
+    akinator_epoch_t           epoch;
+    akinator_server_worker_t   workers[ServerMaxThreads];
+    size_t                     workers_number;
+    pthread_t                  writer;
+    akinator_queue_t           learn_queue;
+    sem_t                      learn_signal;
+    int                        writer_waiting;
+    size_t                     batch_size;
+    uint64_t                   batch_latency_ns;
+    akinator_histogram_t      *queue_depth;
+    akinator_histogram_t      *commit_latency;
+    size_t                     commits_number;
+    size_t                     sessions_started;
+    size_t                     sessions_finished;
+    size_t                     learned_number;
+    akinator_replication_t    *replication;
+    int                        read_only;
+    volatile int               stop;
+    struct timespec            start_time;
+};
+
+akinator_error_t akinator_server_ctor        (akinator_server_t     *server,
+                                              akinator_t            *akinator,
+                                              const char            *socket_path,
+                                              size_t                 threads_number);
+
+akinator_error_t akinator_server_set_batch   (akinator_server_t     *server,
+                                              size_t                 batch_size,
+                                              size_t                 latency_us);
+
+akinator_error_t akinator_server_run         (akinator_server_t     *server);
+
+akinator_error_t akinator_server_publish     (akinator_server_t     *server,
+                                              akinator_generation_t *generation);
+
+bool             akinator_server_file_changed(akinator_server_t     *server,
+                                              struct stat           *file);
+
+akinator_error_t akinator_server_stop        (akinator_server_t     *server);
+
+akinator_error_t akinator_server_print_stats (akinator_server_t     *server);
+
+akinator_error_t akinator_server_dtor        (akinator_server_t     *server);
+
+akinator_error_t akinator_generation_dtor    (akinator_generation_t *generation);
+
+#endif
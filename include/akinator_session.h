@@ -0,0 +1,49 @@
+#ifndef AKINATOR_SESSION_H
+#define AKINATOR_SESSION_H
+
+#include "akinator.h"
+#include "akinator_errors.h"
+
+enum akinator_session_state_t {
+    AKINATOR_SESSION_IDLE     = 0,
+    AKINATOR_SESSION_ASKING   = 1,
+    AKINATOR_SESSION_GUESSING = 2,
+    AKINATOR_SESSION_LEARNING = 3,
+    AKINATOR_SESSION_WON      = 4,
+    AKINATOR_SESSION_LEARNED  = 5,
+};
+
+enum akinator_direction_t {
+    AKINATOR_DIRECTION_STAY = 0,
+    AKINATOR_DIRECTION_YES  = 1,
+    AKINATOR_DIRECTION_NO   = 2,
+};
+
+struct akinator_session_t {
+    akinator_t               *akinator;
+    akinator_node_t          *current;
+    akinator_session_state_t  state;
+    size_t                    questions_asked;
+};
+
+akinator_error_t akinator_session_start            (akinator_session_t *session,
+                                                    akinator_t         *akinator);
+
+akinator_error_t akinator_session_current_question (akinator_session_t *session,
+                                                    const char        **question);
+
+//probably is taken as yes and probably not as no, don't know keeps the current node
+akinator_error_t akinator_session_answer           (akinator_session_t *session,
+                                                    akinator_answer_t   answer);
+
+//what an answer does to any session over a tree: an answered guess only changes the
+//state, an answered question gives the child to go to, the caller makes the move
+akinator_error_t akinator_session_direction        (akinator_session_state_t *state,
+                                                    akinator_answer_t         answer,
+                                                    akinator_direction_t     *direction);
+
+akinator_error_t akinator_session_learn            (akinator_session_t *session,
+                                                    const char         *object,
+                                                    const char         *question);
+
+#endif
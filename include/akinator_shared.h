@@ -0,0 +1,83 @@
+#ifndef AKINATOR_SHARED_H
+#define AKINATOR_SHARED_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "akinator.h"
+#include "akinator_errors.h"
+#include "akinator_flow.h"
+#include "akinator_session.h"
+
+static const char     SharedDefaultPath[] = "/dev/shm/akinator.tree";
+static const uint64_t SharedMagic         = 0x314d48534e494b41; //"AKINSHM1"
+static const uint32_t SharedNone          = UINT32_MAX;
+
+//published tree is one read only mapping, every link is a node number or an offset
+//into strings, so it means the same at any address in any process
+//  header | nodes[nodes_number] | leafs[leafs_number] | strings
+//nodes are laid out in preorder with the yes child next to its parent, leafs are
+//node numbers sorted by object name
+struct akinator_shared_node_t {
+    uint32_t question;
+    uint32_t yes;
+    uint32_t no;
+    uint32_t parent;
+};
+
+struct akinator_shared_header_t {
+    uint64_t magic;
+    uint64_t size;
+    uint32_t nodes_number;
+    uint32_t leafs_number;
+    uint32_t strings_size;
+    uint32_t depth;
+};
+
+struct akinator_shared_t {
+    const akinator_shared_header_t *header;
+    const akinator_shared_node_t   *nodes;
+    const uint32_t                 *leafs;
+    const char                     *strings;
+    size_t                          size;
+};
+
+//same states as akinator_session_t, learning stops at AKINATOR_SESSION_LEARNING
+struct akinator_shared_session_t {
+    akinator_shared_t        *shared;
+    uint32_t                  current;
+    akinator_session_state_t  state;
+    size_t                    questions_asked;
+};
+
+akinator_error_t akinator_shared_publish        (akinator_t                *akinator,
+                                                 const char                *path);
+
+akinator_error_t akinator_shared_attach         (akinator_shared_t         *shared,
+                                                 const char                *path);
+
+akinator_error_t akinator_shared_find           (akinator_shared_t         *shared,
+                                                 const char                *object,
+                                                 uint32_t                  *node_output);
+
+const char      *akinator_shared_question       (akinator_shared_t         *shared,
+                                                 uint32_t                   node);
+
+akinator_error_t akinator_shared_definition     (akinator_shared_t         *shared,
+                                                 uint32_t                   object,
+                                                 akinator_definition_t     *definition);
+
+akinator_error_t akinator_shared_difference     (akinator_shared_t         *shared,
+                                                 uint32_t                   first,
+                                                 uint32_t                   second,
+                                                 akinator_definition_t     *definition);
+
+akinator_error_t akinator_shared_session_start  (akinator_shared_session_t *session,
+                                                 akinator_shared_t         *shared);
+
+akinator_error_t akinator_shared_session_answer (akinator_shared_session_t *session,
+                                                 akinator_answer_t          answer);
+
+akinator_error_t akinator_shared_detach         (akinator_shared_t         *shared);
+
+#endif
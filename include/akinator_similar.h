@@ -0,0 +1,33 @@
+#ifndef AKINATOR_SIMILAR_H
+#define AKINATOR_SIMILAR_H
+
+#include "akinator.h"
+#include "akinator_errors.h"
+
+static const size_t SimilarObjectsNumber = 3;
+
+struct akinator_similar_entry_t {
+    akinator_node_t *node;
+    size_t           lca_depth;
+    size_t           distance;
+};
+
+struct akinator_similar_t {
+    akinator_similar_entry_t *queue;
+    size_t                    queue_size;
+    size_t                    queue_capacity;
+    akinator_similar_entry_t *result;
+    size_t                    result_size;
+    size_t                    result_capacity;
+};
+
+akinator_error_t akinator_similar_ctor (akinator_similar_t *similar,
+                                        size_t              capacity);
+
+akinator_error_t akinator_similar_find (akinator_similar_t *similar,
+                                        akinator_node_t    *object,
+                                        size_t              number);
+
+akinator_error_t akinator_similar_dtor (akinator_similar_t *similar);
+
+#endif
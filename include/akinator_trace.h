@@ -0,0 +1,156 @@
+#ifndef AKINATOR_TRACE_H
+#define AKINATOR_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "akinator_errors.h"
+
+struct akinator_t;
+
+static const char     TraceDefaultFilename[] = "logs/akin.trace";
+static const size_t   TraceDefaultCapacity   = 1 << 16;
+static const uint64_t TraceMagic             = 0x3245434152544b41; //"AKTRACE2"
+static const size_t   TraceMaxNameSize       = 128;
+static const size_t   TraceMaxTextRecords    = 16;
+static const size_t   TraceMaxTexts          = 2;
+
+//  visit      first is the node asked about
+//  answer     first is the node, second the answer
+//  split      first is the leaf, second the id of the new question, object id follows it,
+//             texts are the question and the object
+//  rename     first is the node, text is the new one
+//  lift       first is the question, second the kept answer
+//  normalize  tree went through akinator_normalize, first and second are the questions
+//             it removed and the leafs it merged
+//  dump       first is the caller line, texts are caller file and function
+//  error      same as dump, second is the error code
+//  text       up to 24 bytes of the texts of the event before it
+enum akinator_trace_type_t {
+    TRACE_EVENT_NONE      = 0,
+    TRACE_EVENT_VISIT     = 1,
+    TRACE_EVENT_ANSWER    = 2,
+    TRACE_EVENT_SPLIT     = 3,
+    TRACE_EVENT_RENAME    = 4,
+    TRACE_EVENT_LIFT      = 5,
+    TRACE_EVENT_NORMALIZE = 6,
+    TRACE_EVENT_DUMP      = 7,
+    TRACE_EVENT_ERROR     = 8,
+    TRACE_EVENT_TEXT      = 9,
+};
+
+struct akinator_trace_values_t {
+    uint64_t time;
+    uint64_t first;
+    uint64_t second;
+};
+
+//sequence is one more than the position the record was written at, it is stored
+//last, so a record the writer did not finish or that was overwritten since does
+//not match its position, texts is the number of text records right after it
+struct akinator_trace_event_t {
+    uint32_t sequence;
+    uint16_t type;
+    uint16_t texts;
+    union {
+        akinator_trace_values_t values;
+        char                    text[sizeof(akinator_trace_values_t)];
+    };
+};
+
+//the file is this header and capacity events, head is the next position and only
+//grows, an event is at position & (capacity - 1), node ids in events are ids in the
+//tree as it was when the trace started, that tree is saved next to it as <trace>.db,
+//changes counts split, rename, lift and normalize events
+//
+//the tree is saved again as <trace>.ckpt<slot>.db once head has passed half of the
+//ring, <trace>.ckpt<slot>.ids is checkpoint_head and then the ids of its nodes in the
+//order the database lists them, events from checkpoint_head on apply to that tree
+struct akinator_trace_header_t {
+    uint64_t magic;
+    uint64_t event_size;
+    uint64_t capacity;
+    uint64_t start_ns;
+    int64_t  start_time;
+    uint64_t nodes_number;
+    char     database[TraceMaxNameSize];
+    uint64_t checkpoint_head;
+    uint64_t checkpoint_nodes;
+    uint64_t checkpoint_changes;
+    uint64_t checkpoint_slot;
+    alignas(64) uint64_t head;
+    uint64_t changes;
+};
+
+//writers only reserve positions with one atomic add, the file is shared with the
+//kernel, so whatever was written survives the process
+//the first event that ends past next_checkpoint moves it on with one compare and swap
+//and sets checkpoint_due, the tree itself is saved by akinator_trace_checkpoint
+struct akinator_trace_t {
+    akinator_trace_header_t *header;
+    akinator_trace_event_t  *events;
+    uint64_t                 mask;
+    size_t                   size;
+    akinator_t              *akinator;
+    const char              *path;
+    uint64_t                 next_checkpoint;
+    int                      checkpoint_due;
+};
+
+//texts point into strings and live as long as the reader, position is where the event
+//is in the ring and end the position after its texts
+struct akinator_trace_record_t {
+    akinator_trace_type_t  type;
+    uint64_t               position;
+    uint64_t               end;
+    uint64_t               time;
+    uint64_t               first;
+    uint64_t               second;
+    const char            *texts[TraceMaxTexts];
+};
+
+//records are the events still in the ring oldest first, lost ones were overwritten,
+//torn ones were not finished or belong to an event that was
+struct akinator_trace_reader_t {
+    akinator_trace_header_t  header;
+    akinator_trace_record_t *records;
+    size_t                   records_number;
+    char                    *strings;
+    size_t                   lost_number;
+    size_t                   torn_number;
+};
+
+akinator_error_t akinator_trace_ctor        (akinator_t                *akinator,
+                                             const char                *path,
+                                             size_t                     capacity);
+
+akinator_error_t akinator_trace_node        (akinator_trace_t          *trace,
+                                             akinator_trace_type_t      type,
+                                             uint64_t                   first,
+                                             uint64_t                   second);
+
+akinator_error_t akinator_trace_text        (akinator_trace_t          *trace,
+                                             akinator_trace_type_t      type,
+                                             uint64_t                   first,
+                                             uint64_t                   second,
+                                             const char                *first_text,
+                                             const char                *second_text);
+
+akinator_error_t akinator_trace_error       (akinator_t                *akinator,
+                                             akinator_error_t           error,
+                                             const char                *caller_file,
+                                             size_t                     caller_line,
+                                             const char                *caller_func);
+
+akinator_error_t akinator_trace_checkpoint  (akinator_trace_t          *trace);
+
+akinator_error_t akinator_trace_dtor        (akinator_t                *akinator);
+
+bool             akinator_trace_is_change   (akinator_trace_type_t      type);
+
+akinator_error_t akinator_trace_read        (akinator_trace_reader_t   *reader,
+                                             const char                *path);
+
+akinator_error_t akinator_trace_reader_dtor (akinator_trace_reader_t   *reader);
+
+#endif
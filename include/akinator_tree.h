@@ -0,0 +1,46 @@
+#ifndef AKINATOR_TREE_H
+#define AKINATOR_TREE_H
+
+#include "akinator.h"
+#include "akinator_errors.h"
+
+akinator_error_t akinator_tree_ctor       (akinator_t       *akinator,
+                                           const char       *database_filename);
+
+akinator_error_t akinator_learn           (akinator_t       *akinator,
+                                           akinator_node_t  *leaf,
+                                           const char       *object,
+                                           const char       *question);
+
+akinator_error_t akinator_split_leaf      (akinator_t       *akinator,
+                                           akinator_node_t  *leaf,
+                                           const char       *object,
+                                           const char       *question);
+
+akinator_error_t akinator_rename_node     (akinator_t       *akinator,
+                                           akinator_node_t  *node,
+                                           const char       *text);
+
+akinator_error_t akinator_lift_node       (akinator_t       *akinator,
+                                           akinator_node_t  *node,
+                                           akinator_answer_t kept);
+
+akinator_error_t akinator_collect_leafs   (akinator_t       *akinator);
+
+akinator_error_t akinator_find_node       (akinator_t       *akinator,
+                                           const char       *object,
+                                           akinator_node_t **node_output);
+
+akinator_error_t akinator_update_database (akinator_t       *akinator);
+
+akinator_error_t akinator_save_database   (akinator_t       *akinator);
+
+akinator_error_t akinator_write_database  (akinator_t       *akinator,
+                                           const char       *filename);
+
+akinator_error_t akinator_write_subtree   (akinator_node_t  *root,
+                                           const char       *filename);
+
+akinator_error_t akinator_tree_dtor       (akinator_t       *akinator);
+
+#endif
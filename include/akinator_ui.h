@@ -0,0 +1,132 @@
+#ifndef AKINATOR_UI_H
+#define AKINATOR_UI_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "akinator_errors.h"
+#include "akinator_histogram.h"
+
+static const size_t   UiMaxDirty           = 16;
+static const size_t   UiMaxButtons         = 64;
+static const size_t   UiEventQueueCapacity = 64;
+static const uint32_t UiPollIntervalMs     = 15;
+static const int32_t  UiGlyphWidth         = 8;
+static const int32_t  UiGlyphHeight        = 14;
+static const uint32_t UiTextColor          = 0xffffff;
+static const uint32_t UiBoxColor           = 0x000000;
+static const uint32_t UiHighlightedColor   = 0x211211;
+static const uint32_t UiBackgroundColor    = 0x3c4f65;
+
+struct point_t {
+    double x;
+    double y;
+};
+
+//bottom is the smaller y, the screen y grows down
+struct rectangle_t {
+    double left;
+    double right;
+    double bottom;
+    double top;
+};
+
+//shortcuts are keys choosing the button with the same index, NULL or '\0' for none
+struct akinator_menu_t {
+    rectangle_t *button_boxes;
+    const char **labels;
+    const char  *shortcuts;
+    size_t       number;
+};
+
+//  window    txlib window, input is sampled every UiPollIntervalMs and only a change
+//            of it becomes an event, windows only
+//  headless  software framebuffer, events come from akinator_ui_post_event
+enum akinator_ui_backend_t {
+    UI_BACKEND_WINDOW   = 0,
+    UI_BACKEND_HEADLESS = 1,
+};
+
+enum akinator_ui_event_type_t {
+    UI_EVENT_NONE       = 0,
+    UI_EVENT_MOUSE_MOVE = 1,
+    UI_EVENT_MOUSE_DOWN = 2,
+    UI_EVENT_KEY        = 3,
+    UI_EVENT_QUIT       = 4,
+};
+
+enum akinator_ui_key_t {
+    UI_KEY_ENTER = '\r',
+    UI_KEY_UP    = 0x100,
+    UI_KEY_DOWN  = 0x101,
+};
+
+//key is a character or one of akinator_ui_key_t
+struct akinator_ui_event_t {
+    akinator_ui_event_type_t type;
+    point_t                  position;
+    int                      key;
+};
+
+//nothing is drawn between events, a change marks the rectangles it touches and the
+//next frame redraws and presents only those, pixels is the headless framebuffer
+struct akinator_ui_t {
+    akinator_ui_backend_t    backend;
+    int32_t                  width;
+    int32_t                  height;
+    uint32_t                *pixels;
+    rectangle_t              dirty[UiMaxDirty];
+    size_t                   dirty_number;
+    pthread_mutex_t          lock;
+    pthread_cond_t           changed;
+    akinator_ui_event_t      events[UiEventQueueCapacity];
+    size_t                   events_head;
+    size_t                   events_size;
+    point_t                  last_mouse;
+    bool                     last_button;
+    bool                     last_keys[UI_KEY_DOWN + 1];
+    size_t                   events_number;
+    size_t                   frames_number;
+    size_t                   drawn_pixels;
+    akinator_histogram_t     frame_time;
+};
+
+akinator_error_t akinator_ui_ctor       (akinator_ui_t             *ui,
+                                         akinator_ui_backend_t      backend,
+                                         int32_t                    width,
+                                         int32_t                    height);
+
+akinator_error_t akinator_ui_run_menu   (akinator_ui_t             *ui,
+                                         akinator_menu_t           *menu,
+                                         size_t                    *chosen);
+
+akinator_error_t akinator_ui_mark_dirty (akinator_ui_t             *ui,
+                                         const rectangle_t         *rectangle);
+
+akinator_error_t akinator_ui_post_event (akinator_ui_t             *ui,
+                                         const akinator_ui_event_t *event);
+
+akinator_error_t akinator_ui_write_ppm  (akinator_ui_t             *ui,
+                                         const char                *filename);
+
+akinator_error_t akinator_ui_dtor       (akinator_ui_t             *ui);
+
+#ifdef _WIN32
+//window backend, lives next to the rest of txlib code in graphics.cpp
+akinator_error_t graphics_window_fill       (const rectangle_t   *rectangle,
+                                             uint32_t             color);
+
+akinator_error_t graphics_window_text       (const rectangle_t   *rectangle,
+                                             const char          *text,
+                                             uint32_t             color);
+
+akinator_error_t graphics_window_begin      (void);
+
+akinator_error_t graphics_window_present    (void);
+
+akinator_error_t graphics_window_wait_event (akinator_ui_t       *ui,
+                                             akinator_ui_event_t *event);
+#endif
+
+#endif
@@ -1,6 +1,8 @@
 #ifndef AKINATOR_UTILS_H
 #define AKINATOR_UTILS_H
 
+#include <stdint.h>
+
 #include "akinator_errors.h"
 #include "akinator.h"
 
@@ -10,4 +12,6 @@ akinator_error_t akinator_run_system_command (const char      *format, ...);
 
 size_t           file_size                   (FILE            *file);
 
+uint64_t         get_time_ns                 (void);
+
 #endif
@@ -1,24 +1,124 @@
 #ifndef TTS_H
 #define TTS_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#ifdef _WIN32
 #include <windows.h>
 #include <sapi.h>
 #include <iostream>
 #include <Windows.h>
+#endif
+
+#include "tts_cache.h"
+#include "akinator_histogram.h"
 
 enum tts_error_t {
     TTS_SUCCESS = 0,
     TTS_ERROR   = 1,
 };
 
-static const size_t MaxMessageSize = 256;
+enum tts_backend_t {
+    TTS_BACKEND_NULL = 0,
+    TTS_BACKEND_WAV  = 1,
+    TTS_BACKEND_SAPI = 2,
+};
+
+static const size_t   MaxMessageSize             = TtsCacheMaxMessage;
+static const size_t   TtsQueueCapacity           = 8;
+static const size_t   TtsPrepareCapacity         = 4;
+static const size_t   TtsVoiceSize               = 64;
+static const uint32_t TtsWavRate                 = 16000;
+static const uint32_t TtsWavCharMs               = 60;
+static const uint32_t TtsPollMs                  = 20;
+static const long     TtsSapiRate                = 5;
+static const char     TtsDefaultCacheDirectory[] = "speech_cache";
+
+#ifdef _WIN32
+static const tts_backend_t TtsDefaultBackend = TTS_BACKEND_SAPI;
+#else
+static const tts_backend_t TtsDefaultBackend = TTS_BACKEND_NULL;
+#endif
+
+struct tts_message_t {
+    char     text[MaxMessageSize + 1];
+    uint64_t epoch;
+    uint64_t posted_ns;
+};
 
+//messages are spoken one by one on a worker thread, tts_speak only copies the text
+//into a bounded queue, a full queue loses its oldest message
+//tts_interrupt makes everything posted before it stale: queued messages are dropped
+//and the one being spoken is cut at the next character or poll
+//speech is synthesized into a wav image, looked up in the cache first, and played,
+//tts_prepare asks for a text that may be spoken soon, the worker synthesizes it into
+//the cache when nothing is queued and while sapi plays, prepared texts are never
+//spoken and a full prepare queue loses its oldest text
+//backend is opened on the worker, sapi voice lives in that thread's apartment
+//  null  synthesizes silence and plays nothing, for builds and runs without sound
+//  wav   a tone per character, TtsWavCharMs each, played by appending it to wav_name,
+//        so the file is as long as the speech would be
+//  sapi  windows voice rendered into memory and played with PlaySound
+//start delay runs from tts_speak to the moment playback starts
 struct tts_t {
-    ISpVoice *speaker;
+    tts_backend_t         backend;
+    const char           *wav_name;
+#ifdef _WIN32
+    ISpVoice             *speaker;
+#else
+    void                 *speaker;
+#endif
+    FILE                 *wav;
+    uint32_t              wav_samples;
+    char                  voice[TtsVoiceSize];
+    tts_cache_t           cache;
+    pthread_t             worker;
+    pthread_mutex_t       lock;
+    pthread_cond_t        changed;
+    tts_message_t         queue  [TtsQueueCapacity];
+    size_t                queue_head;
+    size_t                queue_size;
+    tts_message_t         prepare[TtsPrepareCapacity];
+    size_t                prepare_head;
+    size_t                prepare_size;
+    tts_message_t         current;
+    tts_message_t         preparing;
+    uint64_t              epoch;
+    bool                  started;
+    bool                  ready;
+    bool                  busy;
+    int                   stop;
+    tts_error_t           error;
+    size_t                spoken_number;
+    size_t                cancelled_number;
+    size_t                dropped_number;
+    size_t                hits_number;
+    size_t                misses_number;
+    size_t                prepared_number;
+    uint64_t              speak_ns;
+    akinator_histogram_t *start_delay;
 };
 
-tts_error_t tts_ctor(tts_t *tts);
-tts_error_t tts_dtor(tts_t *tts);
-tts_error_t tts_speak(tts_t *tts, const char *string);
+tts_error_t tts_ctor        (tts_t         *tts,
+                             tts_backend_t  backend,
+                             const char    *wav_name,
+                             const char    *cache_directory);
+
+tts_error_t tts_speak       (tts_t         *tts,
+                             const char    *string);
+
+tts_error_t tts_prepare     (tts_t         *tts,
+                             const char    *string);
+
+tts_error_t tts_interrupt   (tts_t         *tts);
+
+tts_error_t tts_wait        (tts_t         *tts);
+
+tts_error_t tts_print_stats (tts_t         *tts);
+
+tts_error_t tts_dtor        (tts_t         *tts);
 
 #endif
@@ -0,0 +1,55 @@
+#ifndef TTS_CACHE_H
+#define TTS_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+static const size_t TtsCacheWays       = 4;
+static const size_t TtsCacheSets       = 256;
+static const size_t TtsCacheMaxMessage = 256;
+static const size_t TtsWavHeaderSize   = 44;
+static const size_t TtsCacheNameSize   = 512;
+
+//audio is a complete wav image, header included, so it can be played from memory
+//and written to disk as is
+struct tts_cache_entry_t {
+    uint64_t  key;
+    char      text[TtsCacheMaxMessage + 1];
+    uint8_t  *audio;
+    size_t    audio_size;
+    uint64_t  used;
+    bool      pinned;
+};
+
+//key is a hash of voice settings and text, an entry lives in set key % TtsCacheSets
+//and the least recently used unpinned way of a full set is evicted
+//every added entry is also written to <directory>/<key>.wav, misses in memory look
+//there before the text is synthesized again, so the cache outlives the process
+//only the speech worker touches the cache
+struct tts_cache_t {
+    tts_cache_entry_t *entries;
+    const char        *directory;
+    uint64_t           clock;
+    size_t             disk_loads_number;
+    size_t             evictions_number;
+};
+
+bool               tts_cache_ctor (tts_cache_t *cache,
+                                   const char  *directory);
+
+uint64_t           tts_cache_key  (const char  *voice,
+                                   const char  *text);
+
+tts_cache_entry_t *tts_cache_find (tts_cache_t *cache,
+                                   uint64_t     key,
+                                   const char  *text);
+
+tts_cache_entry_t *tts_cache_add  (tts_cache_t *cache,
+                                   uint64_t     key,
+                                   const char  *text,
+                                   uint8_t     *audio,
+                                   size_t       audio_size);
+
+void               tts_cache_dtor (tts_cache_t *cache);
+
+#endif
@@ -0,0 +1,203 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "akinator_journal.h"
+#include "akinator_tree.h"
+#include "akinator_utils.h"
+#include "custom_assert.h"
+#include "colors.h"
+
+static const size_t JournalLineSize = JournalMaxWay + 2 * MaxQuestionSize + 4;
+
+static akinator_error_t akinator_journal_replay (akinator_journal_t    *journal,
+                                                 akinator_t            *akinator,
+                                                 FILE                  *file,
+                                                 ino_t                  inode,
+                                                 const struct timespec *modified,
+                                                 long                  *kept_size);
+
+static akinator_error_t akinator_journal_apply  (akinator_t            *akinator,
+                                                 char                  *line);
+
+//records of a journal written on top of this very file are applied to akinator, the
+//journal goes on after the last whole record, any other journal is started again
+akinator_error_t akinator_journal_ctor(akinator_journal_t    *journal,
+                                       akinator_t            *akinator,
+                                       ino_t                  inode,
+                                       const struct timespec *modified) {
+    _C_ASSERT(journal  != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER           );
+    _C_ASSERT(modified != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    journal->file           = NULL;
+    journal->records_number = 0;
+    if((size_t)snprintf(journal->name, sizeof(journal->name), "%s.journal",
+                        akinator->database_name) >= sizeof(journal->name)) {
+        return AKINATOR_DATABASE_FILENAME_NULL;
+    }
+
+    FILE *old = fopen(journal->name, "r");
+    if(old != NULL) {
+        long             kept_size  = 0;
+        akinator_error_t error_code = akinator_journal_replay(journal, akinator, old, inode, modified, &kept_size);
+        fclose(old);
+        if(error_code != AKINATOR_SUCCESS) {
+            return error_code;
+        }
+        if(kept_size != 0) {
+            if(truncate(journal->name, kept_size) != 0 ||
+               (journal->file = fopen(journal->name, "a")) == NULL) {
+                color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                             "Error while reopening journal '%s'.\n", journal->name);
+                return AKINATOR_JOURNAL_ERROR;
+            }
+            return AKINATOR_SUCCESS;
+        }
+    }
+    return akinator_journal_reset(journal, inode, modified);
+}
+
+//question_node has just taken the place of the split leaf, its way is the leaf's way
+akinator_error_t akinator_journal_append(akinator_journal_t *journal,
+                                         akinator_node_t    *question_node,
+                                         const char         *object,
+                                         const char         *question) {
+    _C_ASSERT(journal       != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(journal->file != NULL, return AKINATOR_JOURNAL_ERROR          );
+    _C_ASSERT(question_node != NULL, return AKINATOR_NODE_NULL              );
+
+    char   way[JournalMaxWay] = {};
+    size_t depth              = 0;
+    for(akinator_node_t *node = question_node; node->parent != NULL; node = node->parent) {
+        if(depth == JournalMaxWay) {
+            return AKINATOR_INVALID_NODE_LEVEL;
+        }
+        way[depth++] = (node->parent->no == node) ? '-' : '+';
+    }
+    for(size_t turn = 0; turn < depth / 2; turn++) {
+        char swapped           = way[turn];
+        way[turn]              = way[depth - 1 - turn];
+        way[depth - 1 - turn]  = swapped;
+    }
+
+    if(fprintf(journal->file, "%.*s\t%s\t%s\n", (int)depth, way, object, question) < 0) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while writing journal '%s'.\n", journal->name);
+        return AKINATOR_JOURNAL_ERROR;
+    }
+    journal->records_number++;
+    return AKINATOR_SUCCESS;
+}
+
+//the records appended so far are on disk when it returns
+akinator_error_t akinator_journal_sync(akinator_journal_t *journal) {
+    _C_ASSERT(journal       != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(journal->file != NULL, return AKINATOR_JOURNAL_ERROR          );
+
+    if(fflush(journal->file) != 0 || fdatasync(fileno(journal->file)) != 0) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while syncing journal '%s'.\n", journal->name);
+        return AKINATOR_JOURNAL_ERROR;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+//called once the database file holds everything the journal had, or was replaced from outside
+akinator_error_t akinator_journal_reset(akinator_journal_t    *journal,
+                                        ino_t                  inode,
+                                        const struct timespec *modified) {
+    _C_ASSERT(journal  != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(modified != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    if(journal->file != NULL) {
+        fclose(journal->file);
+    }
+    journal->records_number = 0;
+    journal->file           = fopen(journal->name, "w");
+    if(journal->file == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while creating journal '%s'.\n", journal->name);
+        return AKINATOR_JOURNAL_ERROR;
+    }
+    fprintf(journal->file, "akinator journal %llu %lld %ld\n",
+            (unsigned long long)inode, (long long)modified->tv_sec, (long)modified->tv_nsec);
+    return akinator_journal_sync(journal);
+}
+
+akinator_error_t akinator_journal_dtor(akinator_journal_t *journal) {
+    _C_ASSERT(journal != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    if(journal->file != NULL) {
+        fclose(journal->file);
+    }
+    memset(journal, 0, sizeof(*journal));
+    return AKINATOR_SUCCESS;
+}
+
+//kept_size is where the last whole record ends, 0 when the journal is for another file
+akinator_error_t akinator_journal_replay(akinator_journal_t    *journal,
+                                         akinator_t            *akinator,
+                                         FILE                  *file,
+                                         ino_t                  inode,
+                                         const struct timespec *modified,
+                                         long                  *kept_size) {
+    char               line[JournalLineSize] = {};
+    unsigned long long journal_inode         = 0;
+    long long          journal_seconds       = 0;
+    long               journal_nanoseconds   = 0;
+    *kept_size = 0;
+    if(fgets(line, sizeof(line), file) == NULL ||
+       sscanf(line, "akinator journal %llu %lld %ld",
+              &journal_inode, &journal_seconds, &journal_nanoseconds) != 3 ||
+       journal_inode       != (unsigned long long)inode           ||
+       journal_seconds     != (long long)         modified->tv_sec ||
+       journal_nanoseconds != (long)              modified->tv_nsec) {
+        return AKINATOR_SUCCESS;
+    }
+    *kept_size = ftell(file);
+
+    while(fgets(line, sizeof(line), file) != NULL) {
+        size_t length = strlen(line);
+        if(line[length - 1] != '\n') {
+            break;
+        }
+        line[length - 1] = '\0';
+        RETURN_IF_ERROR(akinator_journal_apply(akinator, line));
+        journal->records_number++;
+        *kept_size = ftell(file);
+    }
+
+    if(journal->records_number != 0) {
+        AKINATOR_VERIFY(akinator);
+        color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                     "%zu learned objects replayed from '%s'.\n", journal->records_number, journal->name);
+    }
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_journal_apply(akinator_t *akinator,
+                                        char       *line) {
+    char *object   = strchr(line, '\t');
+    char *question = (object != NULL) ? strchr(object + 1, '\t') : NULL;
+    if(question == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Broken journal record '%s'.\n", line);
+        return AKINATOR_JOURNAL_ERROR;
+    }
+    *object++   = '\0';
+    *question++ = '\0';
+
+    akinator_node_t *node = akinator->root;
+    for(const char *turn = line; *turn != '\0' && node != NULL; turn++) {
+        node = (is_leaf(node) || (*turn != '+' && *turn != '-')) ? NULL :
+               (*turn == '-') ? node->no : node->yes;
+    }
+    if(node == NULL || !is_leaf(node)) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Journal record for '%s' does not match the database.\n", object);
+        return AKINATOR_JOURNAL_ERROR;
+    }
+    return akinator_split_leaf(akinator, node, object, question);
+}
@@ -0,0 +1,358 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+
+#include "akinator_loop.h"
+#include "custom_assert.h"
+#include "colors.h"
+
+enum loop_action_t {
+    LOOP_ACTION_KEEP  = 0,
+    LOOP_ACTION_CLOSE = 1,
+};
+
+static akinator_error_t akinator_loop_accept      (akinator_loop_t            *loop);
+
+static loop_action_t    akinator_loop_read        (akinator_loop_t            *loop,
+                                                   akinator_loop_connection_t *connection);
+
+static loop_action_t    akinator_loop_handle_line (akinator_loop_t            *loop,
+                                                   akinator_loop_connection_t *connection,
+                                                   char                       *line);
+
+static loop_action_t    akinator_loop_drive       (akinator_loop_t            *loop,
+                                                   akinator_loop_connection_t *connection);
+
+static loop_action_t    akinator_loop_send        (akinator_loop_connection_t *connection,
+                                                   const char                 *format, ...)
+                                                   __attribute__((format(printf, 2, 3)));
+
+static void             akinator_loop_close       (akinator_loop_t            *loop,
+                                                   akinator_loop_connection_t *connection);
+
+//socket_path == NULL makes an in-memory loop, flows are driven by the caller
+akinator_error_t akinator_loop_ctor(akinator_loop_t *loop,
+                                    akinator_t      *akinator,
+                                    const char      *socket_path) {
+    _C_ASSERT(loop     != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER           );
+
+    loop->akinator      = akinator;
+    loop->socket_path   = socket_path;
+    loop->listen_socket = -1;
+    loop->epoll         = -1;
+    clock_gettime(CLOCK_MONOTONIC, &loop->start_time);
+    if(socket_path == NULL) {
+        return AKINATOR_SUCCESS;
+    }
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if(strlen(socket_path) >= sizeof(address.sun_path)) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Socket path '%s' is too long.\n", socket_path);
+        return AKINATOR_SERVER_SOCKET_ERROR;
+    }
+    strcpy(address.sun_path, socket_path);
+    unlink(socket_path);
+
+    loop->listen_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if(loop->listen_socket < 0 ||
+       bind  (loop->listen_socket, (sockaddr *)&address, sizeof(address)) != 0 ||
+       listen(loop->listen_socket, LoopListenBacklog) != 0) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while opening socket '%s': %s.\n", socket_path, strerror(errno));
+        return AKINATOR_SERVER_SOCKET_ERROR;
+    }
+
+    loop->epoll = epoll_create1(0);
+    epoll_event event = {};
+    event.events   = EPOLLIN;
+    event.data.ptr = NULL;
+    if(loop->epoll < 0 || epoll_ctl(loop->epoll, EPOLL_CTL_ADD, loop->listen_socket, &event) != 0) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while creating epoll: %s.\n", strerror(errno));
+        return AKINATOR_SERVER_SOCKET_ERROR;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+//everything runs on the calling thread, a connection costs nothing while it waits for input
+akinator_error_t akinator_loop_run(akinator_loop_t *loop) {
+    _C_ASSERT(loop        != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(loop->epoll >= 0   , return AKINATOR_SERVER_SOCKET_ERROR    );
+
+    clock_gettime(CLOCK_MONOTONIC, &loop->start_time);
+    epoll_event events[LoopMaxEvents] = {};
+    while(!loop->stop) {
+        int events_number = epoll_wait(loop->epoll, events, (int)LoopMaxEvents, LoopPollTimeout);
+        if(events_number < 0 && errno != EINTR) {
+            color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                         "Error while waiting for events: %s.\n", strerror(errno));
+            return AKINATOR_SERVER_SOCKET_ERROR;
+        }
+
+        for(int event = 0; event < events_number; event++) {
+            akinator_loop_connection_t *connection = (akinator_loop_connection_t *)events[event].data.ptr;
+            if(connection == NULL) {
+                RETURN_IF_ERROR(akinator_loop_accept(loop));
+                continue;
+            }
+            if(akinator_loop_read(loop, connection) == LOOP_ACTION_CLOSE) {
+                akinator_loop_close(loop, connection);
+            }
+        }
+    }
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_loop_start_flow(akinator_loop_t            *loop,
+                                          akinator_loop_connection_t *connection,
+                                          const char                 *name) {
+    _C_ASSERT(loop       != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(connection != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(name       != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    akinator_flow_dtor(&connection->flow);
+    connection->io.resume_point = nullptr;
+    connection->io.buffer       = loop->message;
+    connection->io.buffer_size  = sizeof(loop->message);
+    if(strcmp(name, "guess") == 0) {
+        connection->flow = akinator_flow_guess     (loop->akinator, &connection->io);
+    }
+    else if(strcmp(name, "definition") == 0) {
+        connection->flow = akinator_flow_definition(loop->akinator, &connection->io);
+    }
+    else if(strcmp(name, "difference") == 0) {
+        connection->flow = akinator_flow_difference(loop->akinator, &connection->io);
+    }
+    else if(strcmp(name, "similar") == 0) {
+        connection->flow = akinator_flow_similar   (loop->akinator, &connection->io);
+    }
+    else if(strcmp(name, "search") == 0) {
+        connection->flow = akinator_flow_search    (loop->akinator, &connection->io);
+    }
+    else {
+        return AKINATOR_USER_ANSWER_ERROR;
+    }
+
+    if(akinator_flow_done(&connection->flow)) {
+        return AKINATOR_FLOW_ERROR;
+    }
+    loop->flows_started++;
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_loop_print_stats(akinator_loop_t *loop) {
+    _C_ASSERT(loop != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    struct timespec now = {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed = (double)(now.tv_sec  - loop->start_time.tv_sec) +
+                     (double)(now.tv_nsec - loop->start_time.tv_nsec) / 1e9;
+    color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                 "Flows: %zu started, %zu finished, %zu resumes (%.1f/s), "
+                 "%zu connections open, %zu bytes in flow frames.\n",
+                 loop->flows_started,
+                 loop->flows_finished,
+                 loop->resumes_number,
+                 (double)loop->resumes_number / elapsed,
+                 loop->connections_number,
+                 akinator_flow_allocated_bytes());
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_loop_dtor(akinator_loop_t *loop) {
+    _C_ASSERT(loop != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    if(loop->listen_socket >= 0) {
+        close (loop->listen_socket);
+        unlink(loop->socket_path);
+    }
+    if(loop->epoll >= 0) {
+        close(loop->epoll);
+    }
+    memset(loop, 0, sizeof(*loop));
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_loop_accept(akinator_loop_t *loop) {
+    while(true) {
+        int client = accept4(loop->listen_socket, NULL, NULL, SOCK_NONBLOCK);
+        if(client < 0) {
+            if(errno == EAGAIN || errno == ECONNABORTED || errno == EINTR) {
+                return AKINATOR_SUCCESS;
+            }
+            //out of descriptors is not fatal for the sessions already served
+            color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                         "Error while accepting connection: %s.\n", strerror(errno));
+            return (errno == EMFILE || errno == ENFILE) ? AKINATOR_SUCCESS :
+                                                          AKINATOR_SERVER_SOCKET_ERROR;
+        }
+
+        akinator_loop_connection_t *connection =
+            (akinator_loop_connection_t *)calloc(1, sizeof(*connection));
+        if(connection == NULL) {
+            close(client);
+            continue;
+        }
+        connection->socket = client;
+
+        epoll_event event = {};
+        event.events   = EPOLLIN | EPOLLRDHUP;
+        event.data.ptr = connection;
+        if(epoll_ctl(loop->epoll, EPOLL_CTL_ADD, client, &event) != 0) {
+            close(client);
+            free (connection);
+            continue;
+        }
+        loop->connections_number++;
+    }
+}
+
+//complete lines are handled in place, only a trailing partial line is kept per connection
+loop_action_t akinator_loop_read(akinator_loop_t            *loop,
+                                 akinator_loop_connection_t *connection) {
+    size_t size = connection->pending_size;
+    memcpy(loop->line, connection->pending, size);
+    free(connection->pending);
+    connection->pending      = NULL;
+    connection->pending_size = 0;
+
+    ssize_t read_size = read(connection->socket, loop->line + size, LoopMaxLine - size);
+    if(read_size < 0 && (errno == EAGAIN || errno == EINTR)) {
+        read_size = 0;
+    }
+    else if(read_size <= 0) {
+        return LOOP_ACTION_CLOSE;
+    }
+    size += (size_t)read_size;
+
+    char *line = loop->line;
+    while(true) {
+        char *end = (char *)memchr(line, '\n', size);
+        if(end == NULL) {
+            break;
+        }
+        *end = '\0';
+        if(end != line && end[-1] == '\r') {
+            end[-1] = '\0';
+        }
+        if(akinator_loop_handle_line(loop, connection, line) == LOOP_ACTION_CLOSE) {
+            return LOOP_ACTION_CLOSE;
+        }
+        size -= (size_t)(end + 1 - line);
+        line  = end + 1;
+    }
+
+    if(size == LoopMaxLine) {
+        return LOOP_ACTION_CLOSE;
+    }
+    if(size != 0) {
+        connection->pending = (char *)malloc(size);
+        if(connection->pending == NULL) {
+            return LOOP_ACTION_CLOSE;
+        }
+        memcpy(connection->pending, line, size);
+        connection->pending_size = (uint32_t)size;
+    }
+    return LOOP_ACTION_KEEP;
+}
+
+loop_action_t akinator_loop_handle_line(akinator_loop_t            *loop,
+                                        akinator_loop_connection_t *connection,
+                                        char                       *line) {
+    if(strcmp(line, "quit") == 0) {
+        return LOOP_ACTION_CLOSE;
+    }
+
+    bool running = !akinator_flow_done(&connection->flow);
+    if(strncmp(line, "answer ", sizeof("answer ") - 1) == 0 &&
+       running && connection->io.input == AKINATOR_FLOW_INPUT_ANSWER) {
+        connection->io.answer = (akinator_answer_t)atoi(line + sizeof("answer ") - 1);
+        return akinator_loop_drive(loop, connection);
+    }
+    if(strncmp(line, "text ", sizeof("text ") - 1) == 0 &&
+       running && connection->io.input == AKINATOR_FLOW_INPUT_TEXT) {
+        connection->io.text = line + sizeof("text ") - 1;
+        return akinator_loop_drive(loop, connection);
+    }
+    if(!running) {
+        akinator_error_t error_code = akinator_loop_start_flow(loop, connection, line);
+        if(error_code != AKINATOR_SUCCESS) {
+            return akinator_loop_send(connection, "done %d\n", error_code);
+        }
+        return akinator_loop_drive(loop, connection);
+    }
+    return akinator_loop_send(connection, "error %d\n", AKINATOR_SESSION_STATE_ERROR);
+}
+
+//resumes until the flow needs input or ends, every message it shows is sent right away,
+//so the shared message buffer is free again once this returns
+loop_action_t akinator_loop_drive(akinator_loop_t            *loop,
+                                  akinator_loop_connection_t *connection) {
+    while(true) {
+        akinator_error_t error_code = akinator_flow_resume(&connection->flow, &connection->io);
+        loop->resumes_number++;
+        if(error_code != AKINATOR_SUCCESS || akinator_flow_done(&connection->flow)) {
+            if(error_code == AKINATOR_SUCCESS) {
+                error_code = akinator_flow_result(&connection->flow);
+            }
+            akinator_flow_dtor(&connection->flow);
+            connection->io.resume_point = nullptr;
+            loop->flows_finished++;
+            return akinator_loop_send(connection, "done %d\n", error_code);
+        }
+
+        for(char *symbol = loop->message; *symbol != '\0'; symbol++) {
+            if(*symbol == '\n') {
+                *symbol = ' ';
+            }
+        }
+        const char *kind = (connection->io.input == AKINATOR_FLOW_INPUT_ANSWER) ? "ask"  :
+                           (connection->io.input == AKINATOR_FLOW_INPUT_TEXT)   ? "read" :
+                                                                                  "say";
+        if(akinator_loop_send(connection, "%s %s\n", kind, loop->message) == LOOP_ACTION_CLOSE) {
+            return LOOP_ACTION_CLOSE;
+        }
+        if(connection->io.input != AKINATOR_FLOW_INPUT_NONE) {
+            return LOOP_ACTION_KEEP;
+        }
+    }
+}
+
+//replies are short and clients wait for them, a client that does not read is dropped
+loop_action_t akinator_loop_send(akinator_loop_connection_t *connection,
+                                 const char                 *format, ...) {
+    char    message[MaxDefinitionSize + 16] = {};
+    va_list arguments;
+    va_start(arguments, format);
+    int size = vsnprintf(message, sizeof(message), format, arguments);
+    va_end(arguments);
+    if(size < 0 || (size_t)size >= sizeof(message)) {
+        return LOOP_ACTION_CLOSE;
+    }
+
+    ssize_t written = 0;
+    do {
+        written = send(connection->socket, message, (size_t)size, MSG_NOSIGNAL | MSG_DONTWAIT);
+    } while(written < 0 && errno == EINTR);
+    return (written == size) ? LOOP_ACTION_KEEP : LOOP_ACTION_CLOSE;
+}
+
+void akinator_loop_close(akinator_loop_t            *loop,
+                         akinator_loop_connection_t *connection) {
+    epoll_ctl(loop->epoll, EPOLL_CTL_DEL, connection->socket, NULL);
+    close(connection->socket);
+    akinator_flow_dtor(&connection->flow);
+    free(connection->pending);
+    free(connection);
+    loop->connections_number--;
+}
@@ -0,0 +1,333 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "akinator_patch.h"
+#include "akinator_tree.h"
+#include "akinator_utils.h"
+#include "custom_assert.h"
+#include "colors.h"
+
+struct patch_context_t {
+    FILE                   *patch;
+    uint8_t                 way[PatchMaxDepth / 8];
+    akinator_patch_stats_t *stats;
+};
+
+static akinator_error_t akinator_patch_compare   (patch_context_t            *context,
+                                                  akinator_node_t            *old_node,
+                                                  const char                 *old_text,
+                                                  akinator_node_t            *new_node,
+                                                  size_t                      depth);
+
+static akinator_error_t akinator_patch_write     (patch_context_t            *context,
+                                                  akinator_patch_operation_t  kind,
+                                                  size_t                      depth,
+                                                  const char                 *guard,
+                                                  const char                 *first,
+                                                  const char                 *second);
+
+static void             akinator_patch_step      (patch_context_t            *context,
+                                                  size_t                      depth,
+                                                  akinator_answer_t           answer);
+
+static const char      *akinator_patch_no_leaf   (akinator_node_t            *node);
+
+static bool             akinator_patch_read_text (FILE                       *patch,
+                                                  char                       *text);
+
+static akinator_error_t akinator_patch_find      (akinator_t                 *akinator,
+                                                  const uint8_t              *way,
+                                                  size_t                      depth,
+                                                  const char                 *guard,
+                                                  akinator_node_t           **node_output);
+
+//both trees are walked side by side by position, the old side can be a leaf that
+//exists only in the patch, the object a split put on the yes branch
+akinator_error_t akinator_patch_diff(akinator_t             *old_tree,
+                                     akinator_t             *new_tree,
+                                     FILE                   *patch,
+                                     akinator_patch_stats_t *stats) {
+    _C_ASSERT(old_tree != NULL, return AKINATOR_NULL_POINTER           );
+    _C_ASSERT(new_tree != NULL, return AKINATOR_NULL_POINTER           );
+    _C_ASSERT(patch    != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(stats    != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    patch_context_t *context = (patch_context_t *)calloc(1, sizeof(*context));
+    if(context == NULL) {
+        return AKINATOR_PATCH_ERROR;
+    }
+    memset(stats, 0, sizeof(*stats));
+    context->patch = patch;
+    context->stats = stats;
+
+    fwrite(PatchMagic, 1, sizeof(PatchMagic) - 1, patch);
+    akinator_error_t error_code = akinator_patch_compare(context, old_tree->root, NULL, new_tree->root, 0);
+    if(error_code == AKINATOR_SUCCESS) {
+        fputc(AKINATOR_PATCH_END, patch);
+    }
+    free(context);
+    if(error_code == AKINATOR_SUCCESS && (fflush(patch) != 0 || ferror(patch))) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while writing patch.\n");
+        error_code = AKINATOR_PATCH_ERROR;
+    }
+    stats->size = (size_t)ftell(patch);
+    return error_code;
+}
+
+//nothing is checked beyond the guards, a patch for another tree stops at the first
+//node that does not match and leaves the operations before it applied
+akinator_error_t akinator_patch_apply(akinator_t             *akinator,
+                                      FILE                   *patch,
+                                      akinator_patch_stats_t *stats) {
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER           );
+    _C_ASSERT(patch    != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(stats    != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    memset(stats, 0, sizeof(*stats));
+    char magic[sizeof(PatchMagic)] = {};
+    if(fread(magic, 1, sizeof(PatchMagic) - 1, patch) != sizeof(PatchMagic) - 1 ||
+       strcmp(magic, PatchMagic) != 0) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "This is not a database patch.\n");
+        return AKINATOR_PATCH_ERROR;
+    }
+
+    uint8_t          way[PatchMaxDepth / 8]       = {};
+    char             guard [MaxQuestionSize + 1] = {};
+    char             first [MaxQuestionSize + 1] = {};
+    char             second[MaxQuestionSize + 1] = {};
+    akinator_error_t error_code                   = AKINATOR_SUCCESS;
+    while(error_code == AKINATOR_SUCCESS) {
+        int kind = fgetc(patch);
+        if(kind == AKINATOR_PATCH_END) {
+            break;
+        }
+
+        uint8_t depth_bytes[2] = {};
+        if(kind == EOF || fread(depth_bytes, 1, sizeof(depth_bytes), patch) != sizeof(depth_bytes)) {
+            error_code = AKINATOR_PATCH_ERROR;
+            break;
+        }
+        size_t depth    = (size_t)depth_bytes[0] | (size_t)depth_bytes[1] << 8;
+        size_t way_size = (depth + 7) / 8;
+        if(depth > PatchMaxDepth ||
+           fread(way, 1, way_size, patch) != way_size ||
+           !akinator_patch_read_text(patch, guard)) {
+            error_code = AKINATOR_PATCH_ERROR;
+            break;
+        }
+
+        akinator_node_t *node = NULL;
+        error_code = akinator_patch_find(akinator, way, depth, guard, &node);
+        if(error_code != AKINATOR_SUCCESS) {
+            break;
+        }
+        switch(kind) {
+            case AKINATOR_PATCH_SPLIT: {
+                error_code = (akinator_patch_read_text(patch, first) && akinator_patch_read_text(patch, second)) ?
+                             akinator_split_leaf(akinator, node, second, first) :
+                             AKINATOR_PATCH_ERROR;
+                stats->splits++;
+                break;
+            }
+            case AKINATOR_PATCH_RENAME: {
+                error_code = akinator_patch_read_text(patch, first) ?
+                             akinator_rename_node(akinator, node, first) :
+                             AKINATOR_PATCH_ERROR;
+                stats->renames++;
+                break;
+            }
+            case AKINATOR_PATCH_LIFT: {
+                int kept = fgetc(patch);
+                error_code = (kept == AKINATOR_ANSWER_YES || kept == AKINATOR_ANSWER_NO) ?
+                             akinator_lift_node(akinator, node, (akinator_answer_t)kept) :
+                             AKINATOR_PATCH_ERROR;
+                stats->lifts++;
+                break;
+            }
+            case AKINATOR_PATCH_END:
+            default: {
+                error_code = AKINATOR_PATCH_ERROR;
+                break;
+            }
+        }
+    }
+    stats->size = (size_t)ftell(patch);
+    if(error_code != AKINATOR_SUCCESS) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Patch does not fit this database, stopped at byte %zu.\n", stats->size);
+        return error_code;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_patch_print(akinator_patch_stats_t *stats) {
+    _C_ASSERT(stats != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                 "Patch: %zu splits, %zu renames, %zu lifts, %zu bytes.\n",
+                 stats->splits,
+                 stats->renames,
+                 stats->lifts,
+                 stats->size);
+    return AKINATOR_SUCCESS;
+}
+
+//learned objects come out as splits, a question dropped by normalization as a lift,
+//anything else that differs in place as renames
+akinator_error_t akinator_patch_compare(patch_context_t *context,
+                                        akinator_node_t *old_node,
+                                        const char      *old_text,
+                                        akinator_node_t *new_node,
+                                        size_t           depth) {
+    _C_ASSERT(new_node != NULL, return AKINATOR_NODE_NULL);
+
+    if(depth >= PatchMaxDepth) {
+        return AKINATOR_INVALID_NODE_LEVEL;
+    }
+    if(old_node != NULL) {
+        old_text = old_node->question;
+    }
+    bool old_leaf = (old_node == NULL || is_leaf(old_node));
+
+    if(old_leaf && is_leaf(new_node)) {
+        if(strcmp(old_text, new_node->question) == 0) {
+            return AKINATOR_SUCCESS;
+        }
+        return akinator_patch_write(context, AKINATOR_PATCH_RENAME, depth, old_text, new_node->question, NULL);
+    }
+
+    if(old_leaf) {
+        const char *object = akinator_patch_no_leaf(new_node->yes);
+        RETURN_IF_ERROR(akinator_patch_write(context, AKINATOR_PATCH_SPLIT, depth, old_text,
+                                             new_node->question, object));
+        akinator_patch_step(context, depth, AKINATOR_ANSWER_YES);
+        RETURN_IF_ERROR(akinator_patch_compare(context, NULL, object, new_node->yes, depth + 1));
+        akinator_patch_step(context, depth, AKINATOR_ANSWER_NO);
+        RETURN_IF_ERROR(akinator_patch_compare(context, old_node, old_text, new_node->no, depth + 1));
+        return AKINATOR_SUCCESS;
+    }
+
+    if(strcmp(old_text, new_node->question) == 0 && !is_leaf(new_node)) {
+        akinator_patch_step(context, depth, AKINATOR_ANSWER_YES);
+        RETURN_IF_ERROR(akinator_patch_compare(context, old_node->yes, NULL, new_node->yes, depth + 1));
+        akinator_patch_step(context, depth, AKINATOR_ANSWER_NO);
+        RETURN_IF_ERROR(akinator_patch_compare(context, old_node->no,  NULL, new_node->no,  depth + 1));
+        return AKINATOR_SUCCESS;
+    }
+
+    //the new node is one of the children moved up, or the question went away entirely
+    akinator_answer_t kept = AKINATOR_ANSWER_UNKNOWN;
+    if(strcmp(old_node->no->question, new_node->question) == 0 && is_leaf(old_node->no) == is_leaf(new_node)) {
+        kept = AKINATOR_ANSWER_NO;
+    }
+    else if(strcmp(old_node->yes->question, new_node->question) == 0 && is_leaf(old_node->yes) == is_leaf(new_node)) {
+        kept = AKINATOR_ANSWER_YES;
+    }
+    else if(is_leaf(new_node)) {
+        kept = AKINATOR_ANSWER_NO;
+    }
+    if(kept != AKINATOR_ANSWER_UNKNOWN) {
+        char kept_text[2] = {(char)kept, '\0'};
+        RETURN_IF_ERROR(akinator_patch_write(context, AKINATOR_PATCH_LIFT, depth, old_text, kept_text, NULL));
+        return akinator_patch_compare(context, (kept == AKINATOR_ANSWER_YES) ? old_node->yes : old_node->no,
+                                      NULL, new_node, depth);
+    }
+
+    RETURN_IF_ERROR(akinator_patch_write(context, AKINATOR_PATCH_RENAME, depth, old_text, new_node->question, NULL));
+    akinator_patch_step(context, depth, AKINATOR_ANSWER_YES);
+    RETURN_IF_ERROR(akinator_patch_compare(context, old_node->yes, NULL, new_node->yes, depth + 1));
+    akinator_patch_step(context, depth, AKINATOR_ANSWER_NO);
+    RETURN_IF_ERROR(akinator_patch_compare(context, old_node->no,  NULL, new_node->no,  depth + 1));
+    return AKINATOR_SUCCESS;
+}
+
+//lift writes its kept answer as a single byte instead of a string
+akinator_error_t akinator_patch_write(patch_context_t            *context,
+                                      akinator_patch_operation_t  kind,
+                                      size_t                      depth,
+                                      const char                 *guard,
+                                      const char                 *first,
+                                      const char                 *second) {
+    FILE   *patch       = context->patch;
+    uint8_t depth_bytes[2] = {(uint8_t)(depth & 0xff), (uint8_t)(depth >> 8)};
+    fputc (kind, patch);
+    fwrite(depth_bytes,  1, sizeof(depth_bytes), patch);
+    fwrite(context->way, 1, (depth + 7) / 8,     patch);
+
+    const char *texts[3] = {guard, first, second};
+    for(size_t index = 0; index < 3 && texts[index] != NULL; index++) {
+        size_t length = strlen(texts[index]);
+        if(kind == AKINATOR_PATCH_LIFT && index == 1) {
+            fputc(texts[index][0], patch);
+            continue;
+        }
+        if(length > MaxQuestionSize) {
+            return AKINATOR_MESSAGE_SIZE_ERROR;
+        }
+        fputc ((int)length, patch);
+        fwrite(texts[index], 1, length, patch);
+    }
+
+    switch(kind) {
+        case AKINATOR_PATCH_SPLIT:  context->stats->splits++;  break;
+        case AKINATOR_PATCH_RENAME: context->stats->renames++; break;
+        case AKINATOR_PATCH_LIFT:   context->stats->lifts++;   break;
+        case AKINATOR_PATCH_END:
+        default:                                               break;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+void akinator_patch_step(patch_context_t   *context,
+                         size_t             depth,
+                         akinator_answer_t  answer) {
+    uint8_t bit = (uint8_t)(1 << (depth % 8));
+    if(answer == AKINATOR_ANSWER_NO) {
+        context->way[depth / 8] |= bit;
+    }
+    else {
+        context->way[depth / 8] &= (uint8_t)~bit;
+    }
+}
+
+//split keeps the old leaf on no, so following no down the new subtree finds the
+//object that needs no further splits on its way
+const char *akinator_patch_no_leaf(akinator_node_t *node) {
+    while(!is_leaf(node)) {
+        node = node->no;
+    }
+    return node->question;
+}
+
+bool akinator_patch_read_text(FILE *patch,
+                              char *text) {
+    int length = fgetc(patch);
+    if(length == EOF || (size_t)length > MaxQuestionSize ||
+       fread(text, 1, (size_t)length, patch) != (size_t)length) {
+        return false;
+    }
+    text[length] = '\0';
+    return true;
+}
+
+akinator_error_t akinator_patch_find(akinator_t       *akinator,
+                                     const uint8_t    *way,
+                                     size_t            depth,
+                                     const char       *guard,
+                                     akinator_node_t **node_output) {
+    akinator_node_t *node = akinator->root;
+    for(size_t level = 0; level < depth; level++) {
+        if(is_leaf(node)) {
+            return AKINATOR_PATCH_ERROR;
+        }
+        node = (way[level / 8] & (1 << (level % 8))) ? node->no : node->yes;
+    }
+    if(strcmp(node->question, guard) != 0) {
+        return AKINATOR_PATCH_ERROR;
+    }
+    *node_output = node;
+    return AKINATOR_SUCCESS;
+}
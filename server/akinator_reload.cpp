@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+
+#include "akinator_reload.h"
+#include "akinator_tree.h"
+#include "custom_assert.h"
+#include "colors.h"
+
+static const size_t ReloadEventsSize = 4096;
+
+static void                  *akinator_reload_thread     (void                  *argument);
+
+static bool                   akinator_reload_wait       (akinator_reload_t     *reload);
+
+static void                   akinator_reload_database   (akinator_reload_t     *reload);
+
+static akinator_generation_t *akinator_reload_load       (akinator_reload_t     *reload,
+                                                          struct stat           *file);
+
+static void                   akinator_reload_drain      (akinator_reload_t     *reload);
+
+akinator_error_t akinator_reload_ctor(akinator_reload_t *reload,
+                                      akinator_server_t *server) {
+    _C_ASSERT(reload != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(server != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    const char *database_name = server->initial.akinator->database_name;
+    const char *slash         = strrchr(database_name, '/');
+    reload->server    = server;
+    reload->notify    = -1;
+    reload->file_name = (slash == NULL) ? database_name : slash + 1;
+    if(slash == NULL) {
+        strcpy(reload->directory, ".");
+    }
+    else if((size_t)(slash - database_name) + 1 < sizeof(reload->directory)) {
+        memcpy(reload->directory, database_name, (size_t)(slash - database_name) + 1);
+    }
+    else {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Database path '%s' is too long.\n", database_name);
+        return AKINATOR_RELOAD_ERROR;
+    }
+
+    reload->notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(reload->notify < 0) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while creating inotify: %s.\n", strerror(errno));
+        return AKINATOR_RELOAD_ERROR;
+    }
+    reload->watch = inotify_add_watch(reload->notify, reload->directory, IN_CLOSE_WRITE | IN_MOVED_TO);
+    if(reload->watch < 0) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while watching '%s': %s.\n", reload->directory, strerror(errno));
+        return AKINATOR_RELOAD_ERROR;
+    }
+
+    //same as the pool, stop signals belong to the accepting thread
+    sigset_t blocked  = {};
+    sigset_t previous = {};
+    sigemptyset(&blocked);
+    sigaddset  (&blocked, SIGINT);
+    sigaddset  (&blocked, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+    int thread_error = pthread_create(&reload->thread, NULL, akinator_reload_thread, reload);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    if(thread_error != 0) {
+        return AKINATOR_SERVER_THREAD_ERROR;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_reload_print_stats(akinator_reload_t *reload) {
+    _C_ASSERT(reload != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    size_t draining = 0;
+    for(akinator_generation_t *generation = reload->draining; generation != NULL; generation = generation->next_draining) {
+        draining++;
+    }
+    color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                 "Reloads: %zu applied, %zu rejected, %zu old trees freed, %zu still draining.\n",
+                 reload->reloads_number,
+                 reload->rejected_number,
+                 reload->freed_number,
+                 draining);
+    return AKINATOR_SUCCESS;
+}
+
+//has to be called after akinator_server_run returned, no session can pin a tree then
+akinator_error_t akinator_reload_dtor(akinator_reload_t *reload) {
+    _C_ASSERT(reload != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    if(reload->server != NULL) {
+        reload->stop = 1;
+        pthread_join(reload->thread, NULL);
+    }
+    if(reload->notify >= 0) {
+        close(reload->notify);
+    }
+    while(reload->draining != NULL) {
+        akinator_generation_t *generation = reload->draining;
+        reload->draining = generation->next_draining;
+        if(generation->owned) {
+            akinator_generation_dtor(generation);
+        }
+    }
+    memset(reload, 0, sizeof(*reload));
+    return AKINATOR_SUCCESS;
+}
+
+void *akinator_reload_thread(void *argument) {
+    akinator_reload_t *reload = (akinator_reload_t *)argument;
+
+    while(!reload->stop) {
+        if(akinator_reload_wait(reload)) {
+            akinator_reload_database(reload);
+        }
+        akinator_reload_drain(reload);
+    }
+    return NULL;
+}
+
+//true when the database file itself was written or moved in, events for other
+//files of the directory, including the writer's temporary file, are dropped
+bool akinator_reload_wait(akinator_reload_t *reload) {
+    pollfd poll_notify = {reload->notify, POLLIN, 0};
+    if(poll(&poll_notify, 1, ServerPollTimeout) <= 0) {
+        return false;
+    }
+
+    alignas(inotify_event) char events[ReloadEventsSize];
+    bool    changed = false;
+    ssize_t size    = 0;
+    while((size = read(reload->notify, events, sizeof(events))) > 0) {
+        for(char *event = events; event < events + size; ) {
+            inotify_event *current = (inotify_event *)event;
+            if(current->len != 0 && strcmp(current->name, reload->file_name) == 0) {
+                changed = true;
+            }
+            event += sizeof(inotify_event) + current->len;
+        }
+    }
+    return changed;
+}
+
+//file written by the writer itself is recognized by its inode and modification time,
+//anything else is read, verified and handed to the writer
+void akinator_reload_database(akinator_reload_t *reload) {
+    struct stat file = {};
+    if(!akinator_server_file_changed(reload->server, &file)) {
+        return;
+    }
+
+    akinator_generation_t *generation = akinator_reload_load(reload, &file);
+    if(generation == NULL) {
+        reload->rejected_number++;
+        return;
+    }
+
+    color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                 "Database '%s' reloaded, %zu objects.\n",
+                 generation->akinator->database_name,
+                 generation->akinator->leafs_array_size);
+    akinator_generation_t *old = __atomic_load_n(&reload->server->current, __ATOMIC_ACQUIRE);
+    akinator_server_publish(reload->server, generation);
+    reload->reloads_number++;
+
+    //writer takes the tree between batches, an idle writer is woken up by publish
+    while(!reload->stop && __atomic_load_n(&reload->server->current, __ATOMIC_ACQUIRE) == old) {
+        usleep(1000);
+    }
+    if(__atomic_load_n(&reload->server->current, __ATOMIC_ACQUIRE) != old) {
+        old->next_draining = reload->draining;
+        reload->draining   = old;
+    }
+}
+
+akinator_generation_t *akinator_reload_load(akinator_reload_t *reload,
+                                            struct stat       *file) {
+    akinator_generation_t *generation = (akinator_generation_t *)calloc(1, sizeof(*generation));
+    akinator_t            *akinator   = (akinator_t            *)calloc(1, sizeof(*akinator));
+    if(generation == NULL || akinator == NULL) {
+        free(generation);
+        free(akinator);
+        return NULL;
+    }
+    generation->akinator = akinator;
+    generation->owned    = 1;
+    generation->inode    = file->st_ino;
+    generation->modified = file->st_mtim;
+
+    //a tree that reads and verifies but has nothing to guess is a truncated write
+    if(akinator_tree_ctor(akinator, reload->server->initial.akinator->database_name) != AKINATOR_SUCCESS ||
+       akinator->root             == NULL                                                             ||
+       akinator->leafs_array_size == 0) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Database '%s' was changed but is not valid, keeping the current tree.\n",
+                     akinator->database_name);
+        akinator_generation_dtor(generation);
+        return NULL;
+    }
+    return generation;
+}
+
+//old tree is freed when no session pins it and no worker is between loading
+//current and pinning it
+void akinator_reload_drain(akinator_reload_t *reload) {
+    akinator_generation_t **link = &reload->draining;
+    while(*link != NULL) {
+        akinator_generation_t *generation = *link;
+        if(__atomic_load_n(&generation->sessions, __ATOMIC_ACQUIRE) != 0) {
+            link = &generation->next_draining;
+            continue;
+        }
+        akinator_epoch_synchronize(&reload->server->epoch);
+        if(__atomic_load_n(&generation->sessions, __ATOMIC_ACQUIRE) != 0) {
+            link = &generation->next_draining;
+            continue;
+        }
+
+        *link = generation->next_draining;
+        if(generation->owned) {
+            akinator_generation_dtor(generation);
+        }
+        reload->freed_number++;
+    }
+}
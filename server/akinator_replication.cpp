@@ -0,0 +1,716 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "akinator_replication.h"
+#include "akinator_tree.h"
+#include "akinator_utils.h"
+#include "custom_assert.h"
+#include "colors.h"
+
+static const size_t ReplicationMaxLine = 64;
+
+struct akinator_replication_sender_t {
+    akinator_replication_t *replication;
+    int                     socket;
+};
+
+static void            *akinator_replication_listen   (void                          *argument);
+
+static void            *akinator_replication_send     (void                          *argument);
+
+static void            *akinator_replica_thread       (void                          *argument);
+
+static void            *akinator_replica_saver        (void                          *argument);
+
+static akinator_error_t akinator_replica_connect      (akinator_replica_t            *replica);
+
+static akinator_error_t akinator_replica_apply        (akinator_replica_t            *replica);
+
+static akinator_error_t akinator_replica_save         (akinator_replica_t            *replica);
+
+static bool             akinator_subtree_has_leaf     (akinator_node_t               *root,
+                                                       const char                    *object);
+
+static akinator_error_t akinator_sequence_read        (const char                    *sequence_name,
+                                                       uint64_t                      *sequence);
+
+static akinator_error_t akinator_sequence_write       (const char                    *sequence_name,
+                                                       uint64_t                       sequence);
+
+static akinator_error_t akinator_sequence_name        (char                          *sequence_name,
+                                                       const char                    *database_name);
+
+static size_t           akinator_record_encode        (akinator_replication_record_t *record,
+                                                       char                          *message);
+
+static bool             akinator_write_all            (int                            socket,
+                                                       const void                    *data,
+                                                       size_t                         size,
+                                                       volatile int                  *stop);
+
+static bool             akinator_read_all             (int                            socket,
+                                                       void                          *data,
+                                                       size_t                         size,
+                                                       volatile int                  *stop);
+
+static int              akinator_unix_socket          (const char                    *socket_path,
+                                                       bool                           listening);
+
+static void             akinator_block_stop_signals   (sigset_t                      *previous);
+
+akinator_error_t akinator_replication_ctor(akinator_replication_t *replication,
+                                           akinator_server_t      *server,
+                                           const char             *socket_path) {
+    _C_ASSERT(replication != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(server      != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(socket_path != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    replication->server        = server;
+    replication->socket_path   = socket_path;
+    replication->listen_socket = -1;
+    pthread_mutex_init(&replication->lock,             NULL);
+    pthread_cond_init (&replication->published_signal, NULL);
+
+    RETURN_IF_ERROR(akinator_sequence_name(replication->sequence_name, server->initial.akinator->database_name));
+    RETURN_IF_ERROR(akinator_sequence_read(replication->sequence_name, &replication->first));
+    replication->staged    = replication->first;
+    replication->published = replication->first;
+
+    replication->records = (akinator_replication_record_t *)calloc(ReplicationLogCapacity,
+                                                                   sizeof(replication->records[0]));
+    if(replication->records == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while allocating replication log.\n");
+        return AKINATOR_SERVER_ALLOCATION_ERROR;
+    }
+
+    replication->listen_socket = akinator_unix_socket(socket_path, true);
+    if(replication->listen_socket < 0) {
+        return AKINATOR_SERVER_SOCKET_ERROR;
+    }
+
+    sigset_t previous = {};
+    akinator_block_stop_signals(&previous);
+    int thread_error = pthread_create(&replication->listener, NULL, akinator_replication_listen, replication);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    if(thread_error != 0) {
+        close(replication->listen_socket);
+        replication->listen_socket = -1;
+        return AKINATOR_SERVER_THREAD_ERROR;
+    }
+    server->replication = replication;
+    return AKINATOR_SUCCESS;
+}
+
+//called by the writer right after learning at leaf, its place is now held by the new question
+akinator_error_t akinator_replication_stage(akinator_replication_t *replication,
+                                            akinator_node_t        *leaf,
+                                            const char             *object,
+                                            const char             *question) {
+    _C_ASSERT(replication != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(leaf        != NULL, return AKINATOR_NODE_NULL             );
+
+    akinator_node_t *way[ServerMaxWay] = {};
+    size_t           depth             = 0;
+    for(akinator_node_t *node = leaf->parent; node->parent != NULL; node = node->parent) {
+        if(depth == ServerMaxWay) {
+            return AKINATOR_INVALID_NODE_LEVEL;
+        }
+        way[depth++] = node;
+    }
+
+    pthread_mutex_lock(&replication->lock);
+    uint64_t                       sequence = replication->staged + 1;
+    akinator_replication_record_t *record   = replication->records + sequence % ReplicationLogCapacity;
+    memset(record, 0, sizeof(*record));
+    record->header.sequence      = sequence;
+    record->header.depth         = (uint16_t)depth;
+    record->header.object_size   = (uint16_t)strlen(object);
+    record->header.question_size = (uint16_t)strlen(question);
+    for(size_t level = 0; level < depth; level++) {
+        if(way[depth - 1 - level]->parent->no == way[depth - 1 - level]) {
+            record->way[level / 8] |= (uint8_t)(1 << (level % 8));
+        }
+    }
+    strcpy(record->object,   object);
+    strcpy(record->question, question);
+    replication->staged = sequence;
+    if(replication->staged - replication->first > ReplicationLogCapacity) {
+        replication->first = replication->staged - ReplicationLogCapacity;
+    }
+    pthread_mutex_unlock(&replication->lock);
+    return AKINATOR_SUCCESS;
+}
+
+//the number is taken before the batch is saved, after a crash in between the primary
+//starts past records nobody has seen and replicas get gone instead of reused numbers
+akinator_error_t akinator_replication_reserve(akinator_replication_t *replication) {
+    _C_ASSERT(replication != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    return akinator_sequence_write(replication->sequence_name, replication->staged);
+}
+
+akinator_error_t akinator_replication_publish(akinator_replication_t *replication) {
+    _C_ASSERT(replication != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    uint64_t now = get_time_ns();
+    pthread_mutex_lock(&replication->lock);
+    for(uint64_t sequence = replication->published + 1; sequence <= replication->staged; sequence++) {
+        replication->records[sequence % ReplicationLogCapacity].header.committed_ns = now;
+    }
+    replication->published = replication->staged;
+    pthread_cond_broadcast(&replication->published_signal);
+    pthread_mutex_unlock  (&replication->lock);
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_replication_print_stats(akinator_replication_t *replication) {
+    _C_ASSERT(replication != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                 "Replication: records %llu..%llu kept, %zu replicas served.\n",
+                 (unsigned long long)replication->first + 1,
+                 (unsigned long long)replication->published,
+                 replication->replicas_number);
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_replication_dtor(akinator_replication_t *replication) {
+    _C_ASSERT(replication != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    //a zeroed replication was never constructed, its descriptors are not ours
+    if(replication->server != NULL && replication->server->replication == replication) {
+        pthread_mutex_lock(&replication->lock);
+        replication->stop = 1;
+        pthread_cond_broadcast(&replication->published_signal);
+        pthread_mutex_unlock  (&replication->lock);
+        pthread_join(replication->listener, NULL);
+        while(__atomic_load_n(&replication->senders_number, __ATOMIC_ACQUIRE) != 0) {
+            usleep((useconds_t)ServerPollTimeout * 1000);
+        }
+        replication->server->replication = NULL;
+    }
+    if(replication->server != NULL && replication->listen_socket >= 0) {
+        close (replication->listen_socket);
+        unlink(replication->socket_path);
+    }
+    free(replication->records);
+    pthread_cond_destroy (&replication->published_signal);
+    pthread_mutex_destroy(&replication->lock);
+    memset(replication, 0, sizeof(*replication));
+    return AKINATOR_SUCCESS;
+}
+
+void *akinator_replication_listen(void *argument) {
+    akinator_replication_t *replication = (akinator_replication_t *)argument;
+
+    pthread_attr_t attributes = {};
+    pthread_attr_init          (&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+    while(!replication->stop) {
+        pollfd listening = {replication->listen_socket, POLLIN, 0};
+        if(poll(&listening, 1, ServerPollTimeout) <= 0) {
+            continue;
+        }
+        int client = accept(replication->listen_socket, NULL, NULL);
+        if(client < 0) {
+            continue;
+        }
+
+        akinator_replication_sender_t *sender = (akinator_replication_sender_t *)calloc(1, sizeof(*sender));
+        if(sender == NULL) {
+            close(client);
+            continue;
+        }
+        sender->replication = replication;
+        sender->socket      = client;
+        __atomic_fetch_add(&replication->senders_number, 1, __ATOMIC_RELAXED);
+        pthread_t thread = {};
+        if(pthread_create(&thread, &attributes, akinator_replication_send, sender) != 0) {
+            __atomic_fetch_sub(&replication->senders_number, 1, __ATOMIC_RELEASE);
+            close(client);
+            free(sender);
+        }
+    }
+    pthread_attr_destroy(&attributes);
+    return NULL;
+}
+
+//records are copied out under the lock and written without it, a slow replica
+//only holds back its own thread
+void *akinator_replication_send(void *argument) {
+    akinator_replication_sender_t *sender      = (akinator_replication_sender_t *)argument;
+    akinator_replication_t        *replication = sender->replication;
+
+    char   line[ReplicationMaxLine] = {};
+    size_t line_size                = 0;
+    while(line_size < sizeof(line) - 1 && memchr(line, '\n', line_size) == NULL) {
+        pollfd client = {sender->socket, POLLIN, 0};
+        if(replication->stop || poll(&client, 1, ServerPollTimeout) < 0) {
+            break;
+        }
+        if((client.revents & (POLLIN | POLLHUP)) == 0) {
+            continue;
+        }
+        ssize_t read_size = read(sender->socket, line + line_size, sizeof(line) - 1 - line_size);
+        if(read_size <= 0) {
+            break;
+        }
+        line_size += (size_t)read_size;
+    }
+
+    unsigned long long requested = 0;
+    char              *message   = (char *)calloc(1, sizeof(akinator_replication_record_t));
+    if(message != NULL && sscanf(line, "replicate %llu", &requested) == 1) {
+        __atomic_fetch_add(&replication->replicas_number, 1, __ATOMIC_RELAXED);
+        uint64_t next = requested + 1;
+        pthread_mutex_lock(&replication->lock);
+        uint64_t first = replication->first;
+        bool     open  = requested >= first && requested <= replication->published;
+        pthread_mutex_unlock(&replication->lock);
+        int size = snprintf(message, ReplicationMaxLine, "%s %llu\n", open ? "ok" : "gone",
+                            (unsigned long long)first);
+        open = akinator_write_all(sender->socket, message, (size_t)size, &replication->stop) && open;
+
+        while(open) {
+            pthread_mutex_lock(&replication->lock);
+            while(!replication->stop && next > replication->published) {
+                struct timespec timeout = {};
+                clock_gettime(CLOCK_REALTIME, &timeout);
+                timeout.tv_nsec += (long)ServerPollTimeout * 1000000;
+                if(timeout.tv_nsec >= 1000000000) {
+                    timeout.tv_sec++;
+                    timeout.tv_nsec -= 1000000000;
+                }
+                pthread_cond_timedwait(&replication->published_signal, &replication->lock, &timeout);
+            }
+            //a replica that fell behind the whole log reconnects and gets gone
+            open = !replication->stop && next > replication->first;
+            size_t record_size = open ? akinator_record_encode(replication->records + next % ReplicationLogCapacity,
+                                                               message) : 0;
+            pthread_mutex_unlock(&replication->lock);
+            open = open && akinator_write_all(sender->socket, message, record_size, &replication->stop);
+            next++;
+        }
+    }
+
+    free(message);
+    close(sender->socket);
+    free(sender);
+    __atomic_fetch_sub(&replication->senders_number, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+akinator_error_t akinator_replica_ctor(akinator_replica_t *replica,
+                                       akinator_server_t  *server,
+                                       const char         *primary_path) {
+    _C_ASSERT(replica      != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(server       != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(primary_path != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    replica->server       = server;
+    replica->primary_path = primary_path;
+    replica->socket       = -1;
+    RETURN_IF_ERROR(akinator_sequence_name(replica->sequence_name, server->initial.akinator->database_name));
+    RETURN_IF_ERROR(akinator_sequence_read(replica->sequence_name, &replica->applied));
+    replica->saved = replica->applied;
+
+    replica->lag = (akinator_histogram_t *)calloc(1, sizeof(akinator_histogram_t));
+    if(replica->lag == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while allocating lag histogram.\n");
+        return AKINATOR_SERVER_ALLOCATION_ERROR;
+    }
+
+    server->read_only = 1;
+    sigset_t previous = {};
+    akinator_block_stop_signals(&previous);
+    int thread_error = pthread_create(&replica->thread, NULL, akinator_replica_thread, replica);
+    if(thread_error == 0) {
+        thread_error = pthread_create(&replica->saver, NULL, akinator_replica_saver, replica);
+        if(thread_error != 0) {
+            replica->stop = 1;
+            pthread_join(replica->thread, NULL);
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    if(thread_error != 0) {
+        free(replica->lag);
+        replica->lag = NULL;
+        return AKINATOR_SERVER_THREAD_ERROR;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_replica_print_stats(akinator_replica_t *replica) {
+    _C_ASSERT(replica != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    if(replica->lag == NULL) {
+        return AKINATOR_SUCCESS;
+    }
+    uint64_t p50 = 0;
+    uint64_t p99 = 0;
+    akinator_histogram_percentile(replica->lag, 50, &p50);
+    akinator_histogram_percentile(replica->lag, 99, &p99);
+    color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                 "Replica: at record %llu, %zu applied, %zu already present, %zu connects, "
+                 "lag p50 %.1f us, p99 %.1f us, max %.1f us.\n",
+                 (unsigned long long)replica->applied,
+                 replica->lag->count,
+                 replica->skipped_number,
+                 replica->connects_number,
+                 (double)p50 / 1000,
+                 (double)p99 / 1000,
+                 (double)replica->lag->max / 1000);
+    if(replica->error != AKINATOR_SUCCESS) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Replica stopped with error %d.\n", replica->error);
+    }
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_replica_dtor(akinator_replica_t *replica) {
+    _C_ASSERT(replica != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    akinator_error_t error_code = AKINATOR_SUCCESS;
+    if(replica->lag != NULL) {
+        replica->stop = 1;
+        pthread_join(replica->thread, NULL);
+        pthread_join(replica->saver,  NULL);
+        error_code = akinator_replica_save(replica);
+    }
+    if(replica->server != NULL && replica->socket >= 0) {
+        close(replica->socket);
+    }
+    free(replica->lag);
+    memset(replica, 0, sizeof(*replica));
+    return error_code;
+}
+
+//reconnects until stopped, records are applied as they come
+void *akinator_replica_thread(void *argument) {
+    akinator_replica_t *replica = (akinator_replica_t *)argument;
+
+    while(!replica->stop && replica->error == AKINATOR_SUCCESS) {
+        if(replica->socket < 0 && akinator_replica_connect(replica) != AKINATOR_SUCCESS) {
+            usleep((useconds_t)ServerPollTimeout * 1000);
+            continue;
+        }
+
+        akinator_replication_header_t *header = &replica->record.header;
+        if(!akinator_read_all(replica->socket, header, sizeof(*header), &replica->stop)) {
+            close(replica->socket);
+            replica->socket = -1;
+            continue;
+        }
+        size_t way_size = ((size_t)header->depth + 7) / 8;
+        if(header->depth         >  ServerMaxWay    ||
+           header->object_size   >  MaxQuestionSize ||
+           header->question_size >  MaxQuestionSize ||
+           header->sequence      != replica->applied + 1) {
+            replica->error = AKINATOR_REPLICATION_ERROR;
+            break;
+        }
+        memset(replica->record.object,   0, sizeof(replica->record.object));
+        memset(replica->record.question, 0, sizeof(replica->record.question));
+        if(!akinator_read_all(replica->socket, replica->record.way,      way_size,              &replica->stop) ||
+           !akinator_read_all(replica->socket, replica->record.object,   header->object_size,   &replica->stop) ||
+           !akinator_read_all(replica->socket, replica->record.question, header->question_size, &replica->stop)) {
+            close(replica->socket);
+            replica->socket = -1;
+            continue;
+        }
+
+        replica->error = akinator_replica_apply(replica);
+    }
+    return NULL;
+}
+
+void *akinator_replica_saver(void *argument) {
+    akinator_replica_t *replica = (akinator_replica_t *)argument;
+
+    while(!replica->stop) {
+        for(int waited = 0; waited < ReplicationSaveMs && !replica->stop; waited += ServerPollTimeout) {
+            usleep((useconds_t)ServerPollTimeout * 1000);
+        }
+        if(!replica->stop && akinator_replica_save(replica) != AKINATOR_SUCCESS) {
+            color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                         "Error while saving replica, will try again.\n");
+        }
+    }
+    return NULL;
+}
+
+akinator_error_t akinator_replica_connect(akinator_replica_t *replica) {
+    replica->socket = akinator_unix_socket(replica->primary_path, false);
+    if(replica->socket < 0) {
+        return AKINATOR_SERVER_SOCKET_ERROR;
+    }
+
+    char line[ReplicationMaxLine] = {};
+    int  size = snprintf(line, sizeof(line), "replicate %llu\n", (unsigned long long)replica->applied);
+    if(!akinator_write_all(replica->socket, line, (size_t)size, &replica->stop)) {
+        close(replica->socket);
+        replica->socket = -1;
+        return AKINATOR_SERVER_SOCKET_ERROR;
+    }
+
+    //reply line is read byte by byte, records follow right after it
+    size_t line_size = 0;
+    while(line_size < sizeof(line) - 1) {
+        if(!akinator_read_all(replica->socket, line + line_size, 1, &replica->stop)) {
+            close(replica->socket);
+            replica->socket = -1;
+            return AKINATOR_SERVER_SOCKET_ERROR;
+        }
+        if(line[line_size++] == '\n') {
+            break;
+        }
+    }
+    line[line_size] = '\0';
+
+    unsigned long long first = 0;
+    if(sscanf(line, "ok %llu", &first) != 1) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Primary does not keep records after %llu, it starts at %llu, "
+                     "replica has to be seeded again.\n",
+                     (unsigned long long)replica->applied, first);
+        replica->error = AKINATOR_REPLICATION_ERROR;
+        close(replica->socket);
+        replica->socket = -1;
+        return AKINATOR_REPLICATION_ERROR;
+    }
+    replica->connects_number++;
+    return AKINATOR_SUCCESS;
+}
+
+//a record found applied is the tail of a run saved before the .seq file was updated, later
+//records of that run may have split its object already, so the object is looked for in the
+//whole yes subtree, only leafs are split here, so the question stays where the record put it
+akinator_error_t akinator_replica_apply(akinator_replica_t *replica) {
+    akinator_replication_record_t *record   = &replica->record;
+    akinator_t                    *akinator = replica->server->current->akinator;
+
+    akinator_node_t *node = akinator->root;
+    for(size_t level = 0; level < record->header.depth; level++) {
+        if(node == NULL || is_leaf(node)) {
+            return AKINATOR_REPLICATION_ERROR;
+        }
+        node = (record->way[level / 8] & (1 << (level % 8))) ? node->no : node->yes;
+    }
+    if(node == NULL) {
+        return AKINATOR_REPLICATION_ERROR;
+    }
+
+    if(!is_leaf(node)) {
+        if(strcmp(node->question, record->question) != 0 ||
+           !akinator_subtree_has_leaf(node->yes, record->object)) {
+            color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                         "Record %llu does not match the tree, replica has to be seeded again.\n",
+                         (unsigned long long)record->header.sequence);
+            return AKINATOR_REPLICATION_ERROR;
+        }
+        replica->skipped_number++;
+    }
+    else {
+        //the walk above checked the only node the record touches, verifying the whole tree
+        //would be most of the lag
+        RETURN_IF_ERROR(akinator_split_leaf(akinator, node, record->object, record->question));
+        akinator_histogram_add(replica->lag, get_time_ns() - record->header.committed_ns);
+    }
+    __atomic_store_n(&replica->applied, record->header.sequence, __ATOMIC_RELEASE);
+    return AKINATOR_SUCCESS;
+}
+
+//walks the subtree through parent links, so a deep tree needs no stack
+bool akinator_subtree_has_leaf(akinator_node_t *root,
+                               const char      *object) {
+    akinator_node_t *node = root;
+    while(true) {
+        if(!is_leaf(node)) {
+            node = node->yes;
+            continue;
+        }
+        if(strcmp(node->question, object) == 0) {
+            return true;
+        }
+        while(node != root && node->parent->no == node) {
+            node = node->parent;
+        }
+        if(node == root) {
+            return false;
+        }
+        node = node->parent->no;
+    }
+}
+
+//the file may hold records past applied, never fewer
+akinator_error_t akinator_replica_save(akinator_replica_t *replica) {
+    uint64_t applied = __atomic_load_n(&replica->applied, __ATOMIC_ACQUIRE);
+    if(applied == replica->saved) {
+        return AKINATOR_SUCCESS;
+    }
+    RETURN_IF_ERROR(akinator_save_database (replica->server->current->akinator));
+    RETURN_IF_ERROR(akinator_sequence_write(replica->sequence_name, applied));
+    replica->saved = applied;
+    return AKINATOR_SUCCESS;
+}
+
+//a database without .seq starts the log from zero
+akinator_error_t akinator_sequence_read(const char *sequence_name,
+                                        uint64_t   *sequence) {
+    FILE *sequence_file = fopen(sequence_name, "r");
+    if(sequence_file == NULL) {
+        *sequence = 0;
+        return AKINATOR_SUCCESS;
+    }
+    unsigned long long value = 0;
+    int scanned = fscanf(sequence_file, "%llu", &value);
+    fclose(sequence_file);
+    if(scanned != 1) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while reading '%s'.\n", sequence_name);
+        return AKINATOR_REPLICATION_ERROR;
+    }
+    *sequence = value;
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_sequence_write(const char *sequence_name,
+                                         uint64_t    sequence) {
+    char temporary_name[PATH_MAX] = {};
+    if((size_t)snprintf(temporary_name, sizeof(temporary_name), "%s.tmp", sequence_name) >= sizeof(temporary_name)) {
+        return AKINATOR_DATABASE_FILENAME_NULL;
+    }
+    FILE *sequence_file = fopen(temporary_name, "w");
+    if(sequence_file == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while opening '%s'.\n", temporary_name);
+        return AKINATOR_REPLICATION_ERROR;
+    }
+    fprintf(sequence_file, "%llu\n", (unsigned long long)sequence);
+    bool written = fflush(sequence_file) == 0 && fsync(fileno(sequence_file)) == 0;
+    if(fclose(sequence_file) != 0 || !written || rename(temporary_name, sequence_name) != 0) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while writing '%s'.\n", sequence_name);
+        remove(temporary_name);
+        return AKINATOR_REPLICATION_ERROR;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_sequence_name(char       *sequence_name,
+                                        const char *database_name) {
+    if((size_t)snprintf(sequence_name, PATH_MAX, "%s.seq", database_name) >= PATH_MAX) {
+        return AKINATOR_DATABASE_FILENAME_NULL;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+size_t akinator_record_encode(akinator_replication_record_t *record,
+                              char                          *message) {
+    size_t way_size = ((size_t)record->header.depth + 7) / 8;
+    size_t size     = 0;
+    memcpy(message + size, &record->header, sizeof(record->header));
+    size += sizeof(record->header);
+    memcpy(message + size, record->way,      way_size);
+    size += way_size;
+    memcpy(message + size, record->object,   record->header.object_size);
+    size += record->header.object_size;
+    memcpy(message + size, record->question, record->header.question_size);
+    size += record->header.question_size;
+    return size;
+}
+
+bool akinator_write_all(int           socket,
+                        const void   *data,
+                        size_t        size,
+                        volatile int *stop) {
+    size_t sent = 0;
+    while(sent < size && !*stop) {
+        pollfd peer = {socket, POLLOUT, 0};
+        if(poll(&peer, 1, ServerPollTimeout) == 0) {
+            continue;
+        }
+        ssize_t written = send(socket, (const char *)data + sent, size - sent, MSG_NOSIGNAL);
+        if(written < 0 && (errno == EINTR || errno == EAGAIN)) {
+            continue;
+        }
+        if(written <= 0) {
+            return false;
+        }
+        sent += (size_t)written;
+    }
+    return sent == size;
+}
+
+bool akinator_read_all(int           socket,
+                       void         *data,
+                       size_t        size,
+                       volatile int *stop) {
+    size_t received = 0;
+    while(received < size && !*stop) {
+        pollfd peer = {socket, POLLIN, 0};
+        if(poll(&peer, 1, ServerPollTimeout) == 0) {
+            continue;
+        }
+        ssize_t read_size = read(socket, (char *)data + received, size - received);
+        if(read_size < 0 && errno == EINTR) {
+            continue;
+        }
+        if(read_size <= 0) {
+            return false;
+        }
+        received += (size_t)read_size;
+    }
+    return received == size;
+}
+
+int akinator_unix_socket(const char *socket_path,
+                         bool        listening) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if(strlen(socket_path) >= sizeof(address.sun_path)) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Socket path '%s' is too long.\n", socket_path);
+        return -1;
+    }
+    strcpy(address.sun_path, socket_path);
+
+    int unix_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(unix_socket < 0) {
+        return -1;
+    }
+    if(listening) {
+        unlink(socket_path);
+        if(bind  (unix_socket, (sockaddr *)&address, sizeof(address)) != 0 ||
+           listen(unix_socket, ServerListenBacklog) != 0) {
+            color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                         "Error while opening socket '%s': %s.\n", socket_path, strerror(errno));
+            close(unix_socket);
+            return -1;
+        }
+    }
+    else if(connect(unix_socket, (sockaddr *)&address, sizeof(address)) != 0) {
+        close(unix_socket);
+        return -1;
+    }
+    return unix_socket;
+}
+
+//same as the pool, stop signals belong to the accepting thread
+void akinator_block_stop_signals(sigset_t *previous) {
+    sigset_t blocked = {};
+    sigemptyset(&blocked);
+    sigaddset  (&blocked, SIGINT);
+    sigaddset  (&blocked, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &blocked, previous);
+}
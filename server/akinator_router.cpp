@@ -0,0 +1,642 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "akinator_router.h"
+#include "akinator_tree.h"
+#include "akinator_flow.h"
+#include "akinator_definition.h"
+#include "akinator_utils.h"
+#include "custom_assert.h"
+#include "colors.h"
+
+static akinator_error_t akinator_router_write_node  (FILE                         *router_file,
+                                                     akinator_node_t              *node,
+                                                     size_t                        level,
+                                                     size_t                        depth,
+                                                     const char                   *directory,
+                                                     size_t                       *shards_number);
+
+static void            *akinator_router_serve       (void                         *argument);
+
+static bool             akinator_router_handle_line (akinator_router_connection_t *connection,
+                                                     char                         *line);
+
+static bool             akinator_router_reply_state (akinator_router_connection_t *connection);
+
+static bool             akinator_router_learn       (akinator_router_connection_t *connection,
+                                                     char                         *arguments);
+
+static bool             akinator_router_query       (akinator_router_connection_t *connection,
+                                                     const char                   *first,
+                                                     const char                   *second);
+
+static bool             akinator_router_forward     (akinator_router_connection_t *connection,
+                                                     const char                   *line);
+
+static bool             akinator_router_request     (akinator_router_connection_t *connection,
+                                                     size_t                        shard,
+                                                     const char                   *line);
+
+static akinator_error_t akinator_router_find_way    (akinator_router_connection_t *connection,
+                                                     const char                   *object,
+                                                     akinator_router_way_t        *way);
+
+static akinator_error_t akinator_router_node_way    (akinator_node_t              *node,
+                                                     akinator_router_way_t        *way);
+
+static size_t           akinator_way_size           (const akinator_router_way_t  *way);
+
+static const char      *akinator_way_question       (const akinator_router_way_t  *way,
+                                                     size_t                        step);
+
+static bool             akinator_way_no             (const akinator_router_way_t  *way,
+                                                     size_t                        step);
+
+static long             akinator_router_link        (akinator_node_t              *node);
+
+static bool             akinator_router_send        (int                           socket,
+                                                     const char                   *format, ...)
+                                                     __attribute__((format(printf, 2, 3)));
+
+static void             akinator_router_close       (akinator_router_connection_t *connection);
+
+//nodes at depth that still ask questions become shards, leafs above it stay in the router
+akinator_error_t akinator_router_split(akinator_t *akinator,
+                                       size_t      depth,
+                                       const char *directory,
+                                       size_t     *shards_number) {
+    _C_ASSERT(akinator      != NULL, return AKINATOR_NULL_POINTER           );
+    _C_ASSERT(directory     != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(shards_number != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    char router_name[RouterMaxPath] = {};
+    if(mkdir(directory, 0755) != 0 && errno != EEXIST) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while creating '%s': %s.\n", directory, strerror(errno));
+        return AKINATOR_ROUTER_ERROR;
+    }
+    if((size_t)snprintf(router_name, sizeof(router_name), "%s/%s", directory, RouterDatabaseName) >= sizeof(router_name)) {
+        return AKINATOR_DATABASE_FILENAME_NULL;
+    }
+
+    FILE *router_file = fopen(router_name, "w");
+    if(router_file == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while opening database.\n");
+        return AKINATOR_DATABASE_OPENING_ERROR;
+    }
+    *shards_number = 0;
+    akinator_error_t error_code = akinator_router_write_node(router_file, akinator->root, 0, depth,
+                                                             directory, shards_number);
+    if(fclose(router_file) != 0 && error_code == AKINATOR_SUCCESS) {
+        error_code = AKINATOR_DATABASE_OPENING_ERROR;
+    }
+    return error_code;
+}
+
+akinator_error_t akinator_router_ctor(akinator_router_t *router,
+                                      const char        *directory,
+                                      const char        *socket_path) {
+    _C_ASSERT(router      != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(directory   != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(socket_path != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    router->directory     = directory;
+    router->socket_path   = socket_path;
+    router->listen_socket = -1;
+    pthread_mutex_init(&router->learn_lock, NULL);
+    if((size_t)snprintf(router->database_name, sizeof(router->database_name), "%s/%s",
+                        directory, RouterDatabaseName) >= sizeof(router->database_name)) {
+        return AKINATOR_DATABASE_FILENAME_NULL;
+    }
+    RETURN_IF_ERROR(akinator_tree_ctor(&router->akinator, router->database_name));
+
+    for(size_t index = 0; index < router->akinator.leafs_array_size; index++) {
+        long shard = akinator_router_link(router->akinator.leafs_array[index]);
+        if(shard >= 0 && (size_t)shard >= router->shards_number) {
+            router->shards_number = (size_t)shard + 1;
+        }
+    }
+    router->links = (akinator_node_t **)calloc(router->shards_number + 1, sizeof(router->links[0]));
+    if(router->links == NULL) {
+        return AKINATOR_SERVER_ALLOCATION_ERROR;
+    }
+    for(size_t index = 0; index < router->akinator.leafs_array_size; index++) {
+        long shard = akinator_router_link(router->akinator.leafs_array[index]);
+        if(shard >= 0) {
+            router->links[shard] = router->akinator.leafs_array[index];
+        }
+    }
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if(strlen(socket_path) >= sizeof(address.sun_path)) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Socket path '%s' is too long.\n", socket_path);
+        return AKINATOR_SERVER_SOCKET_ERROR;
+    }
+    strcpy(address.sun_path, socket_path);
+    unlink(socket_path);
+
+    router->listen_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(router->listen_socket < 0 ||
+       bind  (router->listen_socket, (sockaddr *)&address, sizeof(address)) != 0 ||
+       listen(router->listen_socket, ServerListenBacklog) != 0) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while opening socket '%s': %s.\n", socket_path, strerror(errno));
+        return AKINATOR_SERVER_SOCKET_ERROR;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+//router only walks the top levels and passes lines on, so every client gets a thread
+//that blocks on its own shard connections
+akinator_error_t akinator_router_run(akinator_router_t *router) {
+    _C_ASSERT(router != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    pthread_attr_t attributes = {};
+    pthread_attr_init          (&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+    sigset_t blocked  = {};
+    sigset_t previous = {};
+    sigemptyset(&blocked);
+    sigaddset  (&blocked, SIGINT);
+    sigaddset  (&blocked, SIGTERM);
+
+    while(!router->stop) {
+        int client = accept(router->listen_socket, NULL, NULL);
+        if(client < 0) {
+            if(errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                         "Error while accepting connection: %s.\n", strerror(errno));
+            break;
+        }
+
+        akinator_router_connection_t *connection =
+            (akinator_router_connection_t *)calloc(1, sizeof(*connection));
+        int *shard_sockets = (int *)malloc((router->shards_number + 1) * sizeof(shard_sockets[0]));
+        if(connection == NULL || shard_sockets == NULL) {
+            free(connection);
+            free(shard_sockets);
+            close(client);
+            continue;
+        }
+        for(size_t shard = 0; shard <= router->shards_number; shard++) {
+            shard_sockets[shard] = -1;
+        }
+        connection->router        = router;
+        connection->socket        = client;
+        connection->shard_sockets = shard_sockets;
+        connection->shard         = -1;
+
+        __atomic_fetch_add(&router->connections_number, 1, __ATOMIC_RELAXED);
+        pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+        int thread_error = pthread_create(&connection->thread, &attributes, akinator_router_serve, connection);
+        pthread_sigmask(SIG_SETMASK, &previous, NULL);
+        if(thread_error != 0) {
+            akinator_router_close(connection);
+        }
+    }
+
+    router->stop = 1;
+    while(__atomic_load_n(&router->connections_number, __ATOMIC_ACQUIRE) != 0) {
+        usleep((useconds_t)ServerPollTimeout * 1000);
+    }
+    pthread_attr_destroy(&attributes);
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_router_print_stats(akinator_router_t *router) {
+    _C_ASSERT(router != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                 "Router: %zu shards, %zu sessions started, %zu handed to shards, %zu definition queries.\n",
+                 router->shards_number,
+                 router->sessions_started,
+                 router->handoffs_number,
+                 router->queries_number);
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_router_dtor(akinator_router_t *router) {
+    _C_ASSERT(router != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    if(router->listen_socket >= 0) {
+        close (router->listen_socket);
+        unlink(router->socket_path);
+    }
+    akinator_tree_dtor(&router->akinator);
+    free(router->links);
+    pthread_mutex_destroy(&router->learn_lock);
+    memset(router, 0, sizeof(*router));
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_router_write_node(FILE            *router_file,
+                                            akinator_node_t *node,
+                                            size_t           level,
+                                            size_t           depth,
+                                            const char      *directory,
+                                            size_t          *shards_number) {
+    _C_ASSERT(node != NULL, return AKINATOR_NODE_NULL);
+
+    if(level == depth && !is_leaf(node)) {
+        char shard_name[RouterMaxPath] = {};
+        if((size_t)snprintf(shard_name, sizeof(shard_name), "%s/shard_%zu",
+                            directory, *shards_number) >= sizeof(shard_name)) {
+            return AKINATOR_DATABASE_FILENAME_NULL;
+        }
+        RETURN_IF_ERROR(akinator_write_subtree(node, shard_name));
+        fprintf(router_file, "%*s{\"%s%zu\"}\n", (int)(level * 8), "", RouterLinkPrefix, *shards_number);
+        (*shards_number)++;
+        return AKINATOR_SUCCESS;
+    }
+
+    fprintf(router_file, "%*s{\"%s\"", (int)(level * 8), "", node->question);
+    if(is_leaf(node)) {
+        fputs("}\n", router_file);
+        return AKINATOR_SUCCESS;
+    }
+    fputc('\n', router_file);
+    RETURN_IF_ERROR(akinator_router_write_node(router_file, node->yes, level + 1, depth, directory, shards_number));
+    RETURN_IF_ERROR(akinator_router_write_node(router_file, node->no,  level + 1, depth, directory, shards_number));
+    fprintf(router_file, "%*s}\n", (int)(level * 8), "");
+    return AKINATOR_SUCCESS;
+}
+
+void *akinator_router_serve(void *argument) {
+    akinator_router_connection_t *connection = (akinator_router_connection_t *)argument;
+    akinator_router_t            *router     = connection->router;
+
+    bool open = true;
+    while(open && !router->stop) {
+        pollfd client = {connection->socket, POLLIN, 0};
+        if(poll(&client, 1, ServerPollTimeout) <= 0) {
+            continue;
+        }
+        ssize_t read_size = read(connection->socket,
+                                 connection->buffer + connection->buffer_size,
+                                 sizeof(connection->buffer) - connection->buffer_size);
+        if(read_size <= 0) {
+            break;
+        }
+        connection->buffer_size += (size_t)read_size;
+
+        char *end = NULL;
+        while(open && (end = (char *)memchr(connection->buffer, '\n', connection->buffer_size)) != NULL) {
+            *end = '\0';
+            open = akinator_router_handle_line(connection, connection->buffer);
+            size_t line_size = (size_t)(end - connection->buffer) + 1;
+            memmove(connection->buffer, end + 1, connection->buffer_size - line_size);
+            connection->buffer_size -= line_size;
+        }
+        if(connection->buffer_size == sizeof(connection->buffer)) {
+            break;
+        }
+    }
+
+    akinator_router_close(connection);
+    return NULL;
+}
+
+bool akinator_router_handle_line(akinator_router_connection_t *connection,
+                                 char                         *line) {
+    akinator_router_t *router = connection->router;
+
+    if(strcmp(line, "start") == 0) {
+        connection->shard = -1;
+        __atomic_fetch_add(&router->sessions_started, 1, __ATOMIC_RELAXED);
+        if(akinator_session_start(&connection->session, &router->akinator) != AKINATOR_SUCCESS) {
+            return akinator_router_send(connection->socket, "error %d\n", AKINATOR_SESSION_STATE_ERROR);
+        }
+        return akinator_router_reply_state(connection);
+    }
+    if(strncmp(line, "answer ", sizeof("answer ") - 1) == 0) {
+        if(connection->shard >= 0) {
+            return akinator_router_forward(connection, line);
+        }
+        akinator_error_t error_code = akinator_session_answer(&connection->session,
+                                                              (akinator_answer_t)atoi(line + sizeof("answer ") - 1));
+        return (error_code == AKINATOR_SUCCESS) ? akinator_router_reply_state(connection) :
+                                                  akinator_router_send(connection->socket, "error %d\n", error_code);
+    }
+    if(strncmp(line, "learn ", sizeof("learn ") - 1) == 0) {
+        if(connection->shard >= 0) {
+            return akinator_router_forward(connection, line);
+        }
+        return akinator_router_learn(connection, line + sizeof("learn ") - 1);
+    }
+    if(strncmp(line, "definition ", sizeof("definition ") - 1) == 0) {
+        return akinator_router_query(connection, line + sizeof("definition ") - 1, NULL);
+    }
+    if(strncmp(line, "difference ", sizeof("difference ") - 1) == 0) {
+        char *second = strchr(line, '\t');
+        if(second == NULL) {
+            return akinator_router_send(connection->socket, "error %d\n", AKINATOR_NULL_OBJECT_NAME);
+        }
+        *second = '\0';
+        return akinator_router_query(connection, line + sizeof("difference ") - 1, second + 1);
+    }
+    if(strcmp(line, "quit") == 0) {
+        return false;
+    }
+    return akinator_router_send(connection->socket, "error %d\n", AKINATOR_USER_ANSWER_ERROR);
+}
+
+//a session that reaches a link is started in the shard, the shard asks from then on
+bool akinator_router_reply_state(akinator_router_connection_t *connection) {
+    akinator_session_t *session = &connection->session;
+    switch(session->state) {
+        case AKINATOR_SESSION_ASKING: {
+            return akinator_router_send(connection->socket, "ask %s\n", session->current->question);
+        }
+        case AKINATOR_SESSION_GUESSING: {
+            long shard = akinator_router_link(session->current);
+            if(shard < 0) {
+                return akinator_router_send(connection->socket, "guess %s\n", session->current->question);
+            }
+            connection->shard = shard;
+            __atomic_fetch_add(&connection->router->handoffs_number, 1, __ATOMIC_RELAXED);
+            return akinator_router_forward(connection, "start");
+        }
+        case AKINATOR_SESSION_LEARNING: {
+            return akinator_router_send(connection->socket, "learn\n");
+        }
+        case AKINATOR_SESSION_WON: {
+            return akinator_router_send(connection->socket, "won\n");
+        }
+        case AKINATOR_SESSION_LEARNED: {
+            return akinator_router_send(connection->socket, "learned\n");
+        }
+        case AKINATOR_SESSION_IDLE: {
+            return akinator_router_send(connection->socket, "error %d\n", AKINATOR_SESSION_STATE_ERROR);
+        }
+        default: {
+            return false;
+        }
+    }
+}
+
+//objects learned above the split depth stay in the router database
+bool akinator_router_learn(akinator_router_connection_t *connection,
+                           char                         *arguments) {
+    akinator_router_t *router    = connection->router;
+    char              *separator = strchr(arguments, '\t');
+    if(separator == NULL ||
+       (size_t)(separator - arguments) > MaxQuestionSize ||
+       strlen(separator + 1)          > MaxQuestionSize ||
+       strncmp(arguments, RouterLinkPrefix, sizeof(RouterLinkPrefix) - 1) == 0) {
+        return akinator_router_send(connection->socket, "error %d\n", AKINATOR_SESSION_STATE_ERROR);
+    }
+    *separator = '\0';
+
+    pthread_mutex_lock(&router->learn_lock);
+    akinator_error_t error_code = akinator_session_learn(&connection->session, arguments, separator + 1);
+    if(error_code == AKINATOR_SUCCESS) {
+        error_code = akinator_save_database(&router->akinator);
+    }
+    pthread_mutex_unlock(&router->learn_lock);
+    return (error_code == AKINATOR_SUCCESS) ? akinator_router_send(connection->socket, "learned\n") :
+                                              akinator_router_send(connection->socket, "error %d\n", error_code);
+}
+
+//ways are put together from the router levels and the shard levels below the link
+bool akinator_router_query(akinator_router_connection_t *connection,
+                           const char                   *first,
+                           const char                   *second) {
+    __atomic_fetch_add(&connection->router->queries_number, 1, __ATOMIC_RELAXED);
+
+    char                  text[MaxDefinitionSize] = {};
+    akinator_definition_t definition = {.definition = text,
+                                        .index      = 0,
+                                        .capacity   = sizeof(text)};
+    akinator_error_t error_code = akinator_router_find_way(connection, first, connection->ways + 0);
+    if(error_code == AKINATOR_SUCCESS && second != NULL) {
+        error_code = akinator_router_find_way(connection, second, connection->ways + 1);
+    }
+    if(error_code == AKINATOR_SUCCESS) {
+        error_code = (second == NULL) ?
+                     akinator_way_define(connection->ways + 0, first, &definition) :
+                     akinator_way_differ(connection->ways + 0, first, connection->ways + 1, second, &definition);
+    }
+    if(error_code != AKINATOR_SUCCESS) {
+        return akinator_router_send(connection->socket, "error %d\n", error_code);
+    }
+
+    for(char *symbol = text; *symbol != '\0'; symbol++) {
+        if(*symbol == '\n') {
+            *symbol = ' ';
+        }
+    }
+    return akinator_router_send(connection->socket, "%s %s\n", (second == NULL) ? "definition" : "difference", text);
+}
+
+//a shard that is down ends the handed over session, the client can start again
+bool akinator_router_forward(akinator_router_connection_t *connection,
+                             const char                   *line) {
+    if(!akinator_router_request(connection, (size_t)connection->shard, line)) {
+        connection->shard = -1;
+        return akinator_router_send(connection->socket, "error %d\n", AKINATOR_SERVER_SOCKET_ERROR);
+    }
+    return akinator_router_send(connection->socket, "%s\n", connection->reply);
+}
+
+//reply is left in connection->reply without the newline, shards answer one line per line
+bool akinator_router_request(akinator_router_connection_t *connection,
+                             size_t                        shard,
+                             const char                   *line) {
+    int *shard_socket = connection->shard_sockets + shard;
+    if(*shard_socket < 0) {
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if((size_t)snprintf(address.sun_path, sizeof(address.sun_path), "%s/shard_%zu.sock",
+                            connection->router->directory, shard) >= sizeof(address.sun_path)) {
+            return false;
+        }
+        *shard_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+        if(*shard_socket < 0 || connect(*shard_socket, (sockaddr *)&address, sizeof(address)) != 0) {
+            color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                         "Error while connecting to shard '%s': %s.\n", address.sun_path, strerror(errno));
+            if(*shard_socket >= 0) {
+                close(*shard_socket);
+            }
+            *shard_socket = -1;
+            return false;
+        }
+    }
+
+    size_t reply_size = 0;
+    if(!akinator_router_send(*shard_socket, "%s\n", line)) {
+        close(*shard_socket);
+        *shard_socket = -1;
+        return false;
+    }
+    while(true) {
+        ssize_t read_size = read(*shard_socket, connection->reply + reply_size,
+                                 sizeof(connection->reply) - 1 - reply_size);
+        if(read_size <= 0) {
+            close(*shard_socket);
+            *shard_socket = -1;
+            return false;
+        }
+        reply_size += (size_t)read_size;
+        if(connection->reply[reply_size - 1] == '\n') {
+            connection->reply[reply_size - 1] = '\0';
+            return true;
+        }
+        if(reply_size == sizeof(connection->reply) - 1) {
+            close(*shard_socket);
+            *shard_socket = -1;
+            return false;
+        }
+    }
+}
+
+//objects above the split are found in the router, the rest is asked from every shard
+akinator_error_t akinator_router_find_way(akinator_router_connection_t *connection,
+                                          const char                   *object,
+                                          akinator_router_way_t        *way) {
+    akinator_router_t *router = connection->router;
+    akinator_node_t   *node   = NULL;
+    akinator_error_t   error_code = AKINATOR_SUCCESS;
+
+    pthread_mutex_lock(&router->learn_lock);
+    if(akinator_find_node(&router->akinator, object, &node) == AKINATOR_EXIT_SUCCESS &&
+       node != NULL && akinator_router_link(node) < 0) {
+        error_code = akinator_router_node_way(node, way);
+        pthread_mutex_unlock(&router->learn_lock);
+        return error_code;
+    }
+    pthread_mutex_unlock(&router->learn_lock);
+
+    char request[ServerMaxLine] = {};
+    if((size_t)snprintf(request, sizeof(request), "way %s", object) >= sizeof(request)) {
+        return AKINATOR_NULL_OBJECT_NAME;
+    }
+    for(size_t shard = 0; shard < router->shards_number; shard++) {
+        if(router->links[shard] == NULL ||
+           !akinator_router_request(connection, shard, request) ||
+           strncmp(connection->reply, "way", sizeof("way") - 1) != 0) {
+            continue;
+        }
+
+        pthread_mutex_lock(&router->learn_lock);
+        error_code = akinator_router_node_way(router->links[shard], way);
+        pthread_mutex_unlock(&router->learn_lock);
+        RETURN_IF_ERROR(error_code);
+
+        char *step = strchr(connection->reply, '\t');
+        while(step != NULL) {
+            char *next = strchr(step + 1, '\t');
+            if(next != NULL) {
+                *next = '\0';
+            }
+            if(way->size == ServerMaxWay || strlen(step + 2) > MaxQuestionSize) {
+                return AKINATOR_INVALID_NODE_LEVEL;
+            }
+            akinator_router_step_t *shard_step = way->steps + way->size++;
+            shard_step->no = (step[1] == '-');
+            strcpy(shard_step->question, step + 2);
+            step = next;
+        }
+        return AKINATOR_SUCCESS;
+    }
+    return AKINATOR_NULL_OBJECT_NAME;
+}
+
+akinator_error_t akinator_router_node_way(akinator_node_t       *node,
+                                          akinator_router_way_t *way) {
+    akinator_node_t *nodes[ServerMaxWay] = {};
+    size_t           level               = 0;
+    for(; node != NULL && level < ServerMaxWay; level++) {
+        nodes[level] = node;
+        node         = __atomic_load_n(&node->parent, __ATOMIC_ACQUIRE);
+    }
+    if(node != NULL) {
+        return AKINATOR_INVALID_NODE_LEVEL;
+    }
+
+    way->size = 0;
+    for(size_t index = level - 1; index > 0; index--) {
+        akinator_router_step_t *step = way->steps + way->size++;
+        strncpy(step->question, nodes[index]->question, MaxQuestionSize);
+        step->no = __atomic_load_n(&nodes[index]->no, __ATOMIC_ACQUIRE) == nodes[index - 1];
+    }
+    return AKINATOR_SUCCESS;
+}
+
+size_t akinator_way_size(const akinator_router_way_t *way) {
+    return way->size;
+}
+
+const char *akinator_way_question(const akinator_router_way_t *way,
+                                  size_t                       step) {
+    return way->steps[step].question;
+}
+
+bool akinator_way_no(const akinator_router_way_t *way,
+                     size_t                       step) {
+    return way->steps[step].no;
+}
+
+//shard number of a link leaf, -1 for everything else
+long akinator_router_link(akinator_node_t *node) {
+    if(node == NULL || !is_leaf(node) ||
+       strncmp(node->question, RouterLinkPrefix, sizeof(RouterLinkPrefix) - 1) != 0) {
+        return -1;
+    }
+    return strtol(node->question + sizeof(RouterLinkPrefix) - 1, NULL, 10);
+}
+
+//replies carry whole ways, so the message does not fit on the thread stack
+bool akinator_router_send(int socket, const char *format, ...) {
+    char *message = (char *)malloc(RouterMaxReply);
+    if(message == NULL) {
+        return false;
+    }
+    va_list arguments;
+    va_start(arguments, format);
+    int size = vsnprintf(message, RouterMaxReply, format, arguments);
+    va_end(arguments);
+
+    size_t sent = 0;
+    bool   sent_all = (size >= 0 && (size_t)size < RouterMaxReply);
+    while(sent_all && sent < (size_t)size) {
+        ssize_t written = send(socket, message + sent, (size_t)size - sent, MSG_NOSIGNAL);
+        if(written < 0 && errno == EINTR) {
+            continue;
+        }
+        if(written <= 0) {
+            sent_all = false;
+        }
+        else {
+            sent += (size_t)written;
+        }
+    }
+    free(message);
+    return sent_all;
+}
+
+void akinator_router_close(akinator_router_connection_t *connection) {
+    akinator_router_t *router = connection->router;
+    for(size_t shard = 0; shard <= router->shards_number; shard++) {
+        if(connection->shard_sockets[shard] >= 0) {
+            close(connection->shard_sockets[shard]);
+        }
+    }
+    close(connection->socket);
+    free(connection->shard_sockets);
+    free(connection);
+    __atomic_fetch_sub(&router->connections_number, 1, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,899 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/stat.h>
+
+#include "akinator_server.h"
+#include "akinator_replication.h"
+#include "akinator_session.h"
+#include "akinator_tree.h"
+#include "akinator_utils.h"
+#include "custom_assert.h"
+#include "colors.h"
+
+enum server_action_t {
+    SERVER_ACTION_REARM = 0,
+    SERVER_ACTION_WAIT  = 1,
+    SERVER_ACTION_CLOSE = 2,
+};
+
+static void                  *akinator_server_worker        (void                     *argument);
+
+static void                  *akinator_server_writer        (void                     *argument);
+
+static akinator_connection_t *akinator_server_collect_batch (akinator_server_t        *server);
+
+static void                   akinator_server_writer_wait   (akinator_server_t        *server,
+                                                             uint64_t                  deadline);
+
+static void                   akinator_server_commit_batch  (akinator_server_t        *server,
+                                                             akinator_connection_t    *batch);
+
+static bool                   akinator_server_check_file    (akinator_server_t        *server,
+                                                             struct stat              *file);
+
+static akinator_error_t       akinator_server_save          (akinator_server_t        *server);
+
+static akinator_error_t       akinator_server_learn         (akinator_connection_t    *connection);
+
+static akinator_error_t       akinator_server_persist       (akinator_server_t        *server);
+
+static akinator_error_t       akinator_server_compact       (akinator_server_t        *server);
+
+static void                   akinator_server_apply_pending (akinator_server_t        *server);
+
+static void                   akinator_server_pin           (akinator_server_t        *server,
+                                                             akinator_connection_t    *connection);
+
+static server_action_t        akinator_server_read          (akinator_server_worker_t *worker,
+                                                             akinator_connection_t    *connection);
+
+static server_action_t        akinator_server_handle_line   (akinator_server_worker_t *worker,
+                                                             akinator_connection_t    *connection,
+                                                             char                     *line);
+
+static server_action_t        akinator_server_handle_learn  (akinator_server_t        *server,
+                                                             akinator_connection_t    *connection,
+                                                             char                     *arguments);
+
+static server_action_t        akinator_server_send_way      (akinator_connection_t    *connection,
+                                                             akinator_t               *akinator,
+                                                             const char               *object);
+
+static server_action_t        akinator_server_reply_state   (akinator_connection_t    *connection);
+
+static server_action_t        akinator_server_send          (akinator_connection_t    *connection,
+                                                             const char               *format, ...)
+                                                             __attribute__((format(printf, 2, 3)));
+
+static server_action_t        akinator_server_write         (akinator_connection_t    *connection,
+                                                             const char               *message,
+                                                             size_t                    size);
+
+static akinator_error_t       akinator_server_arm           (akinator_server_t        *server,
+                                                             akinator_connection_t    *connection,
+                                                             int                       operation);
+
+static void                   akinator_server_close         (akinator_connection_t    *connection);
+
+akinator_error_t akinator_server_ctor(akinator_server_t *server,
+                                      akinator_t        *akinator,
+                                      const char        *socket_path,
+                                      size_t             threads_number) {
+    _C_ASSERT(server         != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(akinator       != NULL, return AKINATOR_NULL_POINTER           );
+    _C_ASSERT(socket_path    != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(threads_number != 0 &&
+              threads_number <= ServerMaxThreads, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    server->initial.akinator = akinator;
+    server->current          = &server->initial;
+    server->socket_path      = socket_path;
+    server->workers_number   = threads_number;
+    server->listen_socket    = -1;
+    server->epoll            = -1;
+    server->batch_size       = ServerDefaultBatch;
+    server->batch_latency_ns = ServerDefaultLatencyUs * 1000;
+    akinator_queue_ctor(&server->learn_queue);
+    sem_init           (&server->learn_signal, 0, 0);
+    akinator_epoch_ctor(&server->epoch);
+    akinator->epoch = &server->epoch;
+    pthread_mutex_init (&server->save_lock, NULL);
+    struct stat file = {};
+    if(stat(akinator->database_name, &file) == 0) {
+        server->initial.inode    = file.st_ino;
+        server->initial.modified = file.st_mtim;
+    }
+    server->saved_inode = server->initial.inode;
+    server->saved_time  = server->initial.modified;
+    RETURN_IF_ERROR(akinator_journal_ctor(&server->journal, akinator,
+                                          server->saved_inode, &server->saved_time));
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if(strlen(socket_path) >= sizeof(address.sun_path)) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Socket path '%s' is too long.\n", socket_path);
+        return AKINATOR_SERVER_SOCKET_ERROR;
+    }
+    strcpy(address.sun_path, socket_path);
+    unlink(socket_path);
+
+    server->listen_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(server->listen_socket < 0 ||
+       bind  (server->listen_socket, (sockaddr *)&address, sizeof(address)) != 0 ||
+       listen(server->listen_socket, ServerListenBacklog) != 0) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while opening socket '%s': %s.\n", socket_path, strerror(errno));
+        return AKINATOR_SERVER_SOCKET_ERROR;
+    }
+
+    server->epoll = epoll_create1(0);
+    if(server->epoll < 0) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while creating epoll: %s.\n", strerror(errno));
+        return AKINATOR_SERVER_SOCKET_ERROR;
+    }
+
+    server->queue_depth    = (akinator_histogram_t *)calloc(1, sizeof(akinator_histogram_t));
+    server->commit_latency = (akinator_histogram_t *)calloc(1, sizeof(akinator_histogram_t));
+    if(server->queue_depth == NULL || server->commit_latency == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while allocating commit histograms.\n");
+        return AKINATOR_SERVER_ALLOCATION_ERROR;
+    }
+
+    for(size_t worker = 0; worker < threads_number; worker++) {
+        server->workers[worker].server         = server;
+        RETURN_IF_ERROR(akinator_epoch_register(&server->epoch, &server->workers[worker].reader));
+        server->workers[worker].answer_latency = (akinator_histogram_t *)calloc(1, sizeof(akinator_histogram_t));
+        if(server->workers[worker].answer_latency == NULL) {
+            color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                         "Error while allocating latency histogram.\n");
+            return AKINATOR_SERVER_ALLOCATION_ERROR;
+        }
+    }
+    return AKINATOR_SUCCESS;
+}
+
+//a batch is committed when it holds batch_size objects or its oldest object waited latency_us
+akinator_error_t akinator_server_set_batch(akinator_server_t *server,
+                                           size_t             batch_size,
+                                           size_t             latency_us) {
+    _C_ASSERT(server     != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(batch_size != 0   , return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    server->batch_size       = batch_size;
+    server->batch_latency_ns = (uint64_t)latency_us * 1000;
+    return AKINATOR_SUCCESS;
+}
+
+//accepts on the calling thread until akinator_server_stop, sessions are served by the pool
+akinator_error_t akinator_server_run(akinator_server_t *server) {
+    _C_ASSERT(server != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    clock_gettime(CLOCK_MONOTONIC, &server->start_time);
+
+    //stop signals have to interrupt accept, so the pool threads never take them
+    sigset_t blocked  = {};
+    sigset_t previous = {};
+    sigemptyset(&blocked);
+    sigaddset  (&blocked, SIGINT);
+    sigaddset  (&blocked, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+    int writer_error = pthread_create(&server->writer, NULL, akinator_server_writer, server);
+    for(size_t worker = 0; worker < server->workers_number && writer_error == 0; worker++) {
+        if(pthread_create(&server->workers[worker].thread, NULL,
+                          akinator_server_worker, server->workers + worker) != 0) {
+            server->workers_number = worker;
+            akinator_server_stop(server);
+            break;
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+    if(writer_error != 0) {
+        return AKINATOR_SERVER_THREAD_ERROR;
+    }
+
+    while(!server->stop) {
+        int client = accept(server->listen_socket, NULL, NULL);
+        if(client < 0) {
+            if(errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                         "Error while accepting connection: %s.\n", strerror(errno));
+            break;
+        }
+
+        akinator_connection_t *connection = (akinator_connection_t *)calloc(1, sizeof(*connection));
+        if(connection == NULL) {
+            close(client);
+            continue;
+        }
+        connection->socket = client;
+        if(akinator_server_arm(server, connection, EPOLL_CTL_ADD) != AKINATOR_SUCCESS) {
+            akinator_server_close(connection);
+        }
+    }
+
+    akinator_server_stop(server);
+    for(size_t worker = 0; worker < server->workers_number; worker++) {
+        pthread_join(server->workers[worker].thread, NULL);
+    }
+    pthread_join(server->writer, NULL);
+    return AKINATOR_SUCCESS;
+}
+
+//true when the database file was written by someone other than the writer since its last save
+bool akinator_server_file_changed(akinator_server_t *server,
+                                  struct stat       *file) {
+    _C_ASSERT(server != NULL, return false);
+    _C_ASSERT(file   != NULL, return false);
+
+    pthread_mutex_lock  (&server->save_lock);
+    bool changed = akinator_server_check_file(server, file);
+    pthread_mutex_unlock(&server->save_lock);
+    return changed;
+}
+
+//takes ownership of generation, it replaces the current tree before the next batch
+akinator_error_t akinator_server_publish(akinator_server_t     *server,
+                                         akinator_generation_t *generation) {
+    _C_ASSERT(server     != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(generation != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    //a tree that was never current has no sessions
+    akinator_generation_t *skipped = __atomic_exchange_n(&server->pending, generation, __ATOMIC_ACQ_REL);
+    if(skipped != NULL) {
+        akinator_generation_dtor(skipped);
+    }
+    if(__atomic_exchange_n(&server->writer_waiting, 0, __ATOMIC_SEQ_CST)) {
+        sem_post(&server->learn_signal);
+    }
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_generation_dtor(akinator_generation_t *generation) {
+    _C_ASSERT(generation        != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(generation->owned != 0   , return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    akinator_tree_dtor(generation->akinator);
+    free(generation->akinator);
+    free(generation);
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_server_stop(akinator_server_t *server) {
+    _C_ASSERT(server != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    __atomic_store_n(&server->stop, 1, __ATOMIC_RELEASE);
+    sem_post(&server->learn_signal);
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_server_print_stats(akinator_server_t *server) {
+    _C_ASSERT(server != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    akinator_histogram_t *latency = (akinator_histogram_t *)calloc(1, sizeof(*latency));
+    if(latency == NULL) {
+        return AKINATOR_SERVER_ALLOCATION_ERROR;
+    }
+    for(size_t worker = 0; worker < server->workers_number; worker++) {
+        akinator_histogram_merge(latency, server->workers[worker].answer_latency);
+    }
+
+    struct timespec now = {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed = (double)(now.tv_sec  - server->start_time.tv_sec) +
+                     (double)(now.tv_nsec - server->start_time.tv_nsec) / 1e9;
+    uint64_t p50 = 0;
+    uint64_t p99 = 0;
+    akinator_histogram_percentile(latency, 50, &p50);
+    akinator_histogram_percentile(latency, 99, &p99);
+
+    color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                 "Sessions: %zu started, %zu finished (%.1f/s), %zu learned, "
+                 "answers: %zu, p50 %.1f us, p99 %.1f us.\n",
+                 server->sessions_started,
+                 server->sessions_finished,
+                 (double)server->sessions_finished / elapsed,
+                 server->learned_number,
+                 latency->count,
+                 (double)p50 / 1000,
+                 (double)p99 / 1000);
+    free(latency);
+
+    uint64_t depth_p50  = 0;
+    uint64_t depth_p99  = 0;
+    uint64_t commit_p50 = 0;
+    uint64_t commit_p99 = 0;
+    akinator_histogram_percentile(server->queue_depth,    50, &depth_p50);
+    akinator_histogram_percentile(server->queue_depth,    99, &depth_p99);
+    akinator_histogram_percentile(server->commit_latency, 50, &commit_p50);
+    akinator_histogram_percentile(server->commit_latency, 99, &commit_p99);
+    color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                 "Commits: %zu for %zu objects, queue depth p50 %llu, p99 %llu, max %llu, "
+                 "commit latency p50 %.1f us, p99 %.1f us, max %.1f us.\n",
+                 server->commits_number,
+                 server->commit_latency->count,
+                 (unsigned long long)depth_p50,
+                 (unsigned long long)depth_p99,
+                 (unsigned long long)server->queue_depth->max,
+                 (double)commit_p50 / 1000,
+                 (double)commit_p99 / 1000,
+                 (double)server->commit_latency->max / 1000);
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_server_dtor(akinator_server_t *server) {
+    _C_ASSERT(server != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    if(server->listen_socket >= 0) {
+        close (server->listen_socket);
+        unlink(server->socket_path);
+    }
+    if(server->epoll >= 0) {
+        close(server->epoll);
+    }
+    for(size_t worker = 0; worker < ServerMaxThreads; worker++) {
+        free(server->workers[worker].answer_latency);
+    }
+    if(server->current != NULL && server->current->owned) {
+        akinator_generation_dtor(server->current);
+    }
+    if(server->pending != NULL) {
+        akinator_generation_dtor(server->pending);
+    }
+    if(server->initial.akinator != NULL) {
+        server->initial.akinator->epoch = NULL;
+    }
+    free(server->queue_depth);
+    free(server->commit_latency);
+    akinator_journal_dtor(&server->journal);
+    akinator_epoch_dtor(&server->epoch);
+    sem_destroy        (&server->learn_signal);
+    pthread_mutex_destroy(&server->save_lock);
+    memset(server, 0, sizeof(*server));
+    return AKINATOR_SUCCESS;
+}
+
+//connections are armed one shot, so exactly one thread owns a connection at a time
+void *akinator_server_worker(void *argument) {
+    akinator_server_worker_t *worker = (akinator_server_worker_t *)argument;
+    akinator_server_t        *server = worker->server;
+
+    while(!__atomic_load_n(&server->stop, __ATOMIC_ACQUIRE)) {
+        epoll_event event = {};
+        if(epoll_wait(server->epoll, &event, 1, ServerPollTimeout) <= 0) {
+            continue;
+        }
+
+        akinator_connection_t *connection = (akinator_connection_t *)event.data.ptr;
+        akinator_epoch_enter(&server->epoch, worker->reader);
+        server_action_t action = akinator_server_read(worker, connection);
+        akinator_epoch_exit (&server->epoch, worker->reader);
+        switch(action) {
+            case SERVER_ACTION_REARM: {
+                if(akinator_server_arm(server, connection, EPOLL_CTL_MOD) != AKINATOR_SUCCESS) {
+                    akinator_server_close(connection);
+                }
+                break;
+            }
+            case SERVER_ACTION_WAIT: {
+                break;
+            }
+            case SERVER_ACTION_CLOSE: {
+                akinator_server_close(connection);
+                break;
+            }
+            default: {
+                akinator_server_close(connection);
+                break;
+            }
+        }
+    }
+    return NULL;
+}
+
+//the only thread that changes the tree, readers never wait for it
+void *akinator_server_writer(void *argument) {
+    akinator_server_t *server = (akinator_server_t *)argument;
+
+    while(true) {
+        akinator_server_apply_pending(server);
+        akinator_connection_t *batch = akinator_server_collect_batch(server);
+        if(batch == NULL) {
+            //the database is left whole on a clean stop, a primary has no shutdown save
+            if(server->journal.records_number != 0) {
+                akinator_server_compact(server);
+            }
+            return NULL;
+        }
+        akinator_server_commit_batch(server, batch);
+    }
+}
+
+//blocks until the first object arrives, then fills the batch until it is full or
+//the first object has waited batch_latency_ns, NULL once stopped with nothing queued
+akinator_connection_t *akinator_server_collect_batch(akinator_server_t *server) {
+    akinator_connection_t  *batch      = NULL;
+    akinator_connection_t **last       = &batch;
+    size_t                  batch_size = 0;
+    uint64_t                deadline   = 0;
+    while(batch_size < server->batch_size) {
+        akinator_queue_node_t *node = akinator_queue_pop(&server->learn_queue);
+        if(node != NULL) {
+            akinator_connection_t *connection =
+                (akinator_connection_t *)((char *)node - offsetof(akinator_connection_t, learn_node));
+            if(batch_size == 0) {
+                deadline = connection->learn_enqueued + server->batch_latency_ns;
+                akinator_histogram_add(server->queue_depth, akinator_queue_depth(&server->learn_queue) + 1);
+            }
+            connection->next_batch = NULL;
+            *last = connection;
+            last  = &connection->next_batch;
+            batch_size++;
+            continue;
+        }
+
+        uint64_t now = get_time_ns();
+        if(batch_size != 0 && now >= deadline) {
+            break;
+        }
+        if(batch_size == 0) {
+            akinator_server_apply_pending(server);
+        }
+        if(batch_size == 0 && __atomic_load_n(&server->stop, __ATOMIC_ACQUIRE) &&
+           akinator_queue_depth(&server->learn_queue) == 0) {
+            break;
+        }
+        akinator_server_writer_wait(server, (batch_size == 0) ? now + (uint64_t)ServerPollTimeout * 1000000 :
+                                                                deadline);
+    }
+    return batch;
+}
+
+//producers post only when the writer announced it sleeps, so a busy queue never touches the semaphore
+void akinator_server_writer_wait(akinator_server_t *server, uint64_t deadline) {
+    __atomic_store_n(&server->writer_waiting, 1, __ATOMIC_SEQ_CST);
+    if(akinator_queue_depth(&server->learn_queue) == 0) {
+        struct timespec now     = {};
+        struct timespec timeout = {};
+        clock_gettime(CLOCK_REALTIME, &now);
+        uint64_t wait = deadline - get_time_ns();
+        if((int64_t)wait > 0) {
+            uint64_t until = (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec + wait;
+            timeout.tv_sec  = (time_t)(until / 1000000000);
+            timeout.tv_nsec = (long)  (until % 1000000000);
+            sem_timedwait(&server->learn_signal, &timeout);
+        }
+    }
+    else if(akinator_queue_depth(&server->learn_queue) != 0) {
+        //a producer is between counting and linking its node
+        sched_yield();
+    }
+    __atomic_store_n(&server->writer_waiting, 0, __ATOMIC_SEQ_CST);
+}
+
+//file is filled with the current state of the database file, a file that is
+//gone counts as unchanged, there is nothing to reload from it
+bool akinator_server_check_file(akinator_server_t *server,
+                                struct stat       *file) {
+    if(stat(server->initial.akinator->database_name, file) != 0) {
+        return false;
+    }
+    return file->st_ino          != server->saved_inode        ||
+           file->st_mtim.tv_sec  != server->saved_time.tv_sec  ||
+           file->st_mtim.tv_nsec != server->saved_time.tv_nsec;
+}
+
+//same as akinator_save_database, but the file is checked right before the rename,
+//a database written from outside wins over the batch and its reload is on the way
+akinator_error_t akinator_server_save(akinator_server_t *server) {
+    akinator_t *akinator = server->current->akinator;
+    char temporary_name[FILENAME_MAX] = {};
+    if((size_t)snprintf(temporary_name, sizeof(temporary_name), "%s.tmp",
+                        akinator->database_name) >= sizeof(temporary_name)) {
+        return AKINATOR_DATABASE_FILENAME_NULL;
+    }
+    RETURN_IF_ERROR(akinator_write_database(akinator, temporary_name));
+
+    akinator_error_t error_code = AKINATOR_SUCCESS;
+    struct stat      file       = {};
+    pthread_mutex_lock(&server->save_lock);
+    if(akinator_server_check_file(server, &file)) {
+        error_code = AKINATOR_TREE_REPLACED;
+        remove(temporary_name);
+    }
+    else if(rename(temporary_name, akinator->database_name) != 0) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while replacing database.\n");
+        error_code = AKINATOR_DATABASE_OPENING_ERROR;
+    }
+    else if(stat(akinator->database_name, &file) == 0) {
+        server->saved_inode = file.st_ino;
+        server->saved_time  = file.st_mtim;
+    }
+    pthread_mutex_unlock(&server->save_lock);
+    return error_code;
+}
+
+//reload thread hands a validated tree over, the writer is the one switching to it, so a
+//batch is never applied to one tree and saved from another
+void akinator_server_apply_pending(akinator_server_t *server) {
+    akinator_generation_t *generation = __atomic_exchange_n(&server->pending,
+                                                            (akinator_generation_t *)NULL,
+                                                            __ATOMIC_ACQ_REL);
+    if(generation == NULL) {
+        return;
+    }
+
+    akinator_generation_t *old = server->current;
+    generation->akinator->epoch = &server->epoch;
+    pthread_mutex_lock  (&server->save_lock);
+    server->saved_inode = generation->inode;
+    server->saved_time  = generation->modified;
+    pthread_mutex_unlock(&server->save_lock);
+    //records of the old tree are gone with it, the new file starts with none
+    akinator_journal_reset(&server->journal, generation->inode, &generation->modified);
+    __atomic_store_n(&server->current, generation, __ATOMIC_RELEASE);
+    __atomic_store_n(&old->retired,    1,          __ATOMIC_RELEASE);
+}
+
+//objects are applied one by one and persisted with a single journal sync,
+//players get their reply only after that sync
+void akinator_server_commit_batch(akinator_server_t     *server,
+                                  akinator_connection_t *batch) {
+    size_t applied = 0;
+    for(akinator_connection_t *connection = batch; connection != NULL; connection = connection->next_batch) {
+        //the old tree is about to be freed, learning there would be lost
+        connection->learn_result = (connection->generation != server->current) ?
+                                   AKINATOR_TREE_REPLACED :
+                                   akinator_server_learn(connection);
+        if(connection->learn_result == AKINATOR_SUCCESS) {
+            applied++;
+            connection->learn_result = akinator_journal_append(&server->journal,
+                                                               connection->session.current->parent,
+                                                               connection->object,
+                                                               connection->question);
+        }
+        if(connection->session.state == AKINATOR_SESSION_LEARNED && server->replication != NULL) {
+            akinator_error_t error_code = akinator_replication_stage(server->replication,
+                                                                     connection->session.current,
+                                                                     connection->object,
+                                                                     connection->question);
+            if(connection->learn_result == AKINATOR_SUCCESS) {
+                connection->learn_result = error_code;
+            }
+        }
+    }
+
+    //replicas get the batch after it is synced here, the tree holds it even when the sync failed,
+    //so they get it either way and later records still find their leafs
+    akinator_error_t save_result = AKINATOR_SUCCESS;
+#ifdef _DEBUG
+    if(applied != 0) {
+        save_result = akinator_verify(server->current->akinator);
+    }
+#endif
+    if(applied != 0 && save_result == AKINATOR_SUCCESS && server->replication != NULL) {
+        save_result = akinator_replication_reserve(server->replication);
+    }
+    if(applied != 0 && save_result == AKINATOR_SUCCESS) {
+        save_result = akinator_server_persist(server);
+        server->commits_number++;
+    }
+    if(applied != 0 && server->replication != NULL) {
+        akinator_replication_publish(server->replication);
+    }
+
+    uint64_t now = get_time_ns();
+    while(batch != NULL) {
+        akinator_connection_t *connection = batch;
+        batch = batch->next_batch;
+
+        akinator_histogram_add(server->commit_latency, now - connection->learn_enqueued);
+        akinator_error_t error_code = (connection->learn_result == AKINATOR_SUCCESS) ? save_result :
+                                                                                        connection->learn_result;
+        server_action_t action = SERVER_ACTION_REARM;
+        if(error_code == AKINATOR_SUCCESS) {
+            server->learned_number++;
+            __atomic_fetch_add(&server->sessions_finished, 1, __ATOMIC_RELAXED);
+            action = akinator_server_send(connection, "learned\n");
+        }
+        else {
+            action = akinator_server_send(connection, "error %d\n", error_code);
+        }
+        if(action != SERVER_ACTION_REARM ||
+           akinator_server_arm(server, connection, EPOLL_CTL_MOD) != AKINATOR_SUCCESS) {
+            akinator_server_close(connection);
+        }
+    }
+
+    //players already have their replies, a failed rewrite is tried again after the next batch
+    if(server->journal.records_number >= JournalCompactRecords) {
+        akinator_server_compact(server);
+    }
+}
+
+//split leaf checks only the nodes it touches, the whole tree is verified once per batch
+akinator_error_t akinator_server_learn(akinator_connection_t *connection) {
+    akinator_session_t *session = &connection->session;
+    if(session->state != AKINATOR_SESSION_LEARNING) {
+        return AKINATOR_SESSION_STATE_ERROR;
+    }
+
+    RETURN_IF_ERROR(akinator_split_leaf(session->akinator, session->current,
+                                        connection->object, connection->question));
+    session->state = AKINATOR_SESSION_LEARNED;
+    return AKINATOR_SUCCESS;
+}
+
+//the journal only goes on top of the file it was started for, a database written from
+//outside wins over the batch and its reload is on the way
+akinator_error_t akinator_server_persist(akinator_server_t *server) {
+    struct stat file = {};
+    if(akinator_server_file_changed(server, &file)) {
+        return AKINATOR_TREE_REPLACED;
+    }
+    return akinator_journal_sync(&server->journal);
+}
+
+//the database is rewritten with everything the journal holds, then the journal starts again
+akinator_error_t akinator_server_compact(akinator_server_t *server) {
+    uint64_t start = get_time_ns();
+    RETURN_IF_ERROR(akinator_server_save(server));
+    RETURN_IF_ERROR(akinator_journal_reset(&server->journal, server->saved_inode, &server->saved_time));
+    color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                 "Journal compacted into '%s' in %.1f ms.\n",
+                 server->current->akinator->database_name, (double)(get_time_ns() - start) / 1e6);
+    return AKINATOR_SUCCESS;
+}
+
+server_action_t akinator_server_read(akinator_server_worker_t *worker,
+                                     akinator_connection_t    *connection) {
+    ssize_t read_size = read(connection->socket,
+                             connection->buffer + connection->buffer_size,
+                             ServerMaxLine - connection->buffer_size);
+    if(read_size <= 0) {
+        return SERVER_ACTION_CLOSE;
+    }
+    connection->buffer_size += (size_t)read_size;
+
+    while(true) {
+        char *end = (char *)memchr(connection->buffer, '\n', connection->buffer_size);
+        if(end == NULL) {
+            return (connection->buffer_size == ServerMaxLine) ? SERVER_ACTION_CLOSE :
+                                                                SERVER_ACTION_REARM;
+        }
+        *end = '\0';
+        if(end != connection->buffer && end[-1] == '\r') {
+            end[-1] = '\0';
+        }
+
+        server_action_t action = akinator_server_handle_line(worker, connection, connection->buffer);
+
+        size_t consumed = (size_t)(end + 1 - connection->buffer);
+        memmove(connection->buffer, end + 1, connection->buffer_size - consumed);
+        connection->buffer_size -= consumed;
+        if(action != SERVER_ACTION_REARM) {
+            return action;
+        }
+    }
+}
+
+//runs inside the worker epoch section, so the reload thread can wait this window out
+void akinator_server_pin(akinator_server_t     *server,
+                         akinator_connection_t *connection) {
+    akinator_generation_t *current = __atomic_load_n(&server->current, __ATOMIC_ACQUIRE);
+    if(connection->generation == current) {
+        return;
+    }
+    if(connection->generation != NULL) {
+        __atomic_fetch_sub(&connection->generation->sessions, 1, __ATOMIC_RELEASE);
+    }
+    __atomic_fetch_add(&current->sessions, 1, __ATOMIC_ACQ_REL);
+    connection->generation = current;
+}
+
+server_action_t akinator_server_handle_line(akinator_server_worker_t *worker,
+                                            akinator_connection_t    *connection,
+                                            char                     *line) {
+    akinator_server_t *server = worker->server;
+    uint64_t           start  = get_time_ns();
+
+    if(strcmp(line, "start") == 0) {
+        akinator_server_pin(server, connection);
+        akinator_error_t error_code = akinator_session_start(&connection->session,
+                                                             connection->generation->akinator);
+        server_action_t  action     = (error_code == AKINATOR_SUCCESS) ?
+                                      akinator_server_reply_state(connection) :
+                                      akinator_server_send(connection, "error %d\n", error_code);
+        __atomic_fetch_add(&server->sessions_started, 1, __ATOMIC_RELAXED);
+        return action;
+    }
+    if(strncmp(line, "answer ", sizeof("answer ") - 1) == 0) {
+        int answer = atoi(line + sizeof("answer ") - 1);
+        akinator_error_t error_code = akinator_session_answer(&connection->session,
+                                                              (akinator_answer_t)answer);
+        server_action_t  action     = (error_code == AKINATOR_SUCCESS) ?
+                                      akinator_server_reply_state(connection) :
+                                      akinator_server_send(connection, "error %d\n", error_code);
+        if(connection->session.state == AKINATOR_SESSION_WON) {
+            __atomic_fetch_add(&server->sessions_finished, 1, __ATOMIC_RELAXED);
+        }
+        akinator_histogram_add(worker->answer_latency, get_time_ns() - start);
+        worker->answers_number++;
+        return action;
+    }
+    if(strncmp(line, "learn ", sizeof("learn ") - 1) == 0) {
+        return akinator_server_handle_learn(server, connection, line + sizeof("learn ") - 1);
+    }
+    if(strncmp(line, "way ", sizeof("way ") - 1) == 0) {
+        //runs inside the epoch section, so a tree replaced meanwhile is not freed under us
+        akinator_generation_t *current = __atomic_load_n(&server->current, __ATOMIC_ACQUIRE);
+        return akinator_server_send_way(connection, current->akinator, line + sizeof("way ") - 1);
+    }
+    if(strcmp(line, "quit") == 0) {
+        return SERVER_ACTION_CLOSE;
+    }
+    return akinator_server_send(connection, "error %d\n", AKINATOR_USER_ANSWER_ERROR);
+}
+
+//learning is handed to the writer, the connection is rearmed once it is applied
+server_action_t akinator_server_handle_learn(akinator_server_t     *server,
+                                             akinator_connection_t *connection,
+                                             char                  *arguments) {
+    if(server->read_only) {
+        return akinator_server_send(connection, "error %d\n", AKINATOR_REPLICA_READ_ONLY);
+    }
+    char *separator = strchr(arguments, '\t');
+    if(separator == NULL ||
+       connection->session.state != AKINATOR_SESSION_LEARNING ||
+       (size_t)(separator - arguments) > MaxQuestionSize ||
+       strlen(separator + 1)          > MaxQuestionSize) {
+        return akinator_server_send(connection, "error %d\n", AKINATOR_SESSION_STATE_ERROR);
+    }
+    *separator = '\0';
+    strcpy(connection->object,   arguments);
+    strcpy(connection->question, separator + 1);
+
+    connection->learn_enqueued = get_time_ns();
+    akinator_queue_push(&server->learn_queue, &connection->learn_node);
+    if(__atomic_exchange_n(&server->writer_waiting, 0, __ATOMIC_SEQ_CST)) {
+        sem_post(&server->learn_signal);
+    }
+    return SERVER_ACTION_WAIT;
+}
+
+//leafs are read while the writer may append to them, the size is loaded before the array
+server_action_t akinator_server_send_way(akinator_connection_t *connection,
+                                         akinator_t            *akinator,
+                                         const char            *object) {
+    size_t            leafs_size = __atomic_load_n(&akinator->leafs_array_size, __ATOMIC_ACQUIRE);
+    akinator_node_t **leafs      = __atomic_load_n(&akinator->leafs_array,      __ATOMIC_ACQUIRE);
+    akinator_node_t  *node       = NULL;
+    for(size_t index = 0; index < leafs_size && node == NULL; index++) {
+        if(leafs[index] != NULL && strcmp(leafs[index]->question, object) == 0) {
+            node = leafs[index];
+        }
+    }
+    if(node == NULL) {
+        return akinator_server_send(connection, "none\n");
+    }
+
+    akinator_node_t *way[ServerMaxWay] = {};
+    size_t           level             = 0;
+    for(; node != NULL && level < ServerMaxWay; level++) {
+        way[level] = node;
+        node       = __atomic_load_n(&node->parent, __ATOMIC_ACQUIRE);
+    }
+    size_t capacity = ServerMaxWay * (MaxQuestionSize + 2);
+    char  *message  = (char *)calloc(capacity, 1);
+    if(node != NULL || message == NULL) {
+        free(message);
+        return akinator_server_send(connection, "error %d\n", AKINATOR_INVALID_NODE_LEVEL);
+    }
+
+    size_t size = (size_t)snprintf(message, capacity, "way");
+    for(size_t index = level - 1; index > 0 && size < capacity; index--) {
+        akinator_node_t *yes = __atomic_load_n(&way[index]->yes, __ATOMIC_ACQUIRE);
+        size += (size_t)snprintf(message + size, capacity - size, "\t%c%s",
+                                 (yes == way[index - 1]) ? '+' : '-',
+                                 way[index]->question);
+    }
+    if(size + 1 >= capacity) {
+        free(message);
+        return akinator_server_send(connection, "error %d\n", AKINATOR_INVALID_NODE_LEVEL);
+    }
+    message[size++] = '\n';
+    server_action_t action = akinator_server_write(connection, message, size);
+    free(message);
+    return action;
+}
+
+server_action_t akinator_server_reply_state(akinator_connection_t *connection) {
+    akinator_session_t *session = &connection->session;
+    switch(session->state) {
+        case AKINATOR_SESSION_ASKING: {
+            return akinator_server_send(connection, "ask %s\n",   session->current->question);
+        }
+        case AKINATOR_SESSION_GUESSING: {
+            return akinator_server_send(connection, "guess %s\n", session->current->question);
+        }
+        case AKINATOR_SESSION_LEARNING: {
+            return akinator_server_send(connection, "learn\n");
+        }
+        case AKINATOR_SESSION_WON: {
+            return akinator_server_send(connection, "won\n");
+        }
+        case AKINATOR_SESSION_LEARNED: {
+            return akinator_server_send(connection, "learned\n");
+        }
+        case AKINATOR_SESSION_IDLE: {
+            return akinator_server_send(connection, "error %d\n", AKINATOR_SESSION_STATE_ERROR);
+        }
+        default: {
+            return SERVER_ACTION_CLOSE;
+        }
+    }
+}
+
+server_action_t akinator_server_send(akinator_connection_t *connection, const char *format, ...) {
+    char    message[ServerMaxLine + 16] = {};
+    va_list arguments;
+    va_start(arguments, format);
+    int size = vsnprintf(message, sizeof(message), format, arguments);
+    va_end(arguments);
+    if(size < 0 || (size_t)size >= sizeof(message)) {
+        return SERVER_ACTION_CLOSE;
+    }
+    return akinator_server_write(connection, message, (size_t)size);
+}
+
+server_action_t akinator_server_write(akinator_connection_t *connection,
+                                      const char            *message,
+                                      size_t                 size) {
+    size_t sent = 0;
+    while(sent < size) {
+        ssize_t written = send(connection->socket, message + sent, size - sent, MSG_NOSIGNAL);
+        if(written < 0 && errno == EINTR) {
+            continue;
+        }
+        if(written <= 0) {
+            return SERVER_ACTION_CLOSE;
+        }
+        sent += (size_t)written;
+    }
+    return SERVER_ACTION_REARM;
+}
+
+akinator_error_t akinator_server_arm(akinator_server_t     *server,
+                                     akinator_connection_t *connection,
+                                     int                    operation) {
+    epoll_event event = {};
+    event.events   = EPOLLIN | EPOLLONESHOT;
+    event.data.ptr = connection;
+    if(epoll_ctl(server->epoll, operation, connection->socket, &event) != 0) {
+        return AKINATOR_SERVER_SOCKET_ERROR;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+void akinator_server_close(akinator_connection_t *connection) {
+    if(connection->generation != NULL) {
+        __atomic_fetch_sub(&connection->generation->sessions, 1, __ATOMIC_RELEASE);
+    }
+    close(connection->socket);
+    free (connection);
+}
@@ -0,0 +1,419 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "akinator_shared.h"
+#include "akinator_definition.h"
+#include "custom_assert.h"
+#include "colors.h"
+
+struct akinator_shared_layout_t {
+    akinator_shared_header_t *header;
+    akinator_shared_node_t   *nodes;
+    uint32_t                 *leafs;
+    char                     *strings;
+    uint32_t                  nodes_number;
+    uint32_t                  leafs_number;
+    uint32_t                  strings_size;
+};
+
+//way from akinator_shared_get_way, node numbers go from the object up to the root
+struct akinator_shared_way_t {
+    akinator_shared_t *shared;
+    uint32_t          *nodes;
+    size_t             level;
+};
+
+static akinator_error_t akinator_shared_count       (akinator_node_t           *node,
+                                                     akinator_shared_header_t  *header,
+                                                     uint32_t                   level);
+
+static uint32_t         akinator_shared_layout      (akinator_shared_layout_t  *layout,
+                                                     akinator_node_t           *node,
+                                                     uint32_t                   parent);
+
+static int              akinator_shared_compare     (const void                *first,
+                                                     const void                *second,
+                                                     void                      *layout_pointer);
+
+static akinator_error_t akinator_shared_write       (const char                *path,
+                                                     const void                *image,
+                                                     size_t                     size);
+
+static akinator_error_t akinator_shared_get_way     (akinator_shared_t         *shared,
+                                                     uint32_t                   node,
+                                                     uint32_t                 **way_output,
+                                                     size_t                    *level_output);
+
+static size_t           akinator_way_size           (const akinator_shared_way_t *way);
+
+static const char      *akinator_way_question       (const akinator_shared_way_t *way,
+                                                     size_t                       step);
+
+static bool             akinator_way_no             (const akinator_shared_way_t *way,
+                                                     size_t                       step);
+
+static akinator_error_t akinator_shared_move        (akinator_shared_session_t *session,
+                                                     uint32_t                   next);
+
+static size_t           akinator_shared_offset      (size_t                     size);
+
+//image is built in memory and renamed over path, processes attached to the old
+//file keep reading it until they attach again
+akinator_error_t akinator_shared_publish(akinator_t *akinator,
+                                         const char *path) {
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER           );
+    _C_ASSERT(path     != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    akinator_node_t         *root   = __atomic_load_n(&akinator->root, __ATOMIC_ACQUIRE);
+    akinator_shared_header_t header = {};
+    if(root == NULL) {
+        return AKINATOR_NULL_ROOT;
+    }
+    RETURN_IF_ERROR(akinator_shared_count(root, &header, 1));
+
+    size_t nodes_offset   = akinator_shared_offset(sizeof(header));
+    size_t leafs_offset   = nodes_offset + header.nodes_number * sizeof(akinator_shared_node_t);
+    size_t strings_offset = leafs_offset + header.leafs_number * sizeof(uint32_t);
+    header.magic = SharedMagic;
+    header.size  = strings_offset + header.strings_size;
+
+    char *image = (char *)calloc(1, header.size);
+    if(image == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while allocating shared tree image.\n");
+        return AKINATOR_SHARED_ERROR;
+    }
+    memcpy(image, &header, sizeof(header));
+    akinator_shared_layout_t layout = {
+        .header  = (akinator_shared_header_t *)image,
+        .nodes   = (akinator_shared_node_t   *)(void *)(image + nodes_offset),
+        .leafs   = (uint32_t                 *)(void *)(image + leafs_offset),
+        .strings = image + strings_offset,
+    };
+    akinator_shared_layout(&layout, root, SharedNone);
+    qsort_r(layout.leafs, layout.leafs_number, sizeof(layout.leafs[0]),
+            akinator_shared_compare, &layout);
+
+    akinator_error_t error_code = akinator_shared_write(path, image, header.size);
+    free(image);
+    return error_code;
+}
+
+//O(1): the file is mapped and its header checked, nodes are checked on access
+akinator_error_t akinator_shared_attach(akinator_shared_t *shared,
+                                        const char        *path) {
+    _C_ASSERT(shared != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(path   != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    int file = open(path, O_RDONLY | O_CLOEXEC);
+    if(file < 0) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while opening shared tree '%s': %s.\n", path, strerror(errno));
+        return AKINATOR_SHARED_ERROR;
+    }
+    struct stat file_stat = {};
+    void       *mapping   = MAP_FAILED;
+    if(fstat(file, &file_stat) == 0 && (size_t)file_stat.st_size >= sizeof(akinator_shared_header_t)) {
+        mapping = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_SHARED, file, 0);
+    }
+    close(file);
+    if(mapping == MAP_FAILED) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while mapping shared tree '%s'.\n", path);
+        return AKINATOR_SHARED_ERROR;
+    }
+
+    const akinator_shared_header_t *header = (const akinator_shared_header_t *)mapping;
+    size_t nodes_offset   = akinator_shared_offset(sizeof(*header));
+    size_t leafs_offset   = nodes_offset + (size_t)header->nodes_number * sizeof(akinator_shared_node_t);
+    size_t strings_offset = leafs_offset + (size_t)header->leafs_number * sizeof(uint32_t);
+    if(header->magic        != SharedMagic                               ||
+       header->size         != (uint64_t)file_stat.st_size               ||
+       header->size         != strings_offset + header->strings_size     ||
+       header->nodes_number == 0                                         ||
+       header->strings_size == 0                                         ||
+       ((const char *)mapping)[header->size - 1] != '\0') {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "'%s' is not a shared tree.\n", path);
+        munmap(mapping, (size_t)file_stat.st_size);
+        return AKINATOR_SHARED_ERROR;
+    }
+
+    shared->header  = header;
+    shared->nodes   = (const akinator_shared_node_t *)(const void *)((const char *)mapping + nodes_offset);
+    shared->leafs   = (const uint32_t               *)(const void *)((const char *)mapping + leafs_offset);
+    shared->strings = (const char *)mapping + strings_offset;
+    shared->size    = (size_t)file_stat.st_size;
+    return AKINATOR_SUCCESS;
+}
+
+//node_output is SharedNone when there is no such object
+akinator_error_t akinator_shared_find(akinator_shared_t *shared,
+                                      const char        *object,
+                                      uint32_t          *node_output) {
+    _C_ASSERT(shared      != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(object      != NULL, return AKINATOR_NULL_OBJECT_NAME       );
+    _C_ASSERT(node_output != NULL, return AKINATOR_NODE_NULL              );
+
+    size_t left  = 0;
+    size_t right = shared->header->leafs_number;
+    while(left < right) {
+        size_t      middle   = left + (right - left) / 2;
+        const char *question = akinator_shared_question(shared, shared->leafs[middle]);
+        if(question == NULL) {
+            return AKINATOR_SHARED_ERROR;
+        }
+        int compare = strcmp(question, object);
+        if(compare == 0) {
+            *node_output = shared->leafs[middle];
+            return AKINATOR_SUCCESS;
+        }
+        if(compare < 0) {
+            left  = middle + 1;
+        }
+        else {
+            right = middle;
+        }
+    }
+    *node_output = SharedNone;
+    return AKINATOR_SUCCESS;
+}
+
+//NULL for a node or string offset outside of the mapping
+const char *akinator_shared_question(akinator_shared_t *shared,
+                                     uint32_t           node) {
+    _C_ASSERT(shared != NULL, return NULL);
+
+    if(node >= shared->header->nodes_number ||
+       shared->nodes[node].question >= shared->header->strings_size) {
+        return NULL;
+    }
+    return shared->strings + shared->nodes[node].question;
+}
+
+akinator_error_t akinator_shared_definition(akinator_shared_t     *shared,
+                                            uint32_t               object,
+                                            akinator_definition_t *definition) {
+    _C_ASSERT(shared     != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(definition != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    akinator_shared_way_t way = {.shared = shared};
+    RETURN_IF_ERROR(akinator_shared_get_way(shared, object, &way.nodes, &way.level));
+
+    akinator_error_t error_code = akinator_way_define(&way, akinator_shared_question(shared, object), definition);
+    free(way.nodes);
+    return error_code;
+}
+
+akinator_error_t akinator_shared_difference(akinator_shared_t     *shared,
+                                            uint32_t               first,
+                                            uint32_t               second,
+                                            akinator_definition_t *definition) {
+    _C_ASSERT(shared     != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(definition != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    akinator_shared_way_t way_first  = {.shared = shared};
+    akinator_shared_way_t way_second = {.shared = shared};
+    RETURN_IF_ERROR(akinator_shared_get_way(shared, first, &way_first.nodes, &way_first.level));
+    akinator_error_t error_code = akinator_shared_get_way(shared, second, &way_second.nodes, &way_second.level);
+    if(error_code == AKINATOR_SUCCESS) {
+        error_code = akinator_way_differ(&way_first,  akinator_shared_question(shared, first),
+                                         &way_second, akinator_shared_question(shared, second),
+                                         definition);
+    }
+    free(way_first.nodes);
+    free(way_second.nodes);
+    return error_code;
+}
+
+akinator_error_t akinator_shared_session_start(akinator_shared_session_t *session,
+                                               akinator_shared_t         *shared) {
+    _C_ASSERT(session != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(shared  != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    session->shared          = shared;
+    session->questions_asked = 0;
+    return akinator_shared_move(session, 0);
+}
+
+akinator_error_t akinator_shared_session_answer(akinator_shared_session_t *session,
+                                                akinator_answer_t          answer) {
+    _C_ASSERT(session != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    akinator_direction_t direction = AKINATOR_DIRECTION_STAY;
+    RETURN_IF_ERROR(akinator_session_direction(&session->state, answer, &direction));
+    session->questions_asked++;
+    const akinator_shared_node_t *current = session->shared->nodes + session->current;
+    switch(direction) {
+        case AKINATOR_DIRECTION_YES: {
+            return akinator_shared_move(session, current->yes);
+        }
+        case AKINATOR_DIRECTION_NO: {
+            return akinator_shared_move(session, current->no);
+        }
+        case AKINATOR_DIRECTION_STAY:
+        default: {
+            return AKINATOR_SUCCESS;
+        }
+    }
+}
+
+akinator_error_t akinator_shared_detach(akinator_shared_t *shared) {
+    _C_ASSERT(shared != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    if(shared->header != NULL) {
+        munmap((void *)(uintptr_t)shared->header, shared->size);
+    }
+    memset(shared, 0, sizeof(*shared));
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_shared_count(akinator_node_t          *node,
+                                       akinator_shared_header_t *header,
+                                       uint32_t                  level) {
+    if(header->nodes_number == SharedNone - 1) {
+        return AKINATOR_SHARED_ERROR;
+    }
+    size_t question_size = strlen(node->question) + 1;
+    if(header->strings_size + question_size >= SharedNone) {
+        return AKINATOR_SHARED_ERROR;
+    }
+    header->nodes_number++;
+    header->strings_size += (uint32_t)question_size;
+    if(level > header->depth) {
+        header->depth = level;
+    }
+
+    akinator_node_t *yes = __atomic_load_n(&node->yes, __ATOMIC_ACQUIRE);
+    akinator_node_t *no  = __atomic_load_n(&node->no,  __ATOMIC_ACQUIRE);
+    if(yes == NULL && no == NULL) {
+        header->leafs_number++;
+        return AKINATOR_SUCCESS;
+    }
+    if(yes == NULL || no == NULL) {
+        return AKINATOR_SHARED_ERROR;
+    }
+    RETURN_IF_ERROR(akinator_shared_count(yes, header, level + 1));
+    return akinator_shared_count(no, header, level + 1);
+}
+
+uint32_t akinator_shared_layout(akinator_shared_layout_t *layout,
+                                akinator_node_t          *node,
+                                uint32_t                  parent) {
+    uint32_t                index  = layout->nodes_number++;
+    akinator_shared_node_t *shared = layout->nodes + index;
+    size_t                  size   = strlen(node->question) + 1;
+    memcpy(layout->strings + layout->strings_size, node->question, size);
+    shared->question      = layout->strings_size;
+    shared->parent        = parent;
+    layout->strings_size += (uint32_t)size;
+
+    akinator_node_t *yes = __atomic_load_n(&node->yes, __ATOMIC_ACQUIRE);
+    akinator_node_t *no  = __atomic_load_n(&node->no,  __ATOMIC_ACQUIRE);
+    if(yes == NULL) {
+        shared->yes = SharedNone;
+        shared->no  = SharedNone;
+        layout->leafs[layout->leafs_number++] = index;
+        return index;
+    }
+    shared->yes = akinator_shared_layout(layout, yes, index);
+    shared->no  = akinator_shared_layout(layout, no,  index);
+    return index;
+}
+
+int akinator_shared_compare(const void *first,
+                            const void *second,
+                            void       *layout_pointer) {
+    akinator_shared_layout_t *layout = (akinator_shared_layout_t *)layout_pointer;
+    return strcmp(layout->strings + layout->nodes[*(const uint32_t *)first ].question,
+                  layout->strings + layout->nodes[*(const uint32_t *)second].question);
+}
+
+akinator_error_t akinator_shared_write(const char *path,
+                                       const void *image,
+                                       size_t      size) {
+    char temporary_name[FILENAME_MAX] = {};
+    if((size_t)snprintf(temporary_name, sizeof(temporary_name), "%s.tmp", path) >= sizeof(temporary_name)) {
+        return AKINATOR_SHARED_ERROR;
+    }
+
+    FILE *file = fopen(temporary_name, "w");
+    if(file == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while opening '%s': %s.\n", temporary_name, strerror(errno));
+        return AKINATOR_SHARED_ERROR;
+    }
+    bool written = fwrite(image, 1, size, file) == size && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    fclose(file);
+    if(!written || rename(temporary_name, path) != 0) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while publishing shared tree '%s'.\n", path);
+        remove(temporary_name);
+        return AKINATOR_SHARED_ERROR;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_shared_get_way(akinator_shared_t *shared,
+                                         uint32_t           node,
+                                         uint32_t         **way_output,
+                                         size_t            *level_output) {
+    size_t    depth = shared->header->depth;
+    uint32_t *way   = (uint32_t *)calloc(depth, sizeof(way[0]));
+    if(way == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while allocating memory to definition elements.\n");
+        return AKINATOR_DEFINITION_ALLOCATING_ERROR;
+    }
+
+    size_t level = 0;
+    for(; node != SharedNone; node = shared->nodes[node].parent) {
+        if(node >= shared->header->nodes_number || level == depth) {
+            free(way);
+            return AKINATOR_SHARED_ERROR;
+        }
+        way[level++] = node;
+    }
+
+    *way_output   = way;
+    *level_output = level;
+    return AKINATOR_SUCCESS;
+}
+
+//SharedNone has an empty way
+size_t akinator_way_size(const akinator_shared_way_t *way) {
+    return (way->level != 0) ? way->level - 1 : 0;
+}
+
+const char *akinator_way_question(const akinator_shared_way_t *way,
+                                  size_t                       step) {
+    return akinator_shared_question(way->shared, way->nodes[way->level - 1 - step]);
+}
+
+bool akinator_way_no(const akinator_shared_way_t *way,
+                     size_t                       step) {
+    return way->shared->nodes[way->nodes[way->level - 1 - step]].no == way->nodes[way->level - 2 - step];
+}
+
+akinator_error_t akinator_shared_move(akinator_shared_session_t *session,
+                                      uint32_t                   next) {
+    akinator_shared_t *shared = session->shared;
+    if(next >= shared->header->nodes_number) {
+        return AKINATOR_SHARED_ERROR;
+    }
+
+    session->current = next;
+    session->state   = (shared->nodes[next].yes == SharedNone) ? AKINATOR_SESSION_GUESSING :
+                                                                  AKINATOR_SESSION_ASKING;
+    return AKINATOR_SUCCESS;
+}
+
+size_t akinator_shared_offset(size_t size) {
+    return (size + alignof(akinator_shared_node_t) - 1) & ~(alignof(akinator_shared_node_t) - 1);
+}
@@ -0,0 +1,226 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "akinator.h"
+#include "akinator_tree.h"
+#include "akinator_session.h"
+#include "akinator_similar.h"
+#include "akinator_matrix.h"
+#include "akinator_histogram.h"
+#include "akinator_utils.h"
+#include "colors.h"
+
+static const size_t BenchDefaultSessions = 100000;
+static const size_t BenchDefaultLearned  = 1000;
+static const size_t BenchAnswersNumber   = 5;
+static const size_t BenchSimilarQueries  = 100000;
+static const size_t BenchMatrixObjects   = 100000;
+static const size_t BenchMatrixGames     = 1000;
+
+static akinator_error_t bench_play        (akinator_session_t   *session,
+                                           akinator_t           *akinator,
+                                           unsigned int         *seed,
+                                           akinator_histogram_t *answer_latency);
+
+static akinator_error_t bench_similar     (akinator_t           *akinator,
+                                           unsigned int         *seed,
+                                           akinator_histogram_t *similar_latency);
+
+static akinator_error_t bench_matrix      (const char           *database_filename,
+                                           unsigned int         *seed,
+                                           akinator_histogram_t *step_latency);
+
+static akinator_error_t bench_matrix_game (akinator_matrix_t    *matrix,
+                                           unsigned int         *seed,
+                                           akinator_histogram_t *step_latency);
+
+static void             bench_print       (const char           *name,
+                                           akinator_histogram_t *latency);
+
+//akin_bench [database] [sessions] [learned]   grows the tree by learned objects through
+//sessions, then plays sessions with random answers and looks for the objects similar
+//to random ones, at last fast guess games are played on the database grown to
+//BenchMatrixObjects objects, everything is kept in memory
+int main(int argc, const char *argv[]) {
+    const char *database_filename = (argc > 1) ? argv[1] : "akinator_database";
+    size_t      sessions_number   = (argc > 2) ? strtoul(argv[2], NULL, 10) : BenchDefaultSessions;
+    size_t      learned_number    = (argc > 3) ? strtoul(argv[3], NULL, 10) : BenchDefaultLearned;
+
+    akinator_t akinator = {};
+    uint64_t   start    = get_time_ns();
+    if(akinator_tree_ctor(&akinator, database_filename) != AKINATOR_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+    color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                 "Loaded %zu nodes in %.3f ms.\n",
+                 akinator.used_storage, (double)(get_time_ns() - start) / 1e6);
+
+    akinator_histogram_t *answer_latency  = (akinator_histogram_t *)calloc(1, sizeof(akinator_histogram_t));
+    akinator_histogram_t *learn_latency   = (akinator_histogram_t *)calloc(1, sizeof(akinator_histogram_t));
+    akinator_histogram_t *similar_latency = (akinator_histogram_t *)calloc(1, sizeof(akinator_histogram_t));
+    akinator_histogram_t *step_latency    = (akinator_histogram_t *)calloc(1, sizeof(akinator_histogram_t));
+    akinator_error_t      error_code      = (answer_latency  == NULL || learn_latency == NULL ||
+                                             similar_latency == NULL || step_latency  == NULL) ?
+                                            AKINATOR_NULL_POINTER : AKINATOR_SUCCESS;
+    unsigned int          seed            = 1;
+    akinator_session_t    session         = {};
+    for(size_t learned = 0; learned < learned_number && error_code == AKINATOR_SUCCESS; ) {
+        error_code = bench_play(&session, &akinator, &seed, answer_latency);
+        if(error_code != AKINATOR_SUCCESS || session.state != AKINATOR_SESSION_LEARNING) {
+            continue;
+        }
+        char object  [MaxQuestionSize + 1] = {};
+        char question[MaxQuestionSize + 1] = {};
+        snprintf(object,   sizeof(object),   "bench object %zu",   learned);
+        snprintf(question, sizeof(question), "bench question %zu", learned);
+        uint64_t learn_start = get_time_ns();
+        error_code = akinator_session_learn(&session, object, question);
+        akinator_histogram_add(learn_latency, get_time_ns() - learn_start);
+        learned++;
+    }
+    if(error_code == AKINATOR_SUCCESS && learned_number != 0) {
+        bench_print("learn", learn_latency);
+    }
+
+    memset(answer_latency, 0, sizeof(*answer_latency));
+    start = get_time_ns();
+    for(size_t played = 0; played < sessions_number && error_code == AKINATOR_SUCCESS; played++) {
+        error_code = bench_play(&session, &akinator, &seed, answer_latency);
+    }
+    double elapsed = (double)(get_time_ns() - start) / 1e9;
+    if(error_code == AKINATOR_SUCCESS) {
+        color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                     "%zu sessions on %zu nodes in %.3f s, %.0f sessions/s.\n",
+                     sessions_number, akinator.used_storage, elapsed, (double)sessions_number / elapsed);
+        bench_print("answer", answer_latency);
+    }
+
+    if(error_code == AKINATOR_SUCCESS) {
+        error_code = bench_similar(&akinator, &seed, similar_latency);
+    }
+    if(error_code == AKINATOR_SUCCESS) {
+        bench_print("similar", similar_latency);
+    }
+
+    if(error_code == AKINATOR_SUCCESS) {
+        error_code = bench_matrix(database_filename, &seed, step_latency);
+    }
+    if(error_code == AKINATOR_SUCCESS) {
+        bench_print("fast guess step", step_latency);
+    }
+
+    free(answer_latency);
+    free(learn_latency);
+    free(similar_latency);
+    free(step_latency);
+    akinator_tree_dtor(&akinator);
+    return (error_code == AKINATOR_SUCCESS) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+//answers at random until the guess is confirmed or rejected
+akinator_error_t bench_play(akinator_session_t   *session,
+                            akinator_t           *akinator,
+                            unsigned int         *seed,
+                            akinator_histogram_t *answer_latency) {
+    RETURN_IF_ERROR(akinator_session_start(session, akinator));
+    while(session->state == AKINATOR_SESSION_ASKING || session->state == AKINATOR_SESSION_GUESSING) {
+        akinator_answer_t answer = (akinator_answer_t)((size_t)rand_r(seed) % BenchAnswersNumber);
+        uint64_t          start  = get_time_ns();
+        RETURN_IF_ERROR(akinator_session_answer(session, answer));
+        akinator_histogram_add(answer_latency, get_time_ns() - start);
+    }
+    return AKINATOR_SUCCESS;
+}
+
+//the same search the menu runs, for SimilarObjectsNumber objects
+akinator_error_t bench_similar(akinator_t           *akinator,
+                               unsigned int         *seed,
+                               akinator_histogram_t *similar_latency) {
+    akinator_similar_t similar    = {};
+    akinator_error_t   error_code = akinator_similar_ctor(&similar, akinator->used_storage);
+    for(size_t query = 0; query < BenchSimilarQueries && error_code == AKINATOR_SUCCESS; query++) {
+        akinator_node_t *object = akinator->leafs_array[(size_t)rand_r(seed) % akinator->leafs_array_size];
+        uint64_t         start  = get_time_ns();
+        error_code = akinator_similar_find(&similar, object, SimilarObjectsNumber);
+        akinator_histogram_add(similar_latency, get_time_ns() - start);
+    }
+    akinator_similar_dtor(&similar);
+    return error_code;
+}
+
+//random leafs are split until the tree has BenchMatrixObjects objects, a step is choosing
+//the next question and narrowing the candidates by its answer
+akinator_error_t bench_matrix(const char           *database_filename,
+                              unsigned int         *seed,
+                              akinator_histogram_t *step_latency) {
+    akinator_t akinator = {};
+    RETURN_IF_ERROR(akinator_tree_ctor(&akinator, database_filename));
+
+    akinator_error_t error_code = AKINATOR_SUCCESS;
+    for(size_t split = 0; akinator.leafs_array_size < BenchMatrixObjects && error_code == AKINATOR_SUCCESS; split++) {
+        char object  [MaxQuestionSize + 1] = {};
+        char question[MaxQuestionSize + 1] = {};
+        snprintf(object,   sizeof(object),   "generated object %zu",   split);
+        snprintf(question, sizeof(question), "generated question %zu", split);
+        akinator_node_t *leaf = akinator.leafs_array[(size_t)rand_r(seed) % akinator.leafs_array_size];
+        error_code = akinator_split_leaf(&akinator, leaf, object, question);
+    }
+
+    akinator_matrix_t matrix = {};
+    uint64_t          start  = get_time_ns();
+    if(error_code == AKINATOR_SUCCESS) {
+        error_code = akinator_matrix_ctor(&matrix, &akinator);
+    }
+    if(error_code == AKINATOR_SUCCESS) {
+        color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                     "Matrix of %zu objects and %zu questions built in %.3f ms.\n",
+                     matrix.objects_number, matrix.questions_number, (double)(get_time_ns() - start) / 1e6);
+    }
+    for(size_t game = 0; game < BenchMatrixGames && error_code == AKINATOR_SUCCESS; game++) {
+        error_code = bench_matrix_game(&matrix, seed, step_latency);
+    }
+
+    akinator_matrix_dtor(&matrix);
+    akinator_tree_dtor(&akinator);
+    return error_code;
+}
+
+//answers for a hidden object where it is under the question and at random elsewhere
+akinator_error_t bench_matrix_game(akinator_matrix_t    *matrix,
+                                   unsigned int         *seed,
+                                   akinator_histogram_t *step_latency) {
+    size_t target = (size_t)rand_r(seed) % matrix->objects_number;
+    RETURN_IF_ERROR(akinator_matrix_reset(matrix));
+    while(true) {
+        uint64_t         start    = get_time_ns();
+        akinator_node_t *question = NULL;
+        RETURN_IF_ERROR(akinator_matrix_next_question(matrix, &question));
+        if(question == NULL) {
+            return AKINATOR_SUCCESS;
+        }
+        akinator_matrix_question_t *column = &matrix->questions[matrix->current_question];
+        akinator_answer_t           answer = (target >= column->yes_begin && target < column->no_begin) ?
+                                             AKINATOR_ANSWER_YES :
+                                             (target >= column->no_begin  && target < column->end) ?
+                                             AKINATOR_ANSWER_NO  :
+                                             (akinator_answer_t)((size_t)rand_r(seed) % BenchAnswersNumber);
+        RETURN_IF_ERROR(akinator_matrix_answer(matrix, answer));
+        akinator_histogram_add(step_latency, get_time_ns() - start);
+    }
+}
+
+void bench_print(const char *name, akinator_histogram_t *latency) {
+    uint64_t p50 = 0;
+    uint64_t p99 = 0;
+    akinator_histogram_percentile(latency, 50, &p50);
+    akinator_histogram_percentile(latency, 99, &p99);
+    color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                 "%zu %s calls, mean %.1f ns, p50 %llu ns, p99 %llu ns, max %llu ns.\n",
+                 latency->count,
+                 name,
+                 (latency->count == 0) ? 0.0 : (double)latency->sum / (double)latency->count,
+                 (unsigned long long)p50,
+                 (unsigned long long)p99,
+                 (unsigned long long)latency->max);
+}
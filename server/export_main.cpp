@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "akinator.h"
+#include "akinator_tree.h"
+#include "akinator_export.h"
+#include "colors.h"
+
+static const size_t ExportRenderBatch   = 8;
+static const size_t ExportMaxFilename   = 256;
+static const size_t ExportMaxCommand    = 32 + ExportRenderBatch * (ExportMaxFilename + 3);
+
+static akinator_error_t export_run          (const char                      *database_name,
+                                             const akinator_export_options_t *options);
+
+static void             export_remove_pages (const char                      *folder);
+
+static akinator_error_t export_render       (const char                      *folder,
+                                             size_t                          *rendered);
+
+//akin_export <database> [depth] [collapse] [radius] [object]   writes logs/export/tree_<id>.dot
+//pages of at most depth levels, each summary links to its own page, with an object the
+//first page is logs/export/focus.dot with the path to it, pages are rendered with dot
+int main(int argc, const char *argv[]) {
+    if(argc < 2) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Usage: akin_export <database> [depth] [collapse] [radius] [object]\n");
+        return EXIT_FAILURE;
+    }
+
+    akinator_export_options_t options = {.depth    = (argc > 2) ? strtoul(argv[2], NULL, 10) : ExportDefaultDepth,
+                                         .collapse = (argc > 3) ? strtoul(argv[3], NULL, 10) : ExportDefaultCollapse,
+                                         .focus    = (argc > 5) ? argv[5]                    : NULL,
+                                         .radius   = (argc > 4) ? strtoul(argv[4], NULL, 10) : ExportDefaultRadius,
+                                         .paginate = true};
+    if(options.depth == 0) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Depth has to be at least 1.\n");
+        return EXIT_FAILURE;
+    }
+    return (export_run(argv[1], &options) == AKINATOR_SUCCESS) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+akinator_error_t export_run(const char                      *database_name,
+                            const akinator_export_options_t *options) {
+    akinator_t akinator = {};
+    RETURN_IF_ERROR(akinator_tree_ctor(&akinator, database_name));
+
+    mkdir("logs",              0755);
+    mkdir(ExportDefaultFolder, 0755);
+    export_remove_pages(ExportDefaultFolder);
+
+    akinator_export_stats_t stats      = {};
+    struct timespec         start      = {};
+    struct timespec         end        = {};
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    akinator_error_t        error_code = akinator_export(&akinator, options, ExportDefaultFolder, &stats);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if(error_code == AKINATOR_SUCCESS) {
+        color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                     "%zu nodes of %zu in %zu pages, %zu summaries, at most %zu nodes a page, %.3f ms.\n",
+                     stats.nodes_number,
+                     akinator.used_storage,
+                     stats.pages_number,
+                     stats.summaries_number,
+                     stats.largest_page,
+                     (double)(end.tv_sec - start.tv_sec) * 1e3 + (double)(end.tv_nsec - start.tv_nsec) / 1e6);
+        size_t rendered = 0;
+        error_code = export_render(ExportDefaultFolder, &rendered);
+        color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                     "%zu pages rendered into %s.\n", rendered, ExportDefaultFolder);
+    }
+    akinator_tree_dtor(&akinator);
+    return error_code;
+}
+
+//pages of an earlier export would be rendered and linked again
+void export_remove_pages(const char *folder) {
+    DIR *directory = opendir(folder);
+    if(directory == NULL) {
+        return;
+    }
+    struct dirent *entry = NULL;
+    while((entry = readdir(directory)) != NULL) {
+        if(strncmp(entry->d_name, "tree_", 5) == 0 || strncmp(entry->d_name, "focus.", 6) == 0) {
+            char filename[ExportMaxFilename + sizeof(entry->d_name)] = {};
+            snprintf(filename, sizeof(filename), "%s/%s", folder, entry->d_name);
+            remove(filename);
+        }
+    }
+    closedir(directory);
+}
+
+//one dot process renders a batch of pages, dot -O writes <page>.dot.svg and pages link
+//to <page>.svg, so the outputs are renamed
+akinator_error_t export_render(const char *folder,
+                               size_t     *rendered) {
+    DIR *directory = opendir(folder);
+    if(directory == NULL) {
+        return AKINATOR_EXPORT_ERROR;
+    }
+
+    char           pages[ExportRenderBatch][ExportMaxFilename] = {};
+    size_t         batch_size                                   = 0;
+    struct dirent *entry                                        = NULL;
+    bool           done                                         = false;
+    while(!done) {
+        entry = readdir(directory);
+        done  = (entry == NULL);
+        if(!done) {
+            size_t folder_size = strlen(folder);
+            size_t name_size   = strlen(entry->d_name);
+            if(name_size < 4 || strcmp(entry->d_name + name_size - 4, ".dot") != 0 ||
+               folder_size + name_size + 2 > ExportMaxFilename) {
+                continue;
+            }
+            memcpy(pages[batch_size], folder, folder_size);
+            pages[batch_size][folder_size] = '/';
+            memcpy(pages[batch_size] + folder_size + 1, entry->d_name, name_size + 1);
+            batch_size++;
+        }
+        if(batch_size == 0 || (!done && batch_size < ExportRenderBatch)) {
+            continue;
+        }
+
+        char   command[ExportMaxCommand] = "dot -Tsvg -O";
+        size_t command_size              = strlen(command);
+        for(size_t page = 0; page < batch_size; page++) {
+            command_size += (size_t)snprintf(command + command_size, sizeof(command) - command_size,
+                                             " \"%s\"", pages[page]);
+        }
+        system(command);
+        for(size_t page = 0; page < batch_size; page++) {
+            char output[ExportMaxFilename + 4] = {};
+            char svg   [ExportMaxFilename]     = {};
+            snprintf(output, sizeof(output), "%s.svg", pages[page]);
+            snprintf(svg,    sizeof(svg),    "%.*s.svg", (int)(strlen(pages[page]) - 4), pages[page]);
+#ifdef _WIN32
+            //rename does not replace on windows
+            remove(svg);
+#endif
+            if(rename(output, svg) == 0) {
+                (*rendered)++;
+            }
+        }
+        batch_size = 0;
+    }
+    closedir(directory);
+    return AKINATOR_SUCCESS;
+}
@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "akinator_server.h"
+#include "akinator_histogram.h"
+#include "akinator_utils.h"
+#include "colors.h"
+
+static const size_t LoadDefaultClients  = 16;
+static const size_t LoadDefaultSessions = 1000;
+static const size_t LoadLearnPercent    = 5;
+static const size_t LoadMaxPercent      = 100;
+static const size_t LoadMaxClients      = 1024;
+
+struct load_client_t {
+    pthread_t             thread;
+    const char           *socket_path;
+    size_t                number;
+    size_t                sessions_number;
+    int                   socket;
+    char                  buffer[ServerMaxLine];
+    size_t                buffer_size;
+    unsigned int          seed;
+    size_t                learn_percent;
+    akinator_histogram_t *latency;
+    size_t                sessions_finished;
+    size_t                learned_number;
+    size_t                conflicts_number;
+    size_t                errors_number;
+};
+
+static void    *load_client_run     (void          *argument);
+
+static int      load_client_request (load_client_t *client,
+                                     const char    *request,
+                                     char          *reply);
+
+int main(int argc, const char *argv[]) {
+    const char *socket_path     = (argc > 1) ? argv[1] : ServerDefaultSocket;
+    size_t      clients_number  = (argc > 2) ? strtoul(argv[2], NULL, 10) : LoadDefaultClients;
+    size_t      sessions_number = (argc > 3) ? strtoul(argv[3], NULL, 10) : LoadDefaultSessions;
+    size_t      learn_percent   = (argc > 4) ? strtoul(argv[4], NULL, 10) : LoadLearnPercent;
+    if(clients_number == 0 || clients_number > LoadMaxClients) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Clients number has to be in [1, %zu].\n", LoadMaxClients);
+        return EXIT_FAILURE;
+    }
+    if(learn_percent > LoadMaxPercent) {
+        learn_percent = LoadMaxPercent;
+    }
+
+    load_client_t *clients = (load_client_t *)calloc(clients_number, sizeof(clients[0]));
+    if(clients == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    uint64_t start = get_time_ns();
+    for(size_t client = 0; client < clients_number; client++) {
+        clients[client].socket_path     = socket_path;
+        clients[client].number          = client;
+        clients[client].sessions_number = sessions_number;
+        clients[client].seed            = (unsigned int)client * 7919 + 1;
+        clients[client].learn_percent   = learn_percent;
+        clients[client].latency         = (akinator_histogram_t *)calloc(1, sizeof(akinator_histogram_t));
+        if(clients[client].latency == NULL ||
+           pthread_create(&clients[client].thread, NULL, load_client_run, clients + client) != 0) {
+            color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                         "Error while starting load client.\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    akinator_histogram_t *latency = (akinator_histogram_t *)calloc(1, sizeof(*latency));
+    if(latency == NULL) {
+        return EXIT_FAILURE;
+    }
+    size_t sessions_finished = 0;
+    size_t learned_number    = 0;
+    size_t conflicts_number  = 0;
+    size_t errors_number     = 0;
+    for(size_t client = 0; client < clients_number; client++) {
+        pthread_join(clients[client].thread, NULL);
+        akinator_histogram_merge(latency, clients[client].latency);
+        sessions_finished += clients[client].sessions_finished;
+        learned_number    += clients[client].learned_number;
+        conflicts_number  += clients[client].conflicts_number;
+        errors_number     += clients[client].errors_number;
+        free(clients[client].latency);
+    }
+    double elapsed = (double)(get_time_ns() - start) / 1e9;
+
+    uint64_t p50 = 0;
+    uint64_t p99 = 0;
+    akinator_histogram_percentile(latency, 50, &p50);
+    akinator_histogram_percentile(latency, 99, &p99);
+    color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                 "%zu clients: %zu sessions in %.2f s (%.0f sessions/s), %zu learned, %zu conflicts, %zu errors, "
+                 "%zu answers, p50 %.1f us, p99 %.1f us, max %.1f us.\n",
+                 clients_number,
+                 sessions_finished,
+                 elapsed,
+                 (double)sessions_finished / elapsed,
+                 learned_number,
+                 conflicts_number,
+                 errors_number,
+                 latency->count,
+                 (double)p50 / 1000,
+                 (double)p99 / 1000,
+                 (double)latency->max / 1000);
+    free(latency);
+    free(clients);
+    return (errors_number == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+//plays random games, learn_percent of lost games teach the server a new object
+void *load_client_run(void *argument) {
+    load_client_t *client = (load_client_t *)argument;
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, client->socket_path, sizeof(address.sun_path) - 1);
+    client->socket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(client->socket < 0 || connect(client->socket, (sockaddr *)&address, sizeof(address)) != 0) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while connecting to '%s': %s.\n", client->socket_path, strerror(errno));
+        client->errors_number++;
+        return NULL;
+    }
+
+    char reply  [ServerMaxLine] = {};
+    char request[ServerMaxLine] = {};
+    for(size_t session = 0; session < client->sessions_number; session++) {
+        if(load_client_request(client, "start\n", reply) != 0) {
+            client->errors_number++;
+            break;
+        }
+        while(strncmp(reply, "ask ", 4) == 0 || strncmp(reply, "guess ", 6) == 0) {
+            snprintf(request, sizeof(request), "answer %d\n", rand_r(&client->seed) % 2);
+            uint64_t start = get_time_ns();
+            if(load_client_request(client, request, reply) != 0) {
+                client->errors_number++;
+                break;
+            }
+            akinator_histogram_add(client->latency, get_time_ns() - start);
+        }
+
+        if(strcmp(reply, "learn") == 0 && (size_t)rand_r(&client->seed) % LoadMaxPercent < client->learn_percent) {
+            snprintf(request, sizeof(request), "learn object %zu-%zu\tquestion %zu-%zu\n",
+                     client->number, session, client->number, session);
+            if(load_client_request(client, request, reply) != 0) {
+                client->errors_number++;
+                break;
+            }
+            if(strcmp(reply, "learned") == 0) {
+                client->learned_number++;
+            }
+            //another player taught the same leaf first or the database was reloaded mid game
+            else if(strncmp(reply, "error ", sizeof("error ") - 1) == 0 &&
+                    (atoi(reply + sizeof("error ") - 1) == AKINATOR_NODE_NOT_LEAF ||
+                     atoi(reply + sizeof("error ") - 1) == AKINATOR_TREE_REPLACED)) {
+                client->conflicts_number++;
+                reply[0] = '\0';
+            }
+        }
+        if(strncmp(reply, "error", 5) == 0) {
+            client->errors_number++;
+        }
+        client->sessions_finished++;
+    }
+
+    load_client_request(client, "quit\n", NULL);
+    close(client->socket);
+    return NULL;
+}
+
+int load_client_request(load_client_t *client, const char *request, char *reply) {
+    size_t size = strlen(request);
+    if(send(client->socket, request, size, MSG_NOSIGNAL) != (ssize_t)size) {
+        return -1;
+    }
+    if(reply == NULL) {
+        return 0;
+    }
+
+    while(true) {
+        char *end = (char *)memchr(client->buffer, '\n', client->buffer_size);
+        if(end != NULL) {
+            size_t line_size = (size_t)(end - client->buffer);
+            memcpy(reply, client->buffer, line_size);
+            reply[line_size] = '\0';
+            client->buffer_size -= line_size + 1;
+            memmove(client->buffer, end + 1, client->buffer_size);
+            return 0;
+        }
+
+        ssize_t read_size = read(client->socket,
+                                 client->buffer + client->buffer_size,
+                                 ServerMaxLine - client->buffer_size);
+        if(read_size <= 0) {
+            return -1;
+        }
+        client->buffer_size += (size_t)read_size;
+    }
+}
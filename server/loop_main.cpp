@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <sys/resource.h>
+
+#include "akinator.h"
+#include "akinator_tree.h"
+#include "akinator_loop.h"
+#include "akinator_utils.h"
+#include "colors.h"
+
+static akinator_loop_t Loop = {};
+
+static void             loop_stop_handler (int              signal_number);
+
+static akinator_error_t loop_bench        (akinator_loop_t *loop,
+                                           size_t           sessions_number);
+
+static long             get_max_rss_kb    (void);
+
+//akin_loop [database] [socket]          serves flows on a unix socket
+//akin_loop [database] --bench [number]  keeps number guess flows suspended in memory and plays them
+int main(int argc, const char *argv[]) {
+    const char *database_filename = (argc > 1) ? argv[1] : "akinator_database";
+    bool        bench             = (argc > 2) && strcmp(argv[2], "--bench") == 0;
+    const char *socket_path       = (argc > 2) ? argv[2] : LoopDefaultSocket;
+
+    akinator_t akinator = {};
+    if(akinator_tree_ctor(&akinator, database_filename) != AKINATOR_SUCCESS ||
+       akinator_loop_ctor(&Loop, &akinator, bench ? NULL : socket_path) != AKINATOR_SUCCESS) {
+        akinator_loop_dtor(&Loop);
+        akinator_tree_dtor(&akinator);
+        return EXIT_FAILURE;
+    }
+
+    akinator_error_t error_code = AKINATOR_SUCCESS;
+    if(bench) {
+        error_code = loop_bench(&Loop, (argc > 3) ? strtoul(argv[3], NULL, 10) : 100000);
+    }
+    else {
+        struct sigaction action = {};
+        action.sa_handler = loop_stop_handler;
+        sigaction(SIGINT,  &action, NULL);
+        sigaction(SIGTERM, &action, NULL);
+
+        color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                     "Serving '%s' on '%s' from one thread.\n",
+                     database_filename, socket_path);
+        error_code = akinator_loop_run(&Loop);
+        akinator_loop_print_stats(&Loop);
+    }
+
+    akinator_loop_dtor(&Loop);
+    akinator_tree_dtor(&akinator);
+    return (error_code == AKINATOR_SUCCESS) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void loop_stop_handler(int signal_number) {
+    (void)signal_number;
+    Loop.stop = 1;
+}
+
+//every flow is started and left at its first question, then all of them are played
+//round robin with random answers, games lost to the player are dropped at the learn prompt
+akinator_error_t loop_bench(akinator_loop_t *loop, size_t sessions_number) {
+    long   rss_before    = get_max_rss_kb();
+    size_t frames_before = akinator_flow_allocated_bytes();
+    akinator_loop_connection_t *sessions =
+        (akinator_loop_connection_t *)calloc(sessions_number, sizeof(sessions[0]));
+    if(sessions == NULL) {
+        return AKINATOR_SERVER_ALLOCATION_ERROR;
+    }
+
+    for(size_t session = 0; session < sessions_number; session++) {
+        RETURN_IF_ERROR(akinator_loop_start_flow(loop, sessions + session, "guess"));
+        RETURN_IF_ERROR(akinator_flow_resume(&sessions[session].flow, &sessions[session].io));
+    }
+    size_t frames_bytes = akinator_flow_allocated_bytes() - frames_before;
+    color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                 "%zu suspended sessions: %zu bytes of state + %zu bytes of frame each, "
+                 "max rss grew by %ld kb.\n",
+                 sessions_number,
+                 sizeof(sessions[0]),
+                 frames_bytes / sessions_number,
+                 get_max_rss_kb() - rss_before);
+
+    unsigned int seed       = 1;
+    size_t       active     = sessions_number;
+    size_t       resumes    = 0;
+    size_t       won        = 0;
+    size_t       dropped    = 0;
+    uint64_t     start      = get_time_ns();
+    while(active != 0) {
+        for(size_t session = 0; session < sessions_number; session++) {
+            akinator_loop_connection_t *current = sessions + session;
+            if(akinator_flow_done(&current->flow)) {
+                continue;
+            }
+            if(current->io.input == AKINATOR_FLOW_INPUT_TEXT) {
+                akinator_flow_dtor(&current->flow);
+                dropped++;
+                active--;
+                continue;
+            }
+
+            current->io.answer = (akinator_answer_t)(rand_r(&seed) % 2);
+            do {
+                RETURN_IF_ERROR(akinator_flow_resume(&current->flow, &current->io));
+                resumes++;
+            } while(!akinator_flow_done(&current->flow) &&
+                    current->io.input == AKINATOR_FLOW_INPUT_NONE);
+            if(akinator_flow_done(&current->flow)) {
+                RETURN_IF_ERROR(akinator_flow_result(&current->flow));
+                akinator_flow_dtor(&current->flow);
+                won++;
+                active--;
+            }
+        }
+    }
+    double elapsed = (double)(get_time_ns() - start) / 1e9;
+
+    color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                 "%zu resumes in %.2f s (%.0f/s), %zu games won, %zu dropped at learning, "
+                 "%zu bytes of frames left.\n",
+                 resumes,
+                 elapsed,
+                 (double)resumes / elapsed,
+                 won,
+                 dropped,
+                 akinator_flow_allocated_bytes() - frames_before);
+    free(sessions);
+    return AKINATOR_SUCCESS;
+}
+
+long get_max_rss_kb(void) {
+    struct rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "akinator.h"
+#include "akinator_tree.h"
+#include "akinator_patch.h"
+#include "akinator_utils.h"
+#include "colors.h"
+
+static akinator_error_t patch_diff  (const char *old_name,
+                                     const char *new_name,
+                                     const char *patch_name);
+
+static akinator_error_t patch_apply (const char *database_name,
+                                     const char *patch_name);
+
+//akin_patch diff <old> <new> <patch>   writes what turns old database into new one
+//akin_patch apply <database> <patch>   changes database in place
+int main(int argc, const char *argv[]) {
+    const char      *command    = (argc > 1) ? argv[1] : "";
+    akinator_error_t error_code = AKINATOR_SUCCESS;
+
+    if(strcmp(command, "diff") == 0 && argc > 4) {
+        error_code = patch_diff(argv[2], argv[3], argv[4]);
+    }
+    else if(strcmp(command, "apply") == 0 && argc > 3) {
+        error_code = patch_apply(argv[2], argv[3]);
+    }
+    else {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Usage: akin_patch diff <old> <new> <patch> | apply <database> <patch>\n");
+        return EXIT_FAILURE;
+    }
+    return (error_code == AKINATOR_SUCCESS) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+akinator_error_t patch_diff(const char *old_name,
+                            const char *new_name,
+                            const char *patch_name) {
+    //two trees do not fit the stack
+    akinator_t            *trees      = (akinator_t *)calloc(2, sizeof(*trees));
+    akinator_t            *old_tree   = trees;
+    akinator_t            *new_tree   = trees + 1;
+    akinator_patch_stats_t stats      = {};
+    if(trees == NULL) {
+        return AKINATOR_PATCH_ERROR;
+    }
+    akinator_error_t       error_code = akinator_tree_ctor(old_tree, old_name);
+    if(error_code == AKINATOR_SUCCESS) {
+        error_code = akinator_tree_ctor(new_tree, new_name);
+    }
+
+    FILE *patch = NULL;
+    if(error_code == AKINATOR_SUCCESS) {
+        patch = fopen(patch_name, "wb");
+        if(patch == NULL) {
+            color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                         "Error while opening '%s'.\n", patch_name);
+            error_code = AKINATOR_PATCH_ERROR;
+        }
+    }
+    if(error_code == AKINATOR_SUCCESS) {
+        uint64_t start = get_time_ns();
+        error_code = akinator_patch_diff(old_tree, new_tree, patch, &stats);
+        color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                     "Diff took %.3f ms.\n", (double)(get_time_ns() - start) / 1e6);
+    }
+    if(patch != NULL) {
+        fclose(patch);
+    }
+    if(error_code == AKINATOR_SUCCESS) {
+        akinator_patch_print(&stats);
+    }
+    akinator_tree_dtor(old_tree);
+    akinator_tree_dtor(new_tree);
+    free(trees);
+    return error_code;
+}
+
+akinator_error_t patch_apply(const char *database_name,
+                             const char *patch_name) {
+    akinator_t             akinator   = {};
+    akinator_patch_stats_t stats      = {};
+    akinator_error_t       error_code = akinator_tree_ctor(&akinator, database_name);
+
+    FILE *patch = NULL;
+    if(error_code == AKINATOR_SUCCESS) {
+        patch = fopen(patch_name, "rb");
+        if(patch == NULL) {
+            color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                         "Error while opening '%s'.\n", patch_name);
+            error_code = AKINATOR_PATCH_ERROR;
+        }
+    }
+    //a patch that stopped half way is not saved, the database file stays as it was
+    if(error_code == AKINATOR_SUCCESS) {
+        uint64_t start = get_time_ns();
+        error_code = akinator_patch_apply(&akinator, patch, &stats);
+        color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                     "Apply took %.3f ms.\n", (double)(get_time_ns() - start) / 1e6);
+    }
+    if(patch != NULL) {
+        fclose(patch);
+    }
+    if(error_code == AKINATOR_SUCCESS) {
+        error_code = akinator_save_database(&akinator);
+    }
+    if(error_code == AKINATOR_SUCCESS) {
+        akinator_patch_print(&stats);
+    }
+    akinator_tree_dtor(&akinator);
+    return error_code;
+}
@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+
+#include "akinator.h"
+#include "akinator_tree.h"
+#include "akinator_router.h"
+#include "colors.h"
+
+static akinator_router_t Router = {};
+
+static void router_stop_handler (int signal_number);
+
+//akin_router split <database> <depth> <directory>   cuts the tree into router and shard_<n> databases
+//akin_router serve <directory> [socket]             routes clients to akin_server on <directory>/shard_<n>.sock
+int main(int argc, const char *argv[]) {
+    const char *command = (argc > 1) ? argv[1] : "";
+
+    if(strcmp(command, "split") == 0 && argc > 4) {
+        akinator_t       akinator      = {};
+        size_t           shards_number = 0;
+        akinator_error_t error_code    = akinator_tree_ctor(&akinator, argv[2]);
+        if(error_code == AKINATOR_SUCCESS) {
+            error_code = akinator_router_split(&akinator, strtoul(argv[3], NULL, 10), argv[4], &shards_number);
+        }
+        if(error_code == AKINATOR_SUCCESS) {
+            color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                         "Split '%s' into '%s', %zu shards.\n", argv[2], argv[4], shards_number);
+        }
+        akinator_tree_dtor(&akinator);
+        return (error_code == AKINATOR_SUCCESS) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if(strcmp(command, "serve") != 0 || argc < 3) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Usage: akin_router split <database> <depth> <directory> | serve <directory> [socket]\n");
+        return EXIT_FAILURE;
+    }
+
+    const char *socket_path = (argc > 3) ? argv[3] : RouterDefaultSocket;
+    if(akinator_router_ctor(&Router, argv[2], socket_path) != AKINATOR_SUCCESS) {
+        akinator_router_dtor(&Router);
+        return EXIT_FAILURE;
+    }
+
+    struct sigaction action = {};
+    action.sa_handler = router_stop_handler;
+    sigaction(SIGINT,  &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                 "Routing '%s' on '%s' to %zu shards.\n", argv[2], socket_path, Router.shards_number);
+    akinator_error_t error_code = akinator_router_run(&Router);
+    akinator_router_print_stats(&Router);
+    akinator_router_dtor       (&Router);
+    return (error_code == AKINATOR_SUCCESS) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void router_stop_handler(int signal_number) {
+    (void)signal_number;
+    Router.stop = 1;
+}
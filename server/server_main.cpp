@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+
+#include "akinator.h"
+#include "akinator_tree.h"
+#include "akinator_server.h"
+#include "akinator_reload.h"
+#include "akinator_replication.h"
+#include "colors.h"
+
+static akinator_server_t      Server      = {};
+static akinator_reload_t      Reload      = {};
+static akinator_replication_t Replication = {};
+static akinator_replica_t     Replica     = {};
+
+static void             server_stop_handler (int  signal_number);
+
+static akinator_error_t server_roles_dtor   (bool reloading,
+                                             bool primary,
+                                             bool replica);
+
+//akin_server [database] [socket] [threads] [batch] [latency_us] [primary|replica <replication socket>]
+//a primary streams learned objects to replicas on the replication socket, a replica follows
+//the primary listening there, answers players and refuses to learn
+//records name leafs by their way from the root of the tree both sides started from, so only
+//a server without a role reloads, an edited tree would make replicas split the wrong leafs
+int main(int argc, const char *argv[]) {
+    const char *database_filename = (argc > 1) ? argv[1] : "akinator_database";
+    const char *socket_path       = (argc > 2) ? argv[2] : ServerDefaultSocket;
+    size_t      threads_number    = (argc > 3) ? strtoul(argv[3], NULL, 10) : ServerDefaultThreads;
+    size_t      batch_size        = (argc > 4) ? strtoul(argv[4], NULL, 10) : ServerDefaultBatch;
+    size_t      latency_us        = (argc > 5) ? strtoul(argv[5], NULL, 10) : ServerDefaultLatencyUs;
+    const char *role              = (argc > 6) ? argv[6] : "";
+    const char *replication_path  = (argc > 7) ? argv[7] : NULL;
+    bool        primary           = strcmp(role, "primary") == 0;
+    bool        replica           = strcmp(role, "replica") == 0;
+    bool        reloading         = !primary && !replica;
+
+    if((argc > 6 && reloading) || (!reloading && replication_path == NULL)) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Usage: %s [database] [socket] [threads] [batch] [latency_us] "
+                     "[primary|replica <replication socket>]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    akinator_t akinator = {};
+    if(akinator_tree_ctor(&akinator, database_filename) != AKINATOR_SUCCESS) {
+        akinator_tree_dtor(&akinator);
+        return EXIT_FAILURE;
+    }
+    if(akinator_server_ctor     (&Server, &akinator, socket_path, threads_number) != AKINATOR_SUCCESS ||
+       akinator_server_set_batch(&Server, batch_size, latency_us)                 != AKINATOR_SUCCESS ||
+       (reloading && akinator_reload_ctor     (&Reload,      &Server)                   != AKINATOR_SUCCESS) ||
+       (primary   && akinator_replication_ctor(&Replication, &Server, replication_path) != AKINATOR_SUCCESS) ||
+       (replica   && akinator_replica_ctor    (&Replica,     &Server, replication_path) != AKINATOR_SUCCESS)) {
+        server_roles_dtor   (reloading, primary, replica);
+        akinator_server_dtor(&Server);
+        akinator_tree_dtor  (&akinator);
+        return EXIT_FAILURE;
+    }
+
+    struct sigaction action = {};
+    action.sa_handler = server_stop_handler;
+    sigaction(SIGINT,  &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                 "Serving '%s' on '%s' with %zu threads, learned objects committed by %zu or after %zu us.\n",
+                 database_filename, socket_path, threads_number, batch_size, latency_us);
+    akinator_error_t error_code = akinator_server_run(&Server);
+    akinator_server_print_stats(&Server);
+    if(reloading) {
+        akinator_reload_print_stats(&Reload);
+    }
+    if(primary) {
+        akinator_replication_print_stats(&Replication);
+    }
+    if(replica) {
+        akinator_replica_print_stats(&Replica);
+    }
+    //the shutdown save must not be taken for a database changed from outside
+    if(server_roles_dtor(reloading, primary, replica) != AKINATOR_SUCCESS && error_code == AKINATOR_SUCCESS) {
+        error_code = AKINATOR_REPLICATION_ERROR;
+    }
+    //every batch is already saved, a primary does not normalize, replicas would not hear of it
+    if(error_code == AKINATOR_SUCCESS && Server.learned_number != 0 && !primary) {
+        error_code = akinator_update_database(Server.current->akinator);
+        if(error_code == AKINATOR_EXIT_SUCCESS) {
+            error_code = AKINATOR_SUCCESS;
+        }
+    }
+
+    akinator_server_dtor(&Server);
+    akinator_tree_dtor  (&akinator);
+    return (error_code == AKINATOR_SUCCESS) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void server_stop_handler(int signal_number) {
+    (void)signal_number;
+    Server.stop = 1;
+}
+
+//only the parts this role constructed are destroyed, a zeroed one would close descriptor 0
+akinator_error_t server_roles_dtor(bool reloading,
+                                   bool primary,
+                                   bool replica) {
+    akinator_error_t error_code = AKINATOR_SUCCESS;
+    if(reloading) {
+        akinator_reload_dtor(&Reload);
+    }
+    if(primary) {
+        akinator_replication_dtor(&Replication);
+    }
+    if(replica) {
+        error_code = akinator_replica_dtor(&Replica);
+    }
+    return error_code;
+}
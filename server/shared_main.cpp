@@ -0,0 +1,267 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "akinator.h"
+#include "akinator_tree.h"
+#include "akinator_session.h"
+#include "akinator_shared.h"
+#include "akinator_utils.h"
+#include "colors.h"
+
+static const size_t SharedBenchGames = 10000;
+
+struct shared_bench_result_t {
+    long     private_kb;
+    long     pss_kb;
+    uint64_t attach_ns;
+    size_t   questions;
+};
+
+static akinator_error_t shared_publish    (const char            *database_filename,
+                                           const char            *path);
+
+static akinator_error_t shared_guess      (akinator_shared_t     *shared);
+
+static akinator_error_t shared_define     (akinator_shared_t     *shared,
+                                           const char            *first,
+                                           const char            *second);
+
+static akinator_error_t shared_bench      (const char            *database_filename,
+                                           const char            *path,
+                                           size_t                 processes_number,
+                                           bool                   private_tree);
+
+static void             shared_bench_child(const char            *database_filename,
+                                           const char            *path,
+                                           bool                   private_tree,
+                                           int                    result_pipe);
+
+static void             get_memory_kb     (long                  *private_kb,
+                                           long                  *pss_kb);
+
+//akin_shared publish [database] [path]              lays the tree out in path, /dev/shm by default
+//akin_shared guess [path]                           plays one game on the published tree
+//akin_shared definition <object> [path]
+//akin_shared difference <first> <second> [path]
+//akin_shared bench <processes> [database] [path]    same games in processes with private and shared trees
+int main(int argc, const char *argv[]) {
+    const char *command = (argc > 1) ? argv[1] : "";
+
+    if(strcmp(command, "publish") == 0) {
+        return shared_publish((argc > 2) ? argv[2] : "akinator_database",
+                              (argc > 3) ? argv[3] : SharedDefaultPath) == AKINATOR_SUCCESS ? EXIT_SUCCESS :
+                                                                                              EXIT_FAILURE;
+    }
+    if(strcmp(command, "bench") == 0 && argc > 2) {
+        const char *database_filename = (argc > 3) ? argv[3] : "akinator_database";
+        const char *path              = (argc > 4) ? argv[4] : SharedDefaultPath;
+        size_t      processes_number  = strtoul(argv[2], NULL, 10);
+        if(shared_publish(database_filename, path)                          != AKINATOR_SUCCESS ||
+           shared_bench  (database_filename, path, processes_number, true)  != AKINATOR_SUCCESS ||
+           shared_bench  (database_filename, path, processes_number, false) != AKINATOR_SUCCESS) {
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    akinator_shared_t shared     = {};
+    akinator_error_t  error_code = AKINATOR_SHARED_ERROR;
+    if(strcmp(command, "guess") == 0) {
+        if(akinator_shared_attach(&shared, (argc > 2) ? argv[2] : SharedDefaultPath) == AKINATOR_SUCCESS) {
+            error_code = shared_guess(&shared);
+        }
+    }
+    else if(strcmp(command, "definition") == 0 && argc > 2) {
+        if(akinator_shared_attach(&shared, (argc > 3) ? argv[3] : SharedDefaultPath) == AKINATOR_SUCCESS) {
+            error_code = shared_define(&shared, argv[2], NULL);
+        }
+    }
+    else if(strcmp(command, "difference") == 0 && argc > 3) {
+        if(akinator_shared_attach(&shared, (argc > 4) ? argv[4] : SharedDefaultPath) == AKINATOR_SUCCESS) {
+            error_code = shared_define(&shared, argv[2], argv[3]);
+        }
+    }
+    else {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Usage: akin_shared publish|guess|definition|difference|bench ...\n");
+    }
+    akinator_shared_detach(&shared);
+    return (error_code == AKINATOR_SUCCESS) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+akinator_error_t shared_publish(const char *database_filename,
+                                const char *path) {
+    akinator_t akinator = {};
+    akinator_error_t error_code = akinator_tree_ctor(&akinator, database_filename);
+    if(error_code == AKINATOR_SUCCESS) {
+        error_code = akinator_shared_publish(&akinator, path);
+    }
+    if(error_code == AKINATOR_SUCCESS) {
+        color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                     "Published '%s' to '%s', %zu objects.\n",
+                     database_filename, path, akinator.leafs_array_size);
+    }
+    akinator_tree_dtor(&akinator);
+    return error_code;
+}
+
+akinator_error_t shared_guess(akinator_shared_t *shared) {
+    akinator_shared_session_t session = {};
+    RETURN_IF_ERROR(akinator_shared_session_start(&session, shared));
+    while(session.state == AKINATOR_SESSION_ASKING || session.state == AKINATOR_SESSION_GUESSING) {
+        const char *question = akinator_shared_question(shared, session.current);
+        printf((session.state == AKINATOR_SESSION_ASKING) ? "%s? [0 yes, 1 no] " : "Это %s? [0 yes, 1 no] ",
+               question);
+        int answer = 0;
+        if(scanf("%d", &answer) != 1) {
+            return AKINATOR_USER_ANSWER_ERROR;
+        }
+        RETURN_IF_ERROR(akinator_shared_session_answer(&session, (akinator_answer_t)answer));
+    }
+    printf((session.state == AKINATOR_SESSION_WON) ? "Угадал.\n" :
+                                                     "Не угадал, опубликованное дерево только для чтения.\n");
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t shared_define(akinator_shared_t *shared,
+                               const char        *first,
+                               const char        *second) {
+    uint32_t first_node  = SharedNone;
+    uint32_t second_node = SharedNone;
+    RETURN_IF_ERROR(akinator_shared_find(shared, first, &first_node));
+    if(second != NULL) {
+        RETURN_IF_ERROR(akinator_shared_find(shared, second, &second_node));
+    }
+    if(first_node == SharedNone || (second != NULL && second_node == SharedNone)) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "There is no such object.\n");
+        return AKINATOR_SUCCESS;
+    }
+
+    char                  message[MaxDefinitionSize] = {};
+    akinator_definition_t definition = {.definition = message,
+                                        .index      = 0,
+                                        .capacity   = sizeof(message)};
+    RETURN_IF_ERROR((second == NULL) ? akinator_shared_definition(shared, first_node, &definition) :
+                                       akinator_shared_difference(shared, first_node, second_node, &definition));
+    printf("%s.\n", message);
+    return AKINATOR_SUCCESS;
+}
+
+//every process plays the same random games, so the whole tree is touched in each one,
+//results come back through a pipe
+akinator_error_t shared_bench(const char *database_filename,
+                              const char *path,
+                              size_t      processes_number,
+                              bool        private_tree) {
+    int result_pipe[2] = {};
+    if(pipe(result_pipe) != 0) {
+        return AKINATOR_SHARED_ERROR;
+    }
+    for(size_t process = 0; process < processes_number; process++) {
+        pid_t child = fork();
+        if(child == 0) {
+            close(result_pipe[0]);
+            shared_bench_child(database_filename, path, private_tree, result_pipe[1]);
+        }
+        if(child < 0) {
+            processes_number = process;
+            break;
+        }
+    }
+    close(result_pipe[1]);
+
+    shared_bench_result_t total   = {};
+    size_t                results = 0;
+    shared_bench_result_t result  = {};
+    while(read(result_pipe[0], &result, sizeof(result)) == (ssize_t)sizeof(result)) {
+        total.private_kb += result.private_kb;
+        total.pss_kb     += result.pss_kb;
+        total.attach_ns  += result.attach_ns;
+        total.questions  += result.questions;
+        results++;
+    }
+    close(result_pipe[0]);
+    while(wait(NULL) > 0) {}
+    if(results != processes_number || results == 0) {
+        return AKINATOR_SHARED_ERROR;
+    }
+
+    color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                 "%zu processes with %s tree: %s in %.1f us, private %ld kb, pss %ld kb per process, "
+                 "%zu kb in total, %zu questions asked.\n",
+                 results,
+                 private_tree ? "private" : "shared",
+                 private_tree ? "loaded"  : "attached",
+                 (double)total.attach_ns / (double)results / 1000,
+                 total.private_kb / (long)results,
+                 total.pss_kb     / (long)results,
+                 (size_t)total.pss_kb,
+                 total.questions);
+    return AKINATOR_SUCCESS;
+}
+
+void shared_bench_child(const char *database_filename,
+                        const char *path,
+                        bool        private_tree,
+                        int         result_pipe) {
+    long private_before = 0;
+    long pss_before     = 0;
+    get_memory_kb(&private_before, &pss_before);
+
+    shared_bench_result_t result   = {};
+    akinator_t            akinator = {};
+    akinator_shared_t     shared   = {};
+    uint64_t              start    = get_time_ns();
+    akinator_error_t      error_code = private_tree ? akinator_tree_ctor    (&akinator, database_filename) :
+                                                      akinator_shared_attach(&shared,   path);
+    result.attach_ns = get_time_ns() - start;
+
+    unsigned int seed = 1;
+    for(size_t game = 0; game < SharedBenchGames && error_code == AKINATOR_SUCCESS; game++) {
+        akinator_session_t        session        = {};
+        akinator_shared_session_t shared_session = {};
+        error_code = private_tree ? akinator_session_start       (&session,        &akinator) :
+                                    akinator_shared_session_start(&shared_session, &shared);
+        akinator_session_state_t *state = private_tree ? &session.state : &shared_session.state;
+        while(error_code == AKINATOR_SUCCESS && *state == AKINATOR_SESSION_ASKING) {
+            akinator_answer_t answer = (akinator_answer_t)(rand_r(&seed) % 2);
+            error_code = private_tree ? akinator_session_answer       (&session,        answer) :
+                                        akinator_shared_session_answer(&shared_session, answer);
+            result.questions++;
+        }
+    }
+
+    long private_after = 0;
+    long pss_after     = 0;
+    get_memory_kb(&private_after, &pss_after);
+    result.private_kb = private_after - private_before;
+    result.pss_kb     = pss_after     - pss_before;
+    if(error_code == AKINATOR_SUCCESS) {
+        write(result_pipe, &result, sizeof(result));
+    }
+    _exit(EXIT_SUCCESS);
+}
+
+void get_memory_kb(long *private_kb,
+                   long *pss_kb) {
+    FILE *rollup = fopen("/proc/self/smaps_rollup", "r");
+    if(rollup == NULL) {
+        return;
+    }
+    char line[128] = {};
+    long value     = 0;
+    while(fgets(line, sizeof(line), rollup) != NULL) {
+        if(sscanf(line, "Pss: %ld", &value) == 1) {
+            *pss_kb = value;
+        }
+        else if(sscanf(line, "Private_Clean: %ld", &value) == 1 ||
+                sscanf(line, "Private_Dirty: %ld", &value) == 1) {
+            *private_kb += value;
+        }
+    }
+    fclose(rollup);
+}
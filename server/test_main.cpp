@@ -0,0 +1,1084 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "akinator.h"
+#include "akinator_tree.h"
+#include "akinator_session.h"
+#include "akinator_flow.h"
+#include "akinator_normalize.h"
+#include "akinator_similar.h"
+#include "akinator_matrix.h"
+#include "akinator_beam.h"
+#include "akinator_encoding.h"
+#include "akinator_trace.h"
+#include "akinator_patch.h"
+#include "akinator_index.h"
+#include "akinator_layout.h"
+#include "akinator_utils.h"
+#include "colors.h"
+
+static const char TestDefaultDatabase[] = "bin/test_database";
+static const char TestTraceName[]       = "bin/test.trace";
+static const char TestPatchName[]       = "bin/test_patch_database";
+static const char TestDatabaseText[]    = "{\"animal\"\n"
+                                          "\t{\"barks\"\n"
+                                          "\t\t{\"dog\"}\n"
+                                          "\t\t{\"cat\"}\n"
+                                          "\t}\n"
+                                          "\t{\"table\"}\n"
+                                          "}\n";
+static const char TestNormalizeText[]   = "{\"animal\"\n"
+                                          "\t{\"animal\"\n"
+                                          "\t\t{\"dog\"}\n"
+                                          "\t\t{\"cat\"}\n"
+                                          "\t}\n"
+                                          "\t{\"wooden\"\n"
+                                          "\t\t{\"table\"}\n"
+                                          "\t\t{\"dog\"}\n"
+                                          "\t}\n"
+                                          "}\n";
+
+static const char TestSimilarText[]     = "{\"animal\"\n"
+                                          "\t{\"barks\"\n"
+                                          "\t\t{\"dog\"}\n"
+                                          "\t\t{\"meows\"\n"
+                                          "\t\t\t{\"cat\"}\n"
+                                          "\t\t\t{\"fish\"}\n"
+                                          "\t\t}\n"
+                                          "\t}\n"
+                                          "\t{\"table\"}\n"
+                                          "}\n";
+
+//TestSimilarText with barks renamed, meows lifted to cat and table split by wooden
+static const char TestPatchText[]       = "{\"animal\"\n"
+                                          "\t{\"barks loudly\"\n"
+                                          "\t\t{\"dog\"}\n"
+                                          "\t\t{\"cat\"}\n"
+                                          "\t}\n"
+                                          "\t{\"wooden\"\n"
+                                          "\t\t{\"chair\"}\n"
+                                          "\t\t{\"table\"}\n"
+                                          "\t}\n"
+                                          "}\n";
+
+static const char TestIndexText[]       = "{\"is it an animal\"\n"
+                                          "\t{\"does it bark\"\n"
+                                          "\t\t{\"dog\"}\n"
+                                          "\t\t{\"does it meow\"\n"
+                                          "\t\t\t{\"cat\"}\n"
+                                          "\t\t\t{\"fish\"}\n"
+                                          "\t\t}\n"
+                                          "\t}\n"
+                                          "\t{\"is it wooden\"\n"
+                                          "\t\t{\"table\"}\n"
+                                          "\t\t{\"lamp\"}\n"
+                                          "\t}\n"
+                                          "}\n";
+
+static const size_t TestTraceCapacity = 64;
+static const int    TestTraceSteps    = 200;
+static const size_t TestMatrixSplits  = 400;
+static const size_t TestMatrixGames   = 50;
+static const size_t TestMatrixSteps   = 1000;
+static const double TestBeamPrecision = 1e-9;
+static const size_t TestLayoutSizes[] = {5, 7, 9, 17, 33, 101, 1001, 10001, 100001};
+
+enum test_layout_shape_t {
+    TEST_LAYOUT_RANDOM        = 0,
+    TEST_LAYOUT_LEFT_CHAIN    = 1,
+    TEST_LAYOUT_RIGHT_CHAIN   = 2,
+    TEST_LAYOUT_ZIGZAG        = 3,
+    TEST_LAYOUT_BALANCED      = 4,
+    TEST_LAYOUT_SHAPES_NUMBER = 5,
+};
+
+struct test_state_t {
+    size_t checks_number;
+    size_t failures_number;
+};
+
+#define TEST_CHECK(test, ...)                                                              \
+    test_check((test), (__VA_ARGS__), #__VA_ARGS__, __LINE__)
+
+static void             test_check          (test_state_t             *test,
+                                             bool                      passed,
+                                             const char               *expression,
+                                             int                       line);
+
+static bool             test_is_at          (akinator_session_t       *session,
+                                             akinator_session_state_t  state,
+                                             const char               *question);
+
+static akinator_error_t test_write_database (const char               *filename,
+                                             const char               *text);
+
+static void             test_play           (test_state_t             *test,
+                                             akinator_t               *akinator);
+
+static void             test_learn          (test_state_t             *test,
+                                             akinator_t               *akinator);
+
+static void             test_wrong_state    (test_state_t             *test,
+                                             akinator_t               *akinator);
+
+static bool             test_flow_asks      (akinator_flow_t          *flow,
+                                             akinator_flow_io_t       *io,
+                                             const char               *question);
+
+static void             test_flow_guess     (test_state_t             *test,
+                                             akinator_t               *akinator);
+
+static void             test_flow_define    (test_state_t             *test,
+                                             akinator_t               *akinator);
+
+static void             test_reload         (test_state_t             *test,
+                                             akinator_t               *akinator);
+
+static void             test_normalize      (test_state_t             *test,
+                                             const char               *filename);
+
+static void             test_similar        (test_state_t             *test,
+                                             const char               *filename);
+
+static bool             test_similar_is     (akinator_similar_t       *similar,
+                                             size_t                    index,
+                                             const char               *object,
+                                             size_t                    lca_depth);
+
+static void             test_matrix         (test_state_t             *test,
+                                             const char               *filename);
+
+static bool             test_matrix_game    (akinator_matrix_t        *matrix,
+                                             akinator_answer_t        *answers,
+                                             bool                     *rejected,
+                                             unsigned int             *seed);
+
+static bool             test_matrix_matches (akinator_matrix_t        *matrix,
+                                             akinator_answer_t        *answers,
+                                             bool                     *rejected);
+
+static void             test_beam           (test_state_t             *test,
+                                             const char               *filename);
+
+static bool             test_beam_share     (akinator_beam_t          *beam,
+                                             const char               *question,
+                                             double                    share);
+
+static void             test_index          (test_state_t             *test,
+                                             const char               *filename);
+
+static bool             test_index_has      (akinator_index_result_t  *result,
+                                             const char               *question,
+                                             size_t                    subtree_size);
+
+static void             test_trace          (test_state_t             *test,
+                                             const char               *filename);
+
+static void             test_trace_run      (test_state_t             *test,
+                                             const char               *filename,
+                                             bool                      checkpoints,
+                                             akinator_trace_reader_t  *reader);
+
+static bool             test_trace_complete (akinator_trace_reader_t  *reader);
+
+static void             test_trace_remove   (void);
+
+static void             test_patch          (test_state_t             *test,
+                                             const char               *filename);
+
+static akinator_error_t test_patch_diff     (akinator_t               *old_tree,
+                                             FILE                     *patch,
+                                             akinator_patch_stats_t   *stats);
+
+static bool             test_patch_leafs    (akinator_t               *akinator,
+                                             akinator_node_t          *node,
+                                             size_t                   *leafs_number);
+
+static bool             test_patch_index    (akinator_t               *akinator);
+
+static bool             test_patch_query    (akinator_t               *akinator,
+                                             akinator_index_t         *fresh,
+                                             const char               *word);
+
+static void             test_layout         (test_state_t             *test);
+
+static akinator_error_t test_layout_tree    (akinator_dump_job_t      *job,
+                                             test_layout_shape_t       shape,
+                                             size_t                    nodes_number,
+                                             unsigned int             *seed);
+
+static bool             test_layout_fits    (akinator_layout_t        *layout,
+                                             akinator_dump_job_t      *job);
+
+static bool             test_decodes_to     (const char               *utf8,
+                                             const char               *cp1251);
+
+static void             test_encoding       (test_state_t             *test);
+
+//akin_test [database]   plays scripted sessions on a small database written to the given
+//file, learns an object, saves and loads it again, exits with failure on any wrong result
+int main(int argc, const char *argv[]) {
+    const char *database_filename = (argc > 1) ? argv[1] : TestDefaultDatabase;
+    if(test_write_database(database_filename, TestDatabaseText) != AKINATOR_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+
+    akinator_t akinator = {};
+    if(akinator_tree_ctor(&akinator, database_filename) != AKINATOR_SUCCESS) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while loading '%s'.\n", database_filename);
+        return EXIT_FAILURE;
+    }
+
+    test_state_t test = {};
+    test_play       (&test, &akinator);
+    test_learn      (&test, &akinator);
+    test_wrong_state(&test, &akinator);
+    test_flow_guess (&test, &akinator);
+    test_flow_define(&test, &akinator);
+    test_reload     (&test, &akinator);
+    test_encoding   (&test);
+    akinator_tree_dtor(&akinator);
+    test_normalize  (&test, database_filename);
+    test_similar    (&test, database_filename);
+    test_matrix     (&test, database_filename);
+    test_beam       (&test, database_filename);
+    test_index      (&test, database_filename);
+    test_trace      (&test, database_filename);
+    test_patch      (&test, database_filename);
+    test_layout     (&test);
+    remove(database_filename);
+
+    if(test.failures_number != 0) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "%zu of %zu checks failed.\n", test.failures_number, test.checks_number);
+        return EXIT_FAILURE;
+    }
+    color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                 "All %zu checks passed.\n", test.checks_number);
+    return EXIT_SUCCESS;
+}
+
+void test_check(test_state_t *test, bool passed, const char *expression, int line) {
+    test->checks_number++;
+    if(!passed) {
+        test->failures_number++;
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Failed at line %d: %s\n", line, expression);
+    }
+}
+
+bool test_is_at(akinator_session_t       *session,
+                akinator_session_state_t  state,
+                const char               *question) {
+    const char *current = NULL;
+    return session->state == state &&
+           akinator_session_current_question(session, &current) == AKINATOR_SUCCESS &&
+           strcmp(current, question) == 0;
+}
+
+akinator_error_t test_write_database(const char *filename,
+                                     const char *text) {
+    FILE *database = fopen(filename, "wb");
+    if(database == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while creating '%s'.\n", filename);
+        return AKINATOR_DATABASE_OPENING_ERROR;
+    }
+    fputs(text, database);
+    fclose(database);
+    return AKINATOR_SUCCESS;
+}
+
+//yes goes to the yes child, don't know stays, a confirmed guess wins
+void test_play(test_state_t *test, akinator_t *akinator) {
+    akinator_session_t session = {};
+    TEST_CHECK(test, akinator_session_start(&session, akinator) == AKINATOR_SUCCESS);
+    TEST_CHECK(test, test_is_at(&session, AKINATOR_SESSION_ASKING, "animal"));
+    TEST_CHECK(test, akinator_session_answer(&session, AKINATOR_ANSWER_UNKNOWN) == AKINATOR_SUCCESS);
+    TEST_CHECK(test, test_is_at(&session, AKINATOR_SESSION_ASKING, "animal"));
+    TEST_CHECK(test, akinator_session_answer(&session, AKINATOR_ANSWER_YES) == AKINATOR_SUCCESS);
+    TEST_CHECK(test, test_is_at(&session, AKINATOR_SESSION_ASKING, "barks"));
+    TEST_CHECK(test, akinator_session_answer(&session, AKINATOR_ANSWER_PROBABLY) == AKINATOR_SUCCESS);
+    TEST_CHECK(test, test_is_at(&session, AKINATOR_SESSION_GUESSING, "dog"));
+    TEST_CHECK(test, akinator_session_answer(&session, AKINATOR_ANSWER_YES) == AKINATOR_SUCCESS);
+    TEST_CHECK(test, session.state == AKINATOR_SESSION_WON);
+    TEST_CHECK(test, session.questions_asked == 4);
+
+    TEST_CHECK(test, akinator_session_start(&session, akinator) == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_session_answer(&session, AKINATOR_ANSWER_PROBABLY_NOT) == AKINATOR_SUCCESS);
+    TEST_CHECK(test, test_is_at(&session, AKINATOR_SESSION_GUESSING, "table"));
+    TEST_CHECK(test, session.questions_asked == 1);
+}
+
+//a rejected guess is learned and the next session reaches it through the new question
+void test_learn(test_state_t *test, akinator_t *akinator) {
+    size_t             used_storage = akinator->used_storage;
+    akinator_session_t session      = {};
+    TEST_CHECK(test, akinator_session_start (&session, akinator)              == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_session_answer(&session, AKINATOR_ANSWER_YES)   == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_session_answer(&session, AKINATOR_ANSWER_NO)    == AKINATOR_SUCCESS);
+    TEST_CHECK(test, test_is_at(&session, AKINATOR_SESSION_GUESSING, "cat"));
+    TEST_CHECK(test, akinator_session_answer(&session, AKINATOR_ANSWER_NO)    == AKINATOR_SUCCESS);
+    TEST_CHECK(test, session.state == AKINATOR_SESSION_LEARNING);
+    TEST_CHECK(test, akinator_session_learn (&session, "fox", "is red")       == AKINATOR_SUCCESS);
+    TEST_CHECK(test, session.state == AKINATOR_SESSION_LEARNED);
+    TEST_CHECK(test, akinator->used_storage == used_storage + 2);
+
+    TEST_CHECK(test, akinator_session_start (&session, akinator)              == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_session_answer(&session, AKINATOR_ANSWER_YES)   == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_session_answer(&session, AKINATOR_ANSWER_NO)    == AKINATOR_SUCCESS);
+    TEST_CHECK(test, test_is_at(&session, AKINATOR_SESSION_ASKING, "is red"));
+    TEST_CHECK(test, akinator_session_answer(&session, AKINATOR_ANSWER_YES)   == AKINATOR_SUCCESS);
+    TEST_CHECK(test, test_is_at(&session, AKINATOR_SESSION_GUESSING, "fox"));
+    TEST_CHECK(test, akinator_session_answer(&session, AKINATOR_ANSWER_YES)   == AKINATOR_SUCCESS);
+    TEST_CHECK(test, session.state == AKINATOR_SESSION_WON);
+
+    TEST_CHECK(test, akinator_session_start (&session, akinator)              == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_session_answer(&session, AKINATOR_ANSWER_YES)   == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_session_answer(&session, AKINATOR_ANSWER_NO)    == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_session_answer(&session, AKINATOR_ANSWER_NO)    == AKINATOR_SUCCESS);
+    TEST_CHECK(test, test_is_at(&session, AKINATOR_SESSION_GUESSING, "cat"));
+
+    akinator_node_t *fox = NULL;
+    TEST_CHECK(test, akinator_find_node(akinator, "fox", &fox) == AKINATOR_EXIT_SUCCESS);
+    TEST_CHECK(test, fox != NULL && fox->parent != NULL && fox->parent->yes == fox);
+}
+
+void test_wrong_state(test_state_t *test, akinator_t *akinator) {
+    akinator_session_t session  = {};
+    const char        *question = NULL;
+    TEST_CHECK(test, akinator_session_answer(&session, AKINATOR_ANSWER_YES)       == AKINATOR_SESSION_STATE_ERROR);
+    TEST_CHECK(test, akinator_session_current_question(&session, &question)       == AKINATOR_SESSION_STATE_ERROR);
+
+    TEST_CHECK(test, akinator_session_start (&session, akinator)                  == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_session_learn (&session, "chair", "has legs")       == AKINATOR_SESSION_STATE_ERROR);
+    TEST_CHECK(test, akinator_session_answer(&session, (akinator_answer_t)7)      == AKINATOR_USER_ANSWER_ERROR);
+    TEST_CHECK(test, akinator_session_answer(&session, AKINATOR_ANSWER_NO)        == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_session_answer(&session, AKINATOR_ANSWER_YES)       == AKINATOR_SUCCESS);
+    TEST_CHECK(test, session.state == AKINATOR_SESSION_WON);
+    TEST_CHECK(test, akinator_session_answer(&session, AKINATOR_ANSWER_YES)       == AKINATOR_SESSION_STATE_ERROR);
+    TEST_CHECK(test, akinator_session_current_question(&session, &question)       == AKINATOR_SESSION_STATE_ERROR);
+}
+
+bool test_flow_asks(akinator_flow_t *flow, akinator_flow_io_t *io, const char *question) {
+    return akinator_flow_resume(flow, io) == AKINATOR_SUCCESS &&
+           io->input == AKINATOR_FLOW_INPUT_ANSWER && io->asked != NULL &&
+           strcmp(io->asked->question, question) == 0;
+}
+
+//the guessing flow moves on probably answers like the session does and asks again on don't know
+void test_flow_guess(test_state_t *test, akinator_t *akinator) {
+    char               buffer[MaxDefinitionSize] = {};
+    akinator_flow_io_t io                        = {};
+    io.buffer      = buffer;
+    io.buffer_size = sizeof(buffer);
+
+    akinator_flow_t flow = akinator_flow_guess(akinator, &io);
+    TEST_CHECK(test, test_flow_asks(&flow, &io, "animal"));
+    io.answer = AKINATOR_ANSWER_PROBABLY;
+    TEST_CHECK(test, test_flow_asks(&flow, &io, "barks"));
+    io.answer = AKINATOR_ANSWER_UNKNOWN;
+    TEST_CHECK(test, akinator_flow_resume(&flow, &io) == AKINATOR_SUCCESS && io.input == AKINATOR_FLOW_INPUT_NONE);
+    TEST_CHECK(test, test_flow_asks(&flow, &io, "barks"));
+    io.answer = AKINATOR_ANSWER_PROBABLY_NOT;
+    TEST_CHECK(test, test_flow_asks(&flow, &io, "is red"));
+    io.answer = AKINATOR_ANSWER_NO;
+    TEST_CHECK(test, test_flow_asks(&flow, &io, "cat"));
+    io.answer = AKINATOR_ANSWER_YES;
+    TEST_CHECK(test, akinator_flow_resume(&flow, &io) == AKINATOR_SUCCESS && !akinator_flow_done(&flow));
+    TEST_CHECK(test, akinator_flow_resume(&flow, &io) == AKINATOR_SUCCESS && akinator_flow_done(&flow));
+    TEST_CHECK(test, akinator_flow_result(&flow) == AKINATOR_SUCCESS);
+    akinator_flow_dtor(&flow);
+}
+
+//definitions are read from the root down, the common part of two ways is said once
+void test_flow_define(test_state_t *test, akinator_t *akinator) {
+    char               buffer[MaxDefinitionSize] = {};
+    akinator_flow_io_t io                        = {};
+    io.buffer      = buffer;
+    io.buffer_size = sizeof(buffer);
+
+    akinator_flow_t flow = akinator_flow_definition(akinator, &io);
+    TEST_CHECK(test, akinator_flow_resume(&flow, &io) == AKINATOR_SUCCESS && io.input == AKINATOR_FLOW_INPUT_TEXT);
+    io.text = "fox";
+    TEST_CHECK(test, akinator_flow_resume(&flow, &io) == AKINATOR_SUCCESS && io.input == AKINATOR_FLOW_INPUT_NONE);
+    TEST_CHECK(test, strcmp(buffer, "fox - это animal, который не barks,\nis red") == 0);
+    akinator_flow_dtor(&flow);
+
+    io   = {.buffer = buffer, .buffer_size = sizeof(buffer)};
+    flow = akinator_flow_difference(akinator, &io);
+    TEST_CHECK(test, akinator_flow_resume(&flow, &io) == AKINATOR_SUCCESS && io.input == AKINATOR_FLOW_INPUT_TEXT);
+    io.text = "dog";
+    TEST_CHECK(test, akinator_flow_resume(&flow, &io) == AKINATOR_SUCCESS && io.input == AKINATOR_FLOW_INPUT_TEXT);
+    io.text = "cat";
+    TEST_CHECK(test, akinator_flow_resume(&flow, &io) == AKINATOR_SUCCESS && io.input == AKINATOR_FLOW_INPUT_NONE);
+    TEST_CHECK(test, strcmp(buffer, "Они оба animal,\nно dog barks, а cat не barks,\nне is red") == 0);
+    akinator_flow_dtor(&flow);
+}
+
+//the learned object survives a save and a load
+void test_reload(test_state_t *test, akinator_t *akinator) {
+    TEST_CHECK(test, akinator_save_database(akinator) == AKINATOR_SUCCESS);
+
+    akinator_t reloaded = {};
+    TEST_CHECK(test, akinator_tree_ctor(&reloaded, akinator->database_name) == AKINATOR_SUCCESS);
+    TEST_CHECK(test, reloaded.used_storage == akinator->used_storage);
+
+    akinator_session_t session = {};
+    TEST_CHECK(test, akinator_session_start (&session, &reloaded)           == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_session_answer(&session, AKINATOR_ANSWER_YES) == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_session_answer(&session, AKINATOR_ANSWER_NO)  == AKINATOR_SUCCESS);
+    TEST_CHECK(test, test_is_at(&session, AKINATOR_SESSION_ASKING, "is red"));
+    TEST_CHECK(test, akinator_session_answer(&session, AKINATOR_ANSWER_YES) == AKINATOR_SUCCESS);
+    TEST_CHECK(test, test_is_at(&session, AKINATOR_SESSION_GUESSING, "fox"));
+    akinator_tree_dtor(&reloaded);
+}
+
+//the repeated question loses its unreachable branch, the object under two answer paths
+//stays in both and is counted, every leaf position points back at its leaf
+void test_normalize(test_state_t *test, const char *filename) {
+    akinator_t akinator = {};
+    TEST_CHECK(test, test_write_database(filename, TestNormalizeText)   == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_tree_ctor(&akinator, filename)            == AKINATOR_SUCCESS);
+
+    akinator_normalize_stats_t stats = {};
+    TEST_CHECK(test, akinator_normalize(&akinator, &stats)              == AKINATOR_SUCCESS);
+    TEST_CHECK(test, stats.nodes_before      == 7 && stats.nodes_after == 5);
+    TEST_CHECK(test, stats.removed_questions == 1 && stats.duplicate_leafs == 1);
+    TEST_CHECK(test, akinator.leafs_array_size == 3);
+    for(size_t index = 0; index < akinator.leafs_array_size; index++) {
+        akinator_node_t *leaf = akinator.leafs_array[index];
+        TEST_CHECK(test, leaf->id < akinator.leafs_positions_capacity &&
+                         akinator.leafs_positions[leaf->id] == index);
+    }
+    akinator_tree_dtor(&akinator);
+}
+
+//objects behind a deeper divergence point come first, the ones behind the same point
+//go by their distance from it
+void test_similar(test_state_t *test, const char *filename) {
+    akinator_t         akinator = {};
+    akinator_similar_t similar  = {};
+    akinator_node_t   *cat      = NULL;
+    akinator_node_t   *dog      = NULL;
+    TEST_CHECK(test, test_write_database(filename, TestSimilarText)   == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_tree_ctor (&akinator, filename)          == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_similar_ctor(&similar, 1)                == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_find_node(&akinator, "cat", &cat)        == AKINATOR_EXIT_SUCCESS);
+    TEST_CHECK(test, akinator_find_node(&akinator, "dog", &dog)        == AKINATOR_EXIT_SUCCESS);
+    if(cat == NULL || dog == NULL) {
+        akinator_similar_dtor(&similar);
+        akinator_tree_dtor   (&akinator);
+        return;
+    }
+
+    TEST_CHECK(test, akinator_similar_find(&similar, cat, 3)           == AKINATOR_SUCCESS);
+    TEST_CHECK(test, similar.result_size == 3);
+    TEST_CHECK(test, test_similar_is(&similar, 0, "fish",  2));
+    TEST_CHECK(test, test_similar_is(&similar, 1, "dog",   1));
+    TEST_CHECK(test, test_similar_is(&similar, 2, "table", 0));
+
+    TEST_CHECK(test, akinator_similar_find(&similar, dog, 3)           == AKINATOR_SUCCESS);
+    TEST_CHECK(test, similar.result_size == 3);
+    TEST_CHECK(test, (test_similar_is(&similar, 0, "cat",  1) && test_similar_is(&similar, 1, "fish", 1)) ||
+                     (test_similar_is(&similar, 0, "fish", 1) && test_similar_is(&similar, 1, "cat",  1)));
+    TEST_CHECK(test, similar.result_size == 3 && similar.result[0].distance == 2 &&
+                     similar.result[1].distance == 2);
+    TEST_CHECK(test, test_similar_is(&similar, 2, "table", 0));
+
+    TEST_CHECK(test, akinator_similar_find(&similar, dog, 1)           == AKINATOR_SUCCESS);
+    TEST_CHECK(test, similar.result_size == 1 && similar.result[0].lca_depth == 1);
+    akinator_similar_dtor(&similar);
+    akinator_tree_dtor   (&akinator);
+}
+
+bool test_similar_is(akinator_similar_t *similar,
+                     size_t              index,
+                     const char         *object,
+                     size_t              lca_depth) {
+    return index < similar->result_size &&
+           strcmp(similar->result[index].node->question, object) == 0 &&
+           similar->result[index].lca_depth == lca_depth;
+}
+
+//the tree is grown by random splits past a few bitset words, every game answers for a
+//hidden object where it is under the question and at random elsewhere, after every
+//answer and rejected guess the candidates are the objects a plain descent still allows
+void test_matrix(test_state_t *test, const char *filename) {
+    akinator_t akinator = {};
+    TEST_CHECK(test, test_write_database(filename, TestDatabaseText) == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_tree_ctor (&akinator, filename)         == AKINATOR_SUCCESS);
+
+    unsigned int     seed       = 1;
+    akinator_error_t error_code = AKINATOR_SUCCESS;
+    for(size_t split = 0; split < TestMatrixSplits && error_code == AKINATOR_SUCCESS; split++) {
+        char object  [MaxQuestionSize] = {};
+        char question[MaxQuestionSize] = {};
+        snprintf(object,   sizeof(object),   "object %zu",   split);
+        snprintf(question, sizeof(question), "question %zu", split);
+        akinator_node_t *leaf = akinator.leafs_array[(size_t)rand_r(&seed) % akinator.leafs_array_size];
+        error_code = akinator_split_leaf(&akinator, leaf, object, question);
+    }
+    TEST_CHECK(test, error_code == AKINATOR_SUCCESS);
+
+    akinator_matrix_t  matrix   = {};
+    akinator_answer_t *answers  = (akinator_answer_t *)calloc(akinator.used_storage, sizeof(answers[0]));
+    bool              *rejected = (bool *)             calloc(akinator.used_storage, sizeof(rejected[0]));
+    TEST_CHECK(test, answers != NULL && rejected != NULL);
+    TEST_CHECK(test, akinator_matrix_ctor(&matrix, &akinator) == AKINATOR_SUCCESS);
+    TEST_CHECK(test, matrix.objects_number == akinator.leafs_array_size && matrix.words_number > 1);
+
+    size_t found = 0;
+    for(size_t game = 0; game < TestMatrixGames && answers != NULL && rejected != NULL; game++) {
+        for(size_t id = 0; id < akinator.used_storage; id++) {
+            answers [id] = AKINATOR_ANSWER_UNKNOWN;
+            rejected[id] = false;
+        }
+        found += test_matrix_game(&matrix, answers, rejected, &seed) ? 1 : 0;
+    }
+    TEST_CHECK(test, found == TestMatrixGames);
+
+    akinator_matrix_dtor(&matrix);
+    free(answers);
+    free(rejected);
+    akinator_tree_dtor(&akinator);
+}
+
+//true when the hidden object is guessed and the candidates matched the tree at every step
+bool test_matrix_game(akinator_matrix_t *matrix,
+                      akinator_answer_t *answers,
+                      bool              *rejected,
+                      unsigned int      *seed) {
+    size_t target = (size_t)rand_r(seed) % matrix->objects_number;
+    if(akinator_matrix_reset(matrix) != AKINATOR_SUCCESS) {
+        return false;
+    }
+
+    for(size_t step = 0; step < TestMatrixSteps; step++) {
+        akinator_node_t *question = NULL;
+        if(akinator_matrix_next_question(matrix, &question) != AKINATOR_SUCCESS) {
+            return false;
+        }
+        if(question == NULL) {
+            akinator_node_t *object = NULL;
+            if(akinator_matrix_get_guess(matrix, &object) != AKINATOR_SUCCESS) {
+                return false;
+            }
+            if(object == matrix->objects[target]) {
+                return true;
+            }
+            rejected[object->id] = true;
+            if(akinator_matrix_reject_guess(matrix) != AKINATOR_SUCCESS) {
+                return false;
+            }
+        }
+        else {
+            akinator_matrix_question_t *column = &matrix->questions[matrix->current_question];
+            akinator_answer_t           answer = (target >= column->yes_begin && target < column->no_begin) ?
+                                                 AKINATOR_ANSWER_YES :
+                                                 (target >= column->no_begin  && target < column->end) ?
+                                                 AKINATOR_ANSWER_NO  :
+                                                 (akinator_answer_t)(rand_r(seed) % 3);
+            answers[question->id] = answer;
+            if(akinator_matrix_answer(matrix, answer) != AKINATOR_SUCCESS) {
+                return false;
+            }
+        }
+        if(!test_matrix_matches(matrix, answers, rejected)) {
+            return false;
+        }
+    }
+    return false;
+}
+
+//an object is still possible when every answered question above it sent the descent its way
+bool test_matrix_matches(akinator_matrix_t *matrix,
+                         akinator_answer_t *answers,
+                         bool              *rejected) {
+    size_t allowed_number = 0;
+    for(size_t object = 0; object < matrix->objects_number; object++) {
+        akinator_node_t *leaf    = matrix->objects[object];
+        bool             allowed = !rejected[leaf->id];
+        for(akinator_node_t *node = leaf; allowed && node->parent != NULL; node = node->parent) {
+            akinator_answer_t answer = answers[node->parent->id];
+            allowed = !(answer == AKINATOR_ANSWER_YES && node->parent->yes != node) &&
+                      !(answer == AKINATOR_ANSWER_NO  && node->parent->no  != node);
+        }
+        bool candidate = (matrix->candidates[object / 64] >> (object % 64)) & 1;
+        if(candidate != allowed) {
+            return false;
+        }
+        allowed_number += allowed ? 1 : 0;
+    }
+    return allowed_number == matrix->candidates_number;
+}
+
+//"don't know" splits the asked subtree's share evenly between its children and leaves
+//every other share as it was, an object holding 80% is guessed while a question is open
+void test_beam(test_state_t *test, const char *filename) {
+    akinator_t       akinator = {};
+    akinator_beam_t  beam     = {};
+    akinator_node_t *question = NULL;
+    akinator_node_t *object   = NULL;
+    TEST_CHECK(test, test_write_database(filename, TestSimilarText) == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_tree_ctor (&akinator, filename)        == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_beam_ctor (&beam, BeamDefaultWidth)    == AKINATOR_SUCCESS);
+
+    TEST_CHECK(test, akinator_beam_reset        (&beam, akinator.root)            == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_beam_next_question(&beam, &question)                == AKINATOR_SUCCESS);
+    TEST_CHECK(test, question == akinator.root);
+    TEST_CHECK(test, akinator_beam_answer       (&beam, AKINATOR_ANSWER_UNKNOWN)  == AKINATOR_SUCCESS);
+    TEST_CHECK(test, test_beam_share(&beam, "barks", 0.5) && test_beam_share(&beam, "table", 0.5));
+    TEST_CHECK(test, akinator_beam_next_question(&beam, &question)                == AKINATOR_SUCCESS);
+    TEST_CHECK(test, question != NULL && strcmp(question->question, "barks") == 0);
+    TEST_CHECK(test, akinator_beam_answer       (&beam, AKINATOR_ANSWER_UNKNOWN)  == AKINATOR_SUCCESS);
+    TEST_CHECK(test, test_beam_share(&beam, "table", 0.5)  && test_beam_share(&beam, "dog", 0.25) &&
+                     test_beam_share(&beam, "meows", 0.25) && beam.frontier_size == 3);
+
+    //0.95 * 0.75 of barks goes to dog, 71% is short of the threshold, so meows is asked
+    TEST_CHECK(test, akinator_beam_reset        (&beam, akinator.root)            == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_beam_next_question(&beam, &question)                == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_beam_answer       (&beam, AKINATOR_ANSWER_YES)      == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_beam_next_question(&beam, &question)                == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_beam_answer       (&beam, AKINATOR_ANSWER_PROBABLY) == AKINATOR_SUCCESS);
+    TEST_CHECK(test, test_beam_share(&beam, "dog", 0.7125));
+    TEST_CHECK(test, akinator_beam_next_question(&beam, &question)                == AKINATOR_SUCCESS);
+    TEST_CHECK(test, question != NULL && strcmp(question->question, "meows") == 0);
+
+    //0.95 * 0.95 gives dog 90%, it is guessed with meows still in the beam
+    TEST_CHECK(test, akinator_beam_reset        (&beam, akinator.root)            == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_beam_next_question(&beam, &question)                == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_beam_answer       (&beam, AKINATOR_ANSWER_YES)      == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_beam_next_question(&beam, &question)                == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_beam_answer       (&beam, AKINATOR_ANSWER_YES)      == AKINATOR_SUCCESS);
+    TEST_CHECK(test, test_beam_share(&beam, "dog", 0.9025) && test_beam_share(&beam, "meows", 0.0475));
+    TEST_CHECK(test, akinator_beam_next_question(&beam, &question)                == AKINATOR_SUCCESS);
+    TEST_CHECK(test, question == NULL);
+    TEST_CHECK(test, akinator_beam_get_guess    (&beam, &object)                  == AKINATOR_SUCCESS);
+    TEST_CHECK(test, object != NULL && strcmp(object->question, "dog") == 0);
+
+    akinator_beam_dtor(&beam);
+    akinator_tree_dtor(&akinator);
+}
+
+bool test_beam_share(akinator_beam_t *beam,
+                     const char      *question,
+                     double           share) {
+    for(size_t index = 0; index < beam->frontier_size; index++) {
+        if(strcmp(beam->frontier[index].node->question, question) == 0) {
+            double difference = beam->frontier[index].weight - share;
+            return difference < TestBeamPrecision && difference > -TestBeamPrecision;
+        }
+    }
+    return false;
+}
+
+//only questions are indexed, words are matched whatever their case and the punctuation
+//around them, a word the index does not know empties an and query and is skipped by an
+//or one, a split question is found at once and its ancestors count the new leaf
+void test_index(test_state_t *test, const char *filename) {
+    akinator_t              akinator = {};
+    akinator_index_result_t result   = {};
+    akinator_index_t       *index    = &akinator.index;
+    akinator_node_t        *lamp     = NULL;
+    TEST_CHECK(test, test_write_database(filename, TestIndexText)     == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_tree_ctor (&akinator, filename)          == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_find_node (&akinator, "lamp", &lamp)     == AKINATOR_EXIT_SUCCESS);
+    if(lamp == NULL) {
+        akinator_tree_dtor(&akinator);
+        return;
+    }
+
+    TEST_CHECK(test, akinator_index_query(index, &akinator, "bark",  AKINATOR_INDEX_AND, &result) == AKINATOR_SUCCESS);
+    TEST_CHECK(test, result.size == 1 && test_index_has(&result, "does it bark", 3));
+    TEST_CHECK(test, akinator_index_query(index, &akinator, "DOES, It?", AKINATOR_INDEX_AND, &result) == AKINATOR_SUCCESS);
+    TEST_CHECK(test, result.size == 2 && test_index_has(&result, "does it bark", 3) &&
+                                         test_index_has(&result, "does it meow", 2));
+    TEST_CHECK(test, akinator_index_query(index, &akinator, "it",    AKINATOR_INDEX_OR,  &result) == AKINATOR_SUCCESS);
+    TEST_CHECK(test, result.size == 4 && test_index_has(&result, "is it an animal", 5) &&
+                                         test_index_has(&result, "is it wooden",    2));
+    TEST_CHECK(test, akinator_index_query(index, &akinator, "bark meow", AKINATOR_INDEX_AND, &result) == AKINATOR_SUCCESS);
+    TEST_CHECK(test, result.size == 0);
+    TEST_CHECK(test, akinator_index_query(index, &akinator, "bark meow", AKINATOR_INDEX_OR,  &result) == AKINATOR_SUCCESS);
+    TEST_CHECK(test, result.size == 2);
+    TEST_CHECK(test, akinator_index_query(index, &akinator, "giraffe wooden", AKINATOR_INDEX_AND, &result) == AKINATOR_SUCCESS);
+    TEST_CHECK(test, result.size == 0);
+    TEST_CHECK(test, akinator_index_query(index, &akinator, "giraffe wooden", AKINATOR_INDEX_OR,  &result) == AKINATOR_SUCCESS);
+    TEST_CHECK(test, result.size == 1 && test_index_has(&result, "is it wooden", 2));
+    TEST_CHECK(test, akinator_index_query(index, &akinator, "dog",   AKINATOR_INDEX_OR,  &result) == AKINATOR_SUCCESS);
+    TEST_CHECK(test, result.size == 0);
+
+    TEST_CHECK(test, akinator_split_leaf(&akinator, lamp, "spoon", "is it metal") == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_index_query(index, &akinator, "metal", AKINATOR_INDEX_AND, &result) == AKINATOR_SUCCESS);
+    TEST_CHECK(test, result.size == 1 && test_index_has(&result, "is it metal", 2));
+    TEST_CHECK(test, akinator_index_query(index, &akinator, "is it", AKINATOR_INDEX_AND, &result) == AKINATOR_SUCCESS);
+    TEST_CHECK(test, result.size == 3 && test_index_has(&result, "is it an animal", 6) &&
+                                         test_index_has(&result, "is it wooden",    3) &&
+                                         test_index_has(&result, "is it metal",     2));
+    akinator_index_result_dtor(&result);
+    akinator_tree_dtor        (&akinator);
+}
+
+bool test_index_has(akinator_index_result_t *result,
+                    const char              *question,
+                    size_t                   subtree_size) {
+    for(size_t element = 0; element < result->size; element++) {
+        if(strcmp(result->nodes[element]->question, question) == 0) {
+            return result->subtree_sizes[element] == subtree_size;
+        }
+    }
+    return false;
+}
+
+//a ring of 64 records is passed many times by random splits, renames and lifts, with a
+//checkpoint taken after every game every change after the newest one is still in the
+//ring, without them the changes made since the base are found lost
+void test_trace(test_state_t *test, const char *filename) {
+    akinator_trace_reader_t reader = {};
+    test_trace_run(test, filename, true, &reader);
+    TEST_CHECK(test, reader.lost_number != 0 && reader.header.checkpoint_head != 0);
+    TEST_CHECK(test, test_trace_complete(&reader));
+
+    char name[FILENAME_MAX] = {};
+    snprintf(name, sizeof(name), "%s.ckpt%llu.ids", TestTraceName,
+             (unsigned long long)reader.header.checkpoint_slot);
+    FILE    *ids  = fopen(name, "rb");
+    uint64_t head = 0;
+    TEST_CHECK(test, ids != NULL && fread(&head, sizeof(head), 1, ids) == 1 &&
+                     head == reader.header.checkpoint_head);
+    if(ids != NULL) {
+        fclose(ids);
+    }
+    akinator_trace_reader_dtor(&reader);
+
+    test_trace_run(test, filename, false, &reader);
+    TEST_CHECK(test, reader.lost_number != 0 && reader.header.checkpoint_head == 0);
+    TEST_CHECK(test, !test_trace_complete(&reader));
+    akinator_trace_reader_dtor(&reader);
+    test_trace_remove();
+}
+
+void test_trace_run(test_state_t            *test,
+                    const char              *filename,
+                    bool                     checkpoints,
+                    akinator_trace_reader_t *reader) {
+    akinator_t akinator = {};
+    TEST_CHECK(test, test_write_database(filename, TestDatabaseText)                 == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_tree_ctor (&akinator, filename)                         == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_trace_ctor(&akinator, TestTraceName, TestTraceCapacity) == AKINATOR_SUCCESS);
+
+    unsigned         seed             = 1;
+    akinator_error_t checkpoint_error = AKINATOR_SUCCESS;
+    for(int step = 0; step < TestTraceSteps && akinator.trace != NULL; step++) {
+        akinator_node_t *node = akinator.root;
+        while(!is_leaf(node)) {
+            akinator_trace_node(akinator.trace, TRACE_EVENT_VISIT, node->id, 0);
+            node = (rand_r(&seed) & 1) ? node->yes : node->no;
+        }
+        char object  [MaxQuestionSize] = {};
+        char question[MaxQuestionSize] = {};
+        int  change                    = rand_r(&seed) % 10;
+        snprintf(object,   sizeof(object),   "object %d",   step);
+        snprintf(question, sizeof(question), "question %d", step);
+        if(change < 5) {
+            akinator_split_leaf(&akinator, node, object, question);
+        }
+        else if(change < 8) {
+            akinator_rename_node(&akinator, (node->parent != NULL) ? node->parent : node, question);
+        }
+        else if(node->parent != NULL && node->parent->parent != NULL) {
+            akinator_lift_node(&akinator, node->parent->parent, AKINATOR_ANSWER_YES);
+        }
+        if(checkpoints && checkpoint_error == AKINATOR_SUCCESS) {
+            checkpoint_error = akinator_trace_checkpoint(akinator.trace);
+        }
+    }
+    TEST_CHECK(test, checkpoint_error == AKINATOR_SUCCESS);
+    akinator_trace_dtor(&akinator);
+    akinator_tree_dtor (&akinator);
+    TEST_CHECK(test, akinator_trace_read(reader, TestTraceName) == AKINATOR_SUCCESS);
+}
+
+//records from the newest checkpoint on follow each other up to head and hold every
+//change the header counted since it
+bool test_trace_complete(akinator_trace_reader_t *reader) {
+    uint64_t expected = reader->header.checkpoint_head;
+    uint64_t changes  = 0;
+    for(size_t index = 0; index < reader->records_number; index++) {
+        akinator_trace_record_t *record = &reader->records[index];
+        if(record->position < reader->header.checkpoint_head) {
+            continue;
+        }
+        if(record->position != expected) {
+            return false;
+        }
+        expected = record->end;
+        changes += akinator_trace_is_change(record->type) ? 1 : 0;
+    }
+    return expected == reader->header.head &&
+           changes  == reader->header.changes - reader->header.checkpoint_changes;
+}
+
+//the second run kept the first one as .prev
+void test_trace_remove(void) {
+    static const char *const suffixes[] = {"", ".db", ".ckpt0.db", ".ckpt0.ids", ".ckpt1.db", ".ckpt1.ids"};
+    char name[FILENAME_MAX] = {};
+    for(size_t suffix = 0; suffix < sizeof(suffixes) / sizeof(suffixes[0]); suffix++) {
+        snprintf(name, sizeof(name), "%s%s", TestTraceName, suffixes[suffix]);
+        remove(name);
+        snprintf(name, sizeof(name), "%s.prev%s", TestTraceName, suffixes[suffix]);
+        remove(name);
+    }
+}
+
+//the patch from TestSimilarText to TestPatchText has one operation of each kind, after
+//applying it the leafs array and the index kept up by the operations are the ones a
+//fresh collection and build give on the result, and nothing is left to patch
+void test_patch(test_state_t *test, const char *filename) {
+    akinator_t             akinator = {};
+    akinator_patch_stats_t stats    = {};
+    FILE                  *patch    = tmpfile();
+    TEST_CHECK(test, patch != NULL);
+    TEST_CHECK(test, test_write_database(filename,      TestSimilarText) == AKINATOR_SUCCESS);
+    TEST_CHECK(test, test_write_database(TestPatchName, TestPatchText)   == AKINATOR_SUCCESS);
+    TEST_CHECK(test, akinator_tree_ctor (&akinator, filename)            == AKINATOR_SUCCESS);
+    if(patch == NULL || akinator.root == NULL) {
+        if(patch != NULL) {
+            fclose(patch);
+        }
+        akinator_tree_dtor(&akinator);
+        remove(TestPatchName);
+        return;
+    }
+
+    TEST_CHECK(test, test_patch_diff(&akinator, patch, &stats)             == AKINATOR_SUCCESS);
+    TEST_CHECK(test, stats.splits == 1 && stats.renames == 1 && stats.lifts == 1);
+    rewind(patch);
+    TEST_CHECK(test, akinator_patch_apply(&akinator, patch, &stats)        == AKINATOR_SUCCESS);
+    TEST_CHECK(test, stats.splits == 1 && stats.renames == 1 && stats.lifts == 1);
+
+    size_t leafs_number = 0;
+    TEST_CHECK(test, test_patch_leafs(&akinator, akinator.root, &leafs_number) &&
+                     leafs_number == akinator.leafs_array_size && leafs_number == 4);
+    TEST_CHECK(test, test_patch_index(&akinator));
+
+    rewind(patch);
+    TEST_CHECK(test, test_patch_diff(&akinator, patch, &stats)             == AKINATOR_SUCCESS);
+    TEST_CHECK(test, stats.splits == 0 && stats.renames == 0 && stats.lifts == 0);
+    fclose(patch);
+    akinator_tree_dtor(&akinator);
+    remove(TestPatchName);
+}
+
+//the new tree is loaded here so the test does not keep two trees on its stack
+akinator_error_t test_patch_diff(akinator_t             *old_tree,
+                                 FILE                   *patch,
+                                 akinator_patch_stats_t *stats) {
+    akinator_t new_tree = {};
+    RETURN_IF_ERROR(akinator_tree_ctor(&new_tree, TestPatchName));
+    akinator_error_t error_code = akinator_patch_diff(old_tree, &new_tree, patch, stats);
+    akinator_tree_dtor(&new_tree);
+    return error_code;
+}
+
+//every leaf under node is in the array at the position kept for its id
+bool test_patch_leafs(akinator_t      *akinator,
+                      akinator_node_t *node,
+                      size_t          *leafs_number) {
+    if(!is_leaf(node)) {
+        return test_patch_leafs(akinator, node->yes, leafs_number) &&
+               test_patch_leafs(akinator, node->no,  leafs_number);
+    }
+    (*leafs_number)++;
+    return node->id < akinator->leafs_positions_capacity &&
+           akinator->leafs_positions[node->id] < akinator->leafs_array_size &&
+           akinator->leafs_array[akinator->leafs_positions[node->id]] == node;
+}
+
+//every word of either index finds the same questions with the same subtree sizes, the
+//kept one may still hold words whose questions all left, those find nothing in both
+bool test_patch_index(akinator_t *akinator) {
+    akinator_index_t fresh  = {};
+    bool             passed = akinator_index_build(&fresh, akinator) == AKINATOR_SUCCESS;
+    for(size_t element = 0; passed && element < fresh.table_capacity; element++) {
+        if(fresh.table[element].word != NULL) {
+            passed = test_patch_query(akinator, &fresh, fresh.table[element].word);
+        }
+    }
+    for(size_t element = 0; passed && element < akinator->index.table_capacity; element++) {
+        if(akinator->index.table[element].word != NULL) {
+            passed = test_patch_query(akinator, &fresh, akinator->index.table[element].word);
+        }
+    }
+    akinator_index_dtor(&fresh);
+    return passed;
+}
+
+bool test_patch_query(akinator_t       *akinator,
+                      akinator_index_t *fresh,
+                      const char       *word) {
+    akinator_index_result_t kept  = {};
+    akinator_index_result_t built = {};
+    bool passed = akinator_index_query(&akinator->index, akinator, word, AKINATOR_INDEX_AND, &kept)  == AKINATOR_SUCCESS &&
+                  akinator_index_query(fresh,            akinator, word, AKINATOR_INDEX_AND, &built) == AKINATOR_SUCCESS &&
+                  kept.size == built.size;
+    for(size_t element = 0; passed && element < kept.size; element++) {
+        passed = kept.nodes[element]         == built.nodes[element] &&
+                 kept.subtree_sizes[element] == built.subtree_sizes[element];
+    }
+    akinator_index_result_dtor(&kept);
+    akinator_index_result_dtor(&built);
+    return passed;
+}
+
+//every shape is laid out at every size of TestLayoutSizes, chains are the deepest trees
+//the layout threads through, balanced ones the widest levels
+void test_layout(test_state_t *test) {
+    unsigned int seed = 1;
+    for(int shape = 0; shape < TEST_LAYOUT_SHAPES_NUMBER; shape++) {
+        for(size_t size = 0; size < sizeof(TestLayoutSizes) / sizeof(TestLayoutSizes[0]); size++) {
+            akinator_dump_job_t job    = {};
+            akinator_layout_t   layout = {};
+            TEST_CHECK(test, test_layout_tree(&job, (test_layout_shape_t)shape, TestLayoutSizes[size], &seed) == AKINATOR_SUCCESS &&
+                             akinator_layout_ctor(&layout, &job) == AKINATOR_SUCCESS &&
+                             test_layout_fits(&layout, &job));
+            akinator_layout_dtor(&layout);
+            free(job.entries);
+        }
+    }
+}
+
+//the tree grows by splitting leafs, the last split's children for chains and zigzags,
+//the oldest leaf for balanced trees and any for random ones, then it is written out
+//breadth first the way the dump snapshots it
+akinator_error_t test_layout_tree(akinator_dump_job_t *job,
+                                  test_layout_shape_t  shape,
+                                  size_t               nodes_number,
+                                  unsigned int        *seed) {
+    size_t *yes   = (size_t *)calloc(nodes_number, sizeof(*yes));
+    size_t *no    = (size_t *)calloc(nodes_number, sizeof(*no));
+    size_t *leafs = (size_t *)calloc(nodes_number, sizeof(*leafs));
+    job->entries  = (akinator_dump_entry_t *)calloc(nodes_number, sizeof(*job->entries));
+    if(yes == NULL || no == NULL || leafs == NULL || job->entries == NULL) {
+        free(yes);
+        free(no);
+        free(leafs);
+        return AKINATOR_NULL_POINTER;
+    }
+    job->entries_number = nodes_number;
+
+    size_t used       = 1;
+    size_t last       = 0;
+    size_t leafs_head = 0;
+    size_t leafs_tail = 1;
+    for(size_t split = 0; split < nodes_number / 2; split++) {
+        size_t leaf = leafs[leafs_head];
+        switch(shape) {
+            case TEST_LAYOUT_RANDOM: {
+                size_t position = leafs_head + (size_t)rand_r(seed) % (leafs_tail - leafs_head);
+                leaf            = leafs[position];
+                leafs[position] = leafs[leafs_head];
+                leafs_head++;
+                break;
+            }
+            case TEST_LAYOUT_LEFT_CHAIN: {
+                leaf = (split == 0) ? 0 : yes[last];
+                break;
+            }
+            case TEST_LAYOUT_RIGHT_CHAIN: {
+                leaf = (split == 0) ? 0 : no[last];
+                break;
+            }
+            case TEST_LAYOUT_ZIGZAG: {
+                leaf = (split == 0) ? 0 : (split % 2 == 0) ? yes[last] : no[last];
+                break;
+            }
+            case TEST_LAYOUT_BALANCED: {
+                leafs_head++;
+                break;
+            }
+            case TEST_LAYOUT_SHAPES_NUMBER:
+            default: {
+                break;
+            }
+        }
+        yes[leaf]           = used++;
+        no [leaf]           = used++;
+        leafs[leafs_tail++] = yes[leaf];
+        leafs[leafs_tail++] = no [leaf];
+        last                = leaf;
+    }
+
+    //leafs is reused for the breadth first order, entry i holds the node at order i
+    size_t tail = 1;
+    leafs[0]    = 0;
+    for(size_t head = 0; head < nodes_number; head++) {
+        size_t                 node  = leafs[head];
+        akinator_dump_entry_t *entry = &job->entries[head];
+        if(yes[node] == 0) {
+            entry->yes = DumpNoChild;
+            entry->no  = DumpNoChild;
+            continue;
+        }
+        entry->yes                  = tail;
+        entry->no                   = tail + 1;
+        job->entries[tail    ].level = entry->level + 1;
+        job->entries[tail + 1].level = entry->level + 1;
+        leafs[tail++]               = yes[node];
+        leafs[tail++]               = no [node];
+    }
+    free(yes);
+    free(no);
+    free(leafs);
+    return AKINATOR_SUCCESS;
+}
+
+//parents are exactly centered over their children, every level goes left to right in
+//the snapshot order at least LayoutMinSeparation apart, x starts at 0 and ends at width
+bool test_layout_fits(akinator_layout_t *layout, akinator_dump_job_t *job) {
+    int32_t min_x = INT32_MAX;
+    int32_t max_x = INT32_MIN;
+    size_t  depth = 0;
+    for(size_t index = 0; index < job->entries_number; index++) {
+        akinator_dump_entry_t *entry = &job->entries[index];
+        int32_t                x     = layout->x[index];
+        min_x = (x < min_x) ? x : min_x;
+        max_x = (x > max_x) ? x : max_x;
+        depth = (entry->level > depth) ? entry->level : depth;
+        if(entry->yes != DumpNoChild &&
+           (2 * x != layout->x[entry->yes] + layout->x[entry->no] || layout->x[entry->yes] >= x)) {
+            return false;
+        }
+        if(index != 0 && job->entries[index - 1].level == entry->level &&
+           x - layout->x[index - 1] < LayoutMinSeparation) {
+            return false;
+        }
+    }
+    return min_x == 0 && max_x == layout->width && depth == layout->depth &&
+           layout->nodes_number == job->entries_number;
+}
+
+bool test_decodes_to(const char *utf8, const char *cp1251) {
+    char   output[MaxQuestionSize + 1] = {};
+    size_t size                        = 0;
+    return akinator_utf8_to_cp1251(utf8, strlen(utf8), output, sizeof(output), &size) == AKINATOR_SUCCESS &&
+           size == strlen(cp1251) && memcmp(output, cp1251, size) == 0;
+}
+
+//overlong forms, surrogates and bytes that never lead are one '?' per byte
+void test_encoding(test_state_t *test) {
+    TEST_CHECK(test, test_decodes_to("a\xd0\xb4\xd1\x8f", "a\xe4\xff"));
+    TEST_CHECK(test, test_decodes_to("\xe2\x84\x96",        "\xb9"));
+    TEST_CHECK(test, test_decodes_to("\xc0\xaf",            "??"));
+    TEST_CHECK(test, test_decodes_to("\xe0\x80\xaf",        "???"));
+    TEST_CHECK(test, test_decodes_to("\xc0\x80",            "??"));
+    TEST_CHECK(test, test_decodes_to("\xc1\xbf",            "??"));
+    TEST_CHECK(test, test_decodes_to("\xf0\x80\x80\xaf",    "????"));
+    TEST_CHECK(test, test_decodes_to("\xed\xa0\x80",        "???"));
+    TEST_CHECK(test, test_decodes_to("\xf4\x90\x80\x80",    "????"));
+    TEST_CHECK(test, test_decodes_to("\xf5\x80\x80\x80",    "????"));
+    TEST_CHECK(test, test_decodes_to("\xff\xfe",            "??"));
+    TEST_CHECK(test, test_decodes_to("\xf0\x9f\x98\x80",    "?"));
+}
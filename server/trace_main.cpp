@@ -0,0 +1,441 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "akinator.h"
+#include "akinator_tree.h"
+#include "akinator_normalize.h"
+#include "akinator_dump.h"
+#include "akinator_trace.h"
+#include "akinator_utils.h"
+#include "colors.h"
+
+static const char *const TraceEventNames[] = {"none", "visit", "answer", "split", "rename",
+                                              "lift", "normalize", "dump", "error", "text"};
+static const char *const TraceAnswers[]    = {"yes", "no", "unknown", "probably", "probably not"};
+static const char *const TraceFolders[]    = {"logs", "logs/img", "logs/dot_utf8"};
+
+//nodes of the replayed tree by the ids the game gave them, next_id is the id the
+//game gives its next node, start is the first position that applies to the tree
+//and start_changes the changes made before it
+struct trace_ids_t {
+    akinator_node_t **nodes;
+    size_t            capacity;
+    uint64_t          next_id;
+    uint64_t          start;
+    uint64_t          start_changes;
+};
+
+static akinator_error_t trace_decode          (const char              *trace_name,
+                                               const char              *base_name);
+
+static akinator_error_t trace_load_base       (akinator_t              *akinator,
+                                               akinator_trace_reader_t *reader,
+                                               const char              *trace_name,
+                                               const char              *base_name,
+                                               trace_ids_t             *ids);
+
+static akinator_error_t trace_load_checkpoint (akinator_t              *akinator,
+                                               akinator_trace_reader_t *reader,
+                                               const char              *trace_name,
+                                               trace_ids_t             *ids);
+
+static akinator_error_t trace_read_ids        (akinator_node_t         *node,
+                                               FILE                    *file,
+                                               trace_ids_t             *ids);
+
+static akinator_error_t trace_replay          (akinator_t              *akinator,
+                                               akinator_trace_reader_t *reader,
+                                               const char              *trace_name,
+                                               trace_ids_t             *ids);
+
+static akinator_error_t trace_print           (trace_ids_t             *ids,
+                                               akinator_trace_record_t *record);
+
+static akinator_error_t trace_apply           (akinator_t              *akinator,
+                                               trace_ids_t             *ids,
+                                               akinator_trace_record_t *record);
+
+static akinator_error_t trace_ids_set         (trace_ids_t             *ids,
+                                               uint64_t                 id,
+                                               akinator_node_t         *node);
+
+static akinator_error_t trace_ids_get         (trace_ids_t             *ids,
+                                               uint64_t                 id,
+                                               akinator_node_t        **node);
+
+static const char      *trace_node_text       (trace_ids_t             *ids,
+                                               uint64_t                 id);
+
+//akin_trace <trace> [base]   prints what is left in the trace and draws logs/akin.html from it,
+//it starts from the newest checkpoint of the trace, or from base, the tree the trace
+//started with, when there is none or base is given
+int main(int argc, const char *argv[]) {
+    if(argc < 2) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Usage: akin_trace <trace> [base database]\n");
+        return EXIT_FAILURE;
+    }
+
+    akinator_error_t error_code = trace_decode(argv[1], (argc > 2) ? argv[2] : NULL);
+    return (error_code == AKINATOR_SUCCESS) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+//caller strings of the dumps point into the reader, so it is destroyed after the dump worker
+akinator_error_t trace_decode(const char *trace_name,
+                              const char *base_name) {
+    akinator_trace_reader_t reader     = {};
+    akinator_t              akinator   = {};
+    trace_ids_t             ids        = {};
+    akinator_error_t        error_code = akinator_trace_read(&reader, trace_name);
+    if(error_code == AKINATOR_SUCCESS && base_name == NULL && reader.header.checkpoint_head != 0 &&
+       trace_load_checkpoint(&akinator, &reader, trace_name, &ids) != AKINATOR_SUCCESS) {
+        color_printf(YELLOW_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                     "The checkpoint does not fit the trace, it is replayed from the base.\n");
+        akinator_tree_dtor(&akinator);
+        free(ids.nodes);
+        akinator = {};
+        ids      = {};
+    }
+    if(error_code == AKINATOR_SUCCESS && akinator.root == NULL) {
+        error_code = trace_load_base(&akinator, &reader, trace_name, base_name, &ids);
+    }
+    if(error_code == AKINATOR_SUCCESS) {
+        for(size_t folder = 0; folder < sizeof(TraceFolders) / sizeof(TraceFolders[0]); folder++) {
+            mkdir(TraceFolders[folder], 0755);
+        }
+        error_code = akinator_dump_init(&akinator);
+    }
+    if(error_code == AKINATOR_SUCCESS) {
+        error_code = trace_replay(&akinator, &reader, trace_name, &ids);
+    }
+
+    akinator_error_t dump_error = akinator_dump_dtor(&akinator);
+    if(error_code == AKINATOR_SUCCESS) {
+        error_code = dump_error;
+    }
+    akinator_tree_dtor        (&akinator);
+    akinator_trace_reader_dtor(&reader);
+    free(ids.nodes);
+    return error_code;
+}
+
+//ids of the base are the ids the game had when the trace started, base is <trace>.db
+//unless given
+akinator_error_t trace_load_base(akinator_t              *akinator,
+                                 akinator_trace_reader_t *reader,
+                                 const char              *trace_name,
+                                 const char              *base_name,
+                                 trace_ids_t             *ids) {
+    char default_name[FILENAME_MAX] = {};
+    if(base_name == NULL) {
+        if((size_t)snprintf(default_name, sizeof(default_name), "%s.db", trace_name) >= sizeof(default_name)) {
+            return AKINATOR_TRACE_ERROR;
+        }
+        base_name = default_name;
+    }
+    RETURN_IF_ERROR(akinator_tree_ctor(akinator, base_name));
+    if(akinator->used_storage != reader->header.nodes_number) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "'%s' has %zu nodes, the trace was started on %llu.\n",
+                     base_name,
+                     akinator->used_storage,
+                     (unsigned long long)reader->header.nodes_number);
+        return AKINATOR_TRACE_ERROR;
+    }
+
+    for(size_t id = 0; id < akinator->used_storage; id++) {
+        akinator_node_t *node = NULL;
+        RETURN_IF_ERROR(akinator_get_node_by_id(akinator, id, &node));
+        RETURN_IF_ERROR(trace_ids_set(ids, id, node));
+    }
+    ids->next_id       = reader->header.nodes_number;
+    ids->start         = 0;
+    ids->start_changes = 0;
+    return AKINATOR_SUCCESS;
+}
+
+//the checkpoint is used only if its ids file was finished for the head the header has
+akinator_error_t trace_load_checkpoint(akinator_t              *akinator,
+                                       akinator_trace_reader_t *reader,
+                                       const char              *trace_name,
+                                       trace_ids_t             *ids) {
+    akinator_trace_header_t *header = &reader->header;
+    char name[FILENAME_MAX] = {};
+    if((size_t)snprintf(name, sizeof(name), "%s.ckpt%llu.db",
+                        trace_name, (unsigned long long)header->checkpoint_slot) >= sizeof(name)) {
+        return AKINATOR_TRACE_ERROR;
+    }
+    RETURN_IF_ERROR(akinator_tree_ctor(akinator, name));
+
+    snprintf(name, sizeof(name), "%s.ckpt%llu.ids", trace_name, (unsigned long long)header->checkpoint_slot);
+    FILE *file = fopen(name, "rb");
+    if(file == NULL) {
+        return AKINATOR_TRACE_ERROR;
+    }
+    uint64_t         head       = 0;
+    uint64_t         extra      = 0;
+    akinator_error_t error_code = (fread(&head, sizeof(head), 1, file) == 1 && head == header->checkpoint_head) ?
+                                  trace_read_ids(akinator->root, file, ids) :
+                                  AKINATOR_TRACE_ERROR;
+    if(error_code == AKINATOR_SUCCESS && fread(&extra, sizeof(extra), 1, file) != 0) {
+        error_code = AKINATOR_TRACE_ERROR;
+    }
+    fclose(file);
+    RETURN_IF_ERROR(error_code);
+
+    ids->next_id       = header->checkpoint_nodes;
+    ids->start         = header->checkpoint_head;
+    ids->start_changes = header->checkpoint_changes;
+    return AKINATOR_SUCCESS;
+}
+
+//ids are listed in the order the database lists the nodes
+akinator_error_t trace_read_ids(akinator_node_t *node,
+                                FILE            *file,
+                                trace_ids_t     *ids) {
+    uint64_t id = 0;
+    if(fread(&id, sizeof(id), 1, file) != 1) {
+        return AKINATOR_TRACE_ERROR;
+    }
+    RETURN_IF_ERROR(trace_ids_set(ids, id, node));
+    if(is_leaf(node)) {
+        return AKINATOR_SUCCESS;
+    }
+    RETURN_IF_ERROR(trace_read_ids(node->yes, file, ids));
+    RETURN_IF_ERROR(trace_read_ids(node->no,  file, ids));
+    return AKINATOR_SUCCESS;
+}
+
+//changes are applied to the base in the order they were made, every dump and error
+//is drawn as the tree was then, the last dump is the tree at the end of the trace,
+//events are missing where one does not start at the end of the one before it, if the
+//changes around the gap do not add up to the ones the header counted, a change was
+//lost there and the ones after it are not applied
+akinator_error_t trace_replay(akinator_t              *akinator,
+                              akinator_trace_reader_t *reader,
+                              const char              *trace_name,
+                              trace_ids_t             *ids) {
+    char   started[64] = {};
+    time_t start_time  = (time_t)reader->header.start_time;
+    strftime(started, sizeof(started), "%Y-%m-%d %H:%M:%S", localtime(&start_time));
+    color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                 "'%s': '%s' at %s, %zu records, %zu overwritten, %zu torn.\n",
+                 trace_name,
+                 reader->header.database,
+                 started,
+                 reader->records_number,
+                 reader->lost_number,
+                 reader->torn_number);
+
+    size_t first = 0;
+    while(first < reader->records_number && reader->records[first].position < ids->start) {
+        first++;
+    }
+    if(ids->start != 0) {
+        color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                     "Replayed from the checkpoint at %llu, %zu records before it are skipped.\n",
+                     (unsigned long long)ids->start, first);
+    }
+
+    uint64_t changes = reader->header.changes - ids->start_changes;
+    uint64_t seen    = 0;
+    uint64_t left    = 0;
+    for(size_t index = first; index < reader->records_number; index++) {
+        left += akinator_trace_is_change(reader->records[index].type) ? 1 : 0;
+    }
+
+    bool     diverged = false;
+    uint64_t expected = ids->start;
+    for(size_t index = first; index < reader->records_number; index++) {
+        akinator_trace_record_t *record = &reader->records[index];
+        if(!diverged && record->position != expected && seen + left != changes) {
+            color_printf(YELLOW_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                         "%llu changes were lost before this record, the ones from here on are skipped.\n",
+                         (unsigned long long)(changes - seen - left));
+            diverged = true;
+        }
+        RETURN_IF_ERROR(trace_print(ids, record));
+        if(!diverged && trace_apply(akinator, ids, record) != AKINATOR_SUCCESS) {
+            color_printf(YELLOW_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                         "The change does not fit the tree, the ones from here on are skipped.\n");
+            diverged = true;
+        }
+        if(akinator_trace_is_change(record->type)) {
+            seen++;
+            left--;
+        }
+        expected = record->end;
+        if(record->type == TRACE_EVENT_DUMP || record->type == TRACE_EVENT_ERROR) {
+            RETURN_IF_ERROR(akinator_dump(akinator, record->texts[0], record->first, record->texts[1]));
+        }
+    }
+    if(!diverged && seen != changes) {
+        color_printf(YELLOW_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                     "%llu changes at the end of the trace were lost.\n",
+                     (unsigned long long)(changes - seen));
+    }
+    RETURN_IF_ERROR(akinator_dump(akinator, trace_name, 0, "end of trace"));
+
+    color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                 "%zu dumps drawn into logs/akin.html.\n", akinator->dumps_number);
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t trace_print(trace_ids_t             *ids,
+                             akinator_trace_record_t *record) {
+    const char *name = (record->type < TRACE_EVENT_TEXT) ? TraceEventNames[record->type] : "unknown";
+    printf("%12.3f ms  %-9s ", (double)record->time / 1e6, name);
+
+    switch(record->type) {
+        case TRACE_EVENT_VISIT: {
+            printf("#%llu \"%s\"\n", (unsigned long long)record->first, trace_node_text(ids, record->first));
+            break;
+        }
+        case TRACE_EVENT_ANSWER: {
+            printf("#%llu \"%s\" %s\n",
+                   (unsigned long long)record->first,
+                   trace_node_text(ids, record->first),
+                   (record->second <= AKINATOR_ANSWER_PROBABLY_NOT) ? TraceAnswers[record->second] : "?");
+            break;
+        }
+        case TRACE_EVENT_SPLIT: {
+            printf("#%llu \"%s\" under \"%s\" as #%llu, new object \"%s\"\n",
+                   (unsigned long long)record->first,
+                   trace_node_text(ids, record->first),
+                   record->texts[0],
+                   (unsigned long long)record->second,
+                   record->texts[1]);
+            break;
+        }
+        case TRACE_EVENT_RENAME: {
+            printf("#%llu \"%s\" to \"%s\"\n",
+                   (unsigned long long)record->first,
+                   trace_node_text(ids, record->first),
+                   record->texts[0]);
+            break;
+        }
+        case TRACE_EVENT_LIFT: {
+            printf("#%llu \"%s\" keeps %s\n",
+                   (unsigned long long)record->first,
+                   trace_node_text(ids, record->first),
+                   (record->second == AKINATOR_ANSWER_YES) ? "yes" : "no");
+            break;
+        }
+        case TRACE_EVENT_NORMALIZE: {
+            printf("%llu questions removed, %llu leafs merged\n",
+                   (unsigned long long)record->first,
+                   (unsigned long long)record->second);
+            break;
+        }
+        case TRACE_EVENT_DUMP: {
+            printf("%s:%llu %s\n", record->texts[0], (unsigned long long)record->first, record->texts[1]);
+            break;
+        }
+        case TRACE_EVENT_ERROR: {
+            printf("%llu at %s:%llu %s\n",
+                   (unsigned long long)record->second,
+                   record->texts[0],
+                   (unsigned long long)record->first,
+                   record->texts[1]);
+            break;
+        }
+        case TRACE_EVENT_NONE:
+        case TRACE_EVENT_TEXT: {
+            printf("\n");
+            break;
+        }
+        default: {
+            printf("type %d\n", (int)record->type);
+            break;
+        }
+    }
+    return AKINATOR_SUCCESS;
+}
+
+//a split is checked against the id the game gave its question, the new nodes get the
+//game's ids, so later events find them
+akinator_error_t trace_apply(akinator_t              *akinator,
+                             trace_ids_t             *ids,
+                             akinator_trace_record_t *record) {
+    akinator_node_t *node = NULL;
+    switch(record->type) {
+        case TRACE_EVENT_SPLIT: {
+            if(ids->next_id != record->second) {
+                return AKINATOR_TRACE_ERROR;
+            }
+            RETURN_IF_ERROR(trace_ids_get      (ids, record->first, &node));
+            RETURN_IF_ERROR(akinator_split_leaf(akinator, node, record->texts[1], record->texts[0]));
+            RETURN_IF_ERROR(trace_ids_set      (ids, record->second,     node->parent));
+            RETURN_IF_ERROR(trace_ids_set      (ids, record->second + 1, node->parent->yes));
+            ids->next_id += 2;
+            return AKINATOR_SUCCESS;
+        }
+        case TRACE_EVENT_RENAME: {
+            RETURN_IF_ERROR(trace_ids_get(ids, record->first, &node));
+            return akinator_rename_node(akinator, node, record->texts[0]);
+        }
+        case TRACE_EVENT_LIFT: {
+            RETURN_IF_ERROR(trace_ids_get(ids, record->first, &node));
+            return akinator_lift_node(akinator, node, (akinator_answer_t)record->second);
+        }
+        case TRACE_EVENT_NORMALIZE: {
+            akinator_normalize_stats_t stats = {};
+            RETURN_IF_ERROR(akinator_normalize(akinator, &stats));
+            return akinator_index_build(&akinator->index, akinator);
+        }
+        case TRACE_EVENT_NONE:
+        case TRACE_EVENT_VISIT:
+        case TRACE_EVENT_ANSWER:
+        case TRACE_EVENT_DUMP:
+        case TRACE_EVENT_ERROR:
+        case TRACE_EVENT_TEXT: {
+            return AKINATOR_SUCCESS;
+        }
+        default: {
+            return AKINATOR_SUCCESS;
+        }
+    }
+}
+
+akinator_error_t trace_ids_set(trace_ids_t     *ids,
+                               uint64_t         id,
+                               akinator_node_t *node) {
+    if(id >= ids->capacity) {
+        size_t new_capacity = (ids->capacity == 0) ? (size_t)id + 1 : ids->capacity;
+        while(new_capacity <= id) {
+            new_capacity *= 2;
+        }
+        akinator_node_t **new_nodes = (akinator_node_t **)realloc(ids->nodes, new_capacity * sizeof(new_nodes[0]));
+        if(new_nodes == NULL) {
+            return AKINATOR_TRACE_ERROR;
+        }
+        memset(new_nodes + ids->capacity, 0, (new_capacity - ids->capacity) * sizeof(new_nodes[0]));
+        ids->nodes    = new_nodes;
+        ids->capacity = new_capacity;
+    }
+    ids->nodes[id] = node;
+    return AKINATOR_SUCCESS;
+}
+
+//nodes the checkpoint did not keep are not found
+akinator_error_t trace_ids_get(trace_ids_t      *ids,
+                               uint64_t          id,
+                               akinator_node_t **node) {
+    if(id >= ids->capacity || ids->nodes[id] == NULL) {
+        return AKINATOR_NODE_NULL;
+    }
+    *node = ids->nodes[id];
+    return AKINATOR_SUCCESS;
+}
+
+const char *trace_node_text(trace_ids_t *ids,
+                            uint64_t     id) {
+    akinator_node_t *node = NULL;
+    if(trace_ids_get(ids, id, &node) != AKINATOR_SUCCESS) {
+        return "?";
+    }
+    return node->question;
+}
@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "akinator_ui.h"
+#include "colors.h"
+
+static const int32_t UiBenchWidth        = 800;
+static const int32_t UiBenchHeight       = 600;
+static const size_t  UiBenchButtons      = 7;
+static const double  UiBenchButtonWidth  = 300;
+static const double  UiBenchButtonHeight = 50;
+static const size_t  UiBenchMoves        = 10000;
+static const size_t  UiBenchIdleMs       = 1000;
+
+struct ui_bench_t {
+    akinator_ui_t    ui;
+    akinator_menu_t  menu;
+    size_t           chosen;
+    akinator_error_t error;
+};
+
+static void    *ui_bench_run      (void       *argument);
+
+static double   ui_bench_cpu_time (void);
+
+static void     ui_bench_sleep    (size_t      milliseconds);
+
+//akin_ui [moves] [idle ms] [picture.ppm]   runs the main menu on the headless backend,
+//moves the mouse over it, leaves it idle and answers with the second button's digit
+int main(int argc, const char *argv[]) {
+    size_t moves   = (argc > 1) ? strtoul(argv[1], NULL, 10) : UiBenchMoves;
+    size_t idle_ms = (argc > 2) ? strtoul(argv[2], NULL, 10) : UiBenchIdleMs;
+
+    static ui_bench_t bench = {};
+    if(akinator_ui_ctor(&bench.ui, UI_BACKEND_HEADLESS, UiBenchWidth, UiBenchHeight) != AKINATOR_SUCCESS) {
+        return EXIT_FAILURE;
+    }
+    const char  *labels[UiBenchButtons] = {"Guess", "Fast game", "Game with doubts", "Definition",
+                                           "Difference", "Similar", "Exit"};
+    rectangle_t  boxes [UiBenchButtons] = {};
+    for(size_t button = 0; button < UiBenchButtons; button++) {
+        double center_y = UiBenchHeight / 2 + ((double)button - ((double)UiBenchButtons - 1) / 2) *
+                                              UiBenchButtonHeight * 1.5;
+        boxes[button] = {.left   = (UiBenchWidth - UiBenchButtonWidth) / 2,
+                         .right  = (UiBenchWidth + UiBenchButtonWidth) / 2,
+                         .bottom = center_y - UiBenchButtonHeight / 2,
+                         .top    = center_y + UiBenchButtonHeight / 2};
+    }
+    bench.menu = {.button_boxes = boxes, .labels = labels, .shortcuts = NULL, .number = UiBenchButtons};
+
+    pthread_t thread = {};
+    if(pthread_create(&thread, NULL, ui_bench_run, &bench) != 0) {
+        akinator_ui_dtor(&bench.ui);
+        return EXIT_FAILURE;
+    }
+
+    //the mouse goes down the screen and back, so it crosses every button
+    for(size_t move = 0; move < moves; move++) {
+        size_t              step  = move % (2 * (size_t)UiBenchHeight);
+        akinator_ui_event_t event = {.type     = UI_EVENT_MOUSE_MOVE,
+                                     .position = {.x = UiBenchWidth / 2,
+                                                  .y = (double)((step < (size_t)UiBenchHeight) ?
+                                                                step : 2 * (size_t)UiBenchHeight - step - 1)},
+                                     .key      = 0};
+        akinator_ui_post_event(&bench.ui, &event);
+    }
+    while(true) {
+        pthread_mutex_lock(&bench.ui.lock);
+        size_t left = bench.ui.events_size;
+        pthread_mutex_unlock(&bench.ui.lock);
+        if(left == 0) {
+            break;
+        }
+        ui_bench_sleep(1);
+    }
+    ui_bench_sleep(10);
+
+    size_t frames     = bench.ui.frames_number;
+    double cpu_before = ui_bench_cpu_time();
+    ui_bench_sleep(idle_ms);
+    double cpu_idle   = ui_bench_cpu_time() - cpu_before;
+    size_t idle_frames = bench.ui.frames_number - frames;
+
+    akinator_ui_event_t keys[] = {{.type = UI_EVENT_KEY, .position = {}, .key = UI_KEY_DOWN},
+                                  {.type = UI_EVENT_KEY, .position = {}, .key = UI_KEY_UP},
+                                  {.type = UI_EVENT_KEY, .position = {}, .key = '2'}};
+    for(size_t key = 0; key < sizeof(keys) / sizeof(keys[0]); key++) {
+        akinator_ui_post_event(&bench.ui, &keys[key]);
+    }
+    pthread_join(thread, NULL);
+
+    color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                 "Chosen %zu, %zu pixels a frame of %d on screen, idle for %zu ms: %.3f ms of cpu, %zu frames.\n",
+                 bench.chosen,
+                 (bench.ui.frames_number == 0) ? 0 : bench.ui.drawn_pixels / bench.ui.frames_number,
+                 UiBenchWidth * UiBenchHeight,
+                 idle_ms,
+                 cpu_idle * 1e3,
+                 idle_frames);
+    if(argc > 3) {
+        akinator_ui_write_ppm(&bench.ui, argv[3]);
+    }
+    akinator_ui_dtor(&bench.ui);
+    return (bench.error == AKINATOR_SUCCESS && bench.chosen == 1) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void *ui_bench_run(void *argument) {
+    ui_bench_t *bench = (ui_bench_t *)argument;
+    bench->error = akinator_ui_run_menu(&bench->ui, &bench->menu, &bench->chosen);
+    return NULL;
+}
+
+double ui_bench_cpu_time(void) {
+    struct timespec time = {};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+    return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+void ui_bench_sleep(size_t milliseconds) {
+    struct timespec time = {.tv_sec  = (time_t)(milliseconds / 1000),
+                            .tv_nsec = (long)(milliseconds % 1000) * 1000000};
+    nanosleep(&time, NULL);
+}
@@ -0,0 +1,211 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "akinator_beam.h"
+#include "akinator_utils.h"
+#include "custom_assert.h"
+#include "colors.h"
+
+static const double BeamDominance     = 0.8;
+static const double OutsideLikelihood = 0.5;
+static const double ChildPrior        = 0.5;
+
+static akinator_error_t akinator_beam_yes_likelihood (akinator_answer_t      answer,
+                                                      double                *likelihood);
+
+static akinator_error_t akinator_beam_normalize      (akinator_beam_entry_t *entries,
+                                                      size_t                 size);
+
+static int              akinator_beam_compare        (const void            *first,
+                                                      const void            *second);
+
+akinator_error_t akinator_beam_ctor(akinator_beam_t *beam, size_t width) {
+    _C_ASSERT(beam  != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(width != 0   , return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    beam->width    = width;
+    beam->frontier = (akinator_beam_entry_t *)calloc(width + 1, sizeof(beam->frontier[0]));
+    beam->scratch  = (akinator_beam_entry_t *)calloc(width + 1, sizeof(beam->scratch [0]));
+    if(beam->frontier == NULL || beam->scratch == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while allocating beam frontier.\n");
+        akinator_beam_dtor(beam);
+        return AKINATOR_BEAM_ALLOCATION_ERROR;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_beam_reset(akinator_beam_t *beam, akinator_node_t *root) {
+    _C_ASSERT(beam != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(root != NULL, return AKINATOR_NULL_ROOT              );
+
+    beam->frontier[0].node   = root;
+    beam->frontier[0].weight = 1;
+    beam->frontier_size      = 1;
+    beam->current_question   = beam->width;
+    beam->current_guess      = NULL;
+    beam->questions_asked    = 0;
+    beam->steps_number       = 0;
+    beam->steps_time         = 0;
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_beam_next_question(akinator_beam_t   *beam,
+                                             akinator_node_t  **question) {
+    _C_ASSERT(beam     != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(question != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    clock_t start = clock();
+    *question = NULL;
+    beam->current_question = beam->width;
+    if(beam->frontier_size == 0) {
+        return AKINATOR_SUCCESS;
+    }
+    if(is_leaf(beam->frontier[0].node) && beam->frontier[0].weight >= BeamDominance) {
+        return AKINATOR_SUCCESS;
+    }
+
+    //frontier is kept sorted, so the first subtree is the heaviest one
+    for(size_t index = 0; index < beam->frontier_size; index++) {
+        if(!is_leaf(beam->frontier[index].node)) {
+            beam->current_question = index;
+            *question = beam->frontier[index].node;
+            break;
+        }
+    }
+
+    beam->steps_time += clock() - start;
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_beam_answer(akinator_beam_t   *beam,
+                                      akinator_answer_t  answer) {
+    _C_ASSERT(beam                   != NULL       , return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(beam->current_question <  beam->width, return AKINATOR_NODE_NULL             );
+
+    clock_t start = clock();
+    double yes_likelihood = 0;
+    RETURN_IF_ERROR(akinator_beam_yes_likelihood(answer, &yes_likelihood));
+
+    akinator_beam_entry_t asked        = beam->frontier[beam->current_question];
+    size_t                scratch_size = 0;
+    //objects outside of the asked subtree answer it at random
+    for(size_t index = 0; index < beam->frontier_size; index++) {
+        if(index != beam->current_question) {
+            beam->scratch[scratch_size].node   = beam->frontier[index].node;
+            beam->scratch[scratch_size].weight = beam->frontier[index].weight * OutsideLikelihood;
+            scratch_size++;
+        }
+    }
+    //an object of the asked subtree is in either child with equal prior, so the subtree
+    //keeps the same share as the outside entries when the answer carries no evidence
+    beam->scratch[scratch_size++] = {.node   = asked.node->yes,
+                                     .weight = ChildPrior * asked.weight * yes_likelihood};
+    beam->scratch[scratch_size++] = {.node   = asked.node->no,
+                                     .weight = ChildPrior * asked.weight * (1 - yes_likelihood)};
+
+    qsort(beam->scratch, scratch_size, sizeof(beam->scratch[0]), akinator_beam_compare);
+    if(scratch_size > beam->width) {
+        scratch_size = beam->width;
+    }
+    RETURN_IF_ERROR(akinator_beam_normalize(beam->scratch, scratch_size));
+
+    akinator_beam_entry_t *old_frontier = beam->frontier;
+    beam->frontier         = beam->scratch;
+    beam->scratch          = old_frontier;
+    beam->frontier_size    = scratch_size;
+    beam->current_question = beam->width;
+    beam->questions_asked++;
+    beam->steps_number++;
+    beam->steps_time += clock() - start;
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_beam_get_guess(akinator_beam_t   *beam,
+                                         akinator_node_t  **object) {
+    _C_ASSERT(beam   != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(object != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    if(beam->frontier_size == 0 || !is_leaf(beam->frontier[0].node)) {
+        *object = NULL;
+        return AKINATOR_NODE_NULL;
+    }
+
+    beam->current_guess = beam->frontier[0].node;
+    *object = beam->current_guess;
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_beam_reject_guess(akinator_beam_t *beam) {
+    _C_ASSERT(beam                != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(beam->current_guess != NULL, return AKINATOR_NODE_NULL             );
+
+    memmove(beam->frontier, beam->frontier + 1,
+            (beam->frontier_size - 1) * sizeof(beam->frontier[0]));
+    beam->frontier_size--;
+    beam->current_guess = NULL;
+    return akinator_beam_normalize(beam->frontier, beam->frontier_size);
+}
+
+akinator_error_t akinator_beam_dtor(akinator_beam_t *beam) {
+    _C_ASSERT(beam != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    free(beam->frontier);
+    free(beam->scratch);
+    memset(beam, 0, sizeof(*beam));
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_beam_yes_likelihood(akinator_answer_t answer, double *likelihood) {
+    switch(answer) {
+        case AKINATOR_ANSWER_YES: {
+            *likelihood = 0.95;
+            return AKINATOR_SUCCESS;
+        }
+        case AKINATOR_ANSWER_PROBABLY: {
+            *likelihood = 0.75;
+            return AKINATOR_SUCCESS;
+        }
+        case AKINATOR_ANSWER_UNKNOWN: {
+            *likelihood = 0.5;
+            return AKINATOR_SUCCESS;
+        }
+        case AKINATOR_ANSWER_PROBABLY_NOT: {
+            *likelihood = 0.25;
+            return AKINATOR_SUCCESS;
+        }
+        case AKINATOR_ANSWER_NO: {
+            *likelihood = 0.05;
+            return AKINATOR_SUCCESS;
+        }
+        default: {
+            return AKINATOR_USER_ANSWER_ERROR;
+        }
+    }
+}
+
+akinator_error_t akinator_beam_normalize(akinator_beam_entry_t *entries, size_t size) {
+    double sum = 0;
+    for(size_t index = 0; index < size; index++) {
+        sum += entries[index].weight;
+    }
+    if(sum <= 0) {
+        return AKINATOR_SUCCESS;
+    }
+    for(size_t index = 0; index < size; index++) {
+        entries[index].weight /= sum;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+int akinator_beam_compare(const void *first, const void *second) {
+    double first_weight  = ((const akinator_beam_entry_t *)first )->weight;
+    double second_weight = ((const akinator_beam_entry_t *)second)->weight;
+    if(first_weight > second_weight) {
+        return -1;
+    }
+    if(first_weight < second_weight) {
+        return 1;
+    }
+    return 0;
+}
@@ -1,51 +1,153 @@
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
 #include "colors.h"
 #include "akinator_dump.h"
+#include "akinator_encoding.h"
+#include "akinator_layout.h"
 #include "akinator_utils.h"
 #include "custom_assert.h"
 
 static const size_t      MaxFilenameSize     = 128;
+static const size_t      MaxDumpLineSize     = 1024;
+static const size_t      MaxDumpCommandSize  = 32 + DumpBatchCapacity * (MaxFilenameSize + 3);
+static const size_t      MinPendingCapacity  = 64;
 static const char *const GeneralDumpFilename = "logs/akin.html";
+static const char *const IndexTempFilename   = "logs/akin.html.tmp";
+static const char *const PagePrefix          = "akin_";
+static const char *const DumpPrefix          = "dump";
 static const char *const LogsFolder           = "logs";
 static const char *const DotUtf8Folder       = "dot_utf8";
-static const char *const DotCp1251Folder     = "dot_cp1251";
 static const char *const ImgFolder            = "img";
 static const char *const RootColor            = "#b8b8ff";
 static const char *const NodeColor            = "#ffeedd";
 static const char *const LeafColor            = "#ffd8be";
 static const char *const DumpBackground       = "#ced4da";
+static const int32_t     SvgCharWidth         = 7;
+static const int32_t     SvgMinNodeWidth      = 80;
+static const int32_t     SvgRowHeight         = 20;
+static const int32_t     SvgNodeGap           = 16;
+static const int32_t     SvgLevelGap          = 40;
+static const int32_t     SvgMargin            = 20;
+static const size_t      MaxEscapedSize       = 6 * MaxQuestionSize + 1;
+static const char        SvgSpecialSymbols[]  = "&<>\"";
+static const char *const SvgEscapes[]         = {"&amp;", "&lt;", "&gt;", "&quot;"};
 
 struct dump_filenames_t {
-    char dot_cp1251[MaxFilenameSize] = {};
-    char dot_utf8  [MaxFilenameSize] = {};
-    char img       [MaxFilenameSize] = {};
+    char dot_utf8[MaxFilenameSize] = {};
+    char img     [MaxFilenameSize] = {};
+};
+
+enum dump_kind_t {
+    DUMP_KIND_FULL      = 0,
+    DUMP_KIND_PARTIAL   = 1,
+    DUMP_KIND_UNCHANGED = 2,
+};
+
+//render is the whole job for a full dump and an owned copy of the changed subtree for
+//a partial one, image is the dump whose picture the page shows, page is the number
+//of the page the dump goes to
+struct dump_plan_t {
+    dump_kind_t         kind;
+    size_t              page;
+    akinator_dump_job_t render;
+    size_t              image;
+    size_t              full_image;
+    size_t              changed_level;
 };
 
-static akinator_error_t akinator_create_dot_cp1251_dump (dump_filenames_t *filenames,
-                                                         akinator_t       *akinator);
+static akinator_error_t akinator_dump_snapshot          (akinator_dump_t     *dumper,
+                                                         akinator_t          *akinator,
+                                                         akinator_dump_job_t *job);
+
+static akinator_error_t akinator_dump_post              (akinator_dump_t     *dumper,
+                                                         akinator_dump_job_t *job);
+
+static void            *akinator_dump_worker            (void                *argument);
+
+static akinator_error_t akinator_process_batch          (akinator_dump_t     *dumper,
+                                                         akinator_dump_job_t *batch,
+                                                         size_t               batch_size);
+
+static akinator_error_t akinator_dump_plan              (akinator_dump_t     *dumper,
+                                                         akinator_dump_job_t *job,
+                                                         akinator_dump_job_t *previous,
+                                                         dump_plan_t         *plan);
+
+static akinator_error_t akinator_dump_hash              (akinator_dump_job_t *job);
+
+static size_t           akinator_dump_find_change       (akinator_dump_job_t *job,
+                                                         akinator_dump_job_t *previous);
+
+static akinator_error_t akinator_dump_subtree           (akinator_dump_job_t *job,
+                                                         size_t               root,
+                                                         akinator_dump_job_t *subtree);
+
+static void             akinator_dump_job_free          (akinator_dump_job_t *job);
+
+static akinator_error_t akinator_render_batch           (akinator_dump_t     *dumper,
+                                                         akinator_dump_job_t *batch,
+                                                         size_t               batch_size);
+
+static akinator_error_t akinator_render_batch_native    (akinator_dump_t     *dumper,
+                                                         akinator_dump_job_t *batch,
+                                                         size_t               batch_size);
+
+static akinator_error_t akinator_render_batch_graphviz  (akinator_dump_t     *dumper,
+                                                         akinator_dump_job_t *batch,
+                                                         size_t               batch_size);
 
-static akinator_error_t akinator_create_img_dump        (dump_filenames_t *filenames);
+static akinator_error_t akinator_create_svg_dump        (dump_filenames_t    *filenames,
+                                                         akinator_dump_job_t *job);
 
-static akinator_error_t akinator_add_general_dump       (const char       *filename_img,
-                                                         akinator_t       *akinator,
-                                                         const char       *caller_file,
-                                                         size_t            caller_line,
-                                                         const char       *caller_func);
+static akinator_error_t akinator_svg_escape             (const char          *text,
+                                                         char                *escaped,
+                                                         size_t               escaped_size);
 
-static akinator_error_t akinator_dot_dump_write_header  (FILE             *dot_file);
+static akinator_error_t akinator_create_dot_dump        (dump_filenames_t    *filenames,
+                                                         akinator_dump_job_t *job);
 
-static akinator_error_t akinator_dump_node              (akinator_t       *akinator,
-                                                         akinator_node_t  *node,
-                                                         FILE             *dot_file,
-                                                         size_t            level);
+static akinator_error_t akinator_add_general_dump       (akinator_dump_t     *dumper,
+                                                         akinator_dump_job_t *job,
+                                                         dump_plan_t         *plan);
 
-static akinator_error_t akinator_dot_dump_write_footer  (FILE             *dot_file);
+static akinator_error_t akinator_dump_open_page         (akinator_dump_t     *dumper,
+                                                         size_t               number,
+                                                         size_t               first_dump);
 
-static akinator_error_t akinator_get_node_color         (akinator_t       *akinator,
-                                                         akinator_node_t  *node,
-                                                         const char      **color);
+static akinator_error_t akinator_dump_close_page        (akinator_dump_t     *dumper,
+                                                         bool                 has_next);
 
-static akinator_error_t akinator_dump_filenames_init    (akinator_t       *akinator,
-                                                         dump_filenames_t *filenames);
+static void             akinator_dump_remove_page       (akinator_dump_t     *dumper);
+
+static akinator_error_t akinator_dump_write_index       (akinator_dump_t     *dumper);
+
+static void             akinator_dump_remove_old_files  (void);
+
+static size_t           akinator_dump_file_size         (const char          *filename);
+
+static akinator_error_t akinator_dot_dump_write_header  (FILE                *dot_file);
+
+static akinator_error_t akinator_dump_node              (akinator_dump_job_t *job,
+                                                         size_t               index,
+                                                         FILE                *dot_file);
+
+static akinator_error_t akinator_dot_dump_write_footer  (FILE                *dot_file);
+
+static akinator_error_t akinator_dump_utf8_printf       (FILE                *dot_file,
+                                                         const char          *format, ...);
+
+static akinator_error_t akinator_get_node_color         (akinator_dump_job_t *job,
+                                                         size_t               index,
+                                                         const char         **color);
+
+static akinator_error_t akinator_dump_filenames_init    (size_t               number,
+                                                         dump_filenames_t    *filenames);
+
+static uint64_t         akinator_dump_mix               (uint64_t             value);
 
 akinator_error_t akinator_dump(akinator_t *akinator,
                                const char *caller_file,
@@ -55,38 +157,484 @@ akinator_error_t akinator_dump(akinator_t *akinator,
     _C_ASSERT(caller_file != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
     _C_ASSERT(caller_func != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
 
-    dump_filenames_t filenames = {};
-    akinator_error_t error_code = AKINATOR_SUCCESS;
+    akinator_trace_text(akinator->trace, TRACE_EVENT_DUMP, caller_line, 0, caller_file, caller_func);
+    if(akinator->dumper == NULL) {
+        return AKINATOR_SUCCESS;
+    }
+
+    uint64_t            start      = get_time_ns();
+    akinator_dump_job_t job        = {.number      = akinator->dumps_number,
+                                      .caller_file = caller_file,
+                                      .caller_line = caller_line,
+                                      .caller_func = caller_func};
+    akinator_error_t    error_code = AKINATOR_SUCCESS;
 
-    if((error_code = akinator_dump_filenames_init(akinator,
-                                                  &filenames)) != AKINATOR_SUCCESS) {
+    if((error_code = akinator_dump_snapshot(akinator->dumper,
+                                            akinator,
+                                            &job)) != AKINATOR_SUCCESS) {
         return error_code;
     }
-    if((error_code = akinator_create_dot_cp1251_dump(&filenames,
-                                                     akinator)) != AKINATOR_SUCCESS) {
+    if((error_code = akinator_dump_post(akinator->dumper,
+                                        &job)) != AKINATOR_SUCCESS) {
         return error_code;
     }
-    if((error_code = akinator_create_img_dump(&filenames)) != AKINATOR_SUCCESS) {
-        return error_code;
+
+    akinator->dumps_number++;
+    akinator_histogram_add(&akinator->dumper->caller_time, get_time_ns() - start);
+    return AKINATOR_SUCCESS;
+}
+
+//breadth first, entries array is the queue itself, pending keeps the tree node of
+//every entry until its children are appended and is reused between dumps
+akinator_error_t akinator_dump_snapshot(akinator_dump_t     *dumper,
+                                        akinator_t          *akinator,
+                                        akinator_dump_job_t *job) {
+    _C_ASSERT(dumper   != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER           );
+    _C_ASSERT(job      != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    size_t capacity = dumper->pending_capacity;
+    job->entries    = (akinator_dump_entry_t *)calloc(capacity, sizeof(*job->entries));
+    if(job->entries == NULL) {
+        return AKINATOR_DUMP_WORKER_ERROR;
+    }
+    dumper->pending[0]  = akinator->root;
+    job->entries[0]     = {.question = akinator->root->question, .yes = DumpNoChild, .no = DumpNoChild, .level = 0};
+    job->entries_number = 1;
+
+    for(size_t index = 0; index < job->entries_number; index++) {
+        akinator_node_t *node = dumper->pending[index];
+        if(is_leaf(node)) {
+            continue;
+        }
+        if(job->entries_number + 2 > capacity) {
+            capacity *= 2;
+            akinator_dump_entry_t *entries = (akinator_dump_entry_t *)realloc(job->entries, capacity * sizeof(*entries));
+            akinator_node_t      **pending = (akinator_node_t      **)realloc(dumper->pending, capacity * sizeof(*pending));
+            if(entries != NULL) {
+                job->entries = entries;
+            }
+            if(pending != NULL) {
+                dumper->pending          = pending;
+                dumper->pending_capacity = capacity;
+            }
+            if(entries == NULL || pending == NULL) {
+                free(job->entries);
+                job->entries = NULL;
+                return AKINATOR_DUMP_WORKER_ERROR;
+            }
+        }
+
+        akinator_node_t *children[] = {node->yes, node->no};
+        size_t           level      = job->entries[index].level + 1;
+        job->entries[index].yes     = job->entries_number;
+        job->entries[index].no      = job->entries_number + 1;
+        for(size_t child = 0; child < 2; child++) {
+            dumper->pending[job->entries_number] = children[child];
+            job->entries   [job->entries_number] = {.question = children[child]->question,
+                                                    .yes      = DumpNoChild,
+                                                    .no       = DumpNoChild,
+                                                    .level    = level};
+            job->entries_number++;
+        }
+    }
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_dump_post(akinator_dump_t     *dumper,
+                                    akinator_dump_job_t *job) {
+    _C_ASSERT(dumper != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(job    != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    pthread_mutex_lock(&dumper->lock);
+    if(dumper->queue_size == DumpQueueCapacity) {
+        dumper->waits_number++;
+    }
+    while(dumper->queue_size == DumpQueueCapacity && dumper->error == AKINATOR_SUCCESS) {
+        pthread_cond_wait(&dumper->changed, &dumper->lock);
+    }
+    akinator_error_t error_code = dumper->error;
+    if(error_code == AKINATOR_SUCCESS) {
+        dumper->queue[(dumper->queue_head + dumper->queue_size) % DumpQueueCapacity] = *job;
+        dumper->queue_size++;
+        pthread_cond_broadcast(&dumper->changed);
+    }
+    pthread_mutex_unlock(&dumper->lock);
+
+    if(error_code != AKINATOR_SUCCESS) {
+        free(job->entries);
+        job->entries = NULL;
+    }
+    return error_code;
+}
+
+//takes everything queued up to a batch at once, dumps posted while dot runs make
+//the next batch
+void *akinator_dump_worker(void *argument) {
+    akinator_dump_t     *dumper                   = (akinator_dump_t *)argument;
+    akinator_dump_job_t  batch[DumpBatchCapacity] = {};
+
+    pthread_mutex_lock(&dumper->lock);
+    while(dumper->error == AKINATOR_SUCCESS) {
+        while(dumper->queue_size == 0 && !dumper->stop) {
+            pthread_cond_wait(&dumper->changed, &dumper->lock);
+        }
+        if(dumper->queue_size == 0) {
+            break;
+        }
+
+        size_t batch_size = 0;
+        while(dumper->queue_size != 0 && batch_size < DumpBatchCapacity) {
+            batch[batch_size++] = dumper->queue[dumper->queue_head];
+            dumper->queue_head  = (dumper->queue_head + 1) % DumpQueueCapacity;
+            dumper->queue_size--;
+        }
+        dumper->busy = true;
+        pthread_cond_broadcast(&dumper->changed);
+        pthread_mutex_unlock(&dumper->lock);
+
+        uint64_t         start      = get_time_ns();
+        akinator_error_t error_code = akinator_process_batch(dumper, batch, batch_size);
+        uint64_t         spent      = get_time_ns() - start;
+
+        pthread_mutex_lock(&dumper->lock);
+        dumper->render_ns += spent;
+        dumper->batches_number++;
+        dumper->error      = error_code;
+        dumper->busy       = false;
+        pthread_cond_broadcast(&dumper->changed);
+    }
+    pthread_mutex_unlock(&dumper->lock);
+    return NULL;
+}
+
+//plans every dump against the one before it, renders what the plans ask for in one go
+//and writes the page, the last dump of the batch is kept to compare the next one with
+akinator_error_t akinator_process_batch(akinator_dump_t     *dumper,
+                                        akinator_dump_job_t *batch,
+                                        size_t               batch_size) {
+    _C_ASSERT(dumper != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(batch  != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    dump_plan_t         plans  [DumpBatchCapacity] = {};
+    akinator_dump_job_t renders[DumpBatchCapacity] = {};
+    size_t              renders_number             = 0;
+    size_t              planned                    = 0;
+    akinator_error_t    error_code                 = AKINATOR_SUCCESS;
+    for(; planned < batch_size && error_code == AKINATOR_SUCCESS; planned++) {
+        akinator_dump_job_t *previous = (planned == 0) ? &dumper->previous : &batch[planned - 1];
+        error_code = akinator_dump_plan(dumper, &batch[planned], previous, &plans[planned]);
+        if(error_code == AKINATOR_SUCCESS && plans[planned].kind != DUMP_KIND_UNCHANGED) {
+            renders[renders_number++] = plans[planned].render;
+        }
+    }
+    if(error_code == AKINATOR_SUCCESS) {
+        error_code = akinator_render_batch(dumper, renders, renders_number);
+    }
+    for(size_t job = 0; job < batch_size && error_code == AKINATOR_SUCCESS; job++) {
+        error_code = akinator_add_general_dump(dumper, &batch[job], &plans[job]);
     }
-    if((error_code = akinator_add_general_dump(filenames.img,
-                                               akinator,
-                                               caller_file,
-                                               caller_line,
-                                               caller_func)) != AKINATOR_SUCCESS) {
+
+    pthread_mutex_lock(&dumper->lock);
+    for(size_t job = 0; job < planned; job++) {
+        switch(plans[job].kind) {
+            case DUMP_KIND_FULL: {
+                dumper->full_number++;
+                break;
+            }
+            case DUMP_KIND_PARTIAL: {
+                dumper->partial_number++;
+                free(plans[job].render.entries);
+                break;
+            }
+            case DUMP_KIND_UNCHANGED: {
+                dumper->unchanged_number++;
+                break;
+            }
+            default: {
+                break;
+            }
+        }
+    }
+    for(size_t render = 0; render < renders_number; render++) {
+        dumper->rendered_nodes += renders[render].entries_number;
+    }
+    pthread_mutex_unlock(&dumper->lock);
+
+    akinator_dump_job_free(&dumper->previous);
+    dumper->previous = batch[batch_size - 1];
+    for(size_t job = 0; job + 1 < batch_size; job++) {
+        akinator_dump_job_free(&batch[job]);
+    }
+    return error_code;
+}
+
+akinator_error_t akinator_dump_plan(akinator_dump_t     *dumper,
+                                    akinator_dump_job_t *job,
+                                    akinator_dump_job_t *previous,
+                                    dump_plan_t         *plan) {
+    _C_ASSERT(dumper   != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(job      != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(previous != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(plan     != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    akinator_error_t error_code = AKINATOR_SUCCESS;
+    if((error_code = akinator_dump_hash(job)) != AKINATOR_SUCCESS) {
         return error_code;
     }
 
-    akinator->dumps_number++;
+    //page bytes are only known for batches already written, so a page may pass its
+    //limit by up to one batch
+    bool new_page = (dumper->planned_pages == 0                ||
+                     dumper->page_dumps    >= DumpPageMaxDumps ||
+                     dumper->page_bytes    >= DumpPageMaxBytes);
+    if(new_page) {
+        dumper->planned_pages++;
+        dumper->page_dumps = 0;
+        dumper->page_bytes = 0;
+    }
+    dumper->page_dumps++;
+
+    plan->kind   = DUMP_KIND_FULL;
+    plan->page   = dumper->planned_pages - 1;
+    plan->render = *job;
+    bool compared = (!new_page && previous->hashes != NULL);
+    if(compared && previous->hashes[0] == job->hashes[0]) {
+        plan->kind = DUMP_KIND_UNCHANGED;
+    }
+    else if(compared) {
+        size_t changed = akinator_dump_find_change(job, previous);
+        if((error_code = akinator_dump_subtree(job, changed, &plan->render)) != AKINATOR_SUCCESS) {
+            return error_code;
+        }
+        if(2 * plan->render.entries_number < job->entries_number) {
+            plan->kind          = DUMP_KIND_PARTIAL;
+            plan->changed_level = job->entries[changed].level;
+        }
+        else {
+            free(plan->render.entries);
+            plan->render = *job;
+        }
+    }
+
+    switch(plan->kind) {
+        case DUMP_KIND_FULL: {
+            dumper->full_image  = job->number;
+            dumper->shown_image = job->number;
+            break;
+        }
+        case DUMP_KIND_PARTIAL: {
+            dumper->shown_image = job->number;
+            break;
+        }
+        case DUMP_KIND_UNCHANGED: {
+            break;
+        }
+        default: {
+            return AKINATOR_DUMP_WORKER_ERROR;
+        }
+    }
+    plan->image      = dumper->shown_image;
+    plan->full_image = dumper->full_image;
+    return AKINATOR_SUCCESS;
+}
+
+//children come after parents in the snapshot, so one backward pass hashes every subtree
+//question pointers stand for their text, a published question is never rewritten and
+//a renamed node gets new storage
+akinator_error_t akinator_dump_hash(akinator_dump_job_t *job) {
+    _C_ASSERT(job != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    job->hashes = (uint64_t *)calloc(job->entries_number, sizeof(*job->hashes));
+    if(job->hashes == NULL) {
+        return AKINATOR_DUMP_WORKER_ERROR;
+    }
+    for(size_t index = job->entries_number; index-- > 0;) {
+        akinator_dump_entry_t *entry = &job->entries[index];
+        uint64_t               hash  = akinator_dump_mix((uint64_t)(uintptr_t)entry->question);
+        if(entry->yes != DumpNoChild) {
+            hash = akinator_dump_mix(hash ^ job->hashes[entry->yes]);
+            hash = akinator_dump_mix(hash + job->hashes[entry->no]);
+        }
+        job->hashes[index] = hash;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+//both snapshots go down together while only one child differs, the node where that
+//stops is the smallest subtree holding every change
+size_t akinator_dump_find_change(akinator_dump_job_t *job,
+                                 akinator_dump_job_t *previous) {
+    size_t index          = 0;
+    size_t previous_index = 0;
+    while(true) {
+        akinator_dump_entry_t *entry          = &job->entries[index];
+        akinator_dump_entry_t *previous_entry = &previous->entries[previous_index];
+        if(entry->question != previous_entry->question ||
+           entry->yes == DumpNoChild || previous_entry->yes == DumpNoChild) {
+            return index;
+        }
+        bool yes_changed = (job->hashes[entry->yes] != previous->hashes[previous_entry->yes]);
+        bool no_changed  = (job->hashes[entry->no]  != previous->hashes[previous_entry->no]);
+        if(yes_changed == no_changed) {
+            return index;
+        }
+        index          = yes_changed ? entry->yes          : entry->no;
+        previous_index = yes_changed ? previous_entry->yes : previous_entry->no;
+    }
+}
+
+//breadth first order of a subtree is the order its entries appear in the snapshot
+//when walked from its root, so children get consecutive indices again
+akinator_error_t akinator_dump_subtree(akinator_dump_job_t *job,
+                                       size_t               root,
+                                       akinator_dump_job_t *subtree) {
+    _C_ASSERT(job     != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(subtree != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    size_t *order = (size_t *)calloc(job->entries_number, sizeof(*order));
+    if(order == NULL) {
+        return AKINATOR_DUMP_WORKER_ERROR;
+    }
+    size_t order_size = 1;
+    order[0]          = root;
+    for(size_t position = 0; position < order_size; position++) {
+        akinator_dump_entry_t *entry = &job->entries[order[position]];
+        if(entry->yes != DumpNoChild) {
+            order[order_size++] = entry->yes;
+            order[order_size++] = entry->no;
+        }
+    }
+
+    *subtree         = *job;
+    subtree->hashes  = NULL;
+    subtree->entries = (akinator_dump_entry_t *)calloc(order_size, sizeof(*subtree->entries));
+    if(subtree->entries == NULL) {
+        free(order);
+        return AKINATOR_DUMP_WORKER_ERROR;
+    }
+    subtree->entries_number = order_size;
+    size_t next             = 1;
+    for(size_t position = 0; position < order_size; position++) {
+        akinator_dump_entry_t *entry = &job->entries[order[position]];
+        subtree->entries[position]       = *entry;
+        subtree->entries[position].level = entry->level - job->entries[root].level;
+        if(entry->yes != DumpNoChild) {
+            subtree->entries[position].yes = next;
+            subtree->entries[position].no  = next + 1;
+            next += 2;
+        }
+    }
+    free(order);
+    return AKINATOR_SUCCESS;
+}
+
+void akinator_dump_job_free(akinator_dump_job_t *job) {
+    free(job->entries);
+    free(job->hashes);
+    job->entries = NULL;
+    job->hashes  = NULL;
+}
+
+akinator_error_t akinator_render_batch(akinator_dump_t     *dumper,
+                                       akinator_dump_job_t *batch,
+                                       size_t               batch_size) {
+    _C_ASSERT(dumper != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(batch  != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    switch(dumper->renderer) {
+        case DUMP_RENDERER_NATIVE: {
+            return akinator_render_batch_native(dumper, batch, batch_size);
+        }
+        case DUMP_RENDERER_GRAPHVIZ: {
+            return akinator_render_batch_graphviz(dumper, batch, batch_size);
+        }
+        default: {
+            return AKINATOR_DUMP_WORKER_ERROR;
+        }
+    }
+}
+
+akinator_error_t akinator_render_batch_native(akinator_dump_t     *dumper,
+                                              akinator_dump_job_t *batch,
+                                              size_t               batch_size) {
+    _C_ASSERT(dumper != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(batch  != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    akinator_error_t error_code = AKINATOR_SUCCESS;
+    for(size_t job = 0; job < batch_size; job++) {
+        dump_filenames_t filenames = {};
+        if((error_code = akinator_dump_filenames_init(batch[job].number,
+                                                      &filenames)) != AKINATOR_SUCCESS) {
+            return error_code;
+        }
+        if((error_code = akinator_create_svg_dump(&filenames,
+                                                  &batch[job])) != AKINATOR_SUCCESS) {
+            return error_code;
+        }
+    }
+
+    pthread_mutex_lock(&dumper->lock);
+    dumper->rendered_number += batch_size;
+    pthread_mutex_unlock(&dumper->lock);
     return AKINATOR_SUCCESS;
 }
 
-akinator_error_t akinator_create_dot_cp1251_dump(dump_filenames_t *filenames,
-                                                 akinator_t       *akinator) {
-    _C_ASSERT(akinator  != NULL, return AKINATOR_NULL_POINTER           );
+//dot -O writes <input>.svg next to every input, those are moved where the page links
+akinator_error_t akinator_render_batch_graphviz(akinator_dump_t     *dumper,
+                                                akinator_dump_job_t *batch,
+                                                size_t               batch_size) {
+    _C_ASSERT(dumper != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(batch  != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    dump_filenames_t filenames[DumpBatchCapacity]  = {};
+    char             command  [MaxDumpCommandSize] = "dot -Tsvg -O";
+    size_t           command_size                  = strlen(command);
+    akinator_error_t error_code                    = AKINATOR_SUCCESS;
+    for(size_t job = 0; job < batch_size; job++) {
+        if((error_code = akinator_dump_filenames_init(batch[job].number,
+                                                      &filenames[job])) != AKINATOR_SUCCESS) {
+            return error_code;
+        }
+        if((error_code = akinator_create_dot_dump(&filenames[job],
+                                                  &batch[job])) != AKINATOR_SUCCESS) {
+            return error_code;
+        }
+        command_size += (size_t)snprintf(command + command_size, sizeof(command) - command_size,
+                                         " \"%s\"", filenames[job].dot_utf8);
+    }
+    system(command);
+
+    size_t failed = 0;
+    for(size_t job = 0; job < batch_size; job++) {
+        char rendered[MaxFilenameSize + 8] = {};
+        char img     [MaxFilenameSize * 2] = {};
+        snprintf(rendered, sizeof(rendered), "%s.svg",  filenames[job].dot_utf8);
+        snprintf(img,      sizeof(img),      "%s/%s", LogsFolder, filenames[job].img);
+#ifdef _WIN32
+        //rename does not replace on windows
+        remove(img);
+#endif
+        if(rename(rendered, img) != 0) {
+            failed++;
+        }
+    }
+
+    pthread_mutex_lock(&dumper->lock);
+    dumper->rendered_number += batch_size - failed;
+    dumper->failed_number   += failed;
+    pthread_mutex_unlock(&dumper->lock);
+    return AKINATOR_SUCCESS;
+}
+
+//graphviz reads utf-8, questions and labels are cp1251 and are transcoded line by
+//line on the way into the file
+akinator_error_t akinator_create_dot_dump(dump_filenames_t    *filenames,
+                                          akinator_dump_job_t *job) {
+    _C_ASSERT(job       != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
     _C_ASSERT(filenames != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
 
-    FILE *dot_file = fopen(filenames->dot_cp1251, "w");
+    FILE *dot_file = fopen(filenames->dot_utf8, "wb");
     if(dot_file == NULL) {
         color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
                      "Error while opening dot file.\n");
@@ -103,12 +651,14 @@ akinator_error_t akinator_create_dot_cp1251_dump(dump_filenames_t *filenames,
         dot_file = NULL;
         return AKINATOR_WRITING_DUMP_ERROR;
     }
-    if((error_code = akinator_dump_node(akinator,
-                                        akinator->root,
-                                        dot_file, 0)) != AKINATOR_SUCCESS) {
-        fclose(dot_file);
-        dot_file = NULL;
-        return error_code;
+    for(size_t index = 0; index < job->entries_number; index++) {
+        if((error_code = akinator_dump_node(job,
+                                            index,
+                                            dot_file)) != AKINATOR_SUCCESS) {
+            fclose(dot_file);
+            dot_file = NULL;
+            return error_code;
+        }
     }
 
     if(fputs("}\n", dot_file) < 0) {
@@ -127,6 +677,133 @@ akinator_error_t akinator_create_dot_cp1251_dump(dump_filenames_t *filenames,
     return AKINATOR_SUCCESS;
 }
 
+//boxes look like the dot records, question over a yes | no row, every box is as wide
+//as the longest question so the layout can use one separation for the whole tree,
+//box and row divider are one symbol filled from the class of each use
+akinator_error_t akinator_create_svg_dump(dump_filenames_t    *filenames,
+                                          akinator_dump_job_t *job) {
+    _C_ASSERT(job       != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(filenames != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    akinator_layout_t layout     = {};
+    akinator_error_t  error_code = AKINATOR_SUCCESS;
+    if((error_code = akinator_layout_ctor(&layout, job)) != AKINATOR_SUCCESS) {
+        return error_code;
+    }
+
+    size_t longest = 0;
+    for(size_t index = 0; index < job->entries_number; index++) {
+        size_t length = strlen(job->entries[index].question);
+        if(length > longest) {
+            longest = length;
+        }
+    }
+    if(longest > MaxQuestionSize) {
+        longest = MaxQuestionSize;
+    }
+    int32_t node_width = (int32_t)longest * SvgCharWidth + SvgNodeGap;
+    if(node_width < SvgMinNodeWidth) {
+        node_width = SvgMinNodeWidth;
+    }
+    int32_t half_step    = (node_width + SvgNodeGap) / LayoutMinSeparation;
+    int32_t level_height = 2 * SvgRowHeight + SvgLevelGap;
+    int32_t width        = 2 * SvgMargin + node_width + layout.width * half_step;
+    int32_t height       = 2 * SvgMargin + (int32_t)(layout.depth + 1) * level_height - SvgLevelGap;
+
+    char img[MaxFilenameSize * 2] = {};
+    snprintf(img, sizeof(img), "%s/%s", LogsFolder, filenames->img);
+    FILE *svg_file = fopen(img, "wb");
+    if(svg_file == NULL) {
+        akinator_layout_dtor(&layout);
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while opening svg file.\n");
+        return AKINATOR_DOT_FILE_OPENING_ERROR;
+    }
+
+    if((error_code = akinator_dump_utf8_printf(svg_file,
+                                               "<svg xmlns=\"http://www.w3.org/2000/svg\" "
+                                               "xmlns:xlink=\"http://www.w3.org/1999/xlink\" "
+                                               "width=\"%d\" height=\"%d\" style=\"background:%s\">\n"
+                                               "<style>use{stroke:#000}path{stroke:#000;fill:none}"
+                                               "text{font:12px sans-serif;text-anchor:middle}"
+                                               ".r{fill:%s}.n{fill:%s}.l{fill:%s}</style>\n"
+                                               "<defs><g id=\"b\"><rect width=\"%d\" height=\"%d\" rx=\"10\"/>"
+                                               "<path d=\"M0 %dH%dM%d %dV%d\"/>"
+                                               "<text x=\"%d\" y=\"%d\" fill=\"#000\">ДА</text>"
+                                               "<text x=\"%d\" y=\"%d\" fill=\"#000\">НЕТ</text></g></defs>\n",
+                                               width, height, DumpBackground,
+                                               RootColor, NodeColor, LeafColor,
+                                               node_width, 2 * SvgRowHeight,
+                                               SvgRowHeight, node_width, node_width / 2, SvgRowHeight, 2 * SvgRowHeight,
+                                               node_width / 4,     2 * SvgRowHeight - 6,
+                                               node_width * 3 / 4, 2 * SvgRowHeight - 6)) != AKINATOR_SUCCESS) {
+        fclose(svg_file);
+        akinator_layout_dtor(&layout);
+        return error_code;
+    }
+
+    for(size_t index = 0; index < job->entries_number && error_code == AKINATOR_SUCCESS; index++) {
+        akinator_dump_entry_t *entry                   = &job->entries[index];
+        char                   escaped[MaxEscapedSize] = {};
+        int32_t                left                    = SvgMargin + layout.x[index] * half_step;
+        int32_t                top                     = SvgMargin + (int32_t)entry->level * level_height;
+        const char            *color_class             = (index == 0) ? "r" : (entry->yes == DumpNoChild) ? "l" : "n";
+        if((error_code = akinator_svg_escape(entry->question, escaped, sizeof(escaped))) != AKINATOR_SUCCESS) {
+            break;
+        }
+        error_code = akinator_dump_utf8_printf(svg_file,
+                                               "<use xlink:href=\"#b\" class=\"%s\" x=\"%d\" y=\"%d\"/>"
+                                               "<text x=\"%d\" y=\"%d\">%s</text>\n",
+                                               color_class, left, top,
+                                               left + node_width / 2, top + SvgRowHeight - 6, escaped);
+        if(error_code != AKINATOR_SUCCESS || entry->yes == DumpNoChild) {
+            continue;
+        }
+        int32_t bottom = top + 2 * SvgRowHeight;
+        if(fprintf(svg_file,
+                   "<path d=\"M%d %dL%d %dM%d %dL%d %d\"/>\n",
+                   left + node_width / 4,     bottom, SvgMargin + layout.x[entry->yes] * half_step + node_width / 2, bottom + SvgLevelGap,
+                   left + node_width * 3 / 4, bottom, SvgMargin + layout.x[entry->no]  * half_step + node_width / 2, bottom + SvgLevelGap) < 0) {
+            error_code = AKINATOR_WRITING_DUMP_ERROR;
+        }
+    }
+    if(error_code == AKINATOR_SUCCESS && fputs("</svg>\n", svg_file) < 0) {
+        error_code = AKINATOR_WRITING_DUMP_ERROR;
+    }
+
+    akinator_layout_dtor(&layout);
+    if(fclose(svg_file) != 0 && error_code == AKINATOR_SUCCESS) {
+        error_code = AKINATOR_WRITING_DUMP_ERROR;
+    }
+    return error_code;
+}
+
+akinator_error_t akinator_svg_escape(const char *text,
+                                     char       *escaped,
+                                     size_t      escaped_size) {
+    _C_ASSERT(text    != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(escaped != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    size_t written = 0;
+    for(const char *symbol = text; *symbol != '\0'; symbol++) {
+        const char *special     = strchr(SvgSpecialSymbols, *symbol);
+        const char *replacement = (special == NULL) ? NULL : SvgEscapes[special - SvgSpecialSymbols];
+        size_t length = (replacement == NULL) ? 1 : strlen(replacement);
+        if(written + length >= escaped_size) {
+            return AKINATOR_WRITING_DUMP_ERROR;
+        }
+        if(replacement == NULL) {
+            escaped[written] = *symbol;
+        }
+        else {
+            memcpy(escaped + written, replacement, length);
+        }
+        written += length;
+    }
+    escaped[written] = '\0';
+    return AKINATOR_SUCCESS;
+}
+
 akinator_error_t akinator_dot_dump_write_header(FILE *dot_file) {
     _C_ASSERT(dot_file != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
 
@@ -144,72 +821,58 @@ akinator_error_t akinator_dot_dump_write_header(FILE *dot_file) {
     return AKINATOR_SUCCESS;
 }
 
-akinator_error_t akinator_dump_node(akinator_t      *akinator,
-                                    akinator_node_t *node,
-                                    FILE            *dot_file,
-                                    size_t           level) {
-    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER           );
-    _C_ASSERT(node     != NULL, return AKINATOR_NODE_NULL              );
-    _C_ASSERT(dot_file != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+akinator_error_t akinator_dump_node(akinator_dump_job_t *job,
+                                    size_t               index,
+                                    FILE                *dot_file) {
+    _C_ASSERT(job      != NULL,                return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(index    <  job->entries_number, return AKINATOR_NODE_NULL              );
+    _C_ASSERT(dot_file != NULL,                return AKINATOR_NULL_FUNCTION_PARAMETER);
 
-    akinator_error_t error_code = AKINATOR_SUCCESS;
-    const char *color = NULL;
-    if((error_code = akinator_get_node_color(akinator,
-                                             node,
+    akinator_dump_entry_t *entry      = &job->entries[index];
+    akinator_error_t       error_code = AKINATOR_SUCCESS;
+    const char            *color      = NULL;
+    if((error_code = akinator_get_node_color(job,
+                                             index,
                                              &color)) != AKINATOR_SUCCESS) {
         return error_code;
     }
-    if(fprintf(dot_file,
-               "node%p[rank = %llu, "
-               "label = \"{ %s | { <yes>  | <no>  } }\", "
-               "fillcolor = \"%s\"];\n",
-               node,
-               level,
-               node->question,
-               color) < 0) {
-        return AKINATOR_WRITING_DUMP_ERROR;
+    if((error_code = akinator_dump_utf8_printf(dot_file,
+                                              "node%zu[rank = %zu, "
+                                              "label = \"{ %s | { <yes> ДА | <no> НЕТ } }\", "
+                                              "fillcolor = \"%s\"];\n",
+                                              index,
+                                              entry->level,
+                                              entry->question,
+                                              color)) != AKINATOR_SUCCESS) {
+        return error_code;
     }
-    if(is_leaf(node)) {
+    if(entry->yes == DumpNoChild) {
         return AKINATOR_SUCCESS;
     }
 
     if(fprintf(dot_file,
-               "node%p -> node%p\n"
-               "node%p -> node%p\n",
-               node,
-               node->yes,
-               node,
-               node->no) < 0) {
+               "node%zu -> node%zu\n"
+               "node%zu -> node%zu\n",
+               index,
+               entry->yes,
+               index,
+               entry->no) < 0) {
         return AKINATOR_WRITING_DUMP_ERROR;
     }
 
-    if((error_code = akinator_dump_node(akinator,
-                                        node->yes,
-                                        dot_file,
-                                        level + 1)) != AKINATOR_SUCCESS) {
-        return error_code;
-    }
-    if((error_code = akinator_dump_node(akinator,
-                                        node->no,
-                                        dot_file,
-                                        level + 1)) != AKINATOR_SUCCESS) {
-        return error_code;
-    }
-
     return AKINATOR_SUCCESS;
 }
 
-akinator_error_t akinator_get_node_color(akinator_t      *akinator,
-                                         akinator_node_t *node,
-                                         const char     **color) {
-    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER           );
-    _C_ASSERT(node     != NULL, return AKINATOR_NODE_NULL              );
-    _C_ASSERT(color    != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+akinator_error_t akinator_get_node_color(akinator_dump_job_t *job,
+                                         size_t               index,
+                                         const char         **color) {
+    _C_ASSERT(job   != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(color != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
 
-    if(akinator->root == node) {
+    if(index == 0) {
         *color = RootColor;
     }
-    else if(is_leaf(node)) {
+    else if(job->entries[index].yes == DumpNoChild) {
         *color = LeafColor;
     }
     else {
@@ -229,71 +892,142 @@ akinator_error_t akinator_dot_dump_write_footer(FILE *dot_file) {
     return AKINATOR_SUCCESS;
 }
 
-akinator_error_t akinator_create_img_dump(dump_filenames_t *filenames) {
-    _C_ASSERT(filenames != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+akinator_error_t akinator_dump_utf8_printf(FILE       *dot_file,
+                                          const char *format, ...) {
+    _C_ASSERT(dot_file != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(format   != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
 
-    akinator_error_t error_code = AKINATOR_SUCCESS;
-    if((error_code = akinator_run_system_command("powershell -command \"Get-Content %s | "
-                                                 "Set-Content -Encoding utf8 %s\"",
-                                                 filenames->dot_cp1251,
-                                                 filenames->dot_utf8)) != AKINATOR_SUCCESS) {
-        return error_code;
-    }
-    FILE *utf8_dot_file = fopen(filenames->dot_utf8, "r+");
-    if(utf8_dot_file == NULL) {
-        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
-                     "Error while opening utf8 dot file.\n");
-        return AKINATOR_DOT_FILE_OPENING_ERROR;
-    }
-    for(size_t symbol = 0; symbol < 3; symbol++) {
-        fputc(' ', utf8_dot_file);
+    char line     [MaxDumpLineSize]                        = {};
+    char utf8_line[MaxDumpLineSize * EncodingMaxUtf8Ratio] = {};
+    va_list args;
+    va_start(args, format);
+    int line_size = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if(line_size < 0 || (size_t)line_size >= sizeof(line)) {
+        return AKINATOR_WRITING_DUMP_ERROR;
     }
-    fclose(utf8_dot_file);
 
-    if((error_code = akinator_run_system_command("dot %s -Tsvg -o %s\\%s",
-                                                 filenames->dot_utf8,
-                                                 LogsFolder,
-                                                 filenames->img)) != AKINATOR_SUCCESS) {
+    size_t utf8_size = 0;
+    akinator_error_t error_code = AKINATOR_SUCCESS;
+    if((error_code = akinator_cp1251_to_utf8(line, (size_t)line_size,
+                                             utf8_line, sizeof(utf8_line),
+                                             &utf8_size)) != AKINATOR_SUCCESS) {
         return error_code;
     }
-
+    if(fwrite(utf8_line, 1, utf8_size, dot_file) != utf8_size) {
+        return AKINATOR_WRITING_DUMP_ERROR;
+    }
     return AKINATOR_SUCCESS;
 }
 
-akinator_error_t akinator_add_general_dump(const char *filename_img,
-                                           akinator_t *akinator,
-                                           const char *caller_file,
-                                           size_t      caller_line,
-                                           const char *caller_func) {
-    _C_ASSERT(filename_img != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
-    _C_ASSERT(akinator     != NULL, return AKINATOR_NULL_POINTER           );
-    _C_ASSERT(caller_file  != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
-    _C_ASSERT(caller_func  != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+akinator_error_t akinator_add_general_dump(akinator_dump_t     *dumper,
+                                           akinator_dump_job_t *job,
+                                           dump_plan_t         *plan) {
+    _C_ASSERT(dumper != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(job    != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(plan   != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
 
-    fprintf(akinator->general_dump,
+    akinator_error_t error_code = AKINATOR_SUCCESS;
+    if(dumper->pages_number == 0 ||
+       dumper->pages[(dumper->pages_head + dumper->pages_number - 1) % DumpMaxPages].number != plan->page) {
+        if((error_code = akinator_dump_open_page(dumper, plan->page, job->number)) != AKINATOR_SUCCESS) {
+            return error_code;
+        }
+    }
+    akinator_dump_page_t *page = &dumper->pages[(dumper->pages_head + dumper->pages_number - 1) % DumpMaxPages];
+
+    dump_filenames_t shown = {};
+    dump_filenames_t full  = {};
+    akinator_dump_filenames_init(plan->image,      &shown);
+    akinator_dump_filenames_init(plan->full_image, &full);
+
+    long page_start = ftell(dumper->page);
+    fprintf(dumper->page,
             "<div style = \"background: %s; border-radius: 25px; padding: 10px; margin: 10px;\">"
-            "<h1>DUMP %llu</h1>"
-            "<h2>called from %s:%llu, caller function: %s</h2>"
-            "<img src = \"%s\">\n"
-            "</div>\n",
+            "<h1>DUMP %zu</h1>"
+            "<h2>called from %s:%zu, caller function: %s</h2>",
             DumpBackground,
-            akinator->dumps_number,
-            caller_file,
-            caller_line,
-            caller_func,
-            filename_img);
+            job->number,
+            job->caller_file,
+            job->caller_line,
+            job->caller_func);
+    switch(plan->kind) {
+        case DUMP_KIND_FULL: {
+            break;
+        }
+        case DUMP_KIND_PARTIAL: {
+            fprintf(dumper->page,
+                    "<h2>only a subtree at depth %zu changed, %zu of %zu nodes, "
+                    "whole tree in <a href = \"%s\">dump %zu</a></h2>",
+                    plan->changed_level,
+                    plan->render.entries_number,
+                    job->entries_number,
+                    full.img,
+                    plan->full_image);
+            break;
+        }
+        case DUMP_KIND_UNCHANGED: {
+            fprintf(dumper->page,
+                    "<h2>unchanged since dump %zu</h2>",
+                    plan->image);
+            break;
+        }
+        default: {
+            return AKINATOR_DUMP_WORKER_ERROR;
+        }
+    }
+    fprintf(dumper->page,
+            "<img src = \"%s\" loading = \"lazy\">\n"
+            "</div>\n",
+            shown.img);
 
-    fflush(akinator->general_dump);
-    return AKINATOR_SUCCESS;
+    if(fflush(dumper->page) != 0) {
+        return AKINATOR_WRITING_DUMP_ERROR;
+    }
+
+    size_t bytes = (size_t)(ftell(dumper->page) - page_start);
+    if(plan->kind != DUMP_KIND_UNCHANGED) {
+        char img[MaxFilenameSize * 2] = {};
+        snprintf(img, sizeof(img), "%s/%s", LogsFolder, shown.img);
+        bytes += akinator_dump_file_size(img);
+        bytes += akinator_dump_file_size(shown.dot_utf8);
+    }
+    page->last_dump = job->number;
+    page->dumps_number++;
+    page->bytes       += bytes;
+    dumper->disk_bytes += bytes;
+    if(plan->page + 1 == dumper->planned_pages) {
+        dumper->page_bytes += bytes;
+    }
+
+    bool removed = false;
+    while(dumper->disk_bytes > DumpMaxDiskBytes && dumper->pages_number > 1) {
+        akinator_dump_remove_page(dumper);
+        removed = true;
+    }
+    return removed ? akinator_dump_write_index(dumper) : AKINATOR_SUCCESS;
 }
 
-akinator_error_t akinator_dump_init(akinator_t *akinator) {
-    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER);
+//the page before it gets a link to this one, the oldest page goes if there are too many
+akinator_error_t akinator_dump_open_page(akinator_dump_t *dumper,
+                                         size_t           number,
+                                         size_t           first_dump) {
+    _C_ASSERT(dumper != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    akinator_error_t error_code = AKINATOR_SUCCESS;
+    if((error_code = akinator_dump_close_page(dumper, true)) != AKINATOR_SUCCESS) {
+        return error_code;
+    }
+    if(dumper->pages_number == DumpMaxPages) {
+        akinator_dump_remove_page(dumper);
+    }
 
-    akinator->general_dump = fopen(GeneralDumpFilename, "w");
-    if(akinator->general_dump == NULL) {
+    char filename[MaxFilenameSize] = {};
+    snprintf(filename, sizeof(filename), "%s/%s%04zu.html", LogsFolder, PagePrefix, number);
+    dumper->page = fopen(filename, "w");
+    if(dumper->page == NULL) {
         color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
-                     "Error while opening akinator dump file.");
+                     "Error while opening dump page '%s'.\n", filename);
         return AKINATOR_GENERAL_DUMP_OPENING_ERROR;
     }
 
@@ -303,8 +1037,17 @@ akinator_error_t akinator_dump_init(akinator_t *akinator) {
                                         "border:solid;"
                                         "text-align:center;";
 
-    fprintf(akinator->general_dump,
+    fprintf(dumper->page,
             "<pre>\n"
+            "<a href = \"akin.html\">all pages</a>");
+    if(number != 0) {
+        fprintf(dumper->page,
+                "  <a href = \"%s%04zu.html\">previous page</a>",
+                PagePrefix,
+                number - 1);
+    }
+    fprintf(dumper->page,
+            "\n"
             "<div style = \"background: %s; border-radius: 25px; padding: 10px; margin: 10px;\">"
             "<h2 style = \"background:%s;%s\">root color</h2>"
             "<h2 style = \"background:%s;%s\">leaf color</h2>"
@@ -314,27 +1057,252 @@ akinator_error_t akinator_dump_init(akinator_t *akinator) {
             RootColor, legend_element_styles,
             LeafColor, legend_element_styles,
             NodeColor, legend_element_styles);
+
+    size_t bytes = (size_t)ftell(dumper->page);
+    dumper->pages[(dumper->pages_head + dumper->pages_number) % DumpMaxPages] = {.number       = number,
+                                                                                .first_dump   = first_dump,
+                                                                                .last_dump    = first_dump,
+                                                                                .dumps_number = 0,
+                                                                                .bytes        = bytes};
+    dumper->pages_number++;
+    dumper->disk_bytes += bytes;
+    return akinator_dump_write_index(dumper);
+}
+
+akinator_error_t akinator_dump_close_page(akinator_dump_t *dumper,
+                                          bool             has_next) {
+    _C_ASSERT(dumper != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    if(dumper->page == NULL) {
+        return AKINATOR_SUCCESS;
+    }
+    akinator_dump_page_t *page = &dumper->pages[(dumper->pages_head + dumper->pages_number - 1) % DumpMaxPages];
+    long                  end  = ftell(dumper->page);
+    if(has_next) {
+        fprintf(dumper->page,
+                "<a href = \"%s%04zu.html\">next page</a>\n",
+                PagePrefix,
+                page->number + 1);
+    }
+    fputs("</pre>\n", dumper->page);
+    size_t bytes = (size_t)(ftell(dumper->page) - end);
+    page->bytes        += bytes;
+    dumper->disk_bytes += bytes;
+
+    int close_result = fclose(dumper->page);
+    dumper->page     = NULL;
+    return (close_result == 0) ? AKINATOR_SUCCESS : AKINATOR_WRITING_DUMP_ERROR;
+}
+
+//images and dot files of the page are removed with it, unchanged dumps have none
+void akinator_dump_remove_page(akinator_dump_t *dumper) {
+    akinator_dump_page_t *page                         = &dumper->pages[dumper->pages_head];
+    char                  filename[MaxFilenameSize * 2] = {};
+    snprintf(filename, sizeof(filename), "%s/%s%04zu.html", LogsFolder, PagePrefix, page->number);
+    remove(filename);
+    for(size_t dump = page->first_dump; dump <= page->last_dump; dump++) {
+        dump_filenames_t filenames = {};
+        akinator_dump_filenames_init(dump, &filenames);
+        snprintf(filename, sizeof(filename), "%s/%s", LogsFolder, filenames.img);
+        remove(filename);
+        remove(filenames.dot_utf8);
+    }
+
+    dumper->disk_bytes -= page->bytes;
+    dumper->pages_head  = (dumper->pages_head + 1) % DumpMaxPages;
+    dumper->pages_number--;
+    dumper->removed_pages++;
+}
+
+//written aside and renamed over the old one, so a browser never sees half of it
+akinator_error_t akinator_dump_write_index(akinator_dump_t *dumper) {
+    _C_ASSERT(dumper != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    FILE *index = fopen(IndexTempFilename, "w");
+    if(index == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while opening akinator dump file.\n");
+        return AKINATOR_GENERAL_DUMP_OPENING_ERROR;
+    }
+    fprintf(index,
+            "<pre>\n"
+            "<h1>DUMPS</h1>"
+            "<h2>%zu pages, %zu KiB of %zu KiB, %zu older pages removed</h2>",
+            dumper->pages_number,
+            dumper->disk_bytes       >> 10,
+            DumpMaxDiskBytes         >> 10,
+            dumper->removed_pages);
+    for(size_t position = dumper->pages_number; position-- > 0;) {
+        akinator_dump_page_t *page = &dumper->pages[(dumper->pages_head + position) % DumpMaxPages];
+        fprintf(index,
+                "<a href = \"%s%04zu.html\">page %zu</a>  dumps %zu - %zu, %zu KiB\n",
+                PagePrefix,
+                page->number,
+                page->number,
+                page->first_dump,
+                page->last_dump,
+                page->bytes >> 10);
+    }
+    fputs("</pre>\n", index);
+    if(fclose(index) != 0) {
+        return AKINATOR_WRITING_DUMP_ERROR;
+    }
+#ifdef _WIN32
+    //rename does not replace on windows
+    remove(GeneralDumpFilename);
+#endif
+    if(rename(IndexTempFilename, GeneralDumpFilename) != 0) {
+        return AKINATOR_WRITING_DUMP_ERROR;
+    }
     return AKINATOR_SUCCESS;
 }
 
-akinator_error_t akinator_dump_filenames_init(akinator_t       *akinator,
+//dumps are numbered from zero every run, pages and images of an earlier run would
+//otherwise stay on disk uncounted
+void akinator_dump_remove_old_files(void) {
+    const char *folders [] = {"", ImgFolder, DotUtf8Folder};
+    const char *prefixes[] = {PagePrefix, DumpPrefix, DumpPrefix};
+    for(size_t folder = 0; folder < sizeof(folders) / sizeof(folders[0]); folder++) {
+        char path[MaxFilenameSize] = {};
+        snprintf(path, sizeof(path), "%s/%s", LogsFolder, folders[folder]);
+        DIR *directory = opendir(path);
+        if(directory == NULL) {
+            continue;
+        }
+        size_t         prefix_size = strlen(prefixes[folder]);
+        struct dirent *entry       = NULL;
+        while((entry = readdir(directory)) != NULL) {
+            if(strncmp(entry->d_name, prefixes[folder], prefix_size) != 0) {
+                continue;
+            }
+            char filename[MaxFilenameSize + sizeof(entry->d_name)] = {};
+            snprintf(filename, sizeof(filename), "%s/%s", path, entry->d_name);
+            remove(filename);
+        }
+        closedir(directory);
+    }
+}
+
+size_t akinator_dump_file_size(const char *filename) {
+    struct stat file_stat = {};
+    if(stat(filename, &file_stat) != 0) {
+        return 0;
+    }
+    return (size_t)file_stat.st_size;
+}
+
+akinator_error_t akinator_dump_init(akinator_t *akinator) {
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER);
+
+    akinator_dump_remove_old_files();
+    akinator_dump_t *dumper = (akinator_dump_t *)calloc(1, sizeof(*dumper));
+    if(dumper == NULL) {
+        return AKINATOR_DUMP_WORKER_ERROR;
+    }
+    akinator->dumper         = dumper;
+    dumper->renderer         = DumpDefaultRenderer;
+    dumper->pending_capacity = MinPendingCapacity;
+    dumper->pending          = (akinator_node_t **)calloc(dumper->pending_capacity, sizeof(*dumper->pending));
+    if(dumper->pending == NULL) {
+        return AKINATOR_DUMP_WORKER_ERROR;
+    }
+    akinator_error_t error_code = akinator_dump_write_index(dumper);
+    if(error_code != AKINATOR_SUCCESS) {
+        return error_code;
+    }
+
+    pthread_mutex_init(&dumper->lock,    NULL);
+    pthread_cond_init (&dumper->changed, NULL);
+    if(pthread_create(&dumper->worker, NULL, akinator_dump_worker, dumper) != 0) {
+        return AKINATOR_DUMP_WORKER_ERROR;
+    }
+    dumper->started = true;
+    return AKINATOR_SUCCESS;
+}
+
+//renders everything still queued, must run before the tree storage is freed
+akinator_error_t akinator_dump_dtor(akinator_t *akinator) {
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER);
+
+    akinator_dump_t *dumper     = akinator->dumper;
+    akinator_error_t error_code = AKINATOR_SUCCESS;
+    if(dumper != NULL && dumper->started) {
+        pthread_mutex_lock(&dumper->lock);
+        dumper->stop = 1;
+        pthread_cond_broadcast(&dumper->changed);
+        pthread_mutex_unlock(&dumper->lock);
+        pthread_join(dumper->worker, NULL);
+
+        for(; dumper->queue_size != 0; dumper->queue_size--) {
+            akinator_dump_job_free(&dumper->queue[dumper->queue_head]);
+            dumper->queue_head = (dumper->queue_head + 1) % DumpQueueCapacity;
+        }
+        pthread_cond_destroy (&dumper->changed);
+        pthread_mutex_destroy(&dumper->lock);
+        error_code = dumper->error;
+
+        if(dumper->caller_time.count != 0) {
+            uint64_t p50 = 0;
+            uint64_t p99 = 0;
+            akinator_histogram_percentile(&dumper->caller_time, 50.0, &p50);
+            akinator_histogram_percentile(&dumper->caller_time, 99.0, &p99);
+            color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                         "Dumps: %zu full, %zu partial, %zu unchanged, %zu nodes drawn, "
+                         "%zu images rendered, %zu failed, %zu batches, %.3f ms per batch, "
+                         "%zu waits for the queue, caller p50 %.3f ms, p99 %.3f ms, "
+                         "%zu pages with %zu KiB kept, %zu removed.\n",
+                         dumper->full_number,
+                         dumper->partial_number,
+                         dumper->unchanged_number,
+                         dumper->rendered_nodes,
+                         dumper->rendered_number,
+                         dumper->failed_number,
+                         dumper->batches_number,
+                         (dumper->batches_number == 0) ? 0.0 :
+                             (double)dumper->render_ns / 1e6 / (double)dumper->batches_number,
+                         dumper->waits_number,
+                         (double)p50 / 1e6,
+                         (double)p99 / 1e6,
+                         dumper->pages_number,
+                         dumper->disk_bytes >> 10,
+                         dumper->removed_pages);
+        }
+    }
+    if(dumper != NULL) {
+        akinator_error_t page_error = akinator_dump_close_page(dumper, false);
+        if(page_error == AKINATOR_SUCCESS) {
+            page_error = akinator_dump_write_index(dumper);
+        }
+        if(error_code == AKINATOR_SUCCESS) {
+            error_code = page_error;
+        }
+        akinator_dump_job_free(&dumper->previous);
+        free(dumper->pending);
+        free(dumper);
+        akinator->dumper = NULL;
+    }
+    return error_code;
+}
+
+akinator_error_t akinator_dump_filenames_init(size_t            number,
                                               dump_filenames_t *filenames) {
-    _C_ASSERT(akinator  != NULL, return AKINATOR_NULL_POINTER           );
     _C_ASSERT(filenames != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
 
-    sprintf(filenames->dot_cp1251,
-            "%s\\%s\\dump%08llx.dot",
-            LogsFolder,
-            DotCp1251Folder,
-            akinator->dumps_number);
     sprintf(filenames->dot_utf8,
-            "%s\\%s\\dump%08llx.dot",
+            "%s/%s/dump%08zx.dot",
             LogsFolder,
             DotUtf8Folder,
-            akinator->dumps_number);
+            number);
     sprintf(filenames->img,
-            "%s\\dump%08llx.svg",
+            "%s/dump%08zx.svg",
             ImgFolder,
-            akinator->dumps_number);
+            number);
     return AKINATOR_SUCCESS;
 }
+
+//splitmix64 finalizer
+uint64_t akinator_dump_mix(uint64_t value) {
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
@@ -0,0 +1,208 @@
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "akinator_encoding.h"
+#include "custom_assert.h"
+
+//code points of cp1251 bytes 0x80..0xff, 0x98 is unassigned and kept as is like
+//windows does
+static const uint16_t Cp1251High[128] = {
+    0x0402, 0x0403, 0x201a, 0x0453, 0x201e, 0x2026, 0x2020, 0x2021,
+    0x20ac, 0x2030, 0x0409, 0x2039, 0x040a, 0x040c, 0x040b, 0x040f,
+    0x0452, 0x2018, 0x2019, 0x201c, 0x201d, 0x2022, 0x2013, 0x2014,
+    0x0098, 0x2122, 0x0459, 0x203a, 0x045a, 0x045c, 0x045b, 0x045f,
+    0x00a0, 0x040e, 0x045e, 0x0408, 0x00a4, 0x0490, 0x00a6, 0x00a7,
+    0x0401, 0x00a9, 0x0404, 0x00ab, 0x00ac, 0x00ad, 0x00ae, 0x0407,
+    0x00b0, 0x00b1, 0x0406, 0x0456, 0x0491, 0x00b5, 0x00b6, 0x00b7,
+    0x0451, 0x2116, 0x0454, 0x00bb, 0x0458, 0x0405, 0x0455, 0x0457,
+    0x0410, 0x0411, 0x0412, 0x0413, 0x0414, 0x0415, 0x0416, 0x0417,
+    0x0418, 0x0419, 0x041a, 0x041b, 0x041c, 0x041d, 0x041e, 0x041f,
+    0x0420, 0x0421, 0x0422, 0x0423, 0x0424, 0x0425, 0x0426, 0x0427,
+    0x0428, 0x0429, 0x042a, 0x042b, 0x042c, 0x042d, 0x042e, 0x042f,
+    0x0430, 0x0431, 0x0432, 0x0433, 0x0434, 0x0435, 0x0436, 0x0437,
+    0x0438, 0x0439, 0x043a, 0x043b, 0x043c, 0x043d, 0x043e, 0x043f,
+    0x0440, 0x0441, 0x0442, 0x0443, 0x0444, 0x0445, 0x0446, 0x0447,
+    0x0448, 0x0449, 0x044a, 0x044b, 0x044c, 0x044d, 0x044e, 0x044f,
+};
+
+//smallest code point each sequence length may carry, shorter forms are overlong
+static const uint32_t Utf8MinCodePoint[5] = {0, 0, 0x80, 0x800, 0x10000};
+static const uint32_t Utf8MaxCodePoint    = 0x10ffff;
+
+static size_t  encoding_ascii_prefix (const uint8_t *input,
+                                      size_t         size);
+
+static uint8_t encoding_from_unicode (uint32_t       code_point);
+
+akinator_error_t akinator_cp1251_to_utf8(const char *input,
+                                         size_t      input_size,
+                                         char       *output,
+                                         size_t      output_capacity,
+                                         size_t     *output_size) {
+    _C_ASSERT(input       != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(output      != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(output_size != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    const uint8_t *source  = (const uint8_t *)input;
+    size_t         written = 0;
+    size_t         index   = 0;
+    while(index < input_size) {
+        size_t ascii = encoding_ascii_prefix(source + index, input_size - index);
+        if(ascii > output_capacity - written) {
+            return AKINATOR_ENCODING_ERROR;
+        }
+        memcpy(output + written, source + index, ascii);
+        written += ascii;
+        index   += ascii;
+
+        //cp1251 has nothing above U+2122, so two or three bytes each, the whole run of
+        //them is done before looking for ascii again
+        for(; index < input_size && source[index] >= 0x80; index++) {
+            uint16_t code_point = Cp1251High[source[index] - 0x80];
+            if(output_capacity - written < 3) {
+                return AKINATOR_ENCODING_ERROR;
+            }
+            if(code_point < 0x800) {
+                output[written++] = (char)(0xc0 | (code_point >> 6));
+            }
+            else {
+                output[written++] = (char)(0xe0 | (code_point >> 12));
+                output[written++] = (char)(0x80 | ((code_point >> 6) & 0x3f));
+            }
+            output[written++] = (char)(0x80 | (code_point & 0x3f));
+        }
+    }
+    *output_size = written;
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_cp1251_to_utf16(const char *input,
+                                          size_t      input_size,
+                                          uint16_t   *output,
+                                          size_t      output_capacity,
+                                          size_t     *output_size) {
+    _C_ASSERT(input       != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(output      != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(output_size != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    if(input_size > output_capacity) {
+        return AKINATOR_ENCODING_ERROR;
+    }
+    const uint8_t *source = (const uint8_t *)input;
+    size_t         index  = 0;
+#ifdef __SSE2__
+    //ascii chunks are widened by interleaving with zero bytes
+    const __m128i zero = _mm_setzero_si128();
+    for(; index + 16 <= input_size; index += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(source + index));
+        if(_mm_movemask_epi8(chunk) != 0) {
+            for(size_t symbol = index; symbol < index + 16; symbol++) {
+                output[symbol] = (source[symbol] < 0x80) ? source[symbol] : Cp1251High[source[symbol] - 0x80];
+            }
+            continue;
+        }
+        _mm_storeu_si128((__m128i *)(output + index),     _mm_unpacklo_epi8(chunk, zero));
+        _mm_storeu_si128((__m128i *)(output + index + 8), _mm_unpackhi_epi8(chunk, zero));
+    }
+#endif
+    for(; index < input_size; index++) {
+        output[index] = (source[index] < 0x80) ? source[index] : Cp1251High[source[index] - 0x80];
+    }
+    *output_size = input_size;
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_utf8_to_cp1251(const char *input,
+                                         size_t      input_size,
+                                         char       *output,
+                                         size_t      output_capacity,
+                                         size_t     *output_size) {
+    _C_ASSERT(input       != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(output      != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(output_size != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    const uint8_t *source  = (const uint8_t *)input;
+    size_t         written = 0;
+    size_t         index   = 0;
+    while(index < input_size) {
+        size_t ascii = encoding_ascii_prefix(source + index, input_size - index);
+        if(ascii > output_capacity - written) {
+            return AKINATOR_ENCODING_ERROR;
+        }
+        memcpy(output + written, source + index, ascii);
+        written += ascii;
+        index   += ascii;
+
+        //lead byte gives the length, anything that does not decode is one '?' per byte:
+        //continuation and C0, C1, F5..FF leads, overlong forms, surrogates and code points
+        //past 10FFFF, so no sequence can smuggle in '/', a quote or NUL
+        while(index < input_size && source[index] >= 0x80) {
+            if(written == output_capacity) {
+                return AKINATOR_ENCODING_ERROR;
+            }
+            uint8_t  lead       = source[index];
+            size_t   length     = (lead >= 0xf5) ? 1 :
+                                  (lead >= 0xf0) ? 4 : (lead >= 0xe0) ? 3 : (lead >= 0xc2) ? 2 : 1;
+            uint32_t code_point = (length == 1) ? 0 : (uint32_t)(lead & (0x7f >> length));
+            bool     valid      = (length != 1 && index + length <= input_size);
+            for(size_t continuation = 1; valid && continuation < length; continuation++) {
+                uint8_t next = source[index + continuation];
+                valid        = ((next & 0xc0) == 0x80);
+                code_point   = (code_point << 6) | (next & 0x3f);
+            }
+            valid = valid && code_point >= Utf8MinCodePoint[length] &&
+                             code_point <= Utf8MaxCodePoint         &&
+                             (code_point < 0xd800 || code_point > 0xdfff);
+            if(!valid) {
+                length = 1;
+            }
+            output[written++] = valid ? (char)encoding_from_unicode(code_point) : '?';
+            index += length;
+        }
+    }
+    *output_size = written;
+    return AKINATOR_SUCCESS;
+}
+
+size_t encoding_ascii_prefix(const uint8_t *input,
+                             size_t         size) {
+    size_t index = 0;
+#ifdef __SSE2__
+    for(; index + 16 <= size; index += 16) {
+        int mask = _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(input + index)));
+        if(mask != 0) {
+            return index + (size_t)__builtin_ctz((unsigned)mask);
+        }
+    }
+#else
+    for(; index + 8 <= size; index += 8) {
+        uint64_t word = 0;
+        memcpy(&word, input + index, sizeof(word));
+        if((word & 0x8080808080808080ull) != 0) {
+            break;
+        }
+    }
+#endif
+    while(index < size && input[index] < 0x80) {
+        index++;
+    }
+    return index;
+}
+
+//cyrillic letters are one subtraction, the rest of the table is searched
+uint8_t encoding_from_unicode(uint32_t code_point) {
+    if(code_point < 0x80) {
+        return (uint8_t)code_point;
+    }
+    if(code_point >= 0x0410 && code_point <= 0x044f) {
+        return (uint8_t)(code_point - 0x0410 + 0xc0);
+    }
+    for(size_t byte = 0; byte < 0x40; byte++) {
+        if(Cp1251High[byte] == code_point) {
+            return (uint8_t)(byte + 0x80);
+        }
+    }
+    return '?';
+}
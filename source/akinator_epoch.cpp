@@ -0,0 +1,135 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "akinator_epoch.h"
+#include "custom_assert.h"
+#include "colors.h"
+
+static const size_t EpochRetiredInitCapacity = 16;
+
+akinator_error_t akinator_epoch_ctor(akinator_epoch_t *epoch) {
+    _C_ASSERT(epoch != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    memset(epoch, 0, sizeof(*epoch));
+    epoch->global = EpochQuiescent + 1;
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_epoch_register(akinator_epoch_t *epoch, size_t *reader) {
+    _C_ASSERT(epoch  != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(reader != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    size_t number = __atomic_fetch_add(&epoch->readers_number, 1, __ATOMIC_RELAXED);
+    if(number >= EpochMaxReaders) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Too many epoch readers, maximum is %zu.\n", EpochMaxReaders);
+        return AKINATOR_EPOCH_ERROR;
+    }
+    *reader = number;
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_epoch_enter(akinator_epoch_t *epoch, size_t reader) {
+    _C_ASSERT(epoch  != NULL          , return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(reader <  EpochMaxReaders, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    __atomic_store_n(epoch->readers + reader,
+                     __atomic_load_n(&epoch->global, __ATOMIC_ACQUIRE),
+                     __ATOMIC_SEQ_CST);
+    //pairs with the fence in collect: either the writer sees this reader or the reader sees the new tree
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_epoch_exit(akinator_epoch_t *epoch, size_t reader) {
+    _C_ASSERT(epoch  != NULL          , return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(reader <  EpochMaxReaders, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    __atomic_store_n(epoch->readers + reader, EpochQuiescent, __ATOMIC_RELEASE);
+    return AKINATOR_SUCCESS;
+}
+
+//called by the single writer after the pointer is unpublished
+akinator_error_t akinator_epoch_retire(akinator_epoch_t *epoch, void *pointer) {
+    _C_ASSERT(epoch != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    if(epoch->retired_size == epoch->retired_capacity) {
+        size_t new_capacity = (epoch->retired_capacity == 0) ? EpochRetiredInitCapacity :
+                                                               epoch->retired_capacity * 2;
+        akinator_epoch_retired_t *new_retired = (akinator_epoch_retired_t *)realloc(epoch->retired,
+                                                                                    new_capacity * sizeof(new_retired[0]));
+        if(new_retired == NULL) {
+            color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                         "Error while allocating retired pointers list.\n");
+            return AKINATOR_EPOCH_ERROR;
+        }
+        epoch->retired          = new_retired;
+        epoch->retired_capacity = new_capacity;
+    }
+
+    epoch->retired[epoch->retired_size].pointer = pointer;
+    epoch->retired[epoch->retired_size].epoch   = __atomic_fetch_add(&epoch->global, 1, __ATOMIC_ACQ_REL);
+    epoch->retired_size++;
+    return akinator_epoch_collect(epoch);
+}
+
+akinator_error_t akinator_epoch_collect(akinator_epoch_t *epoch) {
+    _C_ASSERT(epoch != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    size_t oldest  = __atomic_load_n(&epoch->global, __ATOMIC_ACQUIRE);
+    size_t readers = __atomic_load_n(&epoch->readers_number, __ATOMIC_ACQUIRE);
+    if(readers > EpochMaxReaders) {
+        readers = EpochMaxReaders;
+    }
+    for(size_t reader = 0; reader < readers; reader++) {
+        size_t entered = __atomic_load_n(epoch->readers + reader, __ATOMIC_ACQUIRE);
+        if(entered != EpochQuiescent && entered < oldest) {
+            oldest = entered;
+        }
+    }
+
+    size_t kept = 0;
+    for(size_t index = 0; index < epoch->retired_size; index++) {
+        if(epoch->retired[index].epoch < oldest) {
+            free(epoch->retired[index].pointer);
+        }
+        else {
+            epoch->retired[kept++] = epoch->retired[index];
+        }
+    }
+    epoch->retired_size = kept;
+    return AKINATOR_SUCCESS;
+}
+
+//waits until every reader that may have seen a pointer unpublished before this call has left
+akinator_error_t akinator_epoch_synchronize(akinator_epoch_t *epoch) {
+    _C_ASSERT(epoch != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    size_t stamp = __atomic_fetch_add(&epoch->global, 1, __ATOMIC_ACQ_REL);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    size_t readers = __atomic_load_n(&epoch->readers_number, __ATOMIC_ACQUIRE);
+    if(readers > EpochMaxReaders) {
+        readers = EpochMaxReaders;
+    }
+    for(size_t reader = 0; reader < readers; reader++) {
+        while(true) {
+            size_t entered = __atomic_load_n(epoch->readers + reader, __ATOMIC_ACQUIRE);
+            if(entered == EpochQuiescent || entered > stamp) {
+                break;
+            }
+        }
+    }
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_epoch_dtor(akinator_epoch_t *epoch) {
+    _C_ASSERT(epoch != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    for(size_t index = 0; index < epoch->retired_size; index++) {
+        free(epoch->retired[index].pointer);
+    }
+    free(epoch->retired);
+    memset(epoch, 0, sizeof(*epoch));
+    return AKINATOR_SUCCESS;
+}
@@ -0,0 +1,358 @@
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "akinator.h"
+#include "akinator_export.h"
+#include "akinator_encoding.h"
+#include "akinator_tree.h"
+#include "akinator_utils.h"
+#include "custom_assert.h"
+#include "colors.h"
+
+static const size_t      ExportMaxLineSize   = 1024;
+static const size_t      ExportMaxNameSize   = 256;
+static const size_t      ExportMaxLabelSize  = 2 * MaxQuestionSize + 1;
+static const size_t      ExportNoPage        = SIZE_MAX;
+static const size_t      ExportFocusPage     = SIZE_MAX - 1;
+static const char *const ExportBackground    = "#ced4da";
+static const char *const ExportQuestionColor = "#ffeedd";
+static const char *const ExportLeafColor     = "#ffd8be";
+static const char *const ExportPathColor     = "#b8b8ff";
+static const char *const ExportSummaryColor  = "#e9ecef";
+
+//leafs is the number of objects below every node by id, pages is the queue of page
+//roots, links is the page every queued page was opened from
+struct export_t {
+    akinator_t                      *akinator;
+    const akinator_export_options_t *options;
+    const char                      *folder;
+    akinator_export_stats_t         *stats;
+    size_t                          *leafs;
+    bool                            *on_path;
+    bool                            *queued;
+    akinator_node_t                **pages;
+    size_t                          *links;
+    size_t                           pages_size;
+    FILE                            *file;
+    akinator_node_t                 *page_root;
+    size_t                           page_id;
+    bool                             collapsing;
+    size_t                           page_nodes;
+};
+
+static akinator_error_t export_count_leafs (export_t        *export_state,
+                                            akinator_node_t *node);
+
+static akinator_error_t export_mark_focus  (export_t        *export_state);
+
+static akinator_error_t export_write_page  (export_t        *export_state,
+                                            akinator_node_t *root,
+                                            size_t           page_id,
+                                            size_t           link,
+                                            const char      *filename);
+
+static akinator_error_t export_node        (export_t        *export_state,
+                                            akinator_node_t *node,
+                                            size_t           depth_left);
+
+static akinator_error_t export_summary     (export_t        *export_state,
+                                            akinator_node_t *node);
+
+static akinator_error_t export_escape      (const char      *text,
+                                            char            *escaped,
+                                            size_t           escaped_size);
+
+static akinator_error_t export_printf      (FILE            *file,
+                                            const char      *format, ...);
+
+static void             export_free        (export_t        *export_state);
+
+//the focus page goes first, every page queues the pages of its summaries, so with
+//paginate the whole tree ends up split into pages of at most depth levels
+akinator_error_t akinator_export(akinator_t                      *akinator,
+                                 const akinator_export_options_t *options,
+                                 const char                      *folder,
+                                 akinator_export_stats_t         *stats) {
+    _C_ASSERT(akinator       != NULL, return AKINATOR_NULL_POINTER           );
+    _C_ASSERT(akinator->root != NULL, return AKINATOR_NULL_ROOT              );
+    _C_ASSERT(options        != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(options->depth != 0,    return AKINATOR_EXPORT_ERROR           );
+    _C_ASSERT(folder         != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(stats          != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    size_t   nodes_number = akinator->used_storage;
+    export_t export_state = {.akinator = akinator,
+                             .options  = options,
+                             .folder   = folder,
+                             .stats    = stats,
+                             .leafs    = (size_t           *)calloc(nodes_number, sizeof(size_t)),
+                             .on_path  = (bool             *)calloc(nodes_number, sizeof(bool)),
+                             .queued   = (bool             *)calloc(nodes_number, sizeof(bool)),
+                             .pages    = (akinator_node_t **)calloc(nodes_number, sizeof(akinator_node_t *)),
+                             .links    = (size_t           *)calloc(nodes_number, sizeof(size_t))};
+    *stats = {};
+    if(export_state.leafs == NULL || export_state.on_path == NULL || export_state.queued == NULL ||
+       export_state.pages == NULL || export_state.links   == NULL) {
+        export_free(&export_state);
+        return AKINATOR_EXPORT_ERROR;
+    }
+
+    akinator_error_t error_code = export_count_leafs(&export_state, akinator->root);
+    if(error_code == AKINATOR_SUCCESS && options->focus != NULL) {
+        error_code = export_mark_focus(&export_state);
+        if(error_code == AKINATOR_SUCCESS) {
+            char filename[ExportMaxNameSize] = {};
+            snprintf(filename, sizeof(filename), "%s/focus.dot", folder);
+            error_code = export_write_page(&export_state, akinator->root, ExportFocusPage, ExportNoPage, filename);
+        }
+    }
+    else if(error_code == AKINATOR_SUCCESS) {
+        export_state.pages[export_state.pages_size]   = akinator->root;
+        export_state.links[export_state.pages_size++] = ExportNoPage;
+    }
+
+    for(size_t page = 0; page < export_state.pages_size && error_code == AKINATOR_SUCCESS; page++) {
+        char filename[ExportMaxNameSize] = {};
+        snprintf(filename, sizeof(filename), "%s/tree_%zu.dot", folder, export_state.pages[page]->id);
+        error_code = export_write_page(&export_state,
+                                       export_state.pages[page],
+                                       export_state.pages[page]->id,
+                                       export_state.links[page],
+                                       filename);
+    }
+    export_free(&export_state);
+    return error_code;
+}
+
+akinator_error_t export_count_leafs(export_t        *export_state,
+                                    akinator_node_t *node) {
+    _C_ASSERT(node     != NULL,                                 return AKINATOR_NODE_NULL   );
+    _C_ASSERT(node->id <  export_state->akinator->used_storage, return AKINATOR_EXPORT_ERROR);
+
+    if(is_leaf(node)) {
+        export_state->leafs[node->id] = 1;
+        return AKINATOR_SUCCESS;
+    }
+    RETURN_IF_ERROR(export_count_leafs(export_state, node->yes));
+    RETURN_IF_ERROR(export_count_leafs(export_state, node->no));
+    export_state->leafs[node->id] = export_state->leafs[node->yes->id] + export_state->leafs[node->no->id];
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t export_mark_focus(export_t *export_state) {
+    akinator_node_t *object = NULL;
+    RETURN_IF_ERROR(akinator_collect_leafs(export_state->akinator));
+    akinator_error_t error_code = akinator_find_node(export_state->akinator,
+                                                     export_state->options->focus,
+                                                     &object);
+    if(error_code != AKINATOR_SUCCESS && error_code != AKINATOR_EXIT_SUCCESS) {
+        return error_code;
+    }
+    if(object == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "There is no '%s' in the tree.\n", export_state->options->focus);
+        return AKINATOR_EXPORT_ERROR;
+    }
+    for(akinator_node_t *node = object; node != NULL; node = node->parent) {
+        export_state->on_path[node->id] = true;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+//page_id is what summaries on the page link back with, link is the page this one was
+//opened from, the back node points to it
+akinator_error_t export_write_page(export_t        *export_state,
+                                   akinator_node_t *root,
+                                   size_t           page_id,
+                                   size_t           link,
+                                   const char      *filename) {
+    export_state->file = fopen(filename, "wb");
+    if(export_state->file == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while opening '%s'.\n", filename);
+        return AKINATOR_DOT_FILE_OPENING_ERROR;
+    }
+    export_state->page_root  = root;
+    export_state->page_id    = page_id;
+    export_state->page_nodes = 0;
+    export_state->collapsing = (export_state->leafs[root->id] >= export_state->options->collapse);
+
+    fprintf(export_state->file,
+            "digraph {\n"
+            "bgcolor = \"%s\";\n"
+            "node[shape = box, style = \"rounded, filled\"];\n"
+            "rankdir = TB;\n",
+            ExportBackground);
+    if(link == ExportFocusPage) {
+        fprintf(export_state->file,
+                "back[label = \"back\", shape = larrow, URL = \"focus.svg\"];\n"
+                "back -> n%zu[style = dashed];\n",
+                root->id);
+    }
+    else if(link != ExportNoPage) {
+        fprintf(export_state->file,
+                "back[label = \"back\", shape = larrow, URL = \"tree_%zu.svg\"];\n"
+                "back -> n%zu[style = dashed];\n",
+                link,
+                root->id);
+    }
+
+    akinator_error_t error_code = export_node(export_state, root, export_state->options->depth);
+    if(error_code == AKINATOR_SUCCESS && fputs("}\n", export_state->file) < 0) {
+        error_code = AKINATOR_WRITING_DUMP_ERROR;
+    }
+    if(fclose(export_state->file) != 0 && error_code == AKINATOR_SUCCESS) {
+        error_code = AKINATOR_WRITING_DUMP_ERROR;
+    }
+    export_state->file = NULL;
+
+    export_state->stats->pages_number++;
+    if(export_state->page_nodes > export_state->stats->largest_page) {
+        export_state->stats->largest_page = export_state->page_nodes;
+    }
+    return error_code;
+}
+
+//nodes of the focus path keep their depth, other children of the path get radius
+akinator_error_t export_node(export_t        *export_state,
+                             akinator_node_t *node,
+                             size_t           depth_left) {
+    const akinator_export_options_t *options = export_state->options;
+    char label[ExportMaxLabelSize] = {};
+    RETURN_IF_ERROR(export_escape(node->question, label, sizeof(label)));
+
+    export_state->page_nodes++;
+    if(is_leaf(node)) {
+        export_state->stats->nodes_number++;
+        return export_printf(export_state->file,
+                             "n%zu[label = \"%s\", fillcolor = \"%s\", shape = ellipse];\n",
+                             node->id,
+                             label,
+                             export_state->on_path[node->id] ? ExportPathColor : ExportLeafColor);
+    }
+
+    bool on_path = export_state->on_path[node->id];
+    if(!on_path && node != export_state->page_root &&
+       (depth_left == 0 || (export_state->collapsing && export_state->leafs[node->id] < options->collapse))) {
+        return export_summary(export_state, node);
+    }
+
+    export_state->stats->nodes_number++;
+    RETURN_IF_ERROR(export_printf(export_state->file,
+                                  "n%zu[label = \"%s\", fillcolor = \"%s\"];\n",
+                                  node->id,
+                                  label,
+                                  on_path ? ExportPathColor : ExportQuestionColor));
+
+    akinator_node_t *children[] = {node->yes, node->no};
+    const char      *answers [] = {"ДА", "НЕТ"};
+    for(size_t child = 0; child < 2; child++) {
+        size_t child_depth = depth_left - 1;
+        if(on_path) {
+            child_depth = export_state->on_path[children[child]->id] ? depth_left : options->radius;
+        }
+        RETURN_IF_ERROR(export_node(export_state, children[child], child_depth));
+        RETURN_IF_ERROR(export_printf(export_state->file,
+                                      "n%zu -> n%zu[label = \"%s\"];\n",
+                                      node->id,
+                                      children[child]->id,
+                                      answers[child]));
+    }
+    return AKINATOR_SUCCESS;
+}
+
+//the summary keeps the question of its subtree root, an object is always drawn itself
+akinator_error_t export_summary(export_t        *export_state,
+                                akinator_node_t *node) {
+    char label[ExportMaxLabelSize] = {};
+    RETURN_IF_ERROR(export_escape(node->question, label, sizeof(label)));
+
+    size_t objects = export_state->leafs[node->id];
+    export_state->stats->summaries_number++;
+    if(!export_state->options->paginate) {
+        return export_printf(export_state->file,
+                             "n%zu[label = \"%s\\n%zu objects, %zu questions\", "
+                             "fillcolor = \"%s\", shape = folder];\n",
+                             node->id,
+                             label,
+                             objects,
+                             objects - 1,
+                             ExportSummaryColor);
+    }
+
+    if(!export_state->queued[node->id]) {
+        export_state->queued[node->id] = true;
+        export_state->pages[export_state->pages_size]   = node;
+        export_state->links[export_state->pages_size++] = export_state->page_id;
+    }
+    return export_printf(export_state->file,
+                         "n%zu[label = \"%s\\n%zu objects, %zu questions\", "
+                         "fillcolor = \"%s\", shape = folder, URL = \"tree_%zu.svg\"];\n",
+                         node->id,
+                         label,
+                         objects,
+                         objects - 1,
+                         ExportSummaryColor,
+                         node->id);
+}
+
+akinator_error_t export_escape(const char *text,
+                               char       *escaped,
+                               size_t      escaped_size) {
+    _C_ASSERT(text    != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(escaped != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    size_t size = 0;
+    for(; *text != '\0'; text++) {
+        if(size + 3 > escaped_size) {
+            return AKINATOR_EXPORT_ERROR;
+        }
+        if(*text == '"' || *text == '\\') {
+            escaped[size++] = '\\';
+        }
+        escaped[size++] = *text;
+    }
+    escaped[size] = '\0';
+    return AKINATOR_SUCCESS;
+}
+
+//graphviz reads utf-8, questions are cp1251
+akinator_error_t export_printf(FILE       *file,
+                               const char *format, ...) {
+    _C_ASSERT(file   != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(format != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    char line     [ExportMaxLineSize]                        = {};
+    char utf8_line[ExportMaxLineSize * EncodingMaxUtf8Ratio] = {};
+    va_list args;
+    va_start(args, format);
+    int line_size = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if(line_size < 0 || (size_t)line_size >= sizeof(line)) {
+        return AKINATOR_WRITING_DUMP_ERROR;
+    }
+
+    size_t utf8_size = 0;
+    RETURN_IF_ERROR(akinator_cp1251_to_utf8(line, (size_t)line_size,
+                                            utf8_line, sizeof(utf8_line),
+                                            &utf8_size));
+    if(fwrite(utf8_line, 1, utf8_size, file) != utf8_size) {
+        return AKINATOR_WRITING_DUMP_ERROR;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+void export_free(export_t *export_state) {
+    free(export_state->leafs);
+    free(export_state->on_path);
+    free(export_state->queued);
+    free(export_state->pages);
+    free(export_state->links);
+    export_state->leafs   = NULL;
+    export_state->on_path = NULL;
+    export_state->queued  = NULL;
+    export_state->pages   = NULL;
+    export_state->links   = NULL;
+}
@@ -0,0 +1,567 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "akinator_flow.h"
+#include "akinator_tree.h"
+#include "akinator_session.h"
+#include "akinator_similar.h"
+#include "akinator_definition.h"
+#include "akinator_utils.h"
+#include "custom_assert.h"
+#include "colors.h"
+
+//gcc reports the dispatch switch it generates for every coroutine body
+#pragma GCC diagnostic ignored "-Wswitch-default"
+
+//suspends the flow until the driver has shown io->buffer and collected the input
+struct akinator_flow_wait_t {
+    akinator_flow_io_t *io;
+
+    bool await_ready  (void) noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) noexcept { io->resume_point = handle; }
+    void await_resume (void) noexcept {}
+};
+
+//way from akinator_get_way, nodes go from the object up to the root
+struct akinator_node_way_t {
+    akinator_node_t **nodes;
+    size_t            level;
+};
+
+static size_t flow_allocated_bytes = 0;
+
+static akinator_flow_wait_t akinator_flow_say              (akinator_flow_io_t     *io,
+                                                            const char             *format, ...);
+
+static akinator_flow_wait_t akinator_flow_ask              (akinator_flow_io_t     *io,
+                                                            const char             *format, ...);
+
+static akinator_flow_wait_t akinator_flow_read             (akinator_flow_io_t     *io,
+                                                            const char             *format, ...);
+
+static akinator_flow_wait_t akinator_flow_show             (akinator_flow_io_t     *io);
+
+static akinator_flow_wait_t akinator_flow_wait             (akinator_flow_io_t     *io,
+                                                            akinator_flow_input_t   input,
+                                                            const char             *format,
+                                                            va_list                 args);
+
+static akinator_flow_t      akinator_flow_rewrite_database (akinator_t             *akinator,
+                                                            akinator_flow_io_t     *io);
+
+static akinator_flow_t      akinator_flow_read_and_find    (akinator_t             *akinator,
+                                                            akinator_flow_io_t     *io,
+                                                            const char             *question,
+                                                            akinator_node_t       **node_output);
+
+static akinator_error_t     akinator_flow_copy_text        (akinator_flow_io_t     *io,
+                                                            char                   *output);
+
+static akinator_error_t     akinator_get_way               (akinator_t             *akinator,
+                                                            akinator_node_t        *node,
+                                                            akinator_node_t      ***way_output,
+                                                            size_t                 *level_output);
+
+static akinator_error_t     akinator_format_definition     (akinator_t             *akinator,
+                                                            akinator_flow_io_t     *io,
+                                                            akinator_node_t        *object);
+
+static akinator_error_t     akinator_format_difference     (akinator_t             *akinator,
+                                                            akinator_flow_io_t     *io,
+                                                            akinator_node_t        *first,
+                                                            akinator_node_t        *second);
+
+static akinator_error_t     akinator_format_similar        (akinator_flow_io_t     *io,
+                                                            akinator_node_t        *object);
+
+static akinator_error_t     akinator_format_search         (akinator_t             *akinator,
+                                                            akinator_flow_io_t     *io,
+                                                            const char             *query,
+                                                            akinator_index_mode_t   mode);
+
+static size_t               akinator_way_size              (const akinator_node_way_t *way);
+
+static const char          *akinator_way_question          (const akinator_node_way_t *way,
+                                                            size_t                     step);
+
+static bool                 akinator_way_no                (const akinator_node_way_t *way,
+                                                            size_t                     step);
+
+void *akinator_flow_t::promise_type::operator new(size_t size) noexcept {
+    __atomic_fetch_add(&flow_allocated_bytes, size, __ATOMIC_RELAXED);
+    return malloc(size);
+}
+
+void akinator_flow_t::promise_type::operator delete(void *frame, size_t size) noexcept {
+    __atomic_fetch_sub(&flow_allocated_bytes, size, __ATOMIC_RELAXED);
+    free(frame);
+}
+
+//finished flow continues the one awaiting it, top level flow returns to the driver
+std::coroutine_handle<> akinator_flow_t::final_awaiter_t::await_suspend(handle_t handle) noexcept {
+    handle_t continuation = handle.promise().continuation;
+    if(!continuation) {
+        return std::noop_coroutine();
+    }
+    continuation.promise().child = nullptr;
+    return continuation;
+}
+
+std::coroutine_handle<> akinator_flow_t::await_suspend(handle_t awaiting) noexcept {
+    handle.promise().continuation = awaiting;
+    awaiting.promise().child      = handle;
+    return handle;
+}
+
+akinator_error_t akinator_flow_t::await_resume(void) noexcept {
+    if(!handle) {
+        return AKINATOR_FLOW_ERROR;
+    }
+    akinator_error_t result = handle.promise().result;
+    handle.destroy();
+    handle = nullptr;
+    return result;
+}
+
+akinator_flow_t akinator_flow_guess(akinator_t         *akinator,
+                                    akinator_flow_io_t *io) {
+    akinator_session_t session = {};
+    CO_RETURN_IF_ERROR(akinator_session_start(&session, akinator));
+
+    while(session.state == AKINATOR_SESSION_ASKING ||
+          session.state == AKINATOR_SESSION_GUESSING) {
+        const char *question = NULL;
+        CO_RETURN_IF_ERROR(akinator_session_current_question(&session, &question));
+        io->asked = session.current;
+        co_await akinator_flow_ask(io, "Это %s?", question);
+
+        //probably and probably not go on as yes and no, the same as in the session api
+        switch(io->answer) {
+            case AKINATOR_ANSWER_YES:
+            case AKINATOR_ANSWER_NO:
+            case AKINATOR_ANSWER_PROBABLY:
+            case AKINATOR_ANSWER_PROBABLY_NOT: {
+                CO_RETURN_IF_ERROR(akinator_session_answer(&session, io->answer));
+                break;
+            }
+            case AKINATOR_ANSWER_UNKNOWN: {
+                co_await akinator_flow_say(io, "Не понял ты чё не русский");
+                break;
+            }
+            default: {
+                color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                             "Error while getting user answer.\n");
+                co_return AKINATOR_USER_ANSWER_ERROR;
+            }
+        }
+    }
+
+    if(session.state == AKINATOR_SESSION_WON) {
+        co_await akinator_flow_say(io, "Ну я же говорил");
+        co_return AKINATOR_SUCCESS;
+    }
+    co_return co_await akinator_flow_learn(akinator, io, session.current);
+}
+
+akinator_flow_t akinator_flow_learn(akinator_t         *akinator,
+                                    akinator_flow_io_t *io,
+                                    akinator_node_t    *leaf) {
+    _C_ASSERT(leaf != NULL, co_return AKINATOR_NODE_NULL);
+
+    char object[MaxQuestionSize + 1] = {};
+    co_await akinator_flow_read(io, "Скажи ково или что ты загадал по братке.");
+    CO_RETURN_IF_ERROR(akinator_flow_copy_text(io, object));
+
+    co_await akinator_flow_read(io, "А что его отличает от %s`а?", leaf->question);
+    CO_RETURN_IF_ERROR(akinator_learn(akinator, leaf, object, io->text));
+    co_return co_await akinator_flow_rewrite_database(akinator, io);
+}
+
+akinator_flow_t akinator_flow_definition(akinator_t         *akinator,
+                                         akinator_flow_io_t *io) {
+    akinator_node_t *object = NULL;
+    CO_RETURN_IF_ERROR(co_await akinator_flow_read_and_find(akinator, io,
+                                                            "Определение кого ты хочешь получить?",
+                                                            &object));
+
+    CO_RETURN_IF_ERROR(akinator_format_definition(akinator, io, object));
+    co_await akinator_flow_show(io);
+    co_return AKINATOR_SUCCESS;
+}
+
+akinator_flow_t akinator_flow_difference(akinator_t         *akinator,
+                                         akinator_flow_io_t *io) {
+    akinator_node_t *first  = NULL;
+    akinator_node_t *second = NULL;
+    CO_RETURN_IF_ERROR(co_await akinator_flow_read_and_find(akinator, io,
+                                                            "Кто первый в сравнении?",
+                                                            &first));
+    CO_RETURN_IF_ERROR(co_await akinator_flow_read_and_find(akinator, io,
+                                                            "Кто второй в сравнении?",
+                                                            &second));
+
+    CO_RETURN_IF_ERROR(akinator_format_difference(akinator, io, first, second));
+    co_await akinator_flow_show(io);
+    co_return AKINATOR_SUCCESS;
+}
+
+akinator_flow_t akinator_flow_similar(akinator_t         *akinator,
+                                      akinator_flow_io_t *io) {
+    akinator_node_t *object = NULL;
+    CO_RETURN_IF_ERROR(co_await akinator_flow_read_and_find(akinator, io,
+                                                            "Кого похожих ищем?",
+                                                            &object));
+
+    CO_RETURN_IF_ERROR(akinator_format_similar(io, object));
+    co_await akinator_flow_show(io);
+    co_return AKINATOR_SUCCESS;
+}
+
+//words are looked up in the question index, all of them or any of them
+akinator_flow_t akinator_flow_search(akinator_t         *akinator,
+                                     akinator_flow_io_t *io) {
+    char query[MaxQuestionSize + 1] = {};
+    co_await akinator_flow_read(io, "Про что вопросы ищем?");
+    CO_RETURN_IF_ERROR(akinator_flow_copy_text(io, query));
+
+    co_await akinator_flow_ask(io, "Чтобы были все слова сразу?");
+    while(true) {
+        switch(io->answer) {
+            case AKINATOR_ANSWER_YES: {
+                CO_RETURN_IF_ERROR(akinator_format_search(akinator, io, query, AKINATOR_INDEX_AND));
+                co_await akinator_flow_show(io);
+                co_return AKINATOR_SUCCESS;
+            }
+            case AKINATOR_ANSWER_NO: {
+                CO_RETURN_IF_ERROR(akinator_format_search(akinator, io, query, AKINATOR_INDEX_OR));
+                co_await akinator_flow_show(io);
+                co_return AKINATOR_SUCCESS;
+            }
+            case AKINATOR_ANSWER_UNKNOWN:
+            case AKINATOR_ANSWER_PROBABLY:
+            case AKINATOR_ANSWER_PROBABLY_NOT: {
+                co_await akinator_flow_ask(io, "Не понял ты чё не русский ШТОЛЕ???");
+                break;
+            }
+            default: {
+                color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                             "Error while getting user answer.\n");
+                co_return AKINATOR_USER_ANSWER_ERROR;
+            }
+        }
+    }
+}
+
+akinator_error_t akinator_flow_resume(akinator_flow_t    *flow,
+                                      akinator_flow_io_t *io) {
+    _C_ASSERT(flow != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(io   != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    if(akinator_flow_done(flow)) {
+        return AKINATOR_FLOW_ERROR;
+    }
+
+    std::coroutine_handle<> resume_point = io->resume_point;
+    if(!resume_point) {
+        resume_point = flow->handle;
+    }
+    io->resume_point = nullptr;
+    io->input        = AKINATOR_FLOW_INPUT_NONE;
+    io->asked        = NULL;
+    resume_point.resume();
+    return AKINATOR_SUCCESS;
+}
+
+bool akinator_flow_done(akinator_flow_t *flow) {
+    _C_ASSERT(flow != NULL, return true);
+
+    return !flow->handle || flow->handle.done();
+}
+
+akinator_error_t akinator_flow_result(akinator_flow_t *flow) {
+    _C_ASSERT(flow != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    if(!flow->handle) {
+        return AKINATOR_FLOW_ERROR;
+    }
+    return flow->handle.promise().result;
+}
+
+//driver has to clear io->resume_point when it drops a suspended flow
+akinator_error_t akinator_flow_dtor(akinator_flow_t *flow) {
+    _C_ASSERT(flow != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    akinator_flow_t::handle_t frame = flow->handle;
+    while(frame) {
+        akinator_flow_t::handle_t child = frame.promise().child;
+        frame.destroy();
+        frame = child;
+    }
+    flow->handle = nullptr;
+    return AKINATOR_SUCCESS;
+}
+
+size_t akinator_flow_allocated_bytes(void) {
+    return __atomic_load_n(&flow_allocated_bytes, __ATOMIC_RELAXED);
+}
+
+akinator_error_t akinator_add_definition(akinator_definition_t *definition,
+                                         const char            *format, ...) {
+    _C_ASSERT(definition != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(definition->definition + definition->index,
+                            definition->capacity   - definition->index,
+                            format, args);
+    va_end(args);
+    if(written < 0 || (size_t)written >= definition->capacity - definition->index) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Definition size is bigger than max, check MaxDefinitionSize.\n");
+        return AKINATOR_MESSAGE_SIZE_ERROR;
+    }
+    definition->index += (size_t)written;
+    return AKINATOR_SUCCESS;
+}
+
+akinator_flow_wait_t akinator_flow_say(akinator_flow_io_t *io,
+                                       const char         *format, ...) {
+    va_list args;
+    va_start(args, format);
+    akinator_flow_wait_t wait = akinator_flow_wait(io, AKINATOR_FLOW_INPUT_NONE, format, args);
+    va_end(args);
+    return wait;
+}
+
+akinator_flow_wait_t akinator_flow_ask(akinator_flow_io_t *io,
+                                       const char         *format, ...) {
+    va_list args;
+    va_start(args, format);
+    akinator_flow_wait_t wait = akinator_flow_wait(io, AKINATOR_FLOW_INPUT_ANSWER, format, args);
+    va_end(args);
+    return wait;
+}
+
+akinator_flow_wait_t akinator_flow_read(akinator_flow_io_t *io,
+                                        const char         *format, ...) {
+    va_list args;
+    va_start(args, format);
+    akinator_flow_wait_t wait = akinator_flow_wait(io, AKINATOR_FLOW_INPUT_TEXT, format, args);
+    va_end(args);
+    return wait;
+}
+
+//message is already formatted into io->buffer
+akinator_flow_wait_t akinator_flow_show(akinator_flow_io_t *io) {
+    io->input = AKINATOR_FLOW_INPUT_NONE;
+    return {io};
+}
+
+akinator_flow_wait_t akinator_flow_wait(akinator_flow_io_t    *io,
+                                        akinator_flow_input_t  input,
+                                        const char            *format,
+                                        va_list                args) {
+    vsnprintf(io->buffer, io->buffer_size, format, args);
+    io->input = input;
+    return {io};
+}
+
+akinator_flow_t akinator_flow_rewrite_database(akinator_t         *akinator,
+                                               akinator_flow_io_t *io) {
+    co_await akinator_flow_ask(io, "Ты хочешь чтобы я обновил свою базу данных? Риальна?");
+    while(true) {
+        switch(io->answer) {
+            case AKINATOR_ANSWER_YES: {
+                akinator_error_t error_code = akinator_update_database(akinator);
+                co_return (error_code == AKINATOR_EXIT_SUCCESS) ? AKINATOR_SUCCESS : error_code;
+            }
+            case AKINATOR_ANSWER_NO: {
+                co_return AKINATOR_SUCCESS;
+            }
+            case AKINATOR_ANSWER_UNKNOWN:
+            case AKINATOR_ANSWER_PROBABLY:
+            case AKINATOR_ANSWER_PROBABLY_NOT: {
+                co_await akinator_flow_ask(io, "Не понял ты чё не русский ШТОЛЕ???");
+                break;
+            }
+            default: {
+                color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                             "Error while getting user answer.\n");
+                co_return AKINATOR_USER_ANSWER_ERROR;
+            }
+        }
+    }
+}
+
+akinator_flow_t akinator_flow_read_and_find(akinator_t         *akinator,
+                                            akinator_flow_io_t *io,
+                                            const char         *question,
+                                            akinator_node_t   **node_output) {
+    _C_ASSERT(question    != NULL, co_return AKINATOR_NULL_OBJECT_NAME);
+    _C_ASSERT(node_output != NULL, co_return AKINATOR_NODE_NULL       );
+
+    co_await akinator_flow_read(io, "%s", question);
+    while(true) {
+        akinator_error_t error_code = akinator_find_node(akinator, io->text, node_output);
+        if(error_code == AKINATOR_EXIT_SUCCESS) {
+            co_return AKINATOR_SUCCESS;
+        }
+        if(error_code != AKINATOR_SUCCESS) {
+            co_return error_code;
+        }
+        co_await akinator_flow_read(io, "Такова не знаю");
+    }
+}
+
+akinator_error_t akinator_flow_copy_text(akinator_flow_io_t *io,
+                                         char               *output) {
+    _C_ASSERT(io->text != NULL, return AKINATOR_NULL_OBJECT_NAME);
+
+    size_t length = strlen(io->text);
+    if(length > MaxQuestionSize) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Answer is longer than %zu symbols.\n", MaxQuestionSize);
+        return AKINATOR_MESSAGE_SIZE_ERROR;
+    }
+    memcpy(output, io->text, length + 1);
+    return AKINATOR_SUCCESS;
+}
+
+//way is built after all the input is read, so nothing allocated lives across suspensions
+akinator_error_t akinator_get_way(akinator_t        *akinator,
+                                  akinator_node_t   *node,
+                                  akinator_node_t ***way_output,
+                                  size_t            *level_output) {
+    _C_ASSERT(node != NULL, return AKINATOR_NODE_NULL);
+
+    size_t level = 0;
+    for(akinator_node_t *element = node; element != NULL; element = element->parent) {
+        level++;
+    }
+    _C_ASSERT(level <= akinator->used_storage, return AKINATOR_INVALID_NODE_LEVEL);
+
+    akinator_node_t **way = (akinator_node_t **)calloc(level, sizeof(akinator_node_t *));
+    if(way == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while allocating memory to definition elements.\n");
+        return AKINATOR_DEFINITION_ALLOCATING_ERROR;
+    }
+    for(size_t element = 0; node != NULL; element++) {
+        way[element] = node;
+        node = node->parent;
+    }
+
+    *way_output   = way;
+    *level_output = level;
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_format_definition(akinator_t         *akinator,
+                                            akinator_flow_io_t *io,
+                                            akinator_node_t    *object) {
+    akinator_node_way_t way = {};
+    RETURN_IF_ERROR(akinator_get_way(akinator, object, &way.nodes, &way.level));
+
+    akinator_definition_t definition = {.definition = io->buffer,
+                                        .index      = 0,
+                                        .capacity   = io->buffer_size};
+    akinator_error_t error_code = akinator_way_define(&way, object->question, &definition);
+    free(way.nodes);
+    return error_code;
+}
+
+akinator_error_t akinator_format_difference(akinator_t         *akinator,
+                                            akinator_flow_io_t *io,
+                                            akinator_node_t    *first,
+                                            akinator_node_t    *second) {
+    akinator_node_way_t way_first  = {};
+    akinator_node_way_t way_second = {};
+    RETURN_IF_ERROR(akinator_get_way(akinator, first, &way_first.nodes, &way_first.level));
+    akinator_error_t error_code = akinator_get_way(akinator, second, &way_second.nodes, &way_second.level);
+
+    akinator_definition_t definition = {.definition = io->buffer,
+                                        .index      = 0,
+                                        .capacity   = io->buffer_size};
+    definition.definition[0] = '\0';
+    if(error_code == AKINATOR_SUCCESS) {
+        error_code = akinator_way_differ(&way_first,  first->question,
+                                         &way_second, second->question, &definition);
+    }
+    free(way_first.nodes);
+    free(way_second.nodes);
+    return error_code;
+}
+
+akinator_error_t akinator_format_similar(akinator_flow_io_t *io,
+                                         akinator_node_t    *object) {
+    akinator_similar_t similar    = {};
+    akinator_error_t   error_code = akinator_similar_ctor(&similar, SimilarObjectsNumber);
+    if(error_code == AKINATOR_SUCCESS) {
+        error_code = akinator_similar_find(&similar, object, SimilarObjectsNumber);
+    }
+
+    akinator_definition_t definition = {.definition = io->buffer,
+                                        .index      = 0,
+                                        .capacity   = io->buffer_size};
+    if(error_code == AKINATOR_SUCCESS) {
+        error_code = akinator_add_definition(&definition,
+                                             (similar.result_size == 0) ? "%s ни на кого не похож" :
+                                                                          "%s похож на ",
+                                             object->question);
+    }
+    for(size_t index = 0; index < similar.result_size && error_code == AKINATOR_SUCCESS; index++) {
+        error_code = akinator_add_definition(&definition,
+                                             (index == 0) ? "%s" : ", %s",
+                                             similar.result[index].node->question);
+    }
+
+    akinator_similar_dtor(&similar);
+    return error_code;
+}
+
+//only the first SearchShownNumber questions are listed, each with the number of objects under it
+akinator_error_t akinator_format_search(akinator_t            *akinator,
+                                        akinator_flow_io_t    *io,
+                                        const char            *query,
+                                        akinator_index_mode_t  mode) {
+    akinator_index_result_t result     = {};
+    akinator_error_t        error_code = akinator_index_query(&akinator->index, akinator, query, mode, &result);
+
+    akinator_definition_t definition = {.definition = io->buffer,
+                                        .index      = 0,
+                                        .capacity   = io->buffer_size};
+    if(error_code == AKINATOR_SUCCESS) {
+        error_code = akinator_add_definition(&definition,
+                                             (result.size == 0) ? "Таких вопросов нету" :
+                                                                  "Нашлось вопросов: %zu. ",
+                                             result.size);
+    }
+    for(size_t index = 0; index < result.size && index < SearchShownNumber &&
+                          error_code == AKINATOR_SUCCESS; index++) {
+        error_code = akinator_add_definition(&definition,
+                                             (index == 0) ? "%s? (%zu)" : ", %s? (%zu)",
+                                             result.nodes[index]->question,
+                                             result.subtree_sizes[index]);
+    }
+    if(error_code == AKINATOR_SUCCESS && result.size > SearchShownNumber) {
+        error_code = akinator_add_definition(&definition, " и ещё %zu", result.size - SearchShownNumber);
+    }
+
+    akinator_index_result_dtor(&result);
+    return error_code;
+}
+
+size_t akinator_way_size(const akinator_node_way_t *way) {
+    return way->level - 1;
+}
+
+const char *akinator_way_question(const akinator_node_way_t *way,
+                                  size_t                     step) {
+    return way->nodes[way->level - 1 - step]->question;
+}
+
+bool akinator_way_no(const akinator_node_way_t *way,
+                     size_t                     step) {
+    return way->nodes[way->level - 1 - step]->no == way->nodes[way->level - 2 - step];
+}
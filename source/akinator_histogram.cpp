@@ -0,0 +1,85 @@
+#include <string.h>
+
+#include "akinator_histogram.h"
+#include "custom_assert.h"
+
+static size_t   histogram_bucket       (uint64_t value);
+
+static uint64_t histogram_bucket_value (size_t   bucket);
+
+akinator_error_t akinator_histogram_add(akinator_histogram_t *histogram, uint64_t value) {
+    _C_ASSERT(histogram != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    histogram->buckets[histogram_bucket(value)]++;
+    histogram->count++;
+    histogram->sum += value;
+    if(value > histogram->max) {
+        histogram->max = value;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_histogram_merge(akinator_histogram_t       *destination,
+                                          const akinator_histogram_t *source) {
+    _C_ASSERT(destination != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(source      != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    for(size_t bucket = 0; bucket < HistogramBucketsNumber; bucket++) {
+        destination->buckets[bucket] += source->buckets[bucket];
+    }
+    destination->count += source->count;
+    destination->sum   += source->sum;
+    if(source->max > destination->max) {
+        destination->max = source->max;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_histogram_percentile(const akinator_histogram_t *histogram,
+                                               double                      percentile,
+                                               uint64_t                   *value) {
+    _C_ASSERT(histogram  != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(value      != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(percentile >= 0 &&
+              percentile <= 100 , return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    *value = 0;
+    if(histogram->count == 0) {
+        return AKINATOR_SUCCESS;
+    }
+
+    size_t rank = (size_t)((double)histogram->count * percentile / 100);
+    if(rank >= histogram->count) {
+        rank = histogram->count - 1;
+    }
+    size_t seen = 0;
+    for(size_t bucket = 0; bucket < HistogramBucketsNumber; bucket++) {
+        seen += histogram->buckets[bucket];
+        if(seen > rank) {
+            *value = histogram_bucket_value(bucket);
+            break;
+        }
+    }
+    if(*value > histogram->max) {
+        *value = histogram->max;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+size_t histogram_bucket(uint64_t value) {
+    if(value < HistogramSubBuckets) {
+        return (size_t)value;
+    }
+    size_t shift = (size_t)(63 - __builtin_clzll(value)) - HistogramSubBits;
+    return (shift + 1) * HistogramSubBuckets + (size_t)(value >> shift) - HistogramSubBuckets;
+}
+
+//upper bound of the bucket, so percentiles never look better than they are
+uint64_t histogram_bucket_value(size_t bucket) {
+    if(bucket < HistogramSubBuckets) {
+        return bucket;
+    }
+    size_t shift = bucket / HistogramSubBuckets - 1;
+    size_t sub   = bucket % HistogramSubBuckets;
+    return ((uint64_t)(HistogramSubBuckets + sub + 1) << shift) - 1;
+}
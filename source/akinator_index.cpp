@@ -0,0 +1,611 @@
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "akinator.h"
+#include "akinator_index.h"
+#include "akinator_utils.h"
+#include "custom_assert.h"
+#include "colors.h"
+
+static const size_t MaxWordSize          = 64;
+static const size_t InitTableCapacity    = 256;
+static const size_t InitPostingCapacity  = 16;
+static const size_t MaxVarintSize        = 10;
+
+static akinator_error_t index_build_node      (akinator_index_t         *index,
+                                               akinator_node_t          *node);
+
+static akinator_error_t index_add_text        (akinator_index_t         *index,
+                                               const char               *text,
+                                               size_t                    id);
+
+static akinator_error_t index_remove_text     (akinator_index_t         *index,
+                                               const char               *text,
+                                               size_t                    id);
+
+static akinator_error_t index_remove_node     (akinator_index_t         *index,
+                                               akinator_node_t          *node);
+
+static akinator_error_t index_find_posting    (akinator_index_t         *index,
+                                               const char               *word,
+                                               bool                      create,
+                                               akinator_index_posting_t **posting);
+
+static akinator_error_t index_grow_table      (akinator_index_t         *index);
+
+static akinator_error_t index_posting_add     (akinator_index_posting_t *posting,
+                                               size_t                    id);
+
+static akinator_error_t index_posting_remove  (akinator_index_posting_t *posting,
+                                               size_t                    id);
+
+static akinator_error_t index_posting_append  (akinator_index_posting_t *posting,
+                                               size_t                    id);
+
+static akinator_error_t index_posting_decode  (akinator_index_posting_t *posting,
+                                               size_t                   *ids);
+
+static akinator_error_t index_reserve_sizes   (akinator_index_t         *index,
+                                               size_t                    required);
+
+static akinator_error_t index_result_reserve  (akinator_index_result_t  *result,
+                                               size_t                    required);
+
+static akinator_error_t index_merge_posting   (akinator_index_result_t  *result,
+                                               akinator_index_posting_t *posting,
+                                               akinator_index_mode_t     mode);
+
+static size_t           index_next_word       (const char              **text,
+                                               char                     *word);
+
+static char             index_normalize_symbol(unsigned char             symbol);
+
+static size_t           index_hash            (const char               *word);
+
+akinator_error_t akinator_index_build(akinator_index_t *index, akinator_t *akinator) {
+    _C_ASSERT(index          != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(akinator       != NULL, return AKINATOR_NULL_POINTER           );
+    _C_ASSERT(akinator->root != NULL, return AKINATOR_NULL_ROOT              );
+
+    size_t *subtree_sizes    = index->subtree_sizes;
+    size_t  subtree_capacity = index->subtree_capacity;
+    index->subtree_sizes = NULL;
+    akinator_index_dtor(index);
+    index->subtree_sizes    = subtree_sizes;
+    index->subtree_capacity = subtree_capacity;
+
+    RETURN_IF_ERROR(index_reserve_sizes(index, akinator->used_storage));
+    memset(index->subtree_sizes, 0, index->subtree_capacity * sizeof(index->subtree_sizes[0]));
+    RETURN_IF_ERROR(index_build_node   (index, akinator->root));
+
+    //loading gives the children ids before their subtrees, so ids are added in their
+    //own order, every posting is then appended to and never decoded, nodes no longer
+    //in the tree were left with no size
+    for(size_t id = 0; id < akinator->used_storage; id++) {
+        if(index->subtree_sizes[id] < 2) {
+            continue;
+        }
+        akinator_node_t *node = NULL;
+        RETURN_IF_ERROR(akinator_get_node_by_id(akinator, id, &node));
+        RETURN_IF_ERROR(index_add_text         (index, node->question, id));
+    }
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t index_build_node(akinator_index_t *index, akinator_node_t *node) {
+    _C_ASSERT(node != NULL, return AKINATOR_NODE_NULL);
+
+    if(is_leaf(node)) {
+        index->subtree_sizes[node->id] = 1;
+        return AKINATOR_SUCCESS;
+    }
+
+    RETURN_IF_ERROR(index_build_node(index, node->yes));
+    RETURN_IF_ERROR(index_build_node(index, node->no));
+    index->subtree_sizes[node->id] = index->subtree_sizes[node->yes->id] +
+                                     index->subtree_sizes[node->no ->id];
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_index_add_question(akinator_index_t *index, akinator_node_t *node) {
+    _C_ASSERT(index != NULL  , return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(node  != NULL  , return AKINATOR_NODE_NULL             );
+    _C_ASSERT(!is_leaf(node) , return AKINATOR_NODE_NULL             );
+
+    size_t max_id = (node->yes->id > node->no->id) ? node->yes->id : node->no->id;
+    RETURN_IF_ERROR(index_reserve_sizes(index, max_id + 1));
+
+    index->subtree_sizes[node->yes->id] = 1;
+    index->subtree_sizes[node->no ->id] = 1;
+    index->subtree_sizes[node->id]      = 2;
+    for(akinator_node_t *ancestor = node->parent; ancestor != NULL; ancestor = ancestor->parent) {
+        index->subtree_sizes[ancestor->id]++;
+    }
+
+    RETURN_IF_ERROR(index_add_text(index, node->question, node->id));
+    return AKINATOR_SUCCESS;
+}
+
+//leafs are not indexed, a renamed question moves its id from the old words to the new ones
+akinator_error_t akinator_index_rename(akinator_index_t *index,
+                                       akinator_node_t  *node,
+                                       const char       *old_text) {
+    _C_ASSERT(index    != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(node     != NULL, return AKINATOR_NODE_NULL             );
+    _C_ASSERT(old_text != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    if(is_leaf(node)) {
+        return AKINATOR_SUCCESS;
+    }
+    RETURN_IF_ERROR(index_remove_text(index, old_text,       node->id));
+    RETURN_IF_ERROR(index_add_text   (index, node->question, node->id));
+    return AKINATOR_SUCCESS;
+}
+
+//lifted question and the questions of its dropped branch leave the index, ancestors lose
+//the dropped leafs, so a lift costs the dropped branch and the depth instead of the tree
+akinator_error_t akinator_index_lift(akinator_index_t *index,
+                                     akinator_node_t  *node,
+                                     akinator_node_t  *dropped) {
+    _C_ASSERT(index   != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(node    != NULL, return AKINATOR_NODE_NULL             );
+    _C_ASSERT(dropped != NULL, return AKINATOR_NODE_NULL             );
+
+    RETURN_IF_ERROR(index_remove_text(index, node->question, node->id));
+    RETURN_IF_ERROR(index_remove_node(index, dropped));
+    if(dropped->id >= index->subtree_capacity) {
+        return AKINATOR_SUCCESS;
+    }
+
+    size_t dropped_leafs = index->subtree_sizes[dropped->id];
+    for(akinator_node_t *ancestor = node->parent; ancestor != NULL; ancestor = ancestor->parent) {
+        index->subtree_sizes[ancestor->id] -= dropped_leafs;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t index_remove_node(akinator_index_t *index, akinator_node_t *node) {
+    if(is_leaf(node)) {
+        return AKINATOR_SUCCESS;
+    }
+
+    RETURN_IF_ERROR(index_remove_text(index, node->question, node->id));
+    RETURN_IF_ERROR(index_remove_node(index, node->yes));
+    RETURN_IF_ERROR(index_remove_node(index, node->no));
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_index_query(akinator_index_t        *index,
+                                      akinator_t              *akinator,
+                                      const char              *query,
+                                      akinator_index_mode_t    mode,
+                                      akinator_index_result_t *result) {
+    _C_ASSERT(index    != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER           );
+    _C_ASSERT(query    != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(result   != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    result->size = 0;
+    bool is_first = true;
+    char word[MaxWordSize + 1] = {};
+    while(index_next_word(&query, word) != 0) {
+        akinator_index_posting_t *posting = NULL;
+        RETURN_IF_ERROR(index_find_posting(index, word, false, &posting));
+        if(posting == NULL) {
+            if(mode == AKINATOR_INDEX_AND) {
+                result->size = 0;
+                return AKINATOR_SUCCESS;
+            }
+            continue;
+        }
+
+        if(is_first) {
+            RETURN_IF_ERROR(index_result_reserve(result, posting->count));
+            RETURN_IF_ERROR(index_posting_decode(posting, result->scratch));
+            result->size = posting->count;
+            is_first = false;
+        }
+        else {
+            RETURN_IF_ERROR(index_merge_posting(result, posting, mode));
+        }
+    }
+
+    for(size_t element = 0; element < result->size; element++) {
+        size_t id = result->scratch[element];
+        RETURN_IF_ERROR(akinator_get_node_by_id(akinator, id, result->nodes + element));
+        result->subtree_sizes[element] = index->subtree_sizes[id];
+    }
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_index_result_dtor(akinator_index_result_t *result) {
+    _C_ASSERT(result != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    free(result->nodes);
+    free(result->subtree_sizes);
+    free(result->scratch);
+    memset(result, 0, sizeof(*result));
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_index_dtor(akinator_index_t *index) {
+    _C_ASSERT(index != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    for(size_t element = 0; element < index->table_capacity; element++) {
+        free(index->table[element].word);
+        free(index->table[element].data);
+    }
+    free(index->table);
+    free(index->subtree_sizes);
+    memset(index, 0, sizeof(*index));
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t index_add_text(akinator_index_t *index, const char *text, size_t id) {
+    char word[MaxWordSize + 1] = {};
+    while(index_next_word(&text, word) != 0) {
+        akinator_index_posting_t *posting = NULL;
+        RETURN_IF_ERROR(index_find_posting(index, word, true, &posting));
+        RETURN_IF_ERROR(index_posting_add (posting, id));
+    }
+    return AKINATOR_SUCCESS;
+}
+
+//emptied postings keep their word, a query finds no ids in them
+akinator_error_t index_remove_text(akinator_index_t *index, const char *text, size_t id) {
+    char word[MaxWordSize + 1] = {};
+    while(index_next_word(&text, word) != 0) {
+        akinator_index_posting_t *posting = NULL;
+        RETURN_IF_ERROR(index_find_posting  (index, word, false, &posting));
+        if(posting != NULL) {
+            RETURN_IF_ERROR(index_posting_remove(posting, id));
+        }
+    }
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t index_find_posting(akinator_index_t          *index,
+                                    const char                *word,
+                                    bool                       create,
+                                    akinator_index_posting_t **posting) {
+    *posting = NULL;
+    if(create && (index->words_number + 1) * 2 > index->table_capacity) {
+        RETURN_IF_ERROR(index_grow_table(index));
+    }
+    if(index->table_capacity == 0) {
+        return AKINATOR_SUCCESS;
+    }
+
+    size_t mask    = index->table_capacity - 1;
+    size_t element = index_hash(word) & mask;
+    while(index->table[element].word != NULL) {
+        if(strcmp(index->table[element].word, word) == 0) {
+            *posting = index->table + element;
+            return AKINATOR_SUCCESS;
+        }
+        element = (element + 1) & mask;
+    }
+    if(!create) {
+        return AKINATOR_SUCCESS;
+    }
+
+    index->table[element].word = strdup(word);
+    if(index->table[element].word == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while allocating index word.\n");
+        return AKINATOR_INDEX_ALLOCATION_ERROR;
+    }
+    index->words_number++;
+    *posting = index->table + element;
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t index_grow_table(akinator_index_t *index) {
+    size_t new_capacity = (index->table_capacity == 0) ? InitTableCapacity :
+                                                         index->table_capacity * 2;
+    akinator_index_posting_t *new_table = (akinator_index_posting_t *)calloc(new_capacity,
+                                                                             sizeof(new_table[0]));
+    if(new_table == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while allocating index table.\n");
+        return AKINATOR_INDEX_ALLOCATION_ERROR;
+    }
+
+    for(size_t element = 0; element < index->table_capacity; element++) {
+        if(index->table[element].word == NULL) {
+            continue;
+        }
+        size_t position = index_hash(index->table[element].word) & (new_capacity - 1);
+        while(new_table[position].word != NULL) {
+            position = (position + 1) & (new_capacity - 1);
+        }
+        new_table[position] = index->table[element];
+    }
+
+    free(index->table);
+    index->table          = new_table;
+    index->table_capacity = new_capacity;
+    return AKINATOR_SUCCESS;
+}
+
+//ids are delta-encoded varints, learning usually appends the biggest id
+akinator_error_t index_posting_add(akinator_index_posting_t *posting, size_t id) {
+    if(posting->count == 0 || id > posting->last_id) {
+        return index_posting_append(posting, id);
+    }
+
+    size_t *ids = (size_t *)calloc(posting->count + 1, sizeof(ids[0]));
+    if(ids == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while allocating posting list.\n");
+        return AKINATOR_INDEX_ALLOCATION_ERROR;
+    }
+    akinator_error_t error_code = index_posting_decode(posting, ids);
+    if(error_code != AKINATOR_SUCCESS) {
+        free(ids);
+        return error_code;
+    }
+
+    size_t count    = posting->count;
+    size_t position = 0;
+    while(position < count && ids[position] < id) {
+        position++;
+    }
+    if(position < count && ids[position] == id) {
+        free(ids);
+        return AKINATOR_SUCCESS;
+    }
+    memmove(ids + position + 1, ids + position, (count - position) * sizeof(ids[0]));
+    ids[position] = id;
+
+    posting->size  = 0;
+    posting->count = 0;
+    for(size_t element = 0; element <= count; element++) {
+        if((error_code = index_posting_append(posting, ids[element])) != AKINATOR_SUCCESS) {
+            break;
+        }
+    }
+    free(ids);
+    return error_code;
+}
+
+akinator_error_t index_posting_remove(akinator_index_posting_t *posting, size_t id) {
+    if(posting->count == 0 || id > posting->last_id) {
+        return AKINATOR_SUCCESS;
+    }
+
+    size_t *ids = (size_t *)calloc(posting->count, sizeof(ids[0]));
+    if(ids == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while allocating posting list.\n");
+        return AKINATOR_INDEX_ALLOCATION_ERROR;
+    }
+    akinator_error_t error_code = index_posting_decode(posting, ids);
+    if(error_code != AKINATOR_SUCCESS) {
+        free(ids);
+        return error_code;
+    }
+
+    size_t count    = posting->count;
+    size_t position = 0;
+    while(position < count && ids[position] < id) {
+        position++;
+    }
+    if(position == count || ids[position] != id) {
+        free(ids);
+        return AKINATOR_SUCCESS;
+    }
+
+    //ids after the removed one are appended again, their deltas change
+    posting->size  = 0;
+    posting->count = 0;
+    for(size_t element = 0; element < count; element++) {
+        if(element == position) {
+            continue;
+        }
+        if((error_code = index_posting_append(posting, ids[element])) != AKINATOR_SUCCESS) {
+            break;
+        }
+    }
+    free(ids);
+    return error_code;
+}
+
+akinator_error_t index_posting_append(akinator_index_posting_t *posting, size_t id) {
+    if(posting->size + MaxVarintSize > posting->capacity) {
+        size_t   new_capacity = (posting->capacity == 0) ? InitPostingCapacity :
+                                                           posting->capacity * 2;
+        uint8_t *new_data     = (uint8_t *)realloc(posting->data, new_capacity);
+        if(new_data == NULL) {
+            color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                         "Error while allocating posting list.\n");
+            return AKINATOR_INDEX_ALLOCATION_ERROR;
+        }
+        posting->data     = new_data;
+        posting->capacity = new_capacity;
+    }
+
+    size_t delta = (posting->count == 0) ? id : id - posting->last_id;
+    while(delta >= 0x80) {
+        posting->data[posting->size++] = (uint8_t)(delta | 0x80);
+        delta >>= 7;
+    }
+    posting->data[posting->size++] = (uint8_t)delta;
+
+    posting->last_id = id;
+    posting->count++;
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t index_posting_decode(akinator_index_posting_t *posting, size_t *ids) {
+    size_t position = 0;
+    size_t id       = 0;
+    for(size_t element = 0; element < posting->count; element++) {
+        size_t delta = 0;
+        size_t shift = 0;
+        while(posting->data[position] & 0x80) {
+            delta |= (size_t)(posting->data[position++] & 0x7f) << shift;
+            shift += 7;
+        }
+        delta |= (size_t)posting->data[position++] << shift;
+
+        id += delta;
+        ids[element] = id;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t index_merge_posting(akinator_index_result_t  *result,
+                                     akinator_index_posting_t *posting,
+                                     akinator_index_mode_t     mode) {
+    size_t *merged = (size_t *)calloc(result->size + 2 * posting->count + 1, sizeof(merged[0]));
+    if(merged == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while allocating query buffer.\n");
+        return AKINATOR_INDEX_ALLOCATION_ERROR;
+    }
+    size_t *other = merged + result->size + posting->count;
+    index_posting_decode(posting, other);
+
+    size_t first  = 0;
+    size_t second = 0;
+    size_t size   = 0;
+    while(first < result->size && second < posting->count) {
+        if(result->scratch[first] == other[second]) {
+            merged[size++] = result->scratch[first];
+            first++;
+            second++;
+        }
+        else if(result->scratch[first] < other[second]) {
+            if(mode == AKINATOR_INDEX_OR) {
+                merged[size++] = result->scratch[first];
+            }
+            first++;
+        }
+        else {
+            if(mode == AKINATOR_INDEX_OR) {
+                merged[size++] = other[second];
+            }
+            second++;
+        }
+    }
+    if(mode == AKINATOR_INDEX_OR) {
+        while(first  < result->size   ) {merged[size++] = result->scratch[first++];}
+        while(second < posting->count) {merged[size++] = other[second++];         }
+    }
+
+    akinator_error_t error_code = index_result_reserve(result, size);
+    if(error_code == AKINATOR_SUCCESS) {
+        memcpy(result->scratch, merged, size * sizeof(merged[0]));
+        result->size = size;
+    }
+    free(merged);
+    return error_code;
+}
+
+akinator_error_t index_reserve_sizes(akinator_index_t *index, size_t required) {
+    if(required <= index->subtree_capacity) {
+        return AKINATOR_SUCCESS;
+    }
+
+    size_t new_capacity = (index->subtree_capacity == 0) ? required : index->subtree_capacity;
+    while(new_capacity < required) {
+        new_capacity *= 2;
+    }
+    size_t *new_sizes = (size_t *)realloc(index->subtree_sizes, new_capacity * sizeof(new_sizes[0]));
+    if(new_sizes == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while allocating subtree sizes.\n");
+        return AKINATOR_INDEX_ALLOCATION_ERROR;
+    }
+    memset(new_sizes + index->subtree_capacity, 0,
+           (new_capacity - index->subtree_capacity) * sizeof(new_sizes[0]));
+
+    index->subtree_sizes    = new_sizes;
+    index->subtree_capacity = new_capacity;
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t index_result_reserve(akinator_index_result_t *result, size_t required) {
+    if(required <= result->capacity && result->scratch != NULL) {
+        return AKINATOR_SUCCESS;
+    }
+
+    size_t new_capacity = (result->capacity == 0) ? required + 1 : result->capacity;
+    while(new_capacity < required) {
+        new_capacity *= 2;
+    }
+    akinator_node_t **nodes   = (akinator_node_t **)realloc(result->nodes,
+                                                            new_capacity * sizeof(nodes[0]));
+    if(nodes != NULL) {
+        result->nodes = nodes;
+    }
+    size_t           *sizes   = (size_t *)realloc(result->subtree_sizes,
+                                                  new_capacity * sizeof(sizes[0]));
+    if(sizes != NULL) {
+        result->subtree_sizes = sizes;
+    }
+    size_t           *scratch = (size_t *)realloc(result->scratch,
+                                                  new_capacity * sizeof(scratch[0]));
+    if(scratch != NULL) {
+        result->scratch = scratch;
+    }
+    if(nodes == NULL || sizes == NULL || scratch == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while allocating query result.\n");
+        return AKINATOR_INDEX_ALLOCATION_ERROR;
+    }
+
+    result->capacity = new_capacity;
+    return AKINATOR_SUCCESS;
+}
+
+size_t index_next_word(const char **text, char *word) {
+    const char *symbol = *text;
+    while(*symbol != '\0' && index_normalize_symbol((unsigned char)*symbol) == '\0') {
+        symbol++;
+    }
+
+    size_t length = 0;
+    while(*symbol != '\0') {
+        char normalized = index_normalize_symbol((unsigned char)*symbol);
+        if(normalized == '\0') {
+            break;
+        }
+        if(length < MaxWordSize) {
+            word[length++] = normalized;
+        }
+        symbol++;
+    }
+
+    word[length] = '\0';
+    *text = symbol;
+    return length;
+}
+
+//CP1251: 0xC0-0xDF are capital letters, 0xE0-0xFF small ones, 0xA8/0xB8 are YO
+char index_normalize_symbol(unsigned char symbol) {
+    if(symbol < 0x80) {
+        return isalnum(symbol) ? (char)tolower(symbol) : '\0';
+    }
+    if(symbol == 0xA8 || symbol == 0xB8) {
+        return (char)0xE5;
+    }
+    if(symbol >= 0xC0 && symbol <= 0xDF) {
+        return (char)(symbol + 0x20);
+    }
+    if(symbol >= 0xE0) {
+        return (char)symbol;
+    }
+    return '\0';
+}
+
+size_t index_hash(const char *word) {
+    size_t hash = 14695981039346656037ull;
+    for(; *word != '\0'; word++) {
+        hash ^= (unsigned char)*word;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
@@ -0,0 +1,192 @@
+#include <stdlib.h>
+
+#include "akinator_layout.h"
+#include "custom_assert.h"
+
+static const uint32_t LayoutNoLink = UINT32_MAX;
+
+//deepest node of a subtree on one side, offset is from the subtree root
+struct layout_extreme_t {
+    uint32_t node;
+    int32_t  offset;
+    uint32_t level;
+};
+
+//left and right are the children, a leaf at the bottom of an outer contour gets one
+//of them pointed further down the contour of a deeper neighbour, offset is then the
+//horizontal distance to it instead of the distance to each child
+struct layout_node_t {
+    uint32_t         left;
+    uint32_t         right;
+    int32_t          offset;
+    layout_extreme_t left_most;
+    layout_extreme_t right_most;
+};
+
+static void layout_setup_node (layout_node_t             *nodes,
+                               const akinator_dump_job_t *job,
+                               uint32_t                   index);
+
+//reingold-tilford for full binary trees, children come after their parent in the
+//breadth first snapshot, so walking it backwards places every subtree before its
+//parent and needs no recursion, then absolute x goes down in snapshot order
+akinator_error_t akinator_layout_ctor(akinator_layout_t         *layout,
+                                      const akinator_dump_job_t *job) {
+    _C_ASSERT(layout                    != NULL,         return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(job                       != NULL,         return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(job->entries_number       != 0,            return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(job->entries_number        < LayoutNoLink, return AKINATOR_DUMP_WORKER_ERROR      );
+
+    layout_node_t *nodes = (layout_node_t *)calloc(job->entries_number, sizeof(*nodes));
+    layout->x            = (int32_t       *)calloc(job->entries_number, sizeof(*layout->x));
+    if(nodes == NULL || layout->x == NULL) {
+        free(nodes);
+        free(layout->x);
+        layout->x = NULL;
+        return AKINATOR_DUMP_WORKER_ERROR;
+    }
+    layout->nodes_number = job->entries_number;
+
+    for(uint32_t index = (uint32_t)job->entries_number; index-- > 0;) {
+        layout_setup_node(nodes, job, index);
+    }
+
+    int32_t min_x = 0;
+    int32_t max_x = 0;
+    layout->depth = 0;
+    for(size_t index = 0; index < job->entries_number; index++) {
+        const akinator_dump_entry_t *entry = &job->entries[index];
+        if(entry->level > layout->depth) {
+            layout->depth = entry->level;
+        }
+        if(layout->x[index] < min_x) {
+            min_x = layout->x[index];
+        }
+        if(layout->x[index] > max_x) {
+            max_x = layout->x[index];
+        }
+        if(entry->yes == DumpNoChild) {
+            continue;
+        }
+        layout->x[entry->yes] = layout->x[index] - nodes[index].offset;
+        layout->x[entry->no]  = layout->x[index] + nodes[index].offset;
+    }
+    for(size_t index = 0; index < job->entries_number; index++) {
+        layout->x[index] -= min_x;
+    }
+    layout->width = max_x - min_x;
+
+    free(nodes);
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_layout_dtor(akinator_layout_t *layout) {
+    _C_ASSERT(layout != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    free(layout->x);
+    layout->x            = NULL;
+    layout->nodes_number = 0;
+    return AKINATOR_SUCCESS;
+}
+
+//right contour of the yes subtree and left contour of the no subtree go down side by
+//side, the root separation grows wherever they come closer than LayoutMinSeparation,
+//then the shallower subtree's outer contour is threaded on into the deeper one
+void layout_setup_node(layout_node_t             *nodes,
+                       const akinator_dump_job_t *job,
+                       uint32_t                   index) {
+    const akinator_dump_entry_t *entry = &job->entries[index];
+    layout_node_t               *node  = &nodes[index];
+    if(entry->yes == DumpNoChild) {
+        node->left       = LayoutNoLink;
+        node->right      = LayoutNoLink;
+        node->offset     = 0;
+        node->left_most  = {.node = index, .offset = 0, .level = (uint32_t)entry->level};
+        node->right_most = node->left_most;
+        return;
+    }
+
+    node->left  = (uint32_t)entry->yes;
+    node->right = (uint32_t)entry->no;
+    layout_extreme_t left_left   = nodes[node->left ].left_most;
+    layout_extreme_t left_right  = nodes[node->left ].right_most;
+    layout_extreme_t right_left  = nodes[node->right].left_most;
+    layout_extreme_t right_right = nodes[node->right].right_most;
+
+    uint32_t left              = node->left;
+    uint32_t right             = node->right;
+    int32_t  separation        = LayoutMinSeparation;
+    int32_t  root_separation   = LayoutMinSeparation;
+    int32_t  left_offset_sum   = 0;
+    int32_t  right_offset_sum  = 0;
+    while(left != LayoutNoLink && right != LayoutNoLink) {
+        if(separation < LayoutMinSeparation) {
+            root_separation += LayoutMinSeparation - separation;
+            separation       = LayoutMinSeparation;
+        }
+        if(nodes[left].right != LayoutNoLink) {
+            left_offset_sum += nodes[left].offset;
+            separation      -= nodes[left].offset;
+            left             = nodes[left].right;
+        }
+        else {
+            left_offset_sum -= nodes[left].offset;
+            separation      += nodes[left].offset;
+            left             = nodes[left].left;
+        }
+        if(nodes[right].left != LayoutNoLink) {
+            right_offset_sum -= nodes[right].offset;
+            separation       -= nodes[right].offset;
+            right             = nodes[right].left;
+        }
+        else {
+            right_offset_sum += nodes[right].offset;
+            separation       += nodes[right].offset;
+            right             = nodes[right].right;
+        }
+    }
+
+    node->offset      = (root_separation + 1) / 2;
+    left_offset_sum  -= node->offset;
+    right_offset_sum += node->offset;
+
+    if(right_left.level > left_left.level) {
+        node->left_most         = right_left;
+        node->left_most.offset += node->offset;
+    }
+    else {
+        node->left_most         = left_left;
+        node->left_most.offset -= node->offset;
+    }
+    if(left_right.level > right_right.level) {
+        node->right_most         = left_right;
+        node->right_most.offset -= node->offset;
+    }
+    else {
+        node->right_most         = right_right;
+        node->right_most.offset += node->offset;
+    }
+
+    if(left != LayoutNoLink) {
+        layout_node_t *bottom = &nodes[right_right.node];
+        int32_t        from   = right_right.offset + node->offset;
+        bottom->offset = abs(from - left_offset_sum);
+        if(left_offset_sum <= from) {
+            bottom->left  = left;
+        }
+        else {
+            bottom->right = left;
+        }
+    }
+    else if(right != LayoutNoLink) {
+        layout_node_t *bottom = &nodes[left_left.node];
+        int32_t        from   = left_left.offset - node->offset;
+        bottom->offset = abs(from - right_offset_sum);
+        if(right_offset_sum >= from) {
+            bottom->right = right;
+        }
+        else {
+            bottom->left  = right;
+        }
+    }
+}
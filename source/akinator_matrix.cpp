@@ -0,0 +1,342 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "akinator_matrix.h"
+#include "akinator_utils.h"
+#include "custom_assert.h"
+#include "colors.h"
+
+static const size_t BitsInWord = 64;
+
+static akinator_error_t akinator_matrix_count       (akinator_node_t   *node,
+                                                     size_t            *objects_number,
+                                                     size_t            *questions_number);
+
+static akinator_error_t akinator_matrix_fill        (akinator_matrix_t *matrix,
+                                                     akinator_node_t   *node,
+                                                     size_t            *objects_filled,
+                                                     size_t            *questions_filled,
+                                                     size_t            *index_output);
+
+static akinator_error_t akinator_matrix_recount     (akinator_matrix_t *matrix);
+
+static void             akinator_matrix_clear_range (uint64_t          *words,
+                                                     size_t             begin,
+                                                     size_t             end);
+
+static size_t           akinator_matrix_count_range (akinator_matrix_t *matrix,
+                                                     size_t             begin,
+                                                     size_t             end);
+
+static size_t           akinator_matrix_count_before(akinator_matrix_t *matrix,
+                                                     size_t             position);
+
+static double           akinator_matrix_split_gain  (size_t             count_yes,
+                                                     size_t             count_no);
+
+static size_t           words_for_bits              (size_t             bits);
+
+static size_t           popcount                    (uint64_t           word);
+
+akinator_error_t akinator_matrix_ctor(akinator_matrix_t *matrix,
+                                      akinator_t        *akinator) {
+    _C_ASSERT(matrix         != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(akinator       != NULL, return AKINATOR_NULL_POINTER           );
+    _C_ASSERT(akinator->root != NULL, return AKINATOR_NULL_ROOT              );
+
+    size_t objects_number   = 0;
+    size_t questions_number = 0;
+    RETURN_IF_ERROR(akinator_matrix_count(akinator->root,
+                                          &objects_number,
+                                          &questions_number));
+
+    matrix->objects_number   = objects_number;
+    matrix->questions_number = questions_number;
+    matrix->words_number     = words_for_bits(objects_number);
+
+    matrix->objects      = (akinator_node_t **)calloc(objects_number, sizeof(matrix->objects[0]));
+    matrix->questions    = (akinator_matrix_question_t *)calloc(questions_number + 1,
+                                                                sizeof(matrix->questions[0]));
+    matrix->candidates   = (uint64_t *)calloc(matrix->words_number, sizeof(matrix->candidates[0]));
+    matrix->asked        = (uint64_t *)calloc(words_for_bits(questions_number) + 1,
+                                              sizeof(matrix->asked[0]));
+    matrix->words_prefix = (size_t *)calloc(matrix->words_number + 1,
+                                            sizeof(matrix->words_prefix[0]));
+    matrix->search_stack = (size_t *)calloc(questions_number + 1,
+                                            sizeof(matrix->search_stack[0]));
+    if(matrix->objects      == NULL || matrix->questions    == NULL ||
+       matrix->candidates   == NULL || matrix->asked        == NULL ||
+       matrix->words_prefix == NULL || matrix->search_stack == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while allocating attribute matrix.\n");
+        akinator_matrix_dtor(matrix);
+        return AKINATOR_MATRIX_ALLOCATION_ERROR;
+    }
+
+    size_t objects_filled   = 0;
+    size_t questions_filled = 0;
+    size_t root_index       = 0;
+    RETURN_IF_ERROR(akinator_matrix_fill(matrix,
+                                         akinator->root,
+                                         &objects_filled,
+                                         &questions_filled,
+                                         &root_index));
+
+    RETURN_IF_ERROR(akinator_matrix_reset(matrix));
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_matrix_count(akinator_node_t *node,
+                                       size_t          *objects_number,
+                                       size_t          *questions_number) {
+    _C_ASSERT(node != NULL, return AKINATOR_NODE_NULL);
+
+    if(is_leaf(node)) {
+        (*objects_number)++;
+        return AKINATOR_SUCCESS;
+    }
+
+    (*questions_number)++;
+    RETURN_IF_ERROR(akinator_matrix_count(node->yes, objects_number, questions_number));
+    RETURN_IF_ERROR(akinator_matrix_count(node->no,  objects_number, questions_number));
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_matrix_fill(akinator_matrix_t *matrix,
+                                      akinator_node_t   *node,
+                                      size_t            *objects_filled,
+                                      size_t            *questions_filled,
+                                      size_t            *index_output) {
+    _C_ASSERT(node != NULL, return AKINATOR_NODE_NULL);
+
+    if(is_leaf(node)) {
+        matrix->objects[(*objects_filled)++] = node;
+        *index_output = MatrixNoIndex;
+        return AKINATOR_SUCCESS;
+    }
+
+    size_t index = (*questions_filled)++;
+    akinator_matrix_question_t *question = matrix->questions + index;
+
+    question->node      = node;
+    question->yes_begin = *objects_filled;
+    RETURN_IF_ERROR(akinator_matrix_fill(matrix,
+                                         node->yes,
+                                         objects_filled,
+                                         questions_filled,
+                                         &question->yes_question));
+    question->no_begin  = *objects_filled;
+    RETURN_IF_ERROR(akinator_matrix_fill(matrix,
+                                         node->no,
+                                         objects_filled,
+                                         questions_filled,
+                                         &question->no_question));
+    question->end       = *objects_filled;
+
+    *index_output = index;
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_matrix_reset(akinator_matrix_t *matrix) {
+    _C_ASSERT(matrix != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    memset(matrix->candidates, 0xff, matrix->words_number * sizeof(matrix->candidates[0]));
+    size_t tail = matrix->objects_number % BitsInWord;
+    if(tail != 0) {
+        matrix->candidates[matrix->words_number - 1] = ((uint64_t)1 << tail) - 1;
+    }
+    memset(matrix->asked, 0, words_for_bits(matrix->questions_number) * sizeof(matrix->asked[0]));
+
+    matrix->current_question = MatrixNoIndex;
+    matrix->current_guess    = MatrixNoIndex;
+    return akinator_matrix_recount(matrix);
+}
+
+akinator_error_t akinator_matrix_next_question(akinator_matrix_t *matrix,
+                                               akinator_node_t  **question) {
+    _C_ASSERT(matrix   != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(question != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    *question = NULL;
+    matrix->current_question = MatrixNoIndex;
+    if(matrix->candidates_number <= 1 || matrix->questions_number == 0) {
+        return AKINATOR_SUCCESS;
+    }
+
+    size_t best_index = MatrixNoIndex;
+    double best_gain  = 0;
+    size_t stack_size = 0;
+    matrix->search_stack[stack_size++] = 0;
+
+    while(stack_size != 0) {
+        size_t                      index   = matrix->search_stack[--stack_size];
+        akinator_matrix_question_t *current = matrix->questions + index;
+
+        size_t count_yes = akinator_matrix_count_range(matrix, current->yes_begin, current->no_begin);
+        size_t count_no  = akinator_matrix_count_range(matrix, current->no_begin,  current->end);
+
+        bool is_asked = (matrix->asked[index / BitsInWord] >> (index % BitsInWord)) & 1;
+        if(!is_asked && count_yes != 0 && count_no != 0) {
+            double gain = akinator_matrix_split_gain(count_yes, count_no);
+            if(gain > best_gain) {
+                best_gain  = gain;
+                best_index = index;
+            }
+        }
+
+        //questions in a subtree can not split more candidates than the subtree holds
+        if(current->yes_question != MatrixNoIndex && (double)count_yes > best_gain) {
+            matrix->search_stack[stack_size++] = current->yes_question;
+        }
+        if(current->no_question  != MatrixNoIndex && (double)count_no  > best_gain) {
+            matrix->search_stack[stack_size++] = current->no_question;
+        }
+    }
+
+    if(best_index != MatrixNoIndex) {
+        matrix->current_question = best_index;
+        *question = matrix->questions[best_index].node;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_matrix_answer(akinator_matrix_t *matrix,
+                                        akinator_answer_t  answer) {
+    _C_ASSERT(matrix                   != NULL,          return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(matrix->current_question != MatrixNoIndex, return AKINATOR_NODE_NULL             );
+
+    size_t                      index   = matrix->current_question;
+    akinator_matrix_question_t *current = matrix->questions + index;
+    switch(answer) {
+        case AKINATOR_ANSWER_YES: {
+            akinator_matrix_clear_range(matrix->candidates, current->no_begin, current->end);
+            break;
+        }
+        case AKINATOR_ANSWER_NO: {
+            akinator_matrix_clear_range(matrix->candidates, current->yes_begin, current->no_begin);
+            break;
+        }
+        case AKINATOR_ANSWER_UNKNOWN:
+        case AKINATOR_ANSWER_PROBABLY:
+        case AKINATOR_ANSWER_PROBABLY_NOT: {
+            break;
+        }
+        default: {
+            return AKINATOR_USER_ANSWER_ERROR;
+        }
+    }
+
+    matrix->asked[index / BitsInWord] |= (uint64_t)1 << (index % BitsInWord);
+    matrix->current_question = MatrixNoIndex;
+    return akinator_matrix_recount(matrix);
+}
+
+akinator_error_t akinator_matrix_get_guess(akinator_matrix_t *matrix,
+                                           akinator_node_t  **object) {
+    _C_ASSERT(matrix != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(object != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    *object = NULL;
+    matrix->current_guess = MatrixNoIndex;
+    for(size_t word = 0; word < matrix->words_number; word++) {
+        if(matrix->candidates[word] != 0) {
+            size_t bit = (size_t)__builtin_ctzll((unsigned long long)matrix->candidates[word]);
+            matrix->current_guess = word * BitsInWord + bit;
+            *object = matrix->objects[matrix->current_guess];
+            return AKINATOR_SUCCESS;
+        }
+    }
+
+    return AKINATOR_NODE_NULL;
+}
+
+akinator_error_t akinator_matrix_reject_guess(akinator_matrix_t *matrix) {
+    _C_ASSERT(matrix                != NULL,          return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(matrix->current_guess != MatrixNoIndex, return AKINATOR_NODE_NULL             );
+
+    akinator_matrix_clear_range(matrix->candidates,
+                                matrix->current_guess,
+                                matrix->current_guess + 1);
+    matrix->current_guess = MatrixNoIndex;
+    return akinator_matrix_recount(matrix);
+}
+
+akinator_error_t akinator_matrix_dtor(akinator_matrix_t *matrix) {
+    _C_ASSERT(matrix != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    free(matrix->objects);
+    free(matrix->questions);
+    free(matrix->candidates);
+    free(matrix->asked);
+    free(matrix->words_prefix);
+    free(matrix->search_stack);
+    memset(matrix, 0, sizeof(*matrix));
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_matrix_recount(akinator_matrix_t *matrix) {
+    _C_ASSERT(matrix != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    matrix->words_prefix[0] = 0;
+    for(size_t word = 0; word < matrix->words_number; word++) {
+        matrix->words_prefix[word + 1] = matrix->words_prefix[word] +
+                                         popcount(matrix->candidates[word]);
+    }
+    matrix->candidates_number = matrix->words_prefix[matrix->words_number];
+    return AKINATOR_SUCCESS;
+}
+
+//ANDNOT of the candidates with a column run, inner words are cleared whole
+void akinator_matrix_clear_range(uint64_t *words, size_t begin, size_t end) {
+    if(begin >= end) {
+        return;
+    }
+
+    size_t   first      = begin   / BitsInWord;
+    size_t   last       = (end - 1) / BitsInWord;
+    uint64_t first_mask = ~(uint64_t)0 << (begin % BitsInWord);
+    uint64_t last_mask  = ~(uint64_t)0 >> (BitsInWord - 1 - (end - 1) % BitsInWord);
+
+    if(first == last) {
+        words[first] &= ~(first_mask & last_mask);
+        return;
+    }
+
+    words[first] &= ~first_mask;
+    for(size_t word = first + 1; word < last; word++) {
+        words[word] = 0;
+    }
+    words[last]  &= ~last_mask;
+}
+
+size_t akinator_matrix_count_range(akinator_matrix_t *matrix, size_t begin, size_t end) {
+    return akinator_matrix_count_before(matrix, end) -
+           akinator_matrix_count_before(matrix, begin);
+}
+
+size_t akinator_matrix_count_before(akinator_matrix_t *matrix, size_t position) {
+    size_t word  = position / BitsInWord;
+    size_t bit   = position % BitsInWord;
+    size_t count = matrix->words_prefix[word];
+    if(bit != 0) {
+        count += popcount(matrix->candidates[word] & (((uint64_t)1 << bit) - 1));
+    }
+    return count;
+}
+
+double akinator_matrix_split_gain(size_t count_yes, size_t count_no) {
+    double total       = (double)(count_yes + count_no);
+    double probability = (double)count_yes / total;
+    double entropy     = -probability       * log2(probability) -
+                         (1 - probability) * log2(1 - probability);
+    return total * entropy;
+}
+
+size_t words_for_bits(size_t bits) {
+    return (bits + BitsInWord - 1) / BitsInWord;
+}
+
+size_t popcount(uint64_t word) {
+    return (size_t)__builtin_popcountll((unsigned long long)word);
+}
@@ -0,0 +1,197 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "akinator_normalize.h"
+#include "akinator_tree.h"
+#include "akinator_utils.h"
+#include "custom_assert.h"
+#include "colors.h"
+
+struct normalize_path_element_t {
+    const char        *question;
+    akinator_answer_t  branch;
+};
+
+struct normalize_context_t {
+    akinator_t                 *akinator;
+    normalize_path_element_t   *path;
+    akinator_normalize_stats_t *stats;
+};
+
+static akinator_error_t akinator_normalize_node      (normalize_context_t *context,
+                                                      akinator_node_t    **slot,
+                                                      size_t               depth);
+
+static akinator_error_t akinator_normalize_measure   (akinator_node_t     *node,
+                                                      size_t               depth,
+                                                      size_t              *nodes_number,
+                                                      size_t              *leafs_number,
+                                                      size_t              *depths_sum);
+
+static akinator_error_t akinator_normalize_get_stats (akinator_node_t     *root,
+                                                      size_t              *nodes_number,
+                                                      double              *average_depth);
+
+static akinator_error_t akinator_count_duplicates    (akinator_t          *akinator,
+                                                      size_t              *duplicates);
+
+static int              compare_leafs_names          (const void          *first,
+                                                      const void          *second);
+
+akinator_error_t akinator_normalize(akinator_t                 *akinator,
+                                    akinator_normalize_stats_t *stats) {
+    _C_ASSERT(akinator       != NULL, return AKINATOR_NULL_POINTER           );
+    _C_ASSERT(akinator->root != NULL, return AKINATOR_NULL_ROOT              );
+    _C_ASSERT(stats          != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    memset(stats, 0, sizeof(*stats));
+    RETURN_IF_ERROR(akinator_normalize_get_stats(akinator->root,
+                                                 &stats->nodes_before,
+                                                 &stats->depth_before));
+
+    normalize_context_t context = {
+        .akinator = akinator,
+        .path     = (normalize_path_element_t *)calloc(stats->nodes_before + 1,
+                                                       sizeof(context.path[0])),
+        .stats    = stats
+    };
+    if(context.path == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while allocating normalization path.\n");
+        return AKINATOR_WAY_ARRAY_NULL;
+    }
+
+    akinator_error_t error_code = akinator_normalize_node(&context, &akinator->root, 0);
+    free(context.path);
+    if(error_code != AKINATOR_SUCCESS) {
+        return error_code;
+    }
+    akinator->root->parent = NULL;
+    akinator_trace_node(akinator->trace, TRACE_EVENT_NORMALIZE, stats->removed_questions, stats->merged_leafs);
+
+    RETURN_IF_ERROR(akinator_collect_leafs      (akinator));
+    RETURN_IF_ERROR(akinator_count_duplicates   (akinator, &stats->duplicate_leafs));
+    RETURN_IF_ERROR(akinator_normalize_get_stats(akinator->root,
+                                                 &stats->nodes_after,
+                                                 &stats->depth_after));
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_normalize_print(akinator_normalize_stats_t *stats) {
+    _C_ASSERT(stats != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                 "Normalization: nodes %zu -> %zu, average depth %.2f -> %.2f, "
+                 "removed questions %zu, merged leafs %zu, duplicate objects left %zu.\n",
+                 stats->nodes_before,
+                 stats->nodes_after,
+                 stats->depth_before,
+                 stats->depth_after,
+                 stats->removed_questions,
+                 stats->merged_leafs,
+                 stats->duplicate_leafs);
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_normalize_node(normalize_context_t *context,
+                                         akinator_node_t    **slot,
+                                         size_t               depth) {
+    _C_ASSERT(slot  != NULL, return AKINATOR_NODE_NULL);
+    _C_ASSERT(*slot != NULL, return AKINATOR_NODE_NULL);
+
+    akinator_node_t *node = *slot;
+    //question already asked on the path has a forced answer, other branch is unreachable
+    while(!is_leaf(node)) {
+        size_t ancestor = 0;
+        while(ancestor < depth && strcmp(context->path[ancestor].question, node->question) != 0) {
+            ancestor++;
+        }
+        if(ancestor == depth) {
+            break;
+        }
+
+        akinator_node_t *kept = (context->path[ancestor].branch == AKINATOR_ANSWER_YES) ?
+                                node->yes : node->no;
+        kept->parent = node->parent;
+        *slot = kept;
+        node  = kept;
+        context->stats->removed_questions++;
+    }
+    if(is_leaf(node)) {
+        return AKINATOR_SUCCESS;
+    }
+
+    context->path[depth].question = node->question;
+    context->path[depth].branch   = AKINATOR_ANSWER_YES;
+    RETURN_IF_ERROR(akinator_normalize_node(context, &node->yes, depth + 1));
+    context->path[depth].branch   = AKINATOR_ANSWER_NO;
+    RETURN_IF_ERROR(akinator_normalize_node(context, &node->no,  depth + 1));
+
+    //question leading to the same object twice does not split anything
+    if(is_leaf(node->yes) && is_leaf(node->no) &&
+       strcmp(node->yes->question, node->no->question) == 0) {
+        node->yes->parent = node->parent;
+        *slot = node->yes;
+        context->stats->merged_leafs++;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+//same object under two different answer paths is only counted: each copy is what some
+//answers lead to, dropping one would lose those answers and picking the right copy
+//needs a person who knows the object
+akinator_error_t akinator_count_duplicates(akinator_t *akinator, size_t *duplicates) {
+    akinator_node_t **sorted = (akinator_node_t **)calloc(akinator->leafs_array_size + 1,
+                                                          sizeof(sorted[0]));
+    if(sorted == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while allocating leafs copy.\n");
+        return AKINATOR_LEAFS_ALLOCATING_ERROR;
+    }
+    memcpy(sorted, akinator->leafs_array, akinator->leafs_array_size * sizeof(sorted[0]));
+    qsort(sorted, akinator->leafs_array_size, sizeof(sorted[0]), compare_leafs_names);
+
+    *duplicates = 0;
+    for(size_t index = 1; index < akinator->leafs_array_size; index++) {
+        if(strcmp(sorted[index - 1]->question, sorted[index]->question) == 0) {
+            (*duplicates)++;
+        }
+    }
+    free(sorted);
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_normalize_get_stats(akinator_node_t *root,
+                                              size_t          *nodes_number,
+                                              double          *average_depth) {
+    size_t leafs_number = 0;
+    size_t depths_sum   = 0;
+    *nodes_number = 0;
+    RETURN_IF_ERROR(akinator_normalize_measure(root, 0, nodes_number, &leafs_number, &depths_sum));
+
+    *average_depth = (double)depths_sum / (double)leafs_number;
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_normalize_measure(akinator_node_t *node,
+                                            size_t           depth,
+                                            size_t          *nodes_number,
+                                            size_t          *leafs_number,
+                                            size_t          *depths_sum) {
+    _C_ASSERT(node != NULL, return AKINATOR_NODE_NULL);
+
+    (*nodes_number)++;
+    if(is_leaf(node)) {
+        (*leafs_number)++;
+        *depths_sum += depth;
+        return AKINATOR_SUCCESS;
+    }
+    RETURN_IF_ERROR(akinator_normalize_measure(node->yes, depth + 1, nodes_number, leafs_number, depths_sum));
+    RETURN_IF_ERROR(akinator_normalize_measure(node->no,  depth + 1, nodes_number, leafs_number, depths_sum));
+    return AKINATOR_SUCCESS;
+}
+
+int compare_leafs_names(const void *first, const void *second) {
+    return strcmp((*(akinator_node_t *const *)first )->question,
+                  (*(akinator_node_t *const *)second)->question);
+}
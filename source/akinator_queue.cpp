@@ -0,0 +1,72 @@
+#include <string.h>
+
+#include "akinator_queue.h"
+#include "custom_assert.h"
+
+static void akinator_queue_link (akinator_queue_t      *queue,
+                                 akinator_queue_node_t *node);
+
+akinator_error_t akinator_queue_ctor(akinator_queue_t *queue) {
+    _C_ASSERT(queue != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    memset(queue, 0, sizeof(*queue));
+    queue->head = &queue->stub;
+    queue->tail = &queue->stub;
+    return AKINATOR_SUCCESS;
+}
+
+//wait-free for producers: one exchange and one store
+akinator_error_t akinator_queue_push(akinator_queue_t      *queue,
+                                     akinator_queue_node_t *node) {
+    _C_ASSERT(queue != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(node  != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    __atomic_fetch_add(&queue->depth, 1, __ATOMIC_SEQ_CST);
+    akinator_queue_link(queue, node);
+    return AKINATOR_SUCCESS;
+}
+
+//consumer only, returns NULL when the queue is empty or the newest producer
+//has not linked its node yet, so callers retry instead of treating it as empty
+akinator_queue_node_t *akinator_queue_pop(akinator_queue_t *queue) {
+    _C_ASSERT(queue != NULL, return NULL);
+
+    akinator_queue_node_t *tail = queue->tail;
+    akinator_queue_node_t *next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    if(tail == &queue->stub) {
+        if(next == NULL) {
+            return NULL;
+        }
+        queue->tail = next;
+        tail        = next;
+        next        = __atomic_load_n(&next->next, __ATOMIC_ACQUIRE);
+    }
+    if(next == NULL) {
+        if(tail != __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE)) {
+            return NULL;
+        }
+        //last node can only leave once something is linked after it
+        akinator_queue_link(queue, &queue->stub);
+        next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+        if(next == NULL) {
+            return NULL;
+        }
+    }
+
+    queue->tail = next;
+    __atomic_fetch_sub(&queue->depth, 1, __ATOMIC_RELAXED);
+    return tail;
+}
+
+size_t akinator_queue_depth(akinator_queue_t *queue) {
+    _C_ASSERT(queue != NULL, return 0);
+
+    return __atomic_load_n(&queue->depth, __ATOMIC_SEQ_CST);
+}
+
+void akinator_queue_link(akinator_queue_t      *queue,
+                         akinator_queue_node_t *node) {
+    __atomic_store_n(&node->next, (akinator_queue_node_t *)NULL, __ATOMIC_RELAXED);
+    akinator_queue_node_t *previous = __atomic_exchange_n(&queue->head, node, __ATOMIC_ACQ_REL);
+    __atomic_store_n(&previous->next, node, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,126 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "akinator_session.h"
+#include "akinator_tree.h"
+#include "akinator_utils.h"
+#include "custom_assert.h"
+#include "colors.h"
+
+static akinator_error_t akinator_session_move (akinator_session_t *session,
+                                               akinator_node_t    *next);
+
+akinator_error_t akinator_session_start(akinator_session_t *session,
+                                        akinator_t         *akinator) {
+    _C_ASSERT(session        != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(akinator       != NULL, return AKINATOR_NULL_POINTER           );
+    _C_ASSERT(akinator->root != NULL, return AKINATOR_NULL_ROOT              );
+
+    session->akinator        = akinator;
+    session->questions_asked = 0;
+    return akinator_session_move(session, __atomic_load_n(&akinator->root, __ATOMIC_ACQUIRE));
+}
+
+akinator_error_t akinator_session_current_question(akinator_session_t *session,
+                                                   const char        **question) {
+    _C_ASSERT(session  != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(question != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    if(session->state != AKINATOR_SESSION_ASKING   &&
+       session->state != AKINATOR_SESSION_GUESSING &&
+       session->state != AKINATOR_SESSION_LEARNING) {
+        return AKINATOR_SESSION_STATE_ERROR;
+    }
+    *question = session->current->question;
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_session_answer(akinator_session_t *session,
+                                         akinator_answer_t   answer) {
+    _C_ASSERT(session != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    akinator_direction_t direction = AKINATOR_DIRECTION_STAY;
+    RETURN_IF_ERROR(akinator_session_direction(&session->state, answer, &direction));
+    session->questions_asked++;
+    akinator_trace_node(session->akinator->trace, TRACE_EVENT_ANSWER, session->current->id, answer);
+    switch(direction) {
+        case AKINATOR_DIRECTION_YES: {
+            return akinator_session_move(session, __atomic_load_n(&session->current->yes,
+                                                                  __ATOMIC_ACQUIRE));
+        }
+        case AKINATOR_DIRECTION_NO: {
+            return akinator_session_move(session, __atomic_load_n(&session->current->no,
+                                                                  __ATOMIC_ACQUIRE));
+        }
+        case AKINATOR_DIRECTION_STAY:
+        default: {
+            return AKINATOR_SUCCESS;
+        }
+    }
+}
+
+akinator_error_t akinator_session_direction(akinator_session_state_t *state,
+                                            akinator_answer_t         answer,
+                                            akinator_direction_t     *direction) {
+    _C_ASSERT(state     != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(direction != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    if(*state != AKINATOR_SESSION_ASKING &&
+       *state != AKINATOR_SESSION_GUESSING) {
+        return AKINATOR_SESSION_STATE_ERROR;
+    }
+
+    *direction = AKINATOR_DIRECTION_STAY;
+    switch(answer) {
+        case AKINATOR_ANSWER_YES:
+        case AKINATOR_ANSWER_PROBABLY: {
+            if(*state == AKINATOR_SESSION_GUESSING) {
+                *state = AKINATOR_SESSION_WON;
+                return AKINATOR_SUCCESS;
+            }
+            *direction = AKINATOR_DIRECTION_YES;
+            return AKINATOR_SUCCESS;
+        }
+        case AKINATOR_ANSWER_NO:
+        case AKINATOR_ANSWER_PROBABLY_NOT: {
+            if(*state == AKINATOR_SESSION_GUESSING) {
+                *state = AKINATOR_SESSION_LEARNING;
+                return AKINATOR_SUCCESS;
+            }
+            *direction = AKINATOR_DIRECTION_NO;
+            return AKINATOR_SUCCESS;
+        }
+        case AKINATOR_ANSWER_UNKNOWN: {
+            return AKINATOR_SUCCESS;
+        }
+        default: {
+            color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                         "Error while getting user answer.\n");
+            return AKINATOR_USER_ANSWER_ERROR;
+        }
+    }
+}
+
+akinator_error_t akinator_session_learn(akinator_session_t *session,
+                                        const char         *object,
+                                        const char         *question) {
+    _C_ASSERT(session != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    if(session->state != AKINATOR_SESSION_LEARNING) {
+        return AKINATOR_SESSION_STATE_ERROR;
+    }
+
+    RETURN_IF_ERROR(akinator_learn(session->akinator, session->current, object, question));
+    session->state = AKINATOR_SESSION_LEARNED;
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_session_move(akinator_session_t *session,
+                                       akinator_node_t    *next) {
+    _C_ASSERT(next != NULL, return AKINATOR_NODE_NULL);
+
+    session->current = next;
+    akinator_trace_node(session->akinator->trace, TRACE_EVENT_VISIT, next->id, 0);
+    session->state   = is_leaf(next) ? AKINATOR_SESSION_GUESSING : AKINATOR_SESSION_ASKING;
+    return AKINATOR_SUCCESS;
+}
@@ -0,0 +1,172 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "akinator_similar.h"
+#include "akinator_utils.h"
+#include "custom_assert.h"
+#include "colors.h"
+
+static akinator_error_t akinator_similar_push    (akinator_similar_t       *similar,
+                                                  akinator_similar_entry_t  entry);
+
+static akinator_error_t akinator_similar_pop     (akinator_similar_t       *similar,
+                                                  akinator_similar_entry_t *entry);
+
+static akinator_error_t akinator_similar_reserve (akinator_similar_entry_t **array,
+                                                  size_t                    *capacity,
+                                                  size_t                     required);
+
+static void             swap_entries             (akinator_similar_entry_t *first,
+                                                  akinator_similar_entry_t *second);
+
+akinator_error_t akinator_similar_ctor(akinator_similar_t *similar, size_t capacity) {
+    _C_ASSERT(similar  != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(capacity != 0   , return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    RETURN_IF_ERROR(akinator_similar_reserve(&similar->queue,
+                                             &similar->queue_capacity,
+                                             capacity));
+    RETURN_IF_ERROR(akinator_similar_reserve(&similar->result,
+                                             &similar->result_capacity,
+                                             capacity));
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_similar_find(akinator_similar_t *similar,
+                                       akinator_node_t    *object,
+                                       size_t              number) {
+    _C_ASSERT(similar != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(object  != NULL, return AKINATOR_NODE_NULL             );
+
+    RETURN_IF_ERROR(akinator_similar_reserve(&similar->result,
+                                             &similar->result_capacity,
+                                             number));
+    similar->result_size = 0;
+
+    size_t depth = 0;
+    for(akinator_node_t *node = object; node->parent != NULL; node = node->parent) {
+        depth++;
+    }
+
+    //objects behind a deeper divergence point are always closer,
+    //so sibling subtrees are searched from the object upwards
+    akinator_node_t *child     = object;
+    akinator_node_t *ancestor  = object->parent;
+    size_t           lca_depth = depth;
+    while(ancestor != NULL && similar->result_size < number) {
+        lca_depth--;
+        akinator_node_t *sibling = (ancestor->yes == child) ? ancestor->no : ancestor->yes;
+
+        similar->queue_size = 0;
+        RETURN_IF_ERROR(akinator_similar_push(similar, {.node      = sibling,
+                                                        .lca_depth = lca_depth,
+                                                        .distance  = 1}));
+        while(similar->queue_size != 0 && similar->result_size < number) {
+            akinator_similar_entry_t entry = {};
+            RETURN_IF_ERROR(akinator_similar_pop(similar, &entry));
+            if(is_leaf(entry.node)) {
+                similar->result[similar->result_size++] = entry;
+                continue;
+            }
+
+            RETURN_IF_ERROR(akinator_similar_push(similar, {.node      = entry.node->yes,
+                                                            .lca_depth = lca_depth,
+                                                            .distance  = entry.distance + 1}));
+            RETURN_IF_ERROR(akinator_similar_push(similar, {.node      = entry.node->no,
+                                                            .lca_depth = lca_depth,
+                                                            .distance  = entry.distance + 1}));
+        }
+
+        child    = ancestor;
+        ancestor = ancestor->parent;
+    }
+
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_similar_dtor(akinator_similar_t *similar) {
+    _C_ASSERT(similar != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    free(similar->queue);
+    free(similar->result);
+    memset(similar, 0, sizeof(*similar));
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_similar_push(akinator_similar_t       *similar,
+                                       akinator_similar_entry_t  entry) {
+    RETURN_IF_ERROR(akinator_similar_reserve(&similar->queue,
+                                             &similar->queue_capacity,
+                                             similar->queue_size + 1));
+
+    size_t index = similar->queue_size++;
+    similar->queue[index] = entry;
+    while(index != 0) {
+        size_t parent = (index - 1) / 2;
+        if(similar->queue[parent].distance <= similar->queue[index].distance) {
+            break;
+        }
+        swap_entries(similar->queue + parent, similar->queue + index);
+        index = parent;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_similar_pop(akinator_similar_t       *similar,
+                                      akinator_similar_entry_t *entry) {
+    _C_ASSERT(similar->queue_size != 0, return AKINATOR_NODE_NULL);
+
+    *entry = similar->queue[0];
+    similar->queue[0] = similar->queue[--similar->queue_size];
+
+    size_t index = 0;
+    while(true) {
+        size_t smallest = index;
+        size_t left     = 2 * index + 1;
+        size_t right    = 2 * index + 2;
+        if(left  < similar->queue_size &&
+           similar->queue[left ].distance < similar->queue[smallest].distance) {
+            smallest = left;
+        }
+        if(right < similar->queue_size &&
+           similar->queue[right].distance < similar->queue[smallest].distance) {
+            smallest = right;
+        }
+        if(smallest == index) {
+            break;
+        }
+        swap_entries(similar->queue + smallest, similar->queue + index);
+        index = smallest;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_similar_reserve(akinator_similar_entry_t **array,
+                                          size_t                    *capacity,
+                                          size_t                     required) {
+    if(required <= *capacity && *array != NULL) {
+        return AKINATOR_SUCCESS;
+    }
+
+    size_t new_capacity = (*capacity == 0) ? required : *capacity;
+    while(new_capacity < required) {
+        new_capacity *= 2;
+    }
+    akinator_similar_entry_t *new_array = (akinator_similar_entry_t *)realloc(*array,
+                                                                              new_capacity * sizeof(new_array[0]));
+    if(new_array == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while allocating similar objects storage.\n");
+        return AKINATOR_SIMILAR_ALLOCATION_ERROR;
+    }
+
+    *array    = new_array;
+    *capacity = new_capacity;
+    return AKINATOR_SUCCESS;
+}
+
+void swap_entries(akinator_similar_entry_t *first, akinator_similar_entry_t *second) {
+    akinator_similar_entry_t temporary = *first;
+    *first  = *second;
+    *second = temporary;
+}
@@ -0,0 +1,444 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#include "akinator_trace.h"
+#include "akinator.h"
+#include "akinator_tree.h"
+#include "akinator_utils.h"
+#include "custom_assert.h"
+#include "colors.h"
+
+static const size_t      TraceMaxTextSize       = TraceMaxTextRecords * sizeof(akinator_trace_values_t);
+static const char *const TraceKeptSuffixes[]    = {"", ".db", ".ckpt0.db", ".ckpt0.ids", ".ckpt1.db", ".ckpt1.ids"};
+
+static akinator_error_t trace_map           (akinator_trace_t              *trace,
+                                             const char                    *path,
+                                             size_t                         size);
+
+static void             trace_unmap         (akinator_trace_t              *trace);
+
+static akinator_error_t trace_keep_previous (const char                    *path);
+
+static void             trace_claim         (akinator_trace_t              *trace,
+                                             uint64_t                       end);
+
+static akinator_error_t trace_write_ids     (akinator_node_t               *node,
+                                             FILE                          *ids);
+
+static void             trace_publish       (akinator_trace_t              *trace,
+                                             uint64_t                       position,
+                                             const akinator_trace_event_t  *event);
+
+static akinator_error_t trace_decode        (akinator_trace_reader_t       *reader,
+                                             const akinator_trace_event_t  *events);
+
+//the tree is saved as the base first, the events only make sense on top of it
+akinator_error_t akinator_trace_ctor(akinator_t *akinator,
+                                     const char *path,
+                                     size_t      capacity) {
+    _C_ASSERT(akinator                    != NULL, return AKINATOR_NULL_POINTER           );
+    _C_ASSERT(path                        != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(capacity                    != 0,    return AKINATOR_TRACE_ERROR            );
+    _C_ASSERT((capacity & (capacity - 1)) == 0,    return AKINATOR_TRACE_ERROR            );
+
+    char base[FILENAME_MAX] = {};
+    if((size_t)snprintf(base, sizeof(base), "%s.db", path) >= sizeof(base)) {
+        return AKINATOR_TRACE_ERROR;
+    }
+    RETURN_IF_ERROR(trace_keep_previous    (path));
+    RETURN_IF_ERROR(akinator_write_database(akinator, base));
+
+    akinator_trace_t *trace = (akinator_trace_t *)calloc(1, sizeof(*trace));
+    if(trace == NULL) {
+        return AKINATOR_TRACE_ERROR;
+    }
+    akinator_error_t error_code = trace_map(trace,
+                                            path,
+                                            sizeof(akinator_trace_header_t) +
+                                            capacity * sizeof(akinator_trace_event_t));
+    if(error_code != AKINATOR_SUCCESS) {
+        free(trace);
+        return error_code;
+    }
+
+    akinator_trace_header_t *header = trace->header;
+    header->magic        = TraceMagic;
+    header->event_size   = sizeof(akinator_trace_event_t);
+    header->capacity     = capacity;
+    header->start_ns     = get_time_ns();
+    header->start_time   = (int64_t)time(NULL);
+    header->nodes_number = akinator->used_storage;
+    strncpy(header->database, akinator->database_name, sizeof(header->database) - 1);
+
+    trace->events          = (akinator_trace_event_t *)(void *)(header + 1);
+    trace->mask            = capacity - 1;
+    trace->akinator        = akinator;
+    trace->path            = path;
+    trace->next_checkpoint = (trace->mask >> 1) + 1;
+    akinator->trace        = trace;
+    return AKINATOR_SUCCESS;
+}
+
+//hot path, one atomic add and one record
+akinator_error_t akinator_trace_node(akinator_trace_t      *trace,
+                                     akinator_trace_type_t  type,
+                                     uint64_t               first,
+                                     uint64_t               second) {
+    if(trace == NULL) {
+        return AKINATOR_SUCCESS;
+    }
+
+    if(akinator_trace_is_change(type)) {
+        __atomic_fetch_add(&trace->header->changes, 1, __ATOMIC_RELAXED);
+    }
+    akinator_trace_event_t event    = {};
+    uint64_t               position = __atomic_fetch_add(&trace->header->head, 1, __ATOMIC_RELAXED);
+    event.type   = (uint16_t)type;
+    event.values = {.time = get_time_ns(), .first = first, .second = second};
+    trace_publish(trace, position, &event);
+    trace_claim  (trace, position + 1);
+    return AKINATOR_SUCCESS;
+}
+
+//texts are stored one after another with their terminators, each one is cut to half of
+//TraceMaxTextSize, the event and its text records are reserved together so they are
+//never separated by the records of another thread
+akinator_error_t akinator_trace_text(akinator_trace_t      *trace,
+                                     akinator_trace_type_t  type,
+                                     uint64_t               first,
+                                     uint64_t               second,
+                                     const char            *first_text,
+                                     const char            *second_text) {
+    if(trace == NULL) {
+        return AKINATOR_SUCCESS;
+    }
+
+    char        text [TraceMaxTextSize] = {};
+    const char *texts[TraceMaxTexts]    = {first_text, second_text};
+    size_t      text_size               = 0;
+    for(size_t index = 0; index < TraceMaxTexts && texts[index] != NULL; index++) {
+        size_t length = strnlen(texts[index], sizeof(text) / TraceMaxTexts - 1);
+        memcpy(text + text_size, texts[index], length);
+        text_size += length + 1;
+    }
+
+    if(akinator_trace_is_change(type)) {
+        __atomic_fetch_add(&trace->header->changes, 1, __ATOMIC_RELAXED);
+    }
+    akinator_trace_event_t event    = {};
+    size_t                 records  = (text_size + sizeof(event.text) - 1) / sizeof(event.text);
+    uint64_t               position = __atomic_fetch_add(&trace->header->head, 1 + records, __ATOMIC_RELAXED);
+    event.type = TRACE_EVENT_TEXT;
+    for(size_t record = 0; record < records; record++) {
+        memcpy(event.text, text + record * sizeof(event.text), sizeof(event.text));
+        trace_publish(trace, position + 1 + record, &event);
+    }
+
+    event.type   = (uint16_t)type;
+    event.texts  = (uint16_t)records;
+    event.values = {.time = get_time_ns(), .first = first, .second = second};
+    trace_publish(trace, position, &event);
+    trace_claim  (trace, position + 1 + records);
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_trace_error(akinator_t       *akinator,
+                                      akinator_error_t  error,
+                                      const char       *caller_file,
+                                      size_t            caller_line,
+                                      const char       *caller_func) {
+    if(akinator == NULL) {
+        return AKINATOR_SUCCESS;
+    }
+    return akinator_trace_text(akinator->trace, TRACE_EVENT_ERROR, caller_line, (uint64_t)error,
+                               caller_file, caller_func);
+}
+
+bool akinator_trace_is_change(akinator_trace_type_t type) {
+    return type == TRACE_EVENT_SPLIT  || type == TRACE_EVENT_RENAME ||
+           type == TRACE_EVENT_LIFT   || type == TRACE_EVENT_NORMALIZE;
+}
+
+//the thread that changes the tree calls it where no change is in progress, so the tree
+//it saves is the one every event before head left, slots take turns, so a crash while
+//saving one leaves the other, which the header still points at, the events after the
+//newest checkpoint are kept as long as less than half of the ring passes between a
+//claim and the call after it
+akinator_error_t akinator_trace_checkpoint(akinator_trace_t *trace) {
+    if(trace == NULL || !__atomic_exchange_n(&trace->checkpoint_due, 0, __ATOMIC_ACQUIRE)) {
+        return AKINATOR_SUCCESS;
+    }
+
+    akinator_trace_header_t *header = trace->header;
+    uint64_t                 end    = __atomic_load_n(&header->head, __ATOMIC_ACQUIRE);
+    uint64_t                 slot   = (header->checkpoint_head == 0) ? 0 : header->checkpoint_slot ^ 1;
+    char name[FILENAME_MAX] = {};
+    if((size_t)snprintf(name, sizeof(name), "%s.ckpt%llu.db", trace->path, (unsigned long long)slot) >= sizeof(name)) {
+        return AKINATOR_TRACE_ERROR;
+    }
+    RETURN_IF_ERROR(akinator_write_database(trace->akinator, name));
+
+    snprintf(name, sizeof(name), "%s.ckpt%llu.ids", trace->path, (unsigned long long)slot);
+    FILE *file = fopen(name, "wb");
+    if(file == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while opening '%s'.\n", name);
+        return AKINATOR_TRACE_ERROR;
+    }
+    akinator_error_t error_code = (fwrite(&end, sizeof(end), 1, file) == 1) ?
+                                  trace_write_ids(trace->akinator->root, file) :
+                                  AKINATOR_TRACE_ERROR;
+    if(fclose(file) != 0 || error_code != AKINATOR_SUCCESS) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while writing '%s'.\n", name);
+        return AKINATOR_TRACE_ERROR;
+    }
+
+    header->checkpoint_nodes   = trace->akinator->used_storage;
+    header->checkpoint_changes = __atomic_load_n(&header->changes, __ATOMIC_RELAXED);
+    header->checkpoint_slot    = slot;
+    __atomic_store_n(&header->checkpoint_head, end, __ATOMIC_RELEASE);
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_trace_dtor(akinator_t *akinator) {
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER);
+
+    akinator_trace_t *trace = akinator->trace;
+    if(trace == NULL) {
+        return AKINATOR_SUCCESS;
+    }
+    uint64_t head = __atomic_load_n(&trace->header->head, __ATOMIC_RELAXED);
+    color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                 "Trace: %llu records, %llu overwritten.\n",
+                 (unsigned long long)head,
+                 (unsigned long long)((head > trace->mask) ? head - trace->mask - 1 : 0));
+    trace_unmap(trace);
+    free(trace);
+    akinator->trace = NULL;
+    return AKINATOR_SUCCESS;
+}
+
+//the whole ring is read at once, records and their texts are copied out of it
+akinator_error_t akinator_trace_read(akinator_trace_reader_t *reader,
+                                     const char              *path) {
+    _C_ASSERT(reader != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(path   != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    FILE *file = fopen(path, "rb");
+    if(file == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while opening trace '%s'.\n", path);
+        return AKINATOR_TRACE_ERROR;
+    }
+
+    akinator_trace_header_t *header = &reader->header;
+    akinator_trace_event_t  *events = NULL;
+    size_t                   size   = file_size(file);
+    if(fread(header, sizeof(*header), 1, file) == 1       &&
+       header->magic      == TraceMagic                    &&
+       header->event_size == sizeof(akinator_trace_event_t) &&
+       header->capacity   != 0                             &&
+       (header->capacity & (header->capacity - 1)) == 0    &&
+       size == sizeof(*header) + header->capacity * sizeof(*events)) {
+        events = (akinator_trace_event_t *)calloc(header->capacity, sizeof(*events));
+    }
+    if(events == NULL || fread(events, sizeof(*events), header->capacity, file) != header->capacity) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "'%s' is not a trace.\n", path);
+        fclose(file);
+        free(events);
+        return AKINATOR_TRACE_ERROR;
+    }
+    fclose(file);
+
+    akinator_error_t error_code = trace_decode(reader, events);
+    free(events);
+    return error_code;
+}
+
+akinator_error_t akinator_trace_reader_dtor(akinator_trace_reader_t *reader) {
+    _C_ASSERT(reader != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    free(reader->records);
+    free(reader->strings);
+    memset(reader, 0, sizeof(*reader));
+    return AKINATOR_SUCCESS;
+}
+
+//an event with its texts takes at most texts + 1 records and texts * 24 + 1 bytes
+//of strings, so capacity records of 25 bytes hold all of them
+akinator_error_t trace_decode(akinator_trace_reader_t      *reader,
+                              const akinator_trace_event_t *events) {
+    uint64_t head     = reader->header.head;
+    uint64_t capacity = reader->header.capacity;
+    uint64_t position = (head > capacity) ? head - capacity : 0;
+    reader->lost_number = position;
+    reader->records     = (akinator_trace_record_t *)calloc(capacity, sizeof(*reader->records));
+    reader->strings     = (char *)calloc(capacity, sizeof(akinator_trace_values_t) + 1);
+    if(reader->records == NULL || reader->strings == NULL) {
+        return AKINATOR_TRACE_ERROR;
+    }
+
+    size_t strings_size = 0;
+    for(; position < head; position++) {
+        const akinator_trace_event_t *event = &events[position & (capacity - 1)];
+        bool complete = event->sequence == (uint32_t)(position + 1) &&
+                        event->type     != TRACE_EVENT_TEXT         &&
+                        event->texts    <= TraceMaxTextRecords      &&
+                        position + event->texts < head;
+        for(size_t text = 1; complete && text <= event->texts; text++) {
+            const akinator_trace_event_t *part = &events[(position + text) & (capacity - 1)];
+            complete = part->sequence == (uint32_t)(position + text + 1) &&
+                       part->type     == TRACE_EVENT_TEXT;
+        }
+        if(!complete) {
+            reader->torn_number++;
+            continue;
+        }
+
+        akinator_trace_record_t *record = &reader->records[reader->records_number++];
+        record->type     = (akinator_trace_type_t)event->type;
+        record->position = position;
+        record->end      = position + 1 + event->texts;
+        record->time     = event->values.time - reader->header.start_ns;
+        record->first    = event->values.first;
+        record->second   = event->values.second;
+
+        char  *text      = reader->strings + strings_size;
+        size_t text_size = event->texts * sizeof(event->text);
+        for(size_t part = 0; part < event->texts; part++) {
+            memcpy(text + part * sizeof(event->text),
+                   events[(position + 1 + part) & (capacity - 1)].text,
+                   sizeof(event->text));
+        }
+        text[text_size] = '\0';
+        size_t first_length = strlen(text);
+        record->texts[0] = text;
+        record->texts[1] = text + ((first_length < text_size) ? first_length + 1 : text_size);
+        strings_size += text_size + 1;
+        position     += event->texts;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+//the file is created with its full size, so a crash never leaves a ring shorter
+//than the header says
+akinator_error_t trace_map(akinator_trace_t *trace,
+                           const char       *path,
+                           size_t            size) {
+    void *view = NULL;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                              CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file != INVALID_HANDLE_VALUE) {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE,
+                                            (DWORD)((uint64_t)size >> 32), (DWORD)size, NULL);
+        if(mapping != NULL) {
+            view = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+    }
+#else
+    int file = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(file >= 0) {
+        if(ftruncate(file, (off_t)size) == 0) {
+            view = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+        }
+        close(file);
+    }
+    if(view == MAP_FAILED) {
+        view = NULL;
+    }
+#endif
+    if(view == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while mapping trace '%s'.\n", path);
+        return AKINATOR_TRACE_ERROR;
+    }
+    trace->header = (akinator_trace_header_t *)view;
+    trace->size   = size;
+    return AKINATOR_SUCCESS;
+}
+
+void trace_unmap(akinator_trace_t *trace) {
+#ifdef _WIN32
+    UnmapViewOfFile(trace->header);
+#else
+    munmap(trace->header, trace->size);
+#endif
+    trace->header = NULL;
+    trace->events = NULL;
+}
+
+//the trace of the last run is the one wanted after a crash, so it is kept as
+//<trace>.prev with its base and checkpoints as <trace>.prev.db and so on, a missing
+//one is not an error, a checkpoint the last run did not get to is removed
+akinator_error_t trace_keep_previous(const char *path) {
+    //two names do not fit the stack
+    char *current  = (char *)calloc(2, FILENAME_MAX);
+    char *previous = current + FILENAME_MAX;
+    if(current == NULL) {
+        return AKINATOR_TRACE_ERROR;
+    }
+    akinator_error_t error_code = AKINATOR_SUCCESS;
+    for(size_t suffix = 0; suffix < sizeof(TraceKeptSuffixes) / sizeof(TraceKeptSuffixes[0]); suffix++) {
+        if((size_t)snprintf(current,  FILENAME_MAX, "%s%s",      path, TraceKeptSuffixes[suffix]) >= FILENAME_MAX ||
+           (size_t)snprintf(previous, FILENAME_MAX, "%s.prev%s", path, TraceKeptSuffixes[suffix]) >= FILENAME_MAX) {
+            error_code = AKINATOR_TRACE_ERROR;
+            break;
+        }
+        remove(previous);
+        rename(current, previous);
+    }
+    free(current);
+    return error_code;
+}
+
+//hot path, events from any thread may cross the same half of the ring, the one whose
+//compare and swap moves next_checkpoint on is the only one that claims it
+void trace_claim(akinator_trace_t *trace,
+                 uint64_t          end) {
+    uint64_t next = __atomic_load_n(&trace->next_checkpoint, __ATOMIC_RELAXED);
+    uint64_t half = (trace->mask >> 1) + 1;
+    while(end >= next) {
+        if(__atomic_compare_exchange_n(&trace->next_checkpoint, &next, (end / half + 1) * half,
+                                       false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            __atomic_store_n(&trace->checkpoint_due, 1, __ATOMIC_RELEASE);
+            return;
+        }
+    }
+}
+
+akinator_error_t trace_write_ids(akinator_node_t *node, FILE *ids) {
+    uint64_t id = node->id;
+    if(fwrite(&id, sizeof(id), 1, ids) != 1) {
+        return AKINATOR_TRACE_ERROR;
+    }
+    if(is_leaf(node)) {
+        return AKINATOR_SUCCESS;
+    }
+    RETURN_IF_ERROR(trace_write_ids(node->yes, ids));
+    RETURN_IF_ERROR(trace_write_ids(node->no,  ids));
+    return AKINATOR_SUCCESS;
+}
+
+void trace_publish(akinator_trace_t             *trace,
+                   uint64_t                      position,
+                   const akinator_trace_event_t *event) {
+    akinator_trace_event_t *slot = &trace->events[position & trace->mask];
+    slot->type   = event->type;
+    slot->texts  = event->texts;
+    slot->values = event->values;
+    __atomic_store_n(&slot->sequence, (uint32_t)(position + 1), __ATOMIC_RELEASE);
+}
@@ -0,0 +1,865 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <string.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "akinator_tree.h"
+#include "akinator_utils.h"
+#include "akinator_normalize.h"
+#include "akinator_epoch.h"
+#include "custom_assert.h"
+#include "colors.h"
+
+static akinator_error_t akinator_verify_children_parent     (akinator_node_t       *node);
+
+static akinator_error_t akinator_read_database              (akinator_t            *akinator,
+                                                             const char            *db_filename);
+
+static akinator_error_t akinator_database_read_file         (akinator_t            *akinator,
+                                                             const char            *db_filename);
+
+static akinator_error_t akinator_database_read_node         (akinator_t            *akinator,
+                                                             akinator_node_t       *node);
+
+static akinator_error_t akinator_check_if_new_node          (akinator_t            *akinator);
+
+static akinator_error_t akinator_check_if_node_end          (akinator_t            *akinator);
+
+static akinator_error_t akinator_database_read_question     (akinator_t            *akinator,
+                                                             akinator_node_t       *node);
+
+static akinator_error_t akinator_database_move_quotes       (akinator_t            *akinator);
+
+static akinator_error_t akinator_database_read_children     (akinator_t            *akinator,
+                                                             akinator_node_t       *node);
+
+static akinator_error_t akinator_database_clean_buffer      (akinator_t            *akinator);
+
+static akinator_error_t akinator_get_free_node              (akinator_t            *akinator,
+                                                             akinator_node_t      **node);
+
+static akinator_error_t akinator_get_node_position          (akinator_t            *akinator,
+                                                             size_t                 id,
+                                                             size_t                *container_number,
+                                                             size_t                *container_index);
+
+static akinator_error_t akinator_publish_node              (akinator_t            *akinator,
+                                                             akinator_node_t       *leaf,
+                                                             akinator_node_t       *question_node);
+
+static akinator_error_t akinator_retire                     (akinator_t            *akinator,
+                                                             void                  *pointer);
+
+static int              akinator_sync_file                  (FILE                  *file);
+
+static akinator_error_t akinator_database_write_node        (akinator_node_t       *node,
+                                                             FILE                  *database,
+                                                             size_t                 level);
+
+static akinator_error_t akinator_leafs_array_init           (akinator_t            *akinator,
+                                                             size_t                 capacity);
+
+static akinator_error_t akinator_leafs_array_add            (akinator_t            *akinator,
+                                                             akinator_node_t       *node);
+
+static akinator_error_t akinator_leafs_array_remove         (akinator_t            *akinator,
+                                                             akinator_node_t       *node);
+
+static akinator_error_t akinator_drop_node_leafs            (akinator_t            *akinator,
+                                                             akinator_node_t       *node);
+
+static akinator_error_t akinator_get_children_free_nodes    (akinator_t            *akinator,
+                                                             akinator_node_t       *parent);
+
+static akinator_error_t akinator_collect_node_leafs         (akinator_t            *akinator,
+                                                             akinator_node_t       *node);
+
+/*=============================================================================*/
+
+akinator_error_t akinator_tree_ctor(akinator_t *akinator, const char *database_filename) {
+    _C_ASSERT(akinator          != NULL, return AKINATOR_NULL_POINTER          );
+    _C_ASSERT(database_filename != NULL, return AKINATOR_DATABASE_FILENAME_NULL);
+
+    akinator->container_size = AkinatorContainerSize;
+    akinator->database_name  = database_filename;
+
+    RETURN_IF_ERROR(akinator_read_database(akinator,
+                                           database_filename));
+
+    RETURN_IF_ERROR(akinator_index_build  (&akinator->index,
+                                           akinator));
+
+    AKINATOR_VERIFY(akinator);
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+akinator_error_t akinator_tree_dtor(akinator_t *akinator) {
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER);
+
+    for(size_t element = 0; element < akinator->containers_number; element++) {
+        free(akinator->containers[element]);
+        akinator->containers[element] = NULL;
+    }
+
+    akinator_index_dtor(&akinator->index);
+    text_buffer_dtor   (&akinator->new_questions_storage);
+    free               (akinator->old_questions_storage);
+    free               (akinator->leafs_array);
+    free               (akinator->leafs_positions);
+
+    akinator->root                     = NULL;
+    akinator->containers_number        = 0;
+    akinator->used_storage             = 0;
+    akinator->old_questions_storage    = NULL;
+    akinator->leafs_array              = NULL;
+    akinator->leafs_array_size         = 0;
+    akinator->leafs_array_capacity     = 0;
+    akinator->leafs_positions          = NULL;
+    akinator->leafs_positions_capacity = 0;
+    memset(&akinator->new_questions_storage, 0, sizeof(akinator->new_questions_storage));
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+//whole tree walks around the split are debug only, they cost more than the split itself
+akinator_error_t akinator_learn(akinator_t      *akinator,
+                                akinator_node_t *leaf,
+                                const char      *object,
+                                const char      *question) {
+#ifdef _DEBUG
+    AKINATOR_VERIFY(akinator);
+#endif
+
+    RETURN_IF_ERROR(akinator_split_leaf(akinator, leaf, object, question));
+
+#ifdef _DEBUG
+    AKINATOR_VERIFY(akinator);
+#endif
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+//same as akinator_learn without walking the whole tree around it, for callers
+//applying many changes that check the nodes they touch themselves
+akinator_error_t akinator_split_leaf(akinator_t      *akinator,
+                                     akinator_node_t *leaf,
+                                     const char      *object,
+                                     const char      *question) {
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER    );
+    _C_ASSERT(leaf     != NULL, return AKINATOR_NODE_NULL       );
+    _C_ASSERT(object   != NULL, return AKINATOR_NULL_OBJECT_NAME);
+    _C_ASSERT(question != NULL, return AKINATOR_NULL_OBJECT_NAME);
+
+    if(!is_leaf(leaf)) {
+        return AKINATOR_NODE_NOT_LEAF;
+    }
+    if(strlen(object) > MaxQuestionSize || strlen(question) > MaxQuestionSize) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Question or object name is longer than %zu symbols.\n", MaxQuestionSize);
+        return AKINATOR_MESSAGE_SIZE_ERROR;
+    }
+
+    //the new subtree is complete before it becomes reachable, the old leaf stays as its no branch
+    akinator_node_t *question_node = NULL;
+    akinator_node_t *object_node   = NULL;
+    RETURN_IF_ERROR(akinator_get_free_node(akinator, &question_node));
+    RETURN_IF_ERROR(akinator_get_free_node(akinator, &object_node));
+    RETURN_IF_ERROR(text_buffer_add(&akinator->new_questions_storage, &question_node->question));
+    RETURN_IF_ERROR(text_buffer_add(&akinator->new_questions_storage, &object_node  ->question));
+    strcpy(question_node->question, question);
+    strcpy(object_node  ->question, object);
+
+    object_node  ->parent = question_node;
+    question_node->yes    = object_node;
+    question_node->no     = leaf;
+    question_node->parent = leaf->parent;
+    RETURN_IF_ERROR(akinator_leafs_array_add   (akinator, object_node));
+
+    RETURN_IF_ERROR(akinator_publish_node      (akinator, leaf, question_node));
+    RETURN_IF_ERROR(akinator_index_add_question(&akinator->index, question_node));
+    akinator_trace_text(akinator->trace, TRACE_EVENT_SPLIT, leaf->id, question_node->id, question, object);
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+//text is copied to new storage, loaded questions point into the file buffer and
+//have no room for a longer one
+akinator_error_t akinator_rename_node(akinator_t      *akinator,
+                                      akinator_node_t *node,
+                                      const char      *text) {
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER    );
+    _C_ASSERT(node     != NULL, return AKINATOR_NODE_NULL       );
+    _C_ASSERT(text     != NULL, return AKINATOR_NULL_OBJECT_NAME);
+
+    if(strlen(text) > MaxQuestionSize) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Question or object name is longer than %zu symbols.\n", MaxQuestionSize);
+        return AKINATOR_MESSAGE_SIZE_ERROR;
+    }
+
+    char *storage  = NULL;
+    char *old_text = node->question;
+    RETURN_IF_ERROR(text_buffer_add(&akinator->new_questions_storage, &storage));
+    strcpy(storage, text);
+    __atomic_store_n(&node->question, storage, __ATOMIC_RELEASE);
+    RETURN_IF_ERROR(akinator_index_rename(&akinator->index, node, old_text));
+    akinator_trace_text(akinator->trace, TRACE_EVENT_RENAME, node->id, 0, storage, NULL);
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+//question node is replaced by its kept child, the other branch stays in the containers
+//unreachable like the nodes normalization drops, its leafs and questions leave the
+//leafs array and the index
+akinator_error_t akinator_lift_node(akinator_t        *akinator,
+                                    akinator_node_t   *node,
+                                    akinator_answer_t  kept) {
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER);
+    _C_ASSERT(node     != NULL, return AKINATOR_NODE_NULL   );
+
+    if(is_leaf(node)) {
+        return AKINATOR_ONE_CHILD;
+    }
+
+    akinator_node_t  *child   = (kept == AKINATOR_ANSWER_YES) ? node->yes : node->no;
+    akinator_node_t  *dropped = (kept == AKINATOR_ANSWER_YES) ? node->no  : node->yes;
+    akinator_node_t  *parent  = node->parent;
+    akinator_node_t **slot    = &akinator->root;
+    if(parent != NULL) {
+        slot = (parent->yes == node) ? &parent->yes : &parent->no;
+    }
+    __atomic_store_n(&child->parent, parent, __ATOMIC_RELEASE);
+    __atomic_store_n(slot,           child,  __ATOMIC_RELEASE);
+    RETURN_IF_ERROR(akinator_index_lift     (&akinator->index, node, dropped));
+    RETURN_IF_ERROR(akinator_drop_node_leafs(akinator, dropped));
+    akinator_trace_node(akinator->trace, TRACE_EVENT_LIFT, node->id, kept);
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+akinator_error_t akinator_collect_leafs(akinator_t *akinator) {
+    _C_ASSERT(akinator       != NULL, return AKINATOR_NULL_POINTER);
+    _C_ASSERT(akinator->root != NULL, return AKINATOR_NULL_ROOT   );
+
+    akinator->leafs_array_size = 0;
+    RETURN_IF_ERROR(akinator_collect_node_leafs(akinator, akinator->root));
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_collect_node_leafs(akinator_t      *akinator,
+                                             akinator_node_t *node) {
+    if(is_leaf(node)) {
+        return akinator_leafs_array_add(akinator, node);
+    }
+    RETURN_IF_ERROR(akinator_collect_node_leafs(akinator, node->yes));
+    RETURN_IF_ERROR(akinator_collect_node_leafs(akinator, node->no));
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_drop_node_leafs(akinator_t      *akinator,
+                                          akinator_node_t *node) {
+    if(is_leaf(node)) {
+        return akinator_leafs_array_remove(akinator, node);
+    }
+    RETURN_IF_ERROR(akinator_drop_node_leafs(akinator, node->yes));
+    RETURN_IF_ERROR(akinator_drop_node_leafs(akinator, node->no));
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+akinator_error_t akinator_verify(akinator_t *akinator) {
+    if(akinator == NULL) {
+        return AKINATOR_NULL_POINTER;
+    }
+
+    if(akinator->containers_number >= max_nodes_containers_number) {
+        return AKINATOR_CONTAINERS_OVERFLOW;
+    }
+
+    for(size_t container = 0; container < akinator->containers_number; container++) {
+        if(akinator->containers[container] == NULL) {
+            return AKINATOR_NULL_USED_CONTAINER;
+        }
+    }
+    for(size_t container = akinator->containers_number; container < max_nodes_containers_number; container++) {
+        if(akinator->containers[container] != NULL) {
+            return AKINATOR_NOT_NULL_UNUSED_CONTAINER;
+        }
+    }
+
+    if(akinator->root == NULL && akinator->used_storage == 0) {
+        return AKINATOR_SUCCESS;
+    }
+    if(akinator->root == NULL || akinator->used_storage == 0) {
+        return AKINATOR_NULL_ROOT;
+    }
+
+    RETURN_IF_ERROR(akinator_verify_children_parent(akinator->root));
+
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+akinator_error_t akinator_verify_children_parent(akinator_node_t *node) {
+    _C_ASSERT(node != NULL, return AKINATOR_NODE_NULL);
+
+    if(node->no == NULL && node->yes == NULL) {
+        return AKINATOR_SUCCESS;
+    }
+    if(node->no == NULL || node->yes == NULL) {
+        return AKINATOR_ONE_CHILD;
+    }
+
+    if(node->no->parent != node || node->yes->parent != node) {
+        return AKINATOR_CHILD_PARENT_CONNECTION_ERROR;
+    }
+
+    RETURN_IF_ERROR(akinator_verify_children_parent(node->no));
+    RETURN_IF_ERROR(akinator_verify_children_parent(node->yes));
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+akinator_error_t akinator_read_database(akinator_t *akinator,
+                                        const char *database_filename) {
+    _C_ASSERT(database_filename != NULL, return AKINATOR_DATABASE_FILENAME_NULL);
+    AKINATOR_VERIFY(akinator);
+
+    RETURN_IF_ERROR(akinator_database_read_file (akinator,
+                                                 database_filename));
+
+    RETURN_IF_ERROR(text_buffer_ctor            (&akinator->new_questions_storage,
+                                                 MaxQuestionSize,
+                                                 akinator->old_storage_size));
+
+    RETURN_IF_ERROR(akinator_leafs_array_init   (akinator,
+                                                 akinator->old_storage_size));
+
+    RETURN_IF_ERROR(akinator_get_free_node      (akinator,
+                                                 &akinator->root));
+
+    RETURN_IF_ERROR(akinator_database_read_node (akinator,
+                                                 akinator->root));
+
+    AKINATOR_VERIFY(akinator);
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+akinator_error_t akinator_database_read_file(akinator_t *akinator,
+                                             const char *database_filename) {
+    _C_ASSERT(database_filename != NULL, return AKINATOR_DATABASE_FILENAME_NULL);
+    AKINATOR_VERIFY(akinator);
+
+    FILE *database = fopen(database_filename, "rb");
+    if(database == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while opening database.\n");
+        return AKINATOR_DATABASE_OPENING_ERROR;
+    }
+
+    akinator->old_storage_size      = file_size(database);
+    akinator->old_questions_storage = (char *)calloc(akinator->old_storage_size + 1,
+                                                     sizeof(char));
+
+    if(akinator->old_questions_storage == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while allocating old questions storage.\n");
+        fclose(database);
+        return AKINATOR_TEXT_BUFFER_ALLOCATION_ERROR;
+    }
+
+    if(fread(akinator->old_questions_storage,
+             sizeof(char),
+             akinator->old_storage_size,
+             database) != akinator->old_storage_size) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while reading database from file.\n");
+        fclose(database);
+        return AKINATOR_DATABASE_READING_ERROR;
+    }
+
+    fclose(database);
+    AKINATOR_VERIFY(akinator);
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+akinator_error_t akinator_database_read_node(akinator_t      *akinator,
+                                             akinator_node_t *node) {
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER);
+    _C_ASSERT(node     != NULL, return AKINATOR_NODE_NULL   );
+
+    RETURN_IF_ERROR(akinator_check_if_new_node     (akinator));
+    RETURN_IF_ERROR(akinator_database_read_question(akinator, node));
+
+    if(akinator->old_questions_storage[akinator->questions_storage_position++] != '}') {
+        RETURN_IF_ERROR(akinator_database_read_children(akinator, node));
+        RETURN_IF_ERROR(akinator_check_if_node_end     (akinator));
+    }
+    else {
+        RETURN_IF_ERROR(akinator_leafs_array_add       (akinator, node));
+    }
+
+    RETURN_IF_ERROR(akinator_database_clean_buffer(akinator));
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+akinator_error_t akinator_check_if_new_node(akinator_t *akinator) {
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER);
+
+    if(akinator->old_questions_storage[akinator->questions_storage_position++] != '{') {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while reading database.\n");
+        return AKINATOR_DATABASE_READING_ERROR;
+    }
+
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+akinator_error_t akinator_check_if_node_end(akinator_t *akinator) {
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER);
+
+    if(akinator->old_questions_storage[akinator->questions_storage_position++] != '}') {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while reading database.\n");
+        return AKINATOR_DATABASE_READING_ERROR;
+    }
+
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+//the tree is verified once akinator_read_database has read all of it, a walk per node
+//made loading quadratic
+akinator_error_t akinator_database_read_question(akinator_t *akinator, akinator_node_t *node) {
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER);
+    _C_ASSERT(node     != NULL, return AKINATOR_NODE_NULL   );
+
+    RETURN_IF_ERROR(akinator_database_move_quotes(akinator));
+    node->question = akinator->old_questions_storage + akinator->questions_storage_position;
+    RETURN_IF_ERROR(akinator_database_move_quotes(akinator));
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+akinator_error_t akinator_database_move_quotes(akinator_t *akinator) {
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER);
+
+    while(akinator->old_questions_storage[akinator->questions_storage_position] != '\"') {
+        if(akinator->old_questions_storage[akinator->questions_storage_position] == '\0') {
+            color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                         "Error while reading database.\n");
+            return AKINATOR_DATABASE_READING_ERROR;
+        }
+        akinator->questions_storage_position++;
+    }
+
+    akinator->old_questions_storage[akinator->questions_storage_position++] = '\0';
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+akinator_error_t akinator_database_read_children(akinator_t      *akinator,
+                                                 akinator_node_t *node) {
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER);
+    _C_ASSERT(node     != NULL, return AKINATOR_NODE_NULL   );
+
+    RETURN_IF_ERROR(akinator_get_children_free_nodes(akinator, node));
+
+    node->no->parent  = node;
+    node->yes->parent = node;
+
+    RETURN_IF_ERROR(akinator_database_clean_buffer  (akinator));
+    RETURN_IF_ERROR(akinator_database_read_node     (akinator, node->yes));
+    RETURN_IF_ERROR(akinator_database_read_node     (akinator, node->no));
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+akinator_error_t akinator_database_clean_buffer(akinator_t *akinator) {
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER);
+
+    char symbol = akinator->old_questions_storage[akinator->questions_storage_position++];
+    while(symbol != '{' && symbol != '}' && symbol != '\0' &&
+          akinator->questions_storage_position < akinator->old_storage_size) {
+        symbol = akinator->old_questions_storage[akinator->questions_storage_position++];
+    }
+
+    akinator->questions_storage_position--;
+
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+akinator_error_t akinator_get_free_node(akinator_t       *akinator,
+                                        akinator_node_t **node) {
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER);
+    _C_ASSERT(node     != NULL, return AKINATOR_NODE_NULL   );
+
+    size_t container_number = 0;
+    size_t container_index  = 0;
+    RETURN_IF_ERROR(akinator_get_node_position(akinator,
+                                               akinator->used_storage,
+                                               &container_number,
+                                               &container_index));
+
+    if(container_number == akinator->containers_number) {
+        if(akinator->containers_number == max_nodes_containers_number - 1) {
+            return AKINATOR_CONTAINERS_OVERFLOW;
+        }
+        akinator_node_t *new_container = (akinator_node_t *)calloc(akinator->container_size << container_number,
+                                                                   sizeof(new_container[0]));
+        if(new_container == NULL) {
+            color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                         "Error while allocating tree storage.\n");
+            return AKINATOR_TREE_ALLOCATION_ERROR;
+        }
+        akinator->containers[akinator->containers_number++] = new_container;
+    }
+
+    *node = akinator->containers[container_number] + container_index;
+    (*node)->id = akinator->used_storage;
+    akinator->used_storage++;
+
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+akinator_error_t akinator_get_node_by_id(akinator_t       *akinator,
+                                         size_t            id,
+                                         akinator_node_t **node) {
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER);
+    _C_ASSERT(node     != NULL, return AKINATOR_NODE_NULL   );
+
+    if(id >= akinator->used_storage) {
+        return AKINATOR_NODE_NULL;
+    }
+
+    size_t container_number = 0;
+    size_t container_index  = 0;
+    RETURN_IF_ERROR(akinator_get_node_position(akinator,
+                                               id,
+                                               &container_number,
+                                               &container_index));
+    *node = akinator->containers[container_number] + container_index;
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+//every next container is twice bigger, so the containers array never overflows
+akinator_error_t akinator_get_node_position(akinator_t *akinator,
+                                            size_t      id,
+                                            size_t     *container_number,
+                                            size_t     *container_index) {
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER);
+
+    size_t container = 0;
+    while(id >= akinator->container_size << container) {
+        id -= akinator->container_size << container;
+        container++;
+    }
+
+    *container_number = container;
+    *container_index  = id;
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+akinator_error_t akinator_update_database(akinator_t *akinator) {
+    AKINATOR_VERIFY(akinator);
+
+    akinator_normalize_stats_t stats = {};
+    RETURN_IF_ERROR(akinator_normalize      (akinator, &stats));
+    RETURN_IF_ERROR(akinator_normalize_print(&stats));
+    RETURN_IF_ERROR(akinator_index_build    (&akinator->index, akinator));
+    AKINATOR_VERIFY(akinator);
+
+    RETURN_IF_ERROR(akinator_save_database(akinator));
+
+    AKINATOR_VERIFY(akinator);
+    return AKINATOR_EXIT_SUCCESS;
+}
+
+/*=============================================================================*/
+
+//written next to the database and renamed over it, so a crash leaves either the old or the new file
+akinator_error_t akinator_save_database(akinator_t *akinator) {
+    _C_ASSERT(akinator                != NULL, return AKINATOR_NULL_POINTER           );
+    _C_ASSERT(akinator->database_name != NULL, return AKINATOR_DATABASE_FILENAME_NULL);
+
+    char temporary_name[FILENAME_MAX] = {};
+    if((size_t)snprintf(temporary_name, sizeof(temporary_name), "%s.tmp",
+                        akinator->database_name) >= sizeof(temporary_name)) {
+        return AKINATOR_DATABASE_FILENAME_NULL;
+    }
+
+    RETURN_IF_ERROR(akinator_write_database(akinator, temporary_name));
+
+#ifdef _WIN32
+    //rename does not replace on windows
+    remove(akinator->database_name);
+#endif
+    if(rename(temporary_name, akinator->database_name) != 0) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while replacing database.\n");
+        return AKINATOR_DATABASE_OPENING_ERROR;
+    }
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+akinator_error_t akinator_write_database(akinator_t *akinator, const char *filename) {
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER);
+
+    return akinator_write_subtree(__atomic_load_n(&akinator->root, __ATOMIC_ACQUIRE), filename);
+}
+
+/*=============================================================================*/
+
+//subtree is durable in filename when this returns, a failed write leaves no file behind
+akinator_error_t akinator_write_subtree(akinator_node_t *root, const char *filename) {
+    _C_ASSERT(root     != NULL, return AKINATOR_NULL_ROOT              );
+    _C_ASSERT(filename != NULL, return AKINATOR_DATABASE_FILENAME_NULL);
+
+    FILE *database = fopen(filename, "w");
+    if(database == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while opening database.\n");
+        return AKINATOR_DATABASE_OPENING_ERROR;
+    }
+
+    akinator_error_t error_code = akinator_database_write_node(root, database, 0);
+    if(error_code == AKINATOR_SUCCESS &&
+       (fflush(database) != 0 || akinator_sync_file(database) != 0)) {
+        error_code = AKINATOR_DATABASE_OPENING_ERROR;
+    }
+    fclose(database);
+    if(error_code != AKINATOR_SUCCESS) {
+        remove(filename);
+    }
+    return error_code;
+}
+
+/*=============================================================================*/
+
+int akinator_sync_file(FILE *file) {
+#ifdef _WIN32
+    return _commit(_fileno(file));
+#else
+    return fsync(fileno(file));
+#endif
+}
+
+/*=============================================================================*/
+
+akinator_error_t akinator_database_write_node(akinator_node_t *node,
+                                              FILE            *database,
+                                              size_t           level) {
+    _C_ASSERT(node     != NULL, return AKINATOR_NODE_NULL             );
+    _C_ASSERT(database != NULL, return AKINATOR_DATABASE_OPENING_ERROR);
+
+    fprintf(database, "%*s{\"%s\"", (int)(level * 8), "", node->question);
+    if(is_leaf(node)) {
+        fputs("}\n", database);
+        return AKINATOR_SUCCESS;
+    }
+
+    fputc('\n', database);
+
+    //children are read the way sessions read them, a replica saves while it learns
+    RETURN_IF_ERROR(akinator_database_write_node(__atomic_load_n(&node->yes, __ATOMIC_ACQUIRE), database, level + 1));
+    RETURN_IF_ERROR(akinator_database_write_node(__atomic_load_n(&node->no,  __ATOMIC_ACQUIRE), database, level + 1));
+
+    fprintf(database, "%*s}\n", (int)(level * 8), "");
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+akinator_error_t akinator_find_node(akinator_t       *akinator,
+                                    const char       *object,
+                                    akinator_node_t **node_output) {
+    _C_ASSERT(object      != NULL, return AKINATOR_NULL_OBJECT_NAME);
+    _C_ASSERT(node_output != NULL, return AKINATOR_NODE_NULL       );
+    AKINATOR_VERIFY(akinator);
+
+    for(size_t index = 0; index < akinator->leafs_array_size; index++) {
+        akinator_node_t *node = akinator->leafs_array[index];
+        if(node != NULL && strcmp(node->question, object) == 0) {
+            *node_output = node;
+            return AKINATOR_EXIT_SUCCESS;
+        }
+    }
+
+    AKINATOR_VERIFY(akinator);
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+akinator_error_t akinator_leafs_array_init(akinator_t *akinator,
+                                           size_t      capacity) {
+    AKINATOR_VERIFY(akinator);
+
+    akinator->leafs_array = (akinator_node_t **)calloc(capacity,
+                                                       sizeof(akinator->leafs_array[0]));
+    if(akinator->leafs_array == NULL) {
+        color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                     "Error while allocating leafs array.\n");
+        return AKINATOR_LEAFS_ALLOCATING_ERROR;
+    }
+    akinator->leafs_array_capacity = capacity;
+
+    AKINATOR_VERIFY(akinator);
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+akinator_error_t akinator_leafs_array_add(akinator_t      *akinator,
+                                          akinator_node_t *node) {
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER);
+    _C_ASSERT(node     != NULL, return AKINATOR_NODE_NULL   );
+
+    if(akinator->leafs_array_size >= akinator->leafs_array_capacity) {
+        akinator_node_t **new_array = (akinator_node_t **)calloc(akinator->leafs_array_capacity * 2,
+                                                                 sizeof(new_array[0]));
+        if(new_array == NULL) {
+            color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                         "Error while reallocating leafs array.\n");
+            return AKINATOR_LEAFS_ALLOCATING_ERROR;
+        }
+        memcpy(new_array, akinator->leafs_array,
+               akinator->leafs_array_size * sizeof(new_array[0]));
+
+        akinator_node_t **old_array = akinator->leafs_array;
+        __atomic_store_n(&akinator->leafs_array, new_array, __ATOMIC_RELEASE);
+        akinator->leafs_array_capacity *= 2;
+        RETURN_IF_ERROR(akinator_retire(akinator, old_array));
+    }
+
+    if(node->id >= akinator->leafs_positions_capacity) {
+        size_t  new_capacity = (akinator->leafs_positions_capacity == 0) ? node->id + 1 :
+                                                                            akinator->leafs_positions_capacity;
+        while(new_capacity <= node->id) {
+            new_capacity *= 2;
+        }
+        size_t *new_positions = (size_t *)realloc(akinator->leafs_positions,
+                                                  new_capacity * sizeof(new_positions[0]));
+        if(new_positions == NULL) {
+            color_printf(RED_TEXT, BOLD_TEXT, DEFAULT_BACKGROUND,
+                         "Error while reallocating leafs positions.\n");
+            return AKINATOR_LEAFS_ALLOCATING_ERROR;
+        }
+        akinator->leafs_positions          = new_positions;
+        akinator->leafs_positions_capacity = new_capacity;
+    }
+
+    akinator->leafs_array[akinator->leafs_array_size] = node;
+    akinator->leafs_positions[node->id]               = akinator->leafs_array_size;
+
+    //readers load the size before the array, so they never index past the array they got
+    __atomic_store_n(&akinator->leafs_array_size, akinator->leafs_array_size + 1, __ATOMIC_RELEASE);
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+//the last leaf takes the removed one's place, every refill of the array keeps the
+//positions, so a position that does not point at the node means it is not a leaf here
+akinator_error_t akinator_leafs_array_remove(akinator_t      *akinator,
+                                             akinator_node_t *node) {
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER);
+    _C_ASSERT(node     != NULL, return AKINATOR_NODE_NULL   );
+
+    size_t size     = akinator->leafs_array_size;
+    size_t position = (node->id < akinator->leafs_positions_capacity) ?
+                      akinator->leafs_positions[node->id] : size;
+    if(position >= size || akinator->leafs_array[position] != node) {
+        return AKINATOR_SUCCESS;
+    }
+
+    akinator_node_t *last = akinator->leafs_array[size - 1];
+    akinator->leafs_array[position] = last;
+    if(last->id < akinator->leafs_positions_capacity) {
+        akinator->leafs_positions[last->id] = position;
+    }
+    __atomic_store_n(&akinator->leafs_array_size, size - 1, __ATOMIC_RELEASE);
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+akinator_error_t akinator_get_children_free_nodes(akinator_t      *akinator,
+                                                  akinator_node_t *parent) {
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER);
+    _C_ASSERT(parent   != NULL, return AKINATOR_NODE_NULL   );
+
+    RETURN_IF_ERROR(akinator_get_free_node(akinator, &parent->no));
+    RETURN_IF_ERROR(akinator_get_free_node(akinator, &parent->yes));
+
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+//readers walking yes/no see either the old leaf or the whole new subtree, never a half-built one
+akinator_error_t akinator_publish_node(akinator_t      *akinator,
+                                       akinator_node_t *leaf,
+                                       akinator_node_t *question_node) {
+    _C_ASSERT(leaf          != NULL, return AKINATOR_NODE_NULL);
+    _C_ASSERT(question_node != NULL, return AKINATOR_NODE_NULL);
+
+    akinator_node_t  *parent = leaf->parent;
+    akinator_node_t **slot   = &akinator->root;
+    if(parent != NULL) {
+        slot = (parent->yes == leaf) ? &parent->yes : &parent->no;
+    }
+
+    __atomic_store_n(&leaf->parent, question_node, __ATOMIC_RELEASE);
+    __atomic_store_n(slot,          question_node, __ATOMIC_RELEASE);
+    return AKINATOR_SUCCESS;
+}
+
+/*=============================================================================*/
+
+akinator_error_t akinator_retire(akinator_t *akinator, void *pointer) {
+    _C_ASSERT(akinator != NULL, return AKINATOR_NULL_POINTER);
+
+    if(akinator->epoch == NULL) {
+        free(pointer);
+        return AKINATOR_SUCCESS;
+    }
+    return akinator_epoch_retire(akinator->epoch, pointer);
+}
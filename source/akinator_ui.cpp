@@ -0,0 +1,412 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "akinator_ui.h"
+#include "akinator_utils.h"
+#include "custom_assert.h"
+#include "colors.h"
+
+static akinator_error_t ui_wait_event      (akinator_ui_t       *ui,
+                                            akinator_ui_event_t *event);
+
+static akinator_error_t ui_handle_event    (akinator_menu_t     *menu,
+                                            akinator_ui_event_t *event,
+                                            size_t              *highlighted,
+                                            size_t              *chosen);
+
+static size_t           ui_find_button     (akinator_menu_t     *menu,
+                                            point_t             *position);
+
+static akinator_error_t ui_draw_frame      (akinator_ui_t       *ui,
+                                            akinator_menu_t     *menu,
+                                            size_t               highlighted);
+
+static akinator_error_t ui_fill            (akinator_ui_t       *ui,
+                                            const rectangle_t   *rectangle,
+                                            uint32_t             color);
+
+static akinator_error_t ui_text            (akinator_ui_t       *ui,
+                                            const rectangle_t   *rectangle,
+                                            const char          *text,
+                                            uint32_t             color);
+
+static bool             ui_intersects      (const rectangle_t   *first,
+                                            const rectangle_t   *second);
+
+static void             ui_unite           (rectangle_t         *destination,
+                                            const rectangle_t   *source);
+
+akinator_error_t akinator_ui_ctor(akinator_ui_t         *ui,
+                                  akinator_ui_backend_t  backend,
+                                  int32_t                width,
+                                  int32_t                height) {
+    _C_ASSERT(ui     != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(width  >  0,    return AKINATOR_UI_ERROR               );
+    _C_ASSERT(height >  0,    return AKINATOR_UI_ERROR               );
+
+    memset(ui, 0, sizeof(*ui));
+    ui->backend = backend;
+    ui->width   = width;
+    ui->height  = height;
+    switch(backend) {
+        case UI_BACKEND_WINDOW: {
+#ifndef _WIN32
+            return AKINATOR_UI_ERROR;
+#endif
+            break;
+        }
+        case UI_BACKEND_HEADLESS: {
+            ui->pixels = (uint32_t *)calloc((size_t)width * (size_t)height, sizeof(*ui->pixels));
+            if(ui->pixels == NULL) {
+                return AKINATOR_UI_ERROR;
+            }
+            for(size_t pixel = 0; pixel < (size_t)width * (size_t)height; pixel++) {
+                ui->pixels[pixel] = UiBackgroundColor;
+            }
+            break;
+        }
+        default: {
+            return AKINATOR_UI_ERROR;
+        }
+    }
+    pthread_mutex_init(&ui->lock,    NULL);
+    pthread_cond_init (&ui->changed, NULL);
+    return AKINATOR_SUCCESS;
+}
+
+//blocks until an event comes, every button is drawn once when the menu opens and after
+//that a frame is drawn only when the highlighted button changes
+//chosen is menu->number when the ui is closed without a choice
+akinator_error_t akinator_ui_run_menu(akinator_ui_t   *ui,
+                                      akinator_menu_t *menu,
+                                      size_t          *chosen) {
+    _C_ASSERT(ui           != NULL,         return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(menu         != NULL,         return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(chosen       != NULL,         return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(menu->number <= UiMaxButtons, return AKINATOR_UI_ERROR               );
+
+    size_t highlighted = menu->number;
+    *chosen            = menu->number;
+    for(size_t button = 0; button < menu->number; button++) {
+        RETURN_IF_ERROR(akinator_ui_mark_dirty(ui, &menu->button_boxes[button]));
+    }
+    RETURN_IF_ERROR(ui_draw_frame(ui, menu, highlighted));
+
+    bool is_running = true;
+    while(is_running) {
+        akinator_ui_event_t event = {};
+        RETURN_IF_ERROR(ui_wait_event(ui, &event));
+        ui->events_number++;
+
+        size_t previous = highlighted;
+        RETURN_IF_ERROR(ui_handle_event(menu, &event, &highlighted, chosen));
+        is_running = (*chosen == menu->number && event.type != UI_EVENT_QUIT);
+        if(!is_running) {
+            highlighted = menu->number;
+        }
+        if(highlighted == previous) {
+            continue;
+        }
+        if(previous < menu->number) {
+            RETURN_IF_ERROR(akinator_ui_mark_dirty(ui, &menu->button_boxes[previous]));
+        }
+        if(highlighted < menu->number) {
+            RETURN_IF_ERROR(akinator_ui_mark_dirty(ui, &menu->button_boxes[highlighted]));
+        }
+        RETURN_IF_ERROR(ui_draw_frame(ui, menu, highlighted));
+    }
+    return AKINATOR_SUCCESS;
+}
+
+//the mouse highlights what it is over and clicks it, arrows move the highlight and
+//enter clicks it, digits and shortcuts click their button at once
+akinator_error_t ui_handle_event(akinator_menu_t     *menu,
+                                 akinator_ui_event_t *event,
+                                 size_t              *highlighted,
+                                 size_t              *chosen) {
+    switch(event->type) {
+        case UI_EVENT_MOUSE_MOVE: {
+            *highlighted = ui_find_button(menu, &event->position);
+            break;
+        }
+        case UI_EVENT_MOUSE_DOWN: {
+            *highlighted = ui_find_button(menu, &event->position);
+            *chosen      = *highlighted;
+            break;
+        }
+        case UI_EVENT_KEY: {
+            if(event->key == UI_KEY_UP) {
+                *highlighted = (*highlighted == 0 || *highlighted >= menu->number) ? menu->number - 1 :
+                                                                                    *highlighted - 1;
+            }
+            else if(event->key == UI_KEY_DOWN) {
+                *highlighted = (*highlighted + 1 >= menu->number) ? 0 : *highlighted + 1;
+            }
+            else if(event->key == UI_KEY_ENTER) {
+                *chosen = *highlighted;
+            }
+            else if(event->key >= '1' && event->key <= '9' && (size_t)(event->key - '1') < menu->number) {
+                *chosen = (size_t)(event->key - '1');
+            }
+            else if(menu->shortcuts != NULL && event->key > 0 && event->key < UI_KEY_UP) {
+                const char *shortcut = strchr(menu->shortcuts, event->key);
+                if(shortcut != NULL && (size_t)(shortcut - menu->shortcuts) < menu->number) {
+                    *chosen = (size_t)(shortcut - menu->shortcuts);
+                }
+            }
+            break;
+        }
+        case UI_EVENT_NONE:
+        case UI_EVENT_QUIT: {
+            break;
+        }
+        default: {
+            return AKINATOR_UI_ERROR;
+        }
+    }
+    return AKINATOR_SUCCESS;
+}
+
+size_t ui_find_button(akinator_menu_t *menu,
+                      point_t         *position) {
+    for(size_t button = 0; button < menu->number; button++) {
+        rectangle_t *box = &menu->button_boxes[button];
+        if(position->x >= box->left   && position->x <= box->right &&
+           position->y >= box->bottom && position->y <= box->top) {
+            return button;
+        }
+    }
+    return menu->number;
+}
+
+//touching rectangles are merged, a full list merges the new one into the last
+akinator_error_t akinator_ui_mark_dirty(akinator_ui_t     *ui,
+                                        const rectangle_t *rectangle) {
+    _C_ASSERT(ui        != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(rectangle != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    for(size_t dirty = 0; dirty < ui->dirty_number; dirty++) {
+        if(ui_intersects(&ui->dirty[dirty], rectangle)) {
+            ui_unite(&ui->dirty[dirty], rectangle);
+            return AKINATOR_SUCCESS;
+        }
+    }
+    if(ui->dirty_number == UiMaxDirty) {
+        ui_unite(&ui->dirty[UiMaxDirty - 1], rectangle);
+        return AKINATOR_SUCCESS;
+    }
+    ui->dirty[ui->dirty_number++] = *rectangle;
+    return AKINATOR_SUCCESS;
+}
+
+//every button touching a dirty rectangle is redrawn once
+akinator_error_t ui_draw_frame(akinator_ui_t   *ui,
+                               akinator_menu_t *menu,
+                               size_t           highlighted) {
+    if(ui->dirty_number == 0) {
+        return AKINATOR_SUCCESS;
+    }
+    uint64_t start = get_time_ns();
+    if(ui->backend == UI_BACKEND_WINDOW) {
+#ifdef _WIN32
+        RETURN_IF_ERROR(graphics_window_begin());
+#endif
+    }
+
+    uint64_t drawn = 0;
+    for(size_t dirty = 0; dirty < ui->dirty_number; dirty++) {
+        for(size_t button = 0; button < menu->number; button++) {
+            rectangle_t *box = &menu->button_boxes[button];
+            if(((drawn >> button) & 1) != 0 || !ui_intersects(&ui->dirty[dirty], box)) {
+                continue;
+            }
+            drawn |= (uint64_t)1 << button;
+            RETURN_IF_ERROR(ui_fill(ui, box, (button == highlighted) ? UiHighlightedColor : UiBoxColor));
+            RETURN_IF_ERROR(ui_text(ui, box, menu->labels[button], UiTextColor));
+        }
+    }
+    ui->dirty_number = 0;
+
+    if(ui->backend == UI_BACKEND_WINDOW) {
+#ifdef _WIN32
+        RETURN_IF_ERROR(graphics_window_present());
+#endif
+    }
+    ui->frames_number++;
+    return akinator_histogram_add(&ui->frame_time, get_time_ns() - start);
+}
+
+akinator_error_t ui_fill(akinator_ui_t     *ui,
+                         const rectangle_t *rectangle,
+                         uint32_t           color) {
+    switch(ui->backend) {
+        case UI_BACKEND_WINDOW: {
+#ifdef _WIN32
+            return graphics_window_fill(rectangle, color);
+#else
+            return AKINATOR_UI_ERROR;
+#endif
+        }
+        case UI_BACKEND_HEADLESS: {
+            int32_t left   = (int32_t)fmax(floor(rectangle->left),   0);
+            int32_t right  = (int32_t)fmin(ceil (rectangle->right),  ui->width);
+            int32_t bottom = (int32_t)fmax(floor(rectangle->bottom), 0);
+            int32_t top    = (int32_t)fmin(ceil (rectangle->top),    ui->height);
+            for(int32_t y = bottom; y < top; y++) {
+                uint32_t *row = ui->pixels + (size_t)y * (size_t)ui->width;
+                for(int32_t x = left; x < right; x++) {
+                    row[x] = color;
+                }
+            }
+            if(right > left && top > bottom) {
+                ui->drawn_pixels += (size_t)(right - left) * (size_t)(top - bottom);
+            }
+            return AKINATOR_SUCCESS;
+        }
+        default: {
+            return AKINATOR_UI_ERROR;
+        }
+    }
+}
+
+//headless text is a block for every character, centered like txDrawText does it
+akinator_error_t ui_text(akinator_ui_t     *ui,
+                         const rectangle_t *rectangle,
+                         const char        *text,
+                         uint32_t           color) {
+    switch(ui->backend) {
+        case UI_BACKEND_WINDOW: {
+#ifdef _WIN32
+            return graphics_window_text(rectangle, text, color);
+#else
+            return AKINATOR_UI_ERROR;
+#endif
+        }
+        case UI_BACKEND_HEADLESS: {
+            double length = (double)strlen(text);
+            double left   = (rectangle->left   + rectangle->right - length * UiGlyphWidth) / 2;
+            double bottom = (rectangle->bottom + rectangle->top   - UiGlyphHeight)         / 2;
+            for(size_t symbol = 0; text[symbol] != '\0'; symbol++) {
+                if(text[symbol] == ' ') {
+                    continue;
+                }
+                double      x     = left + (double)symbol * UiGlyphWidth;
+                rectangle_t glyph = {.left   = fmax(x + 1,                 rectangle->left),
+                                     .right  = fmin(x + UiGlyphWidth - 1,  rectangle->right),
+                                     .bottom = fmax(bottom + 2,            rectangle->bottom),
+                                     .top    = fmin(bottom + UiGlyphHeight, rectangle->top)};
+                RETURN_IF_ERROR(ui_fill(ui, &glyph, color));
+            }
+            return AKINATOR_SUCCESS;
+        }
+        default: {
+            return AKINATOR_UI_ERROR;
+        }
+    }
+}
+
+akinator_error_t ui_wait_event(akinator_ui_t       *ui,
+                               akinator_ui_event_t *event) {
+    switch(ui->backend) {
+        case UI_BACKEND_WINDOW: {
+#ifdef _WIN32
+            return graphics_window_wait_event(ui, event);
+#else
+            return AKINATOR_UI_ERROR;
+#endif
+        }
+        case UI_BACKEND_HEADLESS: {
+            pthread_mutex_lock(&ui->lock);
+            while(ui->events_size == 0) {
+                pthread_cond_wait(&ui->changed, &ui->lock);
+            }
+            *event          = ui->events[ui->events_head];
+            ui->events_head = (ui->events_head + 1) % UiEventQueueCapacity;
+            ui->events_size--;
+            pthread_cond_broadcast(&ui->changed);
+            pthread_mutex_unlock(&ui->lock);
+            return AKINATOR_SUCCESS;
+        }
+        default: {
+            return AKINATOR_UI_ERROR;
+        }
+    }
+}
+
+//a full queue makes the poster wait
+akinator_error_t akinator_ui_post_event(akinator_ui_t             *ui,
+                                        const akinator_ui_event_t *event) {
+    _C_ASSERT(ui    != NULL,                         return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(event != NULL,                         return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(ui->backend == UI_BACKEND_HEADLESS, return AKINATOR_UI_ERROR               );
+
+    pthread_mutex_lock(&ui->lock);
+    while(ui->events_size == UiEventQueueCapacity) {
+        pthread_cond_wait(&ui->changed, &ui->lock);
+    }
+    ui->events[(ui->events_head + ui->events_size) % UiEventQueueCapacity] = *event;
+    ui->events_size++;
+    pthread_cond_broadcast(&ui->changed);
+    pthread_mutex_unlock(&ui->lock);
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t akinator_ui_write_ppm(akinator_ui_t *ui,
+                                       const char    *filename) {
+    _C_ASSERT(ui         != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+    _C_ASSERT(ui->pixels != NULL, return AKINATOR_UI_ERROR               );
+    _C_ASSERT(filename   != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    FILE *file = fopen(filename, "wb");
+    if(file == NULL) {
+        return AKINATOR_UI_ERROR;
+    }
+    fprintf(file, "P6\n%d %d\n255\n", ui->width, ui->height);
+    for(size_t pixel = 0; pixel < (size_t)ui->width * (size_t)ui->height; pixel++) {
+        uint8_t rgb[] = {(uint8_t)(ui->pixels[pixel] >> 16),
+                         (uint8_t)(ui->pixels[pixel] >> 8),
+                         (uint8_t)(ui->pixels[pixel])};
+        fwrite(rgb, 1, sizeof(rgb), file);
+    }
+    return (fclose(file) == 0) ? AKINATOR_SUCCESS : AKINATOR_UI_ERROR;
+}
+
+akinator_error_t akinator_ui_dtor(akinator_ui_t *ui) {
+    _C_ASSERT(ui != NULL, return AKINATOR_NULL_FUNCTION_PARAMETER);
+
+    if(ui->frame_time.count != 0) {
+        uint64_t p50 = 0;
+        uint64_t p99 = 0;
+        akinator_histogram_percentile(&ui->frame_time, 50.0, &p50);
+        akinator_histogram_percentile(&ui->frame_time, 99.0, &p99);
+        color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                     "UI: %zu events, %zu frames, %zu pixels drawn, frame p50 %.3f ms, p99 %.3f ms.\n",
+                     ui->events_number,
+                     ui->frames_number,
+                     ui->drawn_pixels,
+                     (double)p50 / 1e6,
+                     (double)p99 / 1e6);
+    }
+    pthread_cond_destroy (&ui->changed);
+    pthread_mutex_destroy(&ui->lock);
+    free(ui->pixels);
+    ui->pixels = NULL;
+    return AKINATOR_SUCCESS;
+}
+
+//touching counts, so neighbouring buttons end up in one rectangle
+bool ui_intersects(const rectangle_t *first,
+                   const rectangle_t *second) {
+    return first->left   <= second->right && second->left   <= first->right &&
+           first->bottom <= second->top   && second->bottom <= first->top;
+}
+
+void ui_unite(rectangle_t       *destination,
+              const rectangle_t *source) {
+    destination->left   = fmin(destination->left,   source->left);
+    destination->right  = fmax(destination->right,  source->right);
+    destination->bottom = fmin(destination->bottom, source->bottom);
+    destination->top    = fmax(destination->top,    source->top);
+}
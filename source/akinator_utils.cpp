@@ -1,13 +1,15 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "akinator_utils.h"
 
 static const size_t max_system_command_length = 256;
 
+//children slots may be swapped by the learning writer while sessions read them
 bool is_leaf(akinator_node_t *node) {
-    if(node->no == NULL) {
+    if(__atomic_load_n(&node->no, __ATOMIC_RELAXED) == NULL) {
         return true;
     }
     else {
@@ -36,3 +38,10 @@ size_t file_size(FILE *file) {
     fseek(file, position, SEEK_SET);
     return size;
 }
+
+//monotonic clock for latencies and periods, never goes back when the wall clock is set
+uint64_t get_time_ns(void) {
+    struct timespec time = {};
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000 + (uint64_t)time.tv_nsec;
+}
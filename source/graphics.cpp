@@ -1,25 +1,8 @@
 #include "TXLib.h"
 #include "graphics.h"
+#include "akinator_ui.h"
 #include "colors.h"
 
-struct point_t {
-    double x;
-    double y;
-};
-
-struct rectangle_t {
-    double left;
-    double right;
-    double bottom;
-    double top;
-};
-
-struct akinator_menu_t {
-    rectangle_t *button_boxes;
-    const char **labels;
-    size_t number;
-};
-
 static HDC MainMenuBackground       = NULL;
 static HDC GuessPageBackground      = NULL;
 static HDC DefinitionPageBackground = NULL;
@@ -27,29 +10,40 @@ static HDC DifferencePageBackground = NULL;
 
 static const size_t  ScreenWidth           = 800;
 static const size_t  ScreenHeight          = 600;
-static const size_t  MainMenuButtonsNumber = 4;
+static const size_t  MainMenuButtonsNumber = 8;
 static const double  MainMenuButtonsWidth  = 300;
 static const double  MainMenuButtonsHeight = 50;
 static const double  YesNoButtonsWidth     = 200;
 static const double  YesNoButtonsHeight    = 50;
 static const point_t YesNoButtonsCenter    = {.x = ScreenWidth  - YesNoButtonsWidth,
                                               .y = ScreenHeight - YesNoButtonsHeight * 2};
+static const size_t  UncertainButtonsNumber = 5;
 
 static const COLORREF TextColor           = RGB(0xff, 0xff, 0xff);
 static const COLORREF BoxColor            = RGB(0x00, 0x00, 0x00);
-static const COLORREF HighlightedBoxColor = RGB(0x21, 0x12, 0x11);
 
 static const rectangle_t DefaultMessageBox = {.left = 10, .right = 500, .bottom = 20, .top = 300};
 
-static double           get_main_menu_box_center_y( size_t number);
-
-static akinator_error_t akinator_run_menu          (akinator_menu_t *menu,
-                                                    size_t          *chosen_case);
+//keys the window backend watches and the ui keys they become
+static const int WindowKeys[][2] = {{VK_RETURN, UI_KEY_ENTER},
+                                    {VK_UP,     UI_KEY_UP   },
+                                    {VK_DOWN,   UI_KEY_DOWN },
+                                    {'Y',       'y'         },
+                                    {'N',       'n'         },
+                                    {'1',       '1'         },
+                                    {'2',       '2'         },
+                                    {'3',       '3'         },
+                                    {'4',       '4'         },
+                                    {'5',       '5'         },
+                                    {'6',       '6'         },
+                                    {'7',       '7'         },
+                                    {'8',       '8'         }};
+
+static akinator_ui_t Ui = {};
 
-static akinator_error_t akinator_draw_menu         (akinator_menu_t *menu,
-                                                    size_t           highlighted);
+static double           get_main_menu_box_center_y( size_t number);
 
-static bool             is_in                      (point_t *point, rectangle_t *rect);
+static COLORREF         graphics_color             (uint32_t color);
 
 akinator_error_t akinator_graphics_init(void) {
     txCreateWindow(ScreenWidth, ScreenHeight);
@@ -65,7 +59,7 @@ akinator_error_t akinator_graphics_init(void) {
     DifferencePageBackground = txLoadImage("img/main_menu.bmp");
 
     txBitBlt(txDC(), 0, 0, ScreenWidth, ScreenHeight, MainMenuBackground);
-    return AKINATOR_SUCCESS;
+    return akinator_ui_ctor(&Ui, UI_BACKEND_WINDOW, ScreenWidth, ScreenHeight);
 }
 
 akinator_error_t akinator_graphics_dtor(void) {
@@ -79,16 +73,20 @@ akinator_error_t akinator_graphics_dtor(void) {
     DefinitionPageBackground = NULL;
     DifferencePageBackground = NULL;
     txDisableAutoPause();
-    return AKINATOR_SUCCESS;
+    return akinator_ui_dtor(&Ui);
 }
 
 akinator_error_t akinator_go_to_main_menu(main_menu_cases_t *output) {
     txBitBlt(txDC(), 0, 0, ScreenWidth, ScreenHeight, MainMenuBackground);
 
-    const char *labels[] = {" ",
-                            "",
-                            "",
-                            ""};
+    const char *labels[] = {"Давай рескни",
+                            "Быстрая игра",
+                            "Игра с сомнением",
+                            "Определение",
+                            "Разница",
+                            "Похожие",
+                            "Поиск вопросов",
+                            "Выход"};
     rectangle_t rectangles[MainMenuButtonsNumber] = {};
     for(size_t i = 0; i < MainMenuButtonsNumber; i++) {
         double box_center_y  = get_main_menu_box_center_y(i);
@@ -102,89 +100,19 @@ akinator_error_t akinator_go_to_main_menu(main_menu_cases_t *output) {
     akinator_menu_t menu = {
         .button_boxes = rectangles,
         .labels       = labels,
+        .shortcuts    = NULL,
         .number       = MainMenuButtonsNumber
     };
 
-    akinator_run_menu(&menu, (size_t *)output);
-
-    return AKINATOR_SUCCESS;
-}
+    size_t chosen = MainMenuButtonsNumber;
+    RETURN_IF_ERROR(akinator_ui_run_menu(&Ui, &menu, &chosen));
+    *output = (chosen < MainMenuButtonsNumber) ? (main_menu_cases_t)chosen : MAIN_MENU_EXIT;
 
-akinator_error_t akinator_run_menu(akinator_menu_t *menu, size_t *chosen_case) {
-    txBegin();
-    akinator_draw_menu(menu, *chosen_case);
-    while(true) {
-        POINT   tx_mouse_pos   = txMousePos();
-        point_t mouse_position = {.x = (double)tx_mouse_pos.x,
-                                  .y = (double)tx_mouse_pos.y};
-        bool is_set     = false;
-        bool is_running = true;
-        for(size_t i = 0; i < menu->number; i++) {
-            if(is_in(&mouse_position, menu->button_boxes + i)) {
-                *chosen_case = i;
-                is_set = true;
-                if(txGetAsyncKeyState(VK_LBUTTON)) {
-                    is_running = false;
-                }
-            }
-        }
-        if(!is_set) {
-            *chosen_case = menu->number;
-        }
-        if(!is_running) {
-            akinator_draw_menu(menu, menu->number);
-            break;
-        }
-        akinator_draw_menu(menu, *chosen_case);
-    }
-    txEnd();
     return AKINATOR_SUCCESS;
 }
 
-akinator_error_t akinator_draw_menu(akinator_menu_t *menu, size_t highlighted) {
-    for(size_t i = 0; i < menu->number; i++) {
-        COLORREF fill_color = BoxColor;
-        COLORREF color      = BoxColor;
-        if(i == highlighted) {
-            fill_color = HighlightedBoxColor;
-            color = HighlightedBoxColor;
-        }
-
-        txSetColor(color);
-        txSetFillColor(fill_color);
-        rectangle_t *box_rectangle = menu->button_boxes + i;
-        txRectangle(box_rectangle->left,
-                    box_rectangle->bottom,
-                    box_rectangle->right,
-                    box_rectangle->top);
-
-        txSetColor(TextColor);
-        txDrawText(box_rectangle->left,
-                   box_rectangle->bottom,
-                   box_rectangle->right,
-                   box_rectangle->top,
-                   menu->labels[i]);
-    }
-    txRedrawWindow();
-
-    return AKINATOR_SUCCESS;
-}
-
-bool is_in(point_t *point, rectangle_t *rect) {
-    if(point->x < rect->left ||
-       point->x > rect->right) {
-        return false;
-    }
-    if(point->y < rect->bottom ||
-       point->y > rect->top) {
-        return false;
-    }
-
-    return true;
-}
-
 double get_main_menu_box_center_y(size_t number) {
-    return ScreenHeight / 2 + (2 * (double)number - (double)MainMenuButtonsNumber) * MainMenuButtonsHeight;
+    return ScreenHeight / 2 + ((double)number - ((double)MainMenuButtonsNumber - 1) / 2) * MainMenuButtonsHeight * 1.5;
 }
 
 akinator_error_t akinator_ui_set_guess(void) {
@@ -224,7 +152,7 @@ akinator_error_t akinator_ui_write_message(const char *message) {
 }
 
 akinator_error_t akinator_get_answer_yes_no(akinator_answer_t *answer) {
-    const char *labels[] = {"", ""};
+    const char *labels[] = {"да", "нет"};
     rectangle_t rectangles[2] = {};
     for(size_t i = 0; i < 2; i++) {
         rectangles[i].left   = YesNoButtonsCenter.x - YesNoButtonsWidth / 2;
@@ -236,11 +164,12 @@ akinator_error_t akinator_get_answer_yes_no(akinator_answer_t *answer) {
     akinator_menu_t menu = {
         .button_boxes = rectangles,
         .labels = labels,
+        .shortcuts = "yn",
         .number = 2
     };
 
     size_t chosen = 0;
-    akinator_run_menu(&menu, &chosen);
+    RETURN_IF_ERROR(akinator_ui_run_menu(&Ui, &menu, &chosen));
     if(chosen == 0) {
         *answer = AKINATOR_ANSWER_YES;
     }
@@ -254,8 +183,129 @@ akinator_error_t akinator_get_answer_yes_no(akinator_answer_t *answer) {
     return AKINATOR_SUCCESS;
 }
 
+akinator_error_t akinator_get_answer_uncertain(akinator_answer_t *answer) {
+    const char *labels[] = {"да", "скорее да", "не знаю", "скорее нет", "нет"};
+    const akinator_answer_t answers[] = {AKINATOR_ANSWER_YES,
+                                         AKINATOR_ANSWER_PROBABLY,
+                                         AKINATOR_ANSWER_UNKNOWN,
+                                         AKINATOR_ANSWER_PROBABLY_NOT,
+                                         AKINATOR_ANSWER_NO};
+    rectangle_t rectangles[UncertainButtonsNumber] = {};
+    for(size_t i = 0; i < UncertainButtonsNumber; i++) {
+        double box_center_y = ScreenHeight - YesNoButtonsHeight *
+                              (1.2 * (double)(UncertainButtonsNumber - i) - 0.5);
+
+        rectangles[i].left   = YesNoButtonsCenter.x - YesNoButtonsWidth / 2;
+        rectangles[i].right  = YesNoButtonsCenter.x + YesNoButtonsWidth / 2;
+        rectangles[i].top    = box_center_y + YesNoButtonsHeight / 2;
+        rectangles[i].bottom = box_center_y - YesNoButtonsHeight / 2;
+    }
+
+    akinator_menu_t menu = {
+        .button_boxes = rectangles,
+        .labels = labels,
+        .shortcuts = NULL,
+        .number = UncertainButtonsNumber
+    };
+
+    size_t chosen = 0;
+    RETURN_IF_ERROR(akinator_ui_run_menu(&Ui, &menu, &chosen));
+    if(chosen < UncertainButtonsNumber) {
+        *answer = answers[chosen];
+    }
+    else {
+        *answer = AKINATOR_ANSWER_UNKNOWN;
+    }
+
+    return AKINATOR_SUCCESS;
+}
+
 akinator_error_t akinator_get_text_answer(char *output) {
-    const char *input = txInputBox(" ");
+    const char *input = txInputBox("чё надо");
     strcpy(output, input);
     return AKINATOR_SUCCESS;
 }
+
+akinator_error_t graphics_window_fill(const rectangle_t *rectangle,
+                                      uint32_t           color) {
+    txSetColor    (graphics_color(color));
+    txSetFillColor(graphics_color(color));
+    txRectangle(rectangle->left,
+                rectangle->bottom,
+                rectangle->right,
+                rectangle->top);
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t graphics_window_text(const rectangle_t *rectangle,
+                                      const char        *text,
+                                      uint32_t           color) {
+    txSetColor(graphics_color(color));
+    txDrawText(rectangle->left,
+               rectangle->bottom,
+               rectangle->right,
+               rectangle->top,
+               text);
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t graphics_window_begin(void) {
+    txBegin();
+    return AKINATOR_SUCCESS;
+}
+
+akinator_error_t graphics_window_present(void) {
+    txRedrawWindow();
+    txEnd();
+    return AKINATOR_SUCCESS;
+}
+
+//txlib has no blocking wait, so input is sampled and the thread sleeps between samples,
+//a click, a move or a key pressed since the last sample is the event
+akinator_error_t graphics_window_wait_event(akinator_ui_t       *ui,
+                                            akinator_ui_event_t *event) {
+    *event = {};
+    while(event->type == UI_EVENT_NONE) {
+        if(!txOK()) {
+            event->type = UI_EVENT_QUIT;
+            break;
+        }
+        POINT   tx_mouse_pos   = txMousePos();
+        point_t mouse_position = {.x = (double)tx_mouse_pos.x,
+                                  .y = (double)tx_mouse_pos.y};
+        bool    button         = txGetAsyncKeyState(VK_LBUTTON) != 0;
+        if(button && !ui->last_button) {
+            event->type     = UI_EVENT_MOUSE_DOWN;
+            event->position = mouse_position;
+        }
+        //txlib gives whole pixels, so they are compared as such
+        else if(tx_mouse_pos.x != (long)ui->last_mouse.x || tx_mouse_pos.y != (long)ui->last_mouse.y) {
+            event->type     = UI_EVENT_MOUSE_MOVE;
+            event->position = mouse_position;
+        }
+        ui->last_button = button;
+        ui->last_mouse  = mouse_position;
+
+        //a press is remembered only once it became an event, one that came with a mouse
+        //event or another key is still new on the next call, which does not sleep
+        for(size_t key = 0; key < sizeof(WindowKeys) / sizeof(WindowKeys[0]); key++) {
+            bool pressed = txGetAsyncKeyState(WindowKeys[key][0]) != 0;
+            if(!pressed) {
+                ui->last_keys[WindowKeys[key][1]] = false;
+            }
+            else if(!ui->last_keys[WindowKeys[key][1]] && event->type == UI_EVENT_NONE) {
+                event->type = UI_EVENT_KEY;
+                event->key  = WindowKeys[key][1];
+                ui->last_keys[WindowKeys[key][1]] = true;
+            }
+        }
+        if(event->type == UI_EVENT_NONE) {
+            txSleep(UiPollIntervalMs);
+        }
+    }
+    return AKINATOR_SUCCESS;
+}
+
+COLORREF graphics_color(uint32_t color) {
+    return RGB((color >> 16) & 0xff, (color >> 8) & 0xff, color & 0xff);
+}
@@ -5,6 +5,7 @@
 
 #include "akinator.h"
 #include "akinator_dump.h"
+#include "akinator_trace.h"
 #include "graphics.h"
 
 int main_exit_failure(akinator_t *akinator);
@@ -16,6 +17,10 @@ int main(void) {
     }
     AKINATOR_DUMP(&akinator);
     while(true) {
+        //back in the menu no change is in progress, the checkpoint the trace asked for is taken here
+        if(akinator_trace_checkpoint(akinator.trace) != AKINATOR_SUCCESS) {
+            return main_exit_failure(&akinator);
+        }
         main_menu_cases_t chosen_case = MAIN_MENU_EXIT;
         if(akinator_go_to_main_menu(&chosen_case) != AKINATOR_SUCCESS) {
             return main_exit_failure(&akinator);
@@ -27,6 +32,18 @@ int main(void) {
                 }
                 break;
             }
+            case MAIN_MENU_GO_FAST_GUESS: {
+                if(akinator_fast_guess(&akinator) != AKINATOR_SUCCESS) {
+                    return main_exit_failure(&akinator);
+                }
+                break;
+            }
+            case MAIN_MENU_GO_BEAM_GUESS: {
+                if(akinator_beam_guess(&akinator) != AKINATOR_SUCCESS) {
+                    return main_exit_failure(&akinator);
+                }
+                break;
+            }
             case MAIN_MENU_GO_DEFINITION: {
                 if(akinator_definition(&akinator) != AKINATOR_SUCCESS) {
                     return main_exit_failure(&akinator);
@@ -39,6 +56,18 @@ int main(void) {
                 }
                 break;
             }
+            case MAIN_MENU_GO_SIMILAR: {
+                if(akinator_similar_objects(&akinator) != AKINATOR_SUCCESS) {
+                    return main_exit_failure(&akinator);
+                }
+                break;
+            }
+            case MAIN_MENU_GO_SEARCH: {
+                if(akinator_search(&akinator) != AKINATOR_SUCCESS) {
+                    return main_exit_failure(&akinator);
+                }
+                break;
+            }
             case MAIN_MENU_EXIT: {
                 akinator_dtor(&akinator);
                 return EXIT_SUCCESS;
@@ -1,46 +1,640 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
 #include "tts.h"
+#include "akinator_encoding.h"
+#include "akinator_utils.h"
+#include "colors.h"
+
+static void              *tts_worker           (void               *argument);
+
+static tts_error_t        tts_post             (tts_t              *tts,
+                                                tts_message_t      *queue,
+                                                size_t             *head,
+                                                size_t             *size,
+                                                size_t              capacity,
+                                                const char         *string);
+
+static tts_error_t        tts_say              (tts_t              *tts,
+                                                tts_message_t      *message);
+
+static bool               tts_prepare_next     (tts_t              *tts);
+
+static tts_cache_entry_t *tts_synthesize       (tts_t              *tts,
+                                                const char         *text,
+                                                uint64_t            key);
+
+static bool               tts_is_stale         (tts_t              *tts,
+                                                tts_message_t      *message);
+
+static tts_error_t        tts_backend_open     (tts_t              *tts);
+
+static tts_error_t        tts_backend_render   (tts_t              *tts,
+                                                const char         *text,
+                                                uint8_t           **audio,
+                                                size_t             *audio_size);
+
+static tts_error_t        tts_backend_play     (tts_t              *tts,
+                                                tts_message_t      *message,
+                                                tts_cache_entry_t  *entry);
+
+static tts_error_t        tts_backend_close    (tts_t              *tts);
+
+static tts_error_t        tts_wav_open         (tts_t              *tts);
 
-static tts_error_t ConvertCP1251ToUTF8(const char *string, wchar_t *output);
+static tts_error_t        tts_wav_render       (const char         *text,
+                                                uint8_t           **audio,
+                                                size_t             *audio_size);
 
-tts_error_t ConvertCP1251ToUTF8(const char *string, wchar_t *output) {
-    int len = MultiByteToWideChar(1251, 0, string, -1, NULL, 0);
-    MultiByteToWideChar(1251, 0, string, -1, output, len);
+static tts_error_t        tts_wav_play         (tts_t              *tts,
+                                                tts_message_t      *message,
+                                                tts_cache_entry_t  *entry);
 
+static tts_error_t        tts_wav_close        (tts_t              *tts);
+
+static void               tts_wav_header       (uint8_t            *header,
+                                                uint32_t            data_size);
+
+static void               tts_wav_put          (uint8_t            *output,
+                                                uint32_t            value,
+                                                size_t              size);
+
+#ifdef _WIN32
+static tts_error_t        tts_sapi_open        (tts_t              *tts);
+
+static tts_error_t        tts_sapi_render      (tts_t              *tts,
+                                                const char         *text,
+                                                uint8_t           **audio,
+                                                size_t             *audio_size);
+
+static tts_error_t        tts_sapi_play        (tts_t              *tts,
+                                                tts_message_t      *message,
+                                                tts_cache_entry_t  *entry);
+
+static tts_error_t        tts_sapi_close       (tts_t              *tts);
+#endif
+
+tts_error_t tts_ctor(tts_t         *tts,
+                     tts_backend_t  backend,
+                     const char    *wav_name,
+                     const char    *cache_directory) {
+    if(tts == NULL || (backend == TTS_BACKEND_WAV && wav_name == NULL)) {
+        return TTS_ERROR;
+    }
+
+    tts->backend     = backend;
+    tts->wav_name    = wav_name;
+    tts->start_delay = (akinator_histogram_t *)calloc(1, sizeof(*tts->start_delay));
+    if(tts->start_delay == NULL || !tts_cache_ctor(&tts->cache, cache_directory)) {
+        return TTS_ERROR;
+    }
+    //everything that changes the sound has to be in the voice, it is part of every key
+    snprintf(tts->voice, sizeof(tts->voice), "%d %u %u %ld",
+             (int)backend, TtsWavRate, TtsWavCharMs, TtsSapiRate);
+
+    pthread_mutex_init(&tts->lock,    NULL);
+    pthread_cond_init (&tts->changed, NULL);
+    if(pthread_create(&tts->worker, NULL, tts_worker, tts) != 0) {
+        return TTS_ERROR;
+    }
+    tts->started = true;
+
+    pthread_mutex_lock(&tts->lock);
+    while(!tts->ready) {
+        pthread_cond_wait(&tts->changed, &tts->lock);
+    }
+    tts_error_t error = tts->error;
+    pthread_mutex_unlock(&tts->lock);
+    return error;
+}
+
+tts_error_t tts_dtor(tts_t *tts) {
+    if(tts == NULL) {
+        return TTS_SUCCESS;
+    }
+
+    tts_error_t error = TTS_SUCCESS;
+    if(tts->started) {
+        tts_interrupt(tts);
+        pthread_mutex_lock(&tts->lock);
+        tts->prepare_size = 0;
+        tts->stop         = 1;
+        pthread_cond_broadcast(&tts->changed);
+        pthread_mutex_unlock(&tts->lock);
+        pthread_join(tts->worker, NULL);
+
+        pthread_cond_destroy (&tts->changed);
+        pthread_mutex_destroy(&tts->lock);
+        tts->started = false;
+        error        = tts->error;
+    }
+    tts_cache_dtor(&tts->cache);
+    free(tts->start_delay);
+    tts->start_delay = NULL;
+    return error;
+}
+
+//returns as soon as the text is queued, nothing here waits for the voice
+tts_error_t tts_speak(tts_t *tts, const char *string) {
+    if(tts == NULL || !tts->started) {
+        return TTS_ERROR;
+    }
+    return tts_post(tts, tts->queue, &tts->queue_head, &tts->queue_size, TtsQueueCapacity, string);
+}
+
+tts_error_t tts_prepare(tts_t *tts, const char *string) {
+    if(tts == NULL || !tts->started) {
+        return TTS_ERROR;
+    }
+    return tts_post(tts, tts->prepare, &tts->prepare_head, &tts->prepare_size, TtsPrepareCapacity, string);
+}
+
+//called once the player has answered, whatever was said before that is no longer news,
+//prepared texts stay, one of them is probably what comes next
+tts_error_t tts_interrupt(tts_t *tts) {
+    if(tts == NULL || !tts->started) {
+        return TTS_ERROR;
+    }
+
+    pthread_mutex_lock(&tts->lock);
+    __atomic_store_n(&tts->epoch, tts->epoch + 1, __ATOMIC_RELEASE);
+    tts->dropped_number += tts->queue_size;
+    tts->queue_size      = 0;
+    pthread_mutex_unlock(&tts->lock);
+    return TTS_SUCCESS;
+}
+
+tts_error_t tts_wait(tts_t *tts) {
+    if(tts == NULL || !tts->started) {
+        return TTS_ERROR;
+    }
+
+    pthread_mutex_lock(&tts->lock);
+    while((tts->queue_size != 0 || tts->prepare_size != 0 || tts->busy) && tts->error == TTS_SUCCESS) {
+        pthread_cond_wait(&tts->changed, &tts->lock);
+    }
+    pthread_mutex_unlock(&tts->lock);
     return TTS_SUCCESS;
 }
 
-tts_error_t tts_ctor(tts_t *tts) {
-    if(SUCCEEDED(::CoInitialize(0))) {
-        ISpVoice* pVoice = nullptr;
-        const HRESULT hr_create = ::CoCreateInstance(::CLSID_SpVoice,
-                                                     nullptr,
-                                                     CLSCTX_ALL,
-                                                     ::IID_ISpVoice,
-                                                     (void **)&pVoice);
-        pVoice->SetRate(5);
-        if(!SUCCEEDED(hr_create)) {
+tts_error_t tts_print_stats(tts_t *tts) {
+    if(tts == NULL || !tts->started) {
+        return TTS_ERROR;
+    }
+
+    pthread_mutex_lock(&tts->lock);
+    uint64_t p50 = 0;
+    uint64_t p99 = 0;
+    akinator_histogram_percentile(tts->start_delay, 50.0, &p50);
+    akinator_histogram_percentile(tts->start_delay, 99.0, &p99);
+    size_t looked_up = tts->hits_number + tts->misses_number;
+    color_printf(GREEN_TEXT, NORMAL_TEXT, DEFAULT_BACKGROUND,
+                 "Speech: %zu spoken, %zu cancelled, %zu dropped, cache hits %zu of %zu (%.1f%%), "
+                 "%zu loaded from disk, %zu prepared, start delay p50 %.3f ms, p99 %.3f ms.\n",
+                 tts->spoken_number,
+                 tts->cancelled_number,
+                 tts->dropped_number,
+                 tts->hits_number,
+                 looked_up,
+                 (looked_up == 0) ? 0.0 : 100.0 * (double)tts->hits_number / (double)looked_up,
+                 tts->cache.disk_loads_number,
+                 tts->prepared_number,
+                 (double)p50 / 1e6,
+                 (double)p99 / 1e6);
+    pthread_mutex_unlock(&tts->lock);
+    return TTS_SUCCESS;
+}
+
+tts_error_t tts_post(tts_t         *tts,
+                     tts_message_t *queue,
+                     size_t        *head,
+                     size_t        *size,
+                     size_t         capacity,
+                     const char    *string) {
+    if(string == NULL || strlen(string) > MaxMessageSize) {
+        return TTS_ERROR;
+    }
+
+    pthread_mutex_lock(&tts->lock);
+    if(*size == capacity) {
+        *head = (*head + 1) % capacity;
+        (*size)--;
+        tts->dropped_number++;
+    }
+    tts_message_t *message = &queue[(*head + *size) % capacity];
+    strcpy(message->text, string);
+    message->epoch     = tts->epoch;
+    message->posted_ns = get_time_ns();
+    (*size)++;
+    pthread_cond_broadcast(&tts->changed);
+    tts_error_t error = tts->error;
+    pthread_mutex_unlock(&tts->lock);
+    return error;
+}
+
+//spoken messages go first, prepared texts are synthesized only when nothing waits
+void *tts_worker(void *argument) {
+    tts_t      *tts    = (tts_t *)argument;
+    tts_error_t error  = tts_backend_open(tts);
+    bool        opened = (error == TTS_SUCCESS);
+
+    pthread_mutex_lock(&tts->lock);
+    tts->error = error;
+    tts->ready = true;
+    pthread_cond_broadcast(&tts->changed);
+    while(error == TTS_SUCCESS) {
+        while(tts->queue_size == 0 && tts->prepare_size == 0 && !tts->stop) {
+            pthread_cond_wait(&tts->changed, &tts->lock);
+        }
+        if(tts->queue_size == 0 && tts->stop) {
+            break;
+        }
+        if(tts->queue_size == 0) {
+            tts->busy = true;
+            pthread_mutex_unlock(&tts->lock);
+            tts_prepare_next(tts);
+            pthread_mutex_lock(&tts->lock);
+            tts->busy = false;
+            pthread_cond_broadcast(&tts->changed);
+            continue;
+        }
+
+        tts->current    = tts->queue[tts->queue_head];
+        tts->queue_head = (tts->queue_head + 1) % TtsQueueCapacity;
+        tts->queue_size--;
+        tts->busy       = true;
+        pthread_mutex_unlock(&tts->lock);
+
+        uint64_t start = get_time_ns();
+        if(!tts_is_stale(tts, &tts->current)) {
+            error = tts_say(tts, &tts->current);
+        }
+        uint64_t spent = get_time_ns() - start;
+
+        pthread_mutex_lock(&tts->lock);
+        tts->speak_ns += spent;
+        tts->spoken_number++;
+        tts->error     = error;
+        tts->busy      = false;
+        pthread_cond_broadcast(&tts->changed);
+    }
+    pthread_mutex_unlock(&tts->lock);
+
+    if(opened && tts_backend_close(tts) != TTS_SUCCESS) {
+        tts->error = TTS_ERROR;
+    }
+    return NULL;
+}
+
+//cache entry is pinned while it plays, preparing during playback must not evict it
+tts_error_t tts_say(tts_t         *tts,
+                    tts_message_t *message) {
+    uint64_t           key   = tts_cache_key(tts->voice, message->text);
+    tts_cache_entry_t *entry = tts_cache_find(&tts->cache, key, message->text);
+    bool               hit   = (entry != NULL);
+    if(!hit) {
+        entry = tts_synthesize(tts, message->text, key);
+    }
+    if(entry == NULL) {
+        return TTS_ERROR;
+    }
+
+    pthread_mutex_lock(&tts->lock);
+    akinator_histogram_add(tts->start_delay, get_time_ns() - message->posted_ns);
+    if(hit) {
+        tts->hits_number++;
+    }
+    else {
+        tts->misses_number++;
+    }
+    pthread_mutex_unlock(&tts->lock);
+
+    entry->pinned     = true;
+    tts_error_t error = tts_backend_play(tts, message, entry);
+    entry->pinned     = false;
+    return error;
+}
+
+bool tts_prepare_next(tts_t *tts) {
+    pthread_mutex_lock(&tts->lock);
+    if(tts->prepare_size == 0) {
+        pthread_mutex_unlock(&tts->lock);
+        return false;
+    }
+    tts->preparing    = tts->prepare[tts->prepare_head];
+    tts->prepare_head = (tts->prepare_head + 1) % TtsPrepareCapacity;
+    tts->prepare_size--;
+    pthread_mutex_unlock(&tts->lock);
+
+    uint64_t key = tts_cache_key(tts->voice, tts->preparing.text);
+    if(tts_cache_find(&tts->cache, key, tts->preparing.text) == NULL &&
+       tts_synthesize(tts, tts->preparing.text, key) != NULL) {
+        tts->prepared_number++;
+    }
+    return true;
+}
+
+tts_cache_entry_t *tts_synthesize(tts_t      *tts,
+                                  const char *text,
+                                  uint64_t    key) {
+    uint8_t *audio      = NULL;
+    size_t   audio_size = 0;
+    if(tts_backend_render(tts, text, &audio, &audio_size) != TTS_SUCCESS) {
+        free(audio);
+        return NULL;
+    }
+    return tts_cache_add(&tts->cache, key, text, audio, audio_size);
+}
+
+bool tts_is_stale(tts_t *tts, tts_message_t *message) {
+    if(message->epoch == __atomic_load_n(&tts->epoch, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    tts->cancelled_number++;
+    return true;
+}
+
+tts_error_t tts_backend_open(tts_t *tts) {
+    switch(tts->backend) {
+        case TTS_BACKEND_NULL: return TTS_SUCCESS;
+        case TTS_BACKEND_WAV:  return tts_wav_open(tts);
+#ifdef _WIN32
+        case TTS_BACKEND_SAPI: return tts_sapi_open(tts);
+#else
+        case TTS_BACKEND_SAPI: return TTS_ERROR;
+#endif
+        default:               return TTS_ERROR;
+    }
+}
+
+tts_error_t tts_backend_render(tts_t       *tts,
+                               const char  *text,
+                               uint8_t    **audio,
+                               size_t      *audio_size) {
+    switch(tts->backend) {
+        case TTS_BACKEND_NULL: return tts_wav_render("", audio, audio_size);
+        case TTS_BACKEND_WAV:  return tts_wav_render(text, audio, audio_size);
+#ifdef _WIN32
+        case TTS_BACKEND_SAPI: return tts_sapi_render(tts, text, audio, audio_size);
+#else
+        case TTS_BACKEND_SAPI: return TTS_ERROR;
+#endif
+        default:               return TTS_ERROR;
+    }
+}
+
+tts_error_t tts_backend_play(tts_t             *tts,
+                             tts_message_t     *message,
+                             tts_cache_entry_t *entry) {
+    switch(tts->backend) {
+        case TTS_BACKEND_NULL: return TTS_SUCCESS;
+        case TTS_BACKEND_WAV:  return tts_wav_play(tts, message, entry);
+#ifdef _WIN32
+        case TTS_BACKEND_SAPI: return tts_sapi_play(tts, message, entry);
+#else
+        case TTS_BACKEND_SAPI: return TTS_ERROR;
+#endif
+        default:               return TTS_ERROR;
+    }
+}
+
+tts_error_t tts_backend_close(tts_t *tts) {
+    switch(tts->backend) {
+        case TTS_BACKEND_NULL: return TTS_SUCCESS;
+        case TTS_BACKEND_WAV:  return tts_wav_close(tts);
+#ifdef _WIN32
+        case TTS_BACKEND_SAPI: return tts_sapi_close(tts);
+#else
+        case TTS_BACKEND_SAPI: return TTS_ERROR;
+#endif
+        default:               return TTS_ERROR;
+    }
+}
+
+//header is written with empty sizes and filled in on close
+tts_error_t tts_wav_open(tts_t *tts) {
+    tts->wav = fopen(tts->wav_name, "wb");
+    if(tts->wav == NULL) {
+        return TTS_ERROR;
+    }
+
+    uint8_t header[TtsWavHeaderSize] = {};
+    tts_wav_header(header, 0);
+    if(fwrite(header, 1, sizeof(header), tts->wav) != sizeof(header)) {
+        return TTS_ERROR;
+    }
+    return TTS_SUCCESS;
+}
+
+//every letter is a short tone with its own pitch, spaces are silence, the phase runs
+//on across letters so the sound has no clicks and starts from zero for every text,
+//the same text always gives the same bytes
+tts_error_t tts_wav_render(const char  *text,
+                           uint8_t    **audio,
+                           size_t      *audio_size) {
+    static const size_t char_samples = TtsWavRate * TtsWavCharMs / 1000;
+
+    size_t data_size = strlen(text) * char_samples * 2;
+    *audio_size = TtsWavHeaderSize + data_size;
+    *audio      = (uint8_t *)malloc(*audio_size);
+    if(*audio == NULL) {
+        return TTS_ERROR;
+    }
+    tts_wav_header(*audio, (uint32_t)data_size);
+
+    uint8_t *output = *audio + TtsWavHeaderSize;
+    double   phase  = 0;
+    for(const char *symbol = text; *symbol != '\0'; symbol++) {
+        unsigned char code      = (unsigned char)*symbol;
+        double        frequency = 200.0 + 20.0 * (double)(code % 32);
+        double        amplitude = (code == ' ') ? 0.0 : 8000.0;
+        for(size_t sample = 0; sample < char_samples; sample++) {
+            tts_wav_put(output, (uint16_t)(int16_t)(amplitude * sin(phase)), 2);
+            output += 2;
+            phase  += 2.0 * M_PI * frequency / TtsWavRate;
+        }
+        phase = fmod(phase, 2.0 * M_PI);
+    }
+    return TTS_SUCCESS;
+}
+
+//appended a letter at a time, so an interrupt cuts it like a voice would be cut
+tts_error_t tts_wav_play(tts_t             *tts,
+                         tts_message_t     *message,
+                         tts_cache_entry_t *entry) {
+    static const size_t char_bytes = TtsWavRate * TtsWavCharMs / 1000 * 2;
+
+    for(size_t offset = TtsWavHeaderSize; offset < entry->audio_size; offset += char_bytes) {
+        if(tts_is_stale(tts, message)) {
+            break;
+        }
+        size_t size = (entry->audio_size - offset < char_bytes) ? entry->audio_size - offset : char_bytes;
+        if(fwrite(entry->audio + offset, 1, size, tts->wav) != size) {
             return TTS_ERROR;
         }
-        tts->speaker = pVoice;
+        tts->wav_samples += (uint32_t)(size / 2);
     }
     return TTS_SUCCESS;
 }
 
-tts_error_t tts_dtor(tts_t *tts) {
-    tts->speaker->Release();
-    tts->speaker = NULL;
-    ::CoUninitialize();
+tts_error_t tts_wav_close(tts_t *tts) {
+    uint8_t header[TtsWavHeaderSize] = {};
+    tts_wav_header(header, tts->wav_samples * 2);
+    fseek (tts->wav, 0, SEEK_SET);
+    fwrite(header, 1, sizeof(header), tts->wav);
+    tts_error_t error = ferror(tts->wav) ? TTS_ERROR : TTS_SUCCESS;
+    fclose(tts->wav);
+    tts->wav = NULL;
+    return error;
+}
+
+//16 bit mono pcm at TtsWavRate
+void tts_wav_header(uint8_t  *header,
+                    uint32_t  data_size) {
+    memcpy(header, "RIFF\0\0\0\0WAVEfmt ", 16);
+    tts_wav_put(header +  4, 36 + data_size, 4);
+    tts_wav_put(header + 16, 16,             4);
+    tts_wav_put(header + 20, 1,              2);
+    tts_wav_put(header + 22, 1,              2);
+    tts_wav_put(header + 24, TtsWavRate,     4);
+    tts_wav_put(header + 28, TtsWavRate * 2, 4);
+    tts_wav_put(header + 32, 2,              2);
+    tts_wav_put(header + 34, 16,             2);
+    memcpy(header + 36, "data", 4);
+    tts_wav_put(header + 40, data_size,      4);
+}
+
+void tts_wav_put(uint8_t  *output,
+                 uint32_t  value,
+                 size_t    size) {
+    for(size_t index = 0; index < size; index++) {
+        output[index] = (uint8_t)(value >> (8 * index));
+    }
+}
+
+#ifdef _WIN32
+tts_error_t tts_sapi_open(tts_t *tts) {
+    if(!SUCCEEDED(::CoInitialize(0))) {
+        return TTS_ERROR;
+    }
+    ISpVoice* pVoice = nullptr;
+    const HRESULT hr_create = ::CoCreateInstance(::CLSID_SpVoice,
+                                                 nullptr,
+                                                 CLSCTX_ALL,
+                                                 ::IID_ISpVoice,
+                                                 (void **)&pVoice);
+    if(!SUCCEEDED(hr_create)) {
+        ::CoUninitialize();
+        return TTS_ERROR;
+    }
+    pVoice->SetRate(TtsSapiRate);
+    tts->speaker = pVoice;
     return TTS_SUCCESS;
 }
 
-tts_error_t tts_speak(tts_t *tts, const char *string) {
+//voice speaks into a memory stream in the format the wav backend writes, the pcm is
+//then copied behind a wav header
+tts_error_t tts_sapi_render(tts_t       *tts,
+                            const char  *text,
+                            uint8_t    **audio,
+                            size_t      *audio_size) {
+    //wchar_t is utf-16 on windows
     wchar_t wide_string[MaxMessageSize + 1] = {};
-    if(ConvertCP1251ToUTF8(string, wide_string) != TTS_SUCCESS) {
+    size_t  wide_size                       = 0;
+    if(akinator_cp1251_to_utf16(text, strlen(text), (uint16_t *)wide_string, MaxMessageSize, &wide_size) != AKINATOR_SUCCESS) {
         return TTS_ERROR;
     }
-    const HRESULT hr_speak = tts->speaker->Speak(wide_string, 0, nullptr);
-    if(!SUCCEEDED(hr_speak)) {
+    wide_string[wide_size] = L'\0';
+
+    WAVEFORMATEX format    = {};
+    format.wFormatTag      = WAVE_FORMAT_PCM;
+    format.nChannels       = 1;
+    format.nSamplesPerSec  = TtsWavRate;
+    format.wBitsPerSample  = 16;
+    format.nBlockAlign     = 2;
+    format.nAvgBytesPerSec = TtsWavRate * 2;
+
+    IStream   *memory = nullptr;
+    ISpStream *stream = nullptr;
+    HRESULT    hr     = ::CreateStreamOnHGlobal(nullptr, TRUE, &memory);
+    if(SUCCEEDED(hr)) {
+        hr = ::CoCreateInstance(::CLSID_SpStream, nullptr, CLSCTX_ALL, ::IID_ISpStream, (void **)&stream);
+    }
+    if(SUCCEEDED(hr)) {
+        hr = stream->SetBaseStream(memory, SPDFID_WaveFormatEx, &format);
+    }
+    if(SUCCEEDED(hr)) {
+        hr = tts->speaker->SetOutput(stream, TRUE);
+    }
+    if(SUCCEEDED(hr)) {
+        hr = tts->speaker->Speak(wide_string, SPF_DEFAULT, nullptr);
+        tts->speaker->SetOutput(nullptr, TRUE);
+    }
+
+    ULARGE_INTEGER end  = {};
+    LARGE_INTEGER  zero = {};
+    HGLOBAL        data = nullptr;
+    if(SUCCEEDED(hr)) {
+        hr = memory->Seek(zero, STREAM_SEEK_CUR, &end);
+    }
+    if(SUCCEEDED(hr)) {
+        hr = ::GetHGlobalFromStream(memory, &data);
+    }
+    if(SUCCEEDED(hr)) {
+        size_t data_size = (size_t)end.QuadPart;
+        *audio_size = TtsWavHeaderSize + data_size;
+        *audio      = (uint8_t *)malloc(*audio_size);
+        void *pcm   = ::GlobalLock(data);
+        if(*audio != NULL && pcm != NULL) {
+            tts_wav_header(*audio, (uint32_t)data_size);
+            memcpy(*audio + TtsWavHeaderSize, pcm, data_size);
+        }
+        else {
+            hr = E_OUTOFMEMORY;
+        }
+        if(pcm != NULL) {
+            ::GlobalUnlock(data);
+        }
+    }
+
+    if(stream != nullptr) {
+        stream->Release();
+    }
+    if(memory != nullptr) {
+        memory->Release();
+    }
+    return SUCCEEDED(hr) ? TTS_SUCCESS : TTS_ERROR;
+}
+
+//PlaySound plays on its own, the worker prepares texts until the sound should be over
+//and purges it when a newer message makes it stale
+tts_error_t tts_sapi_play(tts_t             *tts,
+                          tts_message_t     *message,
+                          tts_cache_entry_t *entry) {
+    if(!::PlaySoundA((LPCSTR)entry->audio, nullptr, SND_MEMORY | SND_ASYNC | SND_NODEFAULT)) {
         return TTS_ERROR;
     }
+
+    uint64_t duration_ns = (uint64_t)(entry->audio_size - TtsWavHeaderSize) / 2 * 1000000000 / TtsWavRate;
+    uint64_t start       = get_time_ns();
+    while(get_time_ns() - start < duration_ns) {
+        if(tts_is_stale(tts, message)) {
+            ::PlaySoundA(nullptr, nullptr, 0);
+            break;
+        }
+        if(!tts_prepare_next(tts)) {
+            ::Sleep(TtsPollMs);
+        }
+    }
+    return TTS_SUCCESS;
+}
+
+tts_error_t tts_sapi_close(tts_t *tts) {
+    ::PlaySoundA(nullptr, nullptr, 0);
+    tts->speaker->Release();
+    tts->speaker = NULL;
+    ::CoUninitialize();
     return TTS_SUCCESS;
 }
+#endif
@@ -0,0 +1,209 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+#include "tts_cache.h"
+
+static tts_cache_entry_t *tts_cache_store     (tts_cache_t *cache,
+                                               uint64_t     key,
+                                               const char  *text,
+                                               uint8_t     *audio,
+                                               size_t       audio_size);
+
+static bool               tts_cache_file_name (tts_cache_t *cache,
+                                               uint64_t     key,
+                                               char        *name,
+                                               size_t       name_size);
+
+static tts_cache_entry_t *tts_cache_load      (tts_cache_t *cache,
+                                               uint64_t     key,
+                                               const char  *text);
+
+static void               tts_cache_save      (tts_cache_t *cache,
+                                               uint64_t     key,
+                                               uint8_t     *audio,
+                                               size_t       audio_size);
+
+//directory is created if missing, without it the cache is only in memory
+bool tts_cache_ctor(tts_cache_t *cache,
+                    const char  *directory) {
+    cache->entries = (tts_cache_entry_t *)calloc(TtsCacheSets * TtsCacheWays, sizeof(*cache->entries));
+    if(cache->entries == NULL) {
+        return false;
+    }
+    cache->directory = directory;
+    if(directory != NULL) {
+#ifdef _WIN32
+        int result = _mkdir(directory);
+#else
+        int result = mkdir(directory, 0755);
+#endif
+        if(result != 0 && errno != EEXIST) {
+            cache->directory = NULL;
+        }
+    }
+    return true;
+}
+
+void tts_cache_dtor(tts_cache_t *cache) {
+    if(cache->entries == NULL) {
+        return;
+    }
+    for(size_t index = 0; index < TtsCacheSets * TtsCacheWays; index++) {
+        free(cache->entries[index].audio);
+    }
+    free(cache->entries);
+    cache->entries = NULL;
+}
+
+//fnv-1a over voice, a zero byte and text
+uint64_t tts_cache_key(const char *voice,
+                       const char *text) {
+    uint64_t hash = 14695981039346656037ull;
+    for(const char *symbol = voice; *symbol != '\0'; symbol++) {
+        hash = (hash ^ (uint8_t)*symbol) * 1099511628211ull;
+    }
+    hash *= 1099511628211ull;
+    for(const char *symbol = text; *symbol != '\0'; symbol++) {
+        hash = (hash ^ (uint8_t)*symbol) * 1099511628211ull;
+    }
+    return hash;
+}
+
+tts_cache_entry_t *tts_cache_find(tts_cache_t *cache,
+                                  uint64_t     key,
+                                  const char  *text) {
+    tts_cache_entry_t *set = cache->entries + (key % TtsCacheSets) * TtsCacheWays;
+    for(size_t way = 0; way < TtsCacheWays; way++) {
+        if(set[way].audio != NULL && set[way].key == key && strcmp(set[way].text, text) == 0) {
+            set[way].used = ++cache->clock;
+            return &set[way];
+        }
+    }
+    return tts_cache_load(cache, key, text);
+}
+
+//takes audio, it is freed by the cache even when nothing could be stored
+tts_cache_entry_t *tts_cache_add(tts_cache_t *cache,
+                                 uint64_t     key,
+                                 const char  *text,
+                                 uint8_t     *audio,
+                                 size_t       audio_size) {
+    tts_cache_save(cache, key, audio, audio_size);
+    return tts_cache_store(cache, key, text, audio, audio_size);
+}
+
+tts_cache_entry_t *tts_cache_store(tts_cache_t *cache,
+                                   uint64_t     key,
+                                   const char  *text,
+                                   uint8_t     *audio,
+                                   size_t       audio_size) {
+    if(strlen(text) > TtsCacheMaxMessage) {
+        free(audio);
+        return NULL;
+    }
+
+    tts_cache_entry_t *set    = cache->entries + (key % TtsCacheSets) * TtsCacheWays;
+    tts_cache_entry_t *victim = NULL;
+    for(size_t way = 0; way < TtsCacheWays; way++) {
+        if(set[way].pinned) {
+            continue;
+        }
+        if(set[way].audio == NULL) {
+            victim = &set[way];
+            break;
+        }
+        if(victim == NULL || set[way].used < victim->used) {
+            victim = &set[way];
+        }
+    }
+    if(victim == NULL) {
+        free(audio);
+        return NULL;
+    }
+    if(victim->audio != NULL) {
+        cache->evictions_number++;
+        free(victim->audio);
+    }
+
+    victim->key        = key;
+    victim->audio      = audio;
+    victim->audio_size = audio_size;
+    victim->used       = ++cache->clock;
+    strcpy(victim->text, text);
+    return victim;
+}
+
+bool tts_cache_file_name(tts_cache_t *cache,
+                         uint64_t     key,
+                         char        *name,
+                         size_t       name_size) {
+    if(cache->directory == NULL) {
+        return false;
+    }
+    int length = snprintf(name, name_size, "%s/%016llx.wav", cache->directory, (unsigned long long)key);
+    return length > 0 && (size_t)length < name_size;
+}
+
+//file name carries only the key, text is trusted to match on a 64 bit hash
+tts_cache_entry_t *tts_cache_load(tts_cache_t *cache,
+                                  uint64_t     key,
+                                  const char  *text) {
+    char name[TtsCacheNameSize] = {};
+    if(!tts_cache_file_name(cache, key, name, sizeof(name))) {
+        return NULL;
+    }
+    FILE *file = fopen(name, "rb");
+    if(file == NULL) {
+        return NULL;
+    }
+
+    uint8_t *audio = NULL;
+    long     size  = -1;
+    if(fseek(file, 0, SEEK_END) == 0 && (size = ftell(file)) >= (long)TtsWavHeaderSize &&
+       fseek(file, 0, SEEK_SET) == 0 && (audio = (uint8_t *)malloc((size_t)size)) != NULL &&
+       fread(audio, 1, (size_t)size, file) != (size_t)size) {
+        free(audio);
+        audio = NULL;
+    }
+    fclose(file);
+    if(audio == NULL) {
+        return NULL;
+    }
+    cache->disk_loads_number++;
+    return tts_cache_store(cache, key, text, audio, (size_t)size);
+}
+
+//written aside and renamed, a crash never leaves a cut file under a valid name
+void tts_cache_save(tts_cache_t *cache,
+                    uint64_t     key,
+                    uint8_t     *audio,
+                    size_t       audio_size) {
+    char name     [TtsCacheNameSize] = {};
+    char temporary[TtsCacheNameSize] = {};
+    if(!tts_cache_file_name(cache, key, name, sizeof(name)) ||
+       (size_t)snprintf(temporary, sizeof(temporary), "%s.tmp", name) >= sizeof(temporary)) {
+        return;
+    }
+    FILE *file = fopen(temporary, "wb");
+    if(file == NULL) {
+        return;
+    }
+    bool written = (fwrite(audio, 1, audio_size, file) == audio_size);
+    if(fclose(file) != 0 || !written) {
+        remove(temporary);
+        return;
+    }
+#ifdef _WIN32
+    //rename does not replace on windows
+    remove(name);
+#endif
+    if(rename(temporary, name) != 0) {
+        remove(temporary);
+    }
+}